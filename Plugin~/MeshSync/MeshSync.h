@@ -15,6 +15,7 @@
 #include "SceneGraph/msEntityConverter.h"
 #include "SceneCache/msSceneCache.h"
 #include "msClient.h"
+#include "msRelay.h"
 #include "msServer.h"
 #include "msMisc.h"
 
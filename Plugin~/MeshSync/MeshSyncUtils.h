@@ -7,3 +7,7 @@
 #include "Utils/msEntityManager.h"
 #include "Utils/msAsyncSceneExporter.h"
 #include "Utils/msMaterialExt.h"
+#include "Utils/msCulling.h"
+#include "Utils/msRaycast.h"
+#include "Utils/msSceneRecorder.h"
+#include "Utils/msLatencyStats.h"
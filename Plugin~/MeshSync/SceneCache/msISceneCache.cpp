@@ -280,8 +280,10 @@ ScenePtr ISceneCacheImpl::getByIndexImpl(size_t scene_index, bool wait_preload)
 
     // push & pop history
     if (!m_header.oscs.strip_unchanged || scene_index != 0) {
+        // cubic interpolation uses 4 scenes at once
+        size_t max_history = m_iscs.cubic_interpolation ? std::max(m_iscs.max_history, 4) : m_iscs.max_history;
         m_history.push_back(scene_index);
-        if (m_history.size() > m_iscs.max_history) {
+        if (m_history.size() > max_history) {
             m_records[m_history.front()].scene.reset();
             m_history.pop_front();
         }
@@ -388,6 +390,9 @@ ScenePtr ISceneCacheImpl::getByTime(float time, bool interpolation)
             auto t2 = m_records[si + 1].time;
 
             kickPreload(si + 1);
+            bool cubic = m_iscs.cubic_interpolation;
+            if (cubic && si + 2 < scene_count)
+                kickPreload(si + 2);
             auto s1 = getByIndexImpl(si + 0);
             auto s2 = getByIndexImpl(si + 1);
 
@@ -395,11 +400,21 @@ ScenePtr ISceneCacheImpl::getByTime(float time, bool interpolation)
                 msProfileScope("ISceneCacheImpl: [%d] lerp", (int)si);
                 ScopedTimer timer;
 
-                float t = (time - t1) / (t2 - t1);
                 ret = Scene::create();
-                ret->lerp(*s1, *s2, t);
-                // keep a reference for s1 (s2 is not needed)
+                if (cubic) {
+                    // at the ends of the sequence, the neighbours are substituted by s1 and s2
+                    ScenePtr s0 = si > 0 ? getByIndexImpl(si - 1) : nullptr;
+                    ScenePtr s3 = si + 2 < scene_count ? getByIndexImpl(si + 2) : nullptr;
+                    float t0 = s0 ? m_records[si - 1].time : t1 - (t2 - t1);
+                    float t3 = s3 ? m_records[si + 2].time : t2 + (t2 - t1);
+                    ret->cubicLerp(s0.get(), *s1, *s2, s3.get(), CubicLerpParams::create(t0, t1, t2, t3, time));
+                }
+                else {
+                    ret->lerp(*s1, *s2, (time - t1) / (t2 - t1));
+                }
+                // entities of s1 and s2 can be passed through or shared by the interpolated ones
                 ret->data_sources.push_back(s1);
+                ret->data_sources.push_back(s2);
 
                 ret->profile_data.lerp_time = timer.elapsed();
             }
@@ -78,6 +78,9 @@ struct ISceneCacheSettingsBase
     uint32_t enable_diff : 1;
     uint32_t preload_scenes : 1;
     uint32_t generate_velocities : 1;
+    // getByTime() with interpolation uses 4 neighbouring scenes. transforms and points are interpolated by
+    // catmull-rom splines, or hermite splines if velocities are present. sparse caches play back more smoothly.
+    uint32_t cubic_interpolation : 1;
     int max_history = 3;
 
     SceneImportSettings sis;
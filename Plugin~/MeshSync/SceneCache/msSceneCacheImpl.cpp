@@ -27,12 +27,14 @@ ISceneCacheSettingsBase::ISceneCacheSettingsBase()
     enable_diff = 1;
     preload_scenes = 1;
     generate_velocities = 0;
+    cubic_interpolation = 0;
 }
 
 BufferEncoderPtr CreateEncoder(SceneCacheEncoding encoding, const SceneCacheEncoderSettings& settings)
 {
     BufferEncoderPtr ret;
     switch (encoding) {
+    case SceneCacheEncoding::Plain: ret = CreatePlainEncoder(); break;
     case SceneCacheEncoding::ZSTD: ret = CreateZSTDEncoder(settings.zstd.compression_level); break;
     default: break;
     }
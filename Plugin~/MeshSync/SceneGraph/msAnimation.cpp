@@ -5,6 +5,62 @@
 
 namespace ms {
 
+static const char *g_curve_names[] = {
+    mskTransformTranslation,
+    mskTransformRotation,
+    mskTransformScale,
+    mskTransformVisible,
+    mskCameraFieldOfView,
+    mskCameraNearPlane,
+    mskCameraFarPlane,
+    mskCameraFocalLength,
+    mskCameraSensorSize,
+    mskCameraLensShift,
+    mskLightColor,
+    mskLightIntensity,
+    mskLightRange,
+    mskLightSpotAngle,
+};
+static_assert(sizeof(g_curve_names) / sizeof(g_curve_names[0]) == (size_t)AnimationCurveKey::Count, "");
+
+// FNV-1a
+static inline uint32_t HashCurveName(const char *name)
+{
+    uint32_t ret = 2166136261u;
+    for (const char *c = name; *c; ++c)
+        ret = (ret ^ (uint8_t)*c) * 16777619u;
+    return ret;
+}
+
+AnimationCurveKey GetAnimationCurveKey(const char *name)
+{
+    const int N = (int)AnimationCurveKey::Count;
+    static uint32_t s_hashes[N];
+    static const bool s_initialized = []() {
+        for (int i = 0; i < N; ++i)
+            s_hashes[i] = HashCurveName(g_curve_names[i]);
+        return true;
+    }();
+    (void)s_initialized;
+
+    if (!name)
+        return AnimationCurveKey::Unknown;
+    uint32_t hash = HashCurveName(name);
+    for (int i = 0; i < N; ++i) {
+        if (s_hashes[i] == hash && std::strcmp(g_curve_names[i], name) == 0)
+            return (AnimationCurveKey)i;
+    }
+    return AnimationCurveKey::Unknown;
+}
+
+const char* GetAnimationCurveName(AnimationCurveKey key)
+{
+    if (key <= AnimationCurveKey::Unknown || key >= AnimationCurveKey::Count)
+        return "";
+    return g_curve_names[(int)key];
+}
+
+
 template<class T>
 struct Equals
 {
@@ -70,19 +126,88 @@ static void ReduceKeyframes(AnimationCurve& self, bool keep_flat_curve)
 }
 template<> void ReduceKeyframes<void>(AnimationCurve& /*self*/, bool /*keep_flat_curve*/) {}
 
+template<class T>
+static bool NearEqualAll(const AnimationCurve& self, const void *v, float eps)
+{
+    TAnimationCurve<T> data(self);
+    if (data.empty())
+        return false;
+    return mu::NearEqualStrided((const float*)&data.cdata()->value, sizeof(TVP<T>) / sizeof(float), data.size(),
+        (const float*)v, sizeof(T) / sizeof(float), eps);
+}
+template<> bool NearEqualAll<int>(const AnimationCurve& self, const void *v, float /*eps*/)
+{
+    TAnimationCurve<int> data(self);
+    if (data.empty())
+        return false;
+    int value = *(const int*)v;
+    for (auto& key : data)
+        if (key.value != value)
+            return false;
+    return true;
+}
+template<> bool NearEqualAll<void>(const AnimationCurve& /*self*/, const void* /*v*/, float /*eps*/) { return false; }
+
+template<class T>
+static bool CollapseKeyframes(AnimationCurve& self, float eps)
+{
+    TAnimationCurve<T> data(self);
+    if (data.size() <= 2 || !NearEqualAll<T>(self, &data.cdata()->value, eps))
+        return false;
+
+    // keep the last key to preserve the time range of the clip (and to prevent Unity's warning)
+    auto last_key = data.back();
+    last_key.value = data.front().value;
+    data.resize(2);
+    data[1] = last_key;
+    return true;
+}
+template<> bool CollapseKeyframes<void>(AnimationCurve& /*self*/, float /*eps*/) { return false; }
+
+
+template<class T> inline T InterpolateKeys(const T& a, const T& b, float t) { return mu::lerp(a, b, t); }
+template<> inline int InterpolateKeys(const int& a, const int& /*b*/, float /*t*/) { return a; }
+template<> inline quatf InterpolateKeys(const quatf& a, const quatf& b, float t) { return mu::slerp(a, b, t); }
+
+template<class T>
+static void EvaluateKeys(const AnimationCurve& self, const AnimationKeyPosition& pos, void *dst)
+{
+    TAnimationCurve<T> data(self);
+    auto& ret = *(T*)dst;
+    size_t n = data.size();
+    if (pos.index < 0 || (size_t)pos.index >= n) {
+        ret = T();
+        return;
+    }
+    auto& k1 = data[pos.index];
+    if (pos.t == 0.0f || self.data_flags.force_constant || (size_t)pos.index + 1 >= n)
+        ret = k1.value;
+    else
+        ret = InterpolateKeys(k1.value, data[pos.index + 1].value, pos.t);
+}
+template<> void EvaluateKeys<void>(const AnimationCurve& /*self*/, const AnimationKeyPosition& /*pos*/, void* /*dst*/) {}
+
+
+template<class T> static size_t GetKeySize() { return sizeof(TVP<T>); }
+template<> size_t GetKeySize<void>() { return 0; }
+
 
 struct AnimationCurveFunctionSet
 {
+    size_t(*key_size)();
     size_t(*size)(const AnimationCurve& self);
     void*(*at)(const AnimationCurve& self, size_t i);
     void(*reserve_keyframes)(AnimationCurve& self, size_t n);
     void(*reduce_keyframes)(AnimationCurve& self, bool keep_flat_curve);
+    bool(*near_equal_all)(const AnimationCurve& self, const void *v, float eps);
+    bool(*collapse_keyframes)(AnimationCurve& self, float eps);
+    void(*evaluate_keys)(const AnimationCurve& self, const AnimationKeyPosition& pos, void *dst);
 };
 
 #define EachDataTypes(Body)\
     Body(void) Body(int) Body(float) Body(float2) Body(float3) Body(float4) Body(quatf)
 
-#define DefFunctionSet(T) {&GetSize<T>, &At<T>, &ReserveKeyframes<T>, &ReduceKeyframes<T>},
+#define DefFunctionSet(T) {&GetKeySize<T>, &GetSize<T>, &At<T>, &ReserveKeyframes<T>, &ReduceKeyframes<T>, &NearEqualAll<T>, &CollapseKeyframes<T>, &EvaluateKeys<T>},
 
 static AnimationCurveFunctionSet g_curve_fs[] = {
     EachDataTypes(DefFunctionSet)
@@ -101,16 +226,80 @@ std::shared_ptr<AnimationCurve> AnimationCurve::create(std::istream& is)
 AnimationCurve::AnimationCurve() {}
 AnimationCurve::~AnimationCurve() {}
 
-#define EachMember(F) F(name) F(data) F(data_type) F(data_flags)
+#define EachMember(F) F(name) F(data) F(data_type) F(data_flags) F(data_ref)
 
 void AnimationCurve::serialize(std::ostream& os) const
 {
-    EachMember(msWrite);
+    static const SharedVector<float> s_no_times;
+    serialize(os, s_no_times);
 }
 
 void AnimationCurve::deserialize(std::istream& is)
+{
+    static const SharedVector<float> s_no_times;
+    deserialize(is, s_no_times);
+}
+
+void AnimationCurve::serialize(std::ostream& os, const SharedVector<float>& times) const
+{
+    auto flags = data_flags;
+    flags.shared_times = data_ref == InvalidID && !times.empty() && timesEqual(times.cdata(), times.size());
+
+    write(os, name);
+    if (data_ref != InvalidID) {
+        // data is restored from the referenced curve
+        static const SharedVector<char> s_empty;
+        write(os, s_empty);
+    }
+    else if (flags.shared_times) {
+        // values only. times are restored from the host Animation
+        size_t n = size();
+        size_t key_size = keySize();
+        size_t value_size = key_size - sizeof(float);
+
+        SharedVector<char> values;
+        values.resize_discard(n * value_size);
+        auto *src = data.cdata() + sizeof(float);
+        auto *dst = values.data();
+        for (size_t i = 0; i < n; ++i)
+            std::memcpy(dst + value_size * i, src + key_size * i, value_size);
+        write(os, values);
+    }
+    else {
+        write(os, data);
+    }
+    write(os, data_type);
+    write(os, flags);
+    write(os, data_ref);
+}
+
+void AnimationCurve::deserialize(std::istream& is, const SharedVector<float>& times)
 {
     EachMember(msRead);
+    key = GetAnimationCurveKey(name.c_str());
+
+    if (data_flags.shared_times) {
+        size_t n = times.size();
+        size_t key_size = keySize();
+        size_t value_size = key_size - sizeof(float);
+        if (n == 0 || key_size == 0 || data.size() != n * value_size) {
+            // broken data
+            data.clear();
+            data_flags.shared_times = 0;
+            return;
+        }
+
+        // interleave times and values
+        SharedVector<char> values;
+        values.swap(data);
+        data.resize_discard(n * key_size);
+        auto *src = values.cdata();
+        auto *dst = data.data();
+        for (size_t i = 0; i < n; ++i) {
+            std::memcpy(dst + key_size * i, &times[i], sizeof(float));
+            std::memcpy(dst + key_size * i + sizeof(float), src + value_size * i, value_size);
+        }
+    }
 }
 
 void AnimationCurve::clear()
@@ -119,7 +308,9 @@ void AnimationCurve::clear()
     data.clear();
     data_type = DataType::Unknown;
     data_flags = {};
+    data_ref = InvalidID;
 
+    key = AnimationCurveKey::Unknown;
     idata.clear();
 }
 
@@ -139,6 +330,22 @@ uint64_t AnimationCurve::checksum() const
     return ret;
 }
 
+std::shared_ptr<AnimationCurve> AnimationCurve::clone() const
+{
+    auto ret = create();
+    ret->name = name;
+    ret->data.assign(data.cdata(), data.cdata() + data.size());
+    ret->data_type = data_type;
+    ret->data_flags = data_flags;
+    ret->key = key;
+    return ret;
+}
+
+size_t AnimationCurve::keySize() const
+{
+    return g_curve_fs[(int)data_type].key_size();
+}
+
 size_t AnimationCurve::size() const
 {
     return g_curve_fs[(int)data_type].size(*this);
@@ -163,6 +370,127 @@ void AnimationCurve::reserve(size_t size)
 {
     g_curve_fs[(int)data_type].reserve_keyframes(*this, size);
 }
+
+bool AnimationCurve::nearEqualAll(const void *v, float eps) const
+{
+    return g_curve_fs[(int)data_type].near_equal_all(*this, v, eps);
+}
+
+bool AnimationCurve::collapse(float eps)
+{
+    return g_curve_fs[(int)data_type].collapse_keyframes(*this, eps);
+}
+
+// index of the first key whose time is not less than t (or greater than t if upper is true)
+static size_t FindKeyByTime(const AnimationCurve& self, float t, bool upper)
+{
+    size_t key_size = self.keySize();
+    auto *src = self.data.cdata();
+    size_t first = 0, count = self.size();
+    while (count > 0) {
+        size_t step = count / 2;
+        size_t i = first + step;
+        float time = *(const float*)(src + key_size * i);
+        if (upper ? !(t < time) : time < t) {
+            first = i + 1;
+            count -= step + 1;
+        }
+        else {
+            count = step;
+        }
+    }
+    return first;
+}
+
+void AnimationCurve::replaceKeys(const AnimationTimeRange& range, const AnimationCurve& src)
+{
+    if (data_type == DataType::Unknown)
+        data_type = src.data_type;
+    size_t key_size = keySize();
+    if (src.data_type != data_type || key_size == 0)
+        return;
+
+    size_t n = size();
+    size_t begin = FindKeyByTime(*this, range.start, false);
+    size_t end = std::max(begin, FindKeyByTime(*this, range.end, true));
+
+    RawVector<char> tmp;
+    size_t head = key_size * begin;
+    size_t tail = key_size * (n - end);
+    tmp.resize_discard(head + src.data.size() + tail);
+    std::memcpy(tmp.data(), data.cdata(), head);
+    std::memcpy(tmp.data() + head, src.data.cdata(), src.data.size());
+    std::memcpy(tmp.data() + head + src.data.size(), data.cdata() + key_size * end, tail);
+    data = std::move(tmp);
+    // times may no longer match the host Animation's
+    data_flags.shared_times = 0;
+}
+
+AnimationKeyPosition AnimationCurve::findKey(float time) const
+{
+    return AnimationKeyPosition::find(data.cdata(), keySize(), size(), time);
+}
+
+void AnimationCurve::evaluate(const AnimationKeyPosition& pos, void *dst) const
+{
+    g_curve_fs[(int)data_type].evaluate_keys(*this, pos, dst);
+}
+
+void AnimationCurve::evaluate(float time, void *dst) const
+{
+    evaluate(findKey(time), dst);
+}
+
+AnimationKeyPosition AnimationKeyPosition::find(const void *times, size_t stride, size_t n, float time)
+{
+    AnimationKeyPosition ret;
+    if (n == 0)
+        return ret;
+
+    auto time_at = [times, stride](size_t i) { return *(const float*)((const char*)times + stride * i); };
+    if (!(time > time_at(0))) {
+        ret.index = 0;
+        return ret;
+    }
+    if (!(time < time_at(n - 1))) {
+        ret.index = (int)n - 1;
+        return ret;
+    }
+
+    // last key whose time is not greater than time
+    size_t first = 0, count = n;
+    while (count > 0) {
+        size_t step = count / 2;
+        size_t i = first + step;
+        if (!(time < time_at(i))) {
+            first = i + 1;
+            count -= step + 1;
+        }
+        else {
+            count = step;
+        }
+    }
+    size_t i = first - 1;
+    float t1 = time_at(i);
+    float t2 = time_at(i + 1);
+    ret.index = (int)i;
+    ret.t = t2 > t1 ? (time - t1) / (t2 - t1) : 0.0f;
+    return ret;
+}
+
+bool AnimationCurve::timesEqual(const float *times, size_t n) const
+{
+    if (size() != n)
+        return false;
+
+    size_t key_size = keySize();
+    auto *src = data.cdata();
+    for (size_t i = 0; i < n; ++i) {
+        if (*(const float*)(src + key_size * i) != times[i])
+            return false;
+    }
+    return true;
+}
 #undef EachMember
 
 
@@ -181,14 +509,31 @@ void Animation::serialize(std::ostream & os) const
 {
     write(os, entity_type);
     write(os, path);
-    write(os, curves);
+
+    SharedVector<float> shared_times;
+    buildSharedTimes(shared_times);
+    write(os, shared_times);
+
+    auto num_curves = (uint32_t)curves.size();
+    write(os, num_curves);
+    for (auto& curve : curves)
+        curve->serialize(os, shared_times);
 }
 
 void Animation::deserialize(std::istream & is)
 {
     read(is, entity_type);
     read(is, path);
-    read(is, curves);
+    read(is, times);
+
+    uint32_t num_curves = 0;
+    read(is, num_curves);
+    curves.resize(num_curves);
+    for (auto& curve : curves) {
+        curve = AnimationCurve::create();
+        curve->deserialize(is, times);
+    }
+    updateKeyIndex();
 }
 
 void Animation::clear()
@@ -196,6 +541,9 @@ void Animation::clear()
     entity_type = EntityType::Unknown;
     path.clear();
     curves.clear();
+    times.clear();
+    for (auto& c : m_key_curves)
+        c.reset();
 }
 
 uint64_t Animation::hash() const
@@ -212,6 +560,19 @@ uint64_t Animation::checksum() const
         ret += c->checksum();
     return ret;
 }
+std::shared_ptr<Animation> Animation::clone() const
+{
+    auto ret = create();
+    ret->entity_type = entity_type;
+    ret->path = path;
+    ret->times.assign(times.cdata(), times.cdata() + times.size());
+    ret->curves.reserve(curves.size());
+    for (auto& c : curves)
+        ret->curves.push_back(c->clone());
+    ret->updateKeyIndex();
+    return ret;
+}
+
 bool Animation::empty() const
 {
     return curves.empty();
@@ -229,6 +590,10 @@ bool Animation::isRoot() const
 
 AnimationCurvePtr Animation::findCurve(const char *name) const
 {
+    auto key = GetAnimationCurveKey(name);
+    if (key != Key::Unknown)
+        return findCurve(key);
+
     auto it = std::lower_bound(curves.begin(), curves.end(), name, [](auto& curve, auto name) {
         return std::strcmp(curve->name.c_str(), name) < 0;
     });
@@ -254,56 +619,90 @@ AnimationCurvePtr Animation::findCurve(const std::string& name, DataType type) c
     return findCurve(name.c_str(), type);
 }
 
+AnimationCurvePtr Animation::findCurve(Key key) const
+{
+    if (key <= Key::Unknown || key >= Key::Count)
+        return nullptr;
+    return m_key_curves[(int)key];
+}
 
-AnimationCurvePtr Animation::addCurve(const char *name, DataType type)
+AnimationCurvePtr Animation::findCurve(Key key, DataType type) const
 {
+    auto ret = findCurve(key);
+    if (ret && ret->data_type == type)
+        return ret;
+    return nullptr;
+}
+
+
+AnimationCurvePtr Animation::addCurveImpl(const char *name, Key key, DataType type, bool clear_existing)
+{
+    if (key != Key::Unknown) {
+        if (auto& ret = m_key_curves[(int)key]) {
+            if (clear_existing) {
+                ret->data.clear();
+                ret->data_type = type;
+            }
+            return ret;
+        }
+    }
+
     auto it = std::lower_bound(curves.begin(), curves.end(), name, [](auto& curve, auto name) {
         return std::strcmp(curve->name.c_str(), name) < 0;
     });
     if (it != curves.end() && (*it)->name == name) {
         auto& ret = *it;
-        // clear existing one
-        ret->data.clear();
-        ret->data_type = type;
+        if (clear_existing) {
+            ret->data.clear();
+            ret->data_type = type;
+        }
         return ret;
     }
     else {
         auto ret = AnimationCurve::create();
         ret->name = name;
         ret->data_type = type;
+        ret->key = key;
         curves.insert(it, ret);
+        if (key != Key::Unknown)
+            m_key_curves[(int)key] = ret;
         return ret;
     }
 }
+
+AnimationCurvePtr Animation::addCurve(const char *name, DataType type)
+{
+    return addCurveImpl(name, GetAnimationCurveKey(name), type, true);
+}
 AnimationCurvePtr Animation::addCurve(const std::string& name, DataType type)
 {
     return addCurve(name.c_str(), type);
 }
+AnimationCurvePtr Animation::addCurve(Key key, DataType type)
+{
+    return addCurveImpl(GetAnimationCurveName(key), key, type, true);
+}
 
 AnimationCurvePtr Animation::getCurve(const char *name, DataType type)
 {
-    auto it = std::lower_bound(curves.begin(), curves.end(), name, [](auto& curve, auto name) {
-        return std::strcmp(curve->name.c_str(), name) < 0;
-    });
-    if (it != curves.end() && (*it)->name == name)
-        return *it;
-
-    auto ret = AnimationCurve::create();
-    ret->name = name;
-    ret->data_type = type;
-    curves.insert(it, ret);
-    return ret;
+    return addCurveImpl(name, GetAnimationCurveKey(name), type, false);
 }
-
 AnimationCurvePtr Animation::getCurve(const std::string& name, DataType type)
 {
     return getCurve(name.c_str(), type);
 }
+AnimationCurvePtr Animation::getCurve(Key key, DataType type)
+{
+    return addCurveImpl(GetAnimationCurveName(key), key, type, false);
+}
 
 bool Animation::eraseCurve(const AnimationCurve *curve)
 {
     auto it = std::find_if(curves.begin(), curves.end(), [&](auto& c) {return c.get() == curve; });
     if (it != curves.end()) {
+        auto key = (*it)->key;
+        if (key != Key::Unknown && m_key_curves[(int)key] == *it)
+            m_key_curves[(int)key].reset();
         curves.erase(it);
         return true;
     }
@@ -315,6 +714,78 @@ void Animation::clearEmptyCurves()
     curves.erase(
         std::remove_if(curves.begin(), curves.end(), [](auto& c) { return c->empty(); }),
         curves.end());
+    updateKeyIndex();
+}
+
+void Animation::optimize(const AnimationOptimizeSettings& settings, const Transform *rest)
+{
+    if (settings.collapse_constant_curves) {
+        for (auto& c : curves)
+            c->collapse(settings.eps);
+    }
+
+    if (settings.erase_static_curves && rest) {
+        auto erase_if_static = [&](Key key, DataType type, const void *v) {
+            auto curve = findCurve(key, type);
+            if (curve && curve->nearEqualAll(v, settings.eps))
+                eraseCurve(curve.get());
+        };
+
+        auto& flags = rest->td_flags;
+        if (flags.has_position)
+            erase_if_static(Key::TransformTranslation, DataType::Float3, &rest->position);
+        if (flags.has_rotation)
+            erase_if_static(Key::TransformRotation, DataType::Quaternion, &rest->rotation);
+        if (flags.has_scale)
+            erase_if_static(Key::TransformScale, DataType::Float3, &rest->scale);
+        if (flags.has_visibility) {
+            int visible = rest->visibility.visible_in_render;
+            erase_if_static(Key::TransformVisible, DataType::Int, &visible);
+        }
+    }
+}
+
+void Animation::buildSharedTimes(SharedVector<float>& dst) const
+{
+    // use the times of the longest curve as the base
+    const AnimationCurve *base = nullptr;
+    size_t base_size = 0;
+    for (auto& curve : curves) {
+        if (curve->data_ref != InvalidID)
+            continue;
+        size_t n = curve->size();
+        if (n >= 2 && n > base_size) {
+            base = curve.get();
+            base_size = n;
+        }
+    }
+    if (!base)
+        return;
+
+    dst.resize_discard(base_size);
+    size_t key_size = base->keySize();
+    auto *src = base->data.cdata();
+    for (size_t i = 0; i < base_size; ++i)
+        dst[i] = *(const float*)(src + key_size * i);
+
+    // not worth it if no other curves share the times
+    int num_shared = 0;
+    for (auto& curve : curves) {
+        if (curve->data_ref == InvalidID && curve->timesEqual(dst.cdata(), base_size))
+            ++num_shared;
+    }
+    if (num_shared < 2)
+        dst.clear();
+}
+
+void Animation::updateKeyIndex()
+{
+    for (auto& c : m_key_curves)
+        c.reset();
+    for (auto& c : curves) {
+        if (c->key != Key::Unknown)
+            m_key_curves[(int)c->key] = c;
+    }
 }
 
 
@@ -368,6 +839,7 @@ void AnimationClip::deserialize(std::istream& is)
 {
     super::deserialize(is);
     EachMember(msRead);
+    resolveDataRefs();
 }
 
 #undef EachMember
@@ -394,6 +866,18 @@ uint64_t AnimationClip::checksum() const
     return ret;
 }
 
+std::shared_ptr<AnimationClip> AnimationClip::clone() const
+{
+    auto ret = create();
+    ret->name = name;
+    ret->id = id;
+    ret->frame_rate = frame_rate;
+    ret->animations.reserve(animations.size());
+    for (auto& a : animations)
+        ret->animations.push_back(a->clone());
+    return ret;
+}
+
 bool AnimationClip::empty() const
 {
     return animations.empty();
@@ -417,6 +901,79 @@ void AnimationClip::clearEmptyAnimations()
         animations.end());
 }
 
+void AnimationClip::optimize(const AnimationOptimizeSettings& settings, const std::vector<TransformPtr>& rests)
+{
+    std::map<std::string, const Transform*> rest_table;
+    if (settings.erase_static_curves) {
+        for (auto& e : rests)
+            rest_table[e->path] = e.get();
+    }
+
+    parallel_for(0, (int)animations.size(), [&](int ai) {
+        auto& anim = *animations[ai];
+        auto it = rest_table.find(anim.path);
+        anim.optimize(settings, it != rest_table.end() ? it->second : nullptr);
+    });
+    clearEmptyAnimations();
+
+    if (settings.share_identical_curves)
+        shareIdenticalCurves();
+}
+
+void AnimationClip::shareIdenticalCurves()
+{
+    struct Record
+    {
+        const AnimationCurve *curve;
+        int index;
+    };
+    // key: checksum of data
+    std::map<uint64_t, std::vector<Record>> table;
+
+    int index = 0;
+    for (auto& anim : animations) {
+        for (auto& curve : anim->curves) {
+            int ci = index++;
+            curve->data_ref = InvalidID;
+            // too small to be worth referencing
+            if (curve->data.size() <= sizeof(TVP<float4>))
+                continue;
+
+            auto& records = table[csum(curve->data)];
+            auto it = std::find_if(records.begin(), records.end(), [&curve](const Record& r) {
+                auto& d1 = r.curve->data;
+                auto& d2 = curve->data;
+                return r.curve->data_type == curve->data_type && d1.size() == d2.size() &&
+                    std::memcmp(d1.cdata(), d2.cdata(), d1.size()) == 0;
+            });
+            if (it != records.end()) {
+                curve->data.share(it->curve->data);
+                curve->data_ref = it->index;
+            }
+            else {
+                records.push_back({ curve.get(), ci });
+            }
+        }
+    }
+}
+
+void AnimationClip::resolveDataRefs()
+{
+    std::vector<AnimationCurve*> all_curves;
+    for (auto& anim : animations) {
+        for (auto& curve : anim->curves) {
+            if (curve->data_ref != InvalidID) {
+                if (curve->data_ref >= 0 && curve->data_ref < (int)all_curves.size()) {
+                    auto& src = all_curves[curve->data_ref]->data;
+                    curve->data.assign(src.cdata(), src.cdata() + src.size());
+                }
+                curve->data_ref = InvalidID;
+            }
+            all_curves.push_back(curve.get());
+        }
+    }
+}
+
 
 template<class T>
 static inline std::shared_ptr<T> CreateTypedAnimation(AnimationPtr host)
@@ -433,12 +990,12 @@ static inline std::shared_ptr<T> CreateTypedAnimation(AnimationPtr host)
     }
 }
 
-static AnimationCurvePtr GetCurve(AnimationPtr& host, const char *name, AnimationCurve::DataType type, bool create_if_not_exist)
+static AnimationCurvePtr GetCurve(AnimationPtr& host, AnimationCurveKey key, AnimationCurve::DataType type, bool create_if_not_exist)
 {
     if (create_if_not_exist)
-        return host->getCurve(name, type);
+        return host->getCurve(key, type);
     else
-        return host->findCurve(name, type);
+        return host->findCurve(key, type);
 }
 
 std::shared_ptr<TransformAnimation> TransformAnimation::create(AnimationPtr host)
@@ -459,10 +1016,10 @@ TransformAnimation::~TransformAnimation()
 
 void TransformAnimation::setupCurves(bool create_if_not_exist)
 {
-    translation = GetCurve(host, mskTransformTranslation, DataType::Float3, create_if_not_exist);
-    rotation = GetCurve(host, mskTransformRotation, DataType::Quaternion, create_if_not_exist);
-    scale = GetCurve(host, mskTransformScale, DataType::Float3, create_if_not_exist);
-    visible = GetCurve(host, mskTransformVisible, DataType::Int, create_if_not_exist);
+    translation = GetCurve(host, Key::TransformTranslation, DataType::Float3, create_if_not_exist);
+    rotation = GetCurve(host, Key::TransformRotation, DataType::Quaternion, create_if_not_exist);
+    scale = GetCurve(host, Key::TransformScale, DataType::Float3, create_if_not_exist);
+    visible = GetCurve(host, Key::TransformVisible, DataType::Int, create_if_not_exist);
 
     if (create_if_not_exist) {
         translation.curve->data_flags.affect_handedness = true;
@@ -508,12 +1065,12 @@ void CameraAnimation::setupCurves(bool create_if_not_exist)
 {
     super::setupCurves(create_if_not_exist);
 
-    fov = GetCurve(host, mskCameraFieldOfView, DataType::Float, create_if_not_exist);
-    near_plane = GetCurve(host, mskCameraNearPlane, DataType::Float, create_if_not_exist);
-    far_plane = GetCurve(host, mskCameraFarPlane, DataType::Float, create_if_not_exist);
-    focal_length = GetCurve(host, mskCameraFocalLength, DataType::Float, create_if_not_exist);
-    sensor_size = GetCurve(host, mskCameraSensorSize, DataType::Float2, create_if_not_exist);
-    lens_shift = GetCurve(host, mskCameraLensShift, DataType::Float2, create_if_not_exist);
+    fov = GetCurve(host, Key::CameraFieldOfView, DataType::Float, create_if_not_exist);
+    near_plane = GetCurve(host, Key::CameraNearPlane, DataType::Float, create_if_not_exist);
+    far_plane = GetCurve(host, Key::CameraFarPlane, DataType::Float, create_if_not_exist);
+    focal_length = GetCurve(host, Key::CameraFocalLength, DataType::Float, create_if_not_exist);
+    sensor_size = GetCurve(host, Key::CameraSensorSize, DataType::Float2, create_if_not_exist);
+    lens_shift = GetCurve(host, Key::CameraLensShift, DataType::Float2, create_if_not_exist);
 
     if (create_if_not_exist) {
         near_plane.curve->data_flags.affect_scale = true;
@@ -553,10 +1110,10 @@ void LightAnimation::setupCurves(bool create_if_not_exist)
 {
     super::setupCurves(create_if_not_exist);
 
-    color = GetCurve(host, mskLightColor, DataType::Float4, create_if_not_exist);
-    intensity = GetCurve(host, mskLightIntensity, DataType::Float, create_if_not_exist);
-    range = GetCurve(host, mskLightRange, DataType::Float, create_if_not_exist);
-    spot_angle = GetCurve(host, mskLightSpotAngle, DataType::Float, create_if_not_exist);
+    color = GetCurve(host, Key::LightColor, DataType::Float4, create_if_not_exist);
+    intensity = GetCurve(host, Key::LightIntensity, DataType::Float, create_if_not_exist);
+    range = GetCurve(host, Key::LightRange, DataType::Float, create_if_not_exist);
+    spot_angle = GetCurve(host, Key::LightSpotAngle, DataType::Float, create_if_not_exist);
 
     if (create_if_not_exist) {
         range.curve->data_flags.affect_scale = true;
@@ -605,4 +1162,123 @@ TAnimationCurve<float> MeshAnimation::getBlendshapeCurve(const std::string& name
     return getBlendshapeCurve(name.c_str());
 }
 
+
+
+#define EachMember(F) F(path) F(curve) F(range)
+
+void AnimationCurveRange::serialize(std::ostream& os) const
+{
+    EachMember(msWrite);
+}
+
+void AnimationCurveRange::deserialize(std::istream& is)
+{
+    EachMember(msRead);
+}
+
+#undef EachMember
+
+
+#define EachMember(F) F(clip) F(ranges)
+
+AnimationClipDelta::AnimationClipDelta()
+{
+    clip = AnimationClip::create();
+}
+
+void AnimationClipDelta::serialize(std::ostream& os) const
+{
+    EachMember(msWrite);
+}
+
+void AnimationClipDelta::deserialize(std::istream& is)
+{
+    EachMember(msRead);
+}
+
+#undef EachMember
+
+bool AnimationClipDelta::isTarget(const AnimationClip& v) const
+{
+    return v.identify(clip->getIdentifier());
+}
+
+const AnimationCurveRange* AnimationClipDelta::findRange(const std::string& path, const std::string& curve) const
+{
+    for (auto& r : ranges) {
+        if (r.path == path && r.curve == curve)
+            return &r;
+    }
+    return nullptr;
+}
+
+void AnimationClipDelta::apply(AnimationClip& dst, AnimationClip *updated) const
+{
+    for (auto& anim : clip->animations) {
+        AnimationPtr dst_anim;
+        for (auto& a : dst.animations) {
+            if (a->path == anim->path) {
+                dst_anim = a;
+                break;
+            }
+        }
+        if (!dst_anim) {
+            dst_anim = Animation::create();
+            dst_anim->entity_type = anim->entity_type;
+            dst_anim->path = anim->path;
+            dst.addAnimation(dst_anim);
+        }
+
+        AnimationPtr updated_anim;
+        for (auto& curve : anim->curves) {
+            // empty curves have no range to replace (e.g. curves added by TransformAnimation::create())
+            if (curve->empty())
+                continue;
+
+            AnimationTimeRange range;
+            if (auto *r = findRange(anim->path, curve->name)) {
+                range = r->range;
+            }
+            else {
+                // no range. replace keys in the range of the new keys
+                auto *src = curve->data.cdata();
+                range.start = *(const float*)src;
+                range.end = *(const float*)(src + curve->data.size() - curve->keySize());
+            }
+
+            auto dst_curve = dst_anim->findCurve(curve->name);
+            if (!dst_curve) {
+                dst_curve = dst_anim->addCurve(curve->name, curve->data_type);
+                dst_curve->data_flags = curve->data_flags;
+            }
+            dst_curve->replaceKeys(range, *curve);
+
+            if (updated) {
+                if (!updated_anim) {
+                    updated_anim = Animation::create();
+                    updated_anim->entity_type = dst_anim->entity_type;
+                    updated_anim->path = dst_anim->path;
+                    updated->addAnimation(updated_anim);
+                }
+                auto c = updated_anim->addCurve(dst_curve->name, dst_curve->data_type);
+                c->data.assign(dst_curve->data.cdata(), dst_curve->data.cdata() + dst_curve->data.size());
+                c->data_flags = dst_curve->data_flags;
+            }
+        }
+    }
+}
+
+AnimationTimeRange AnimationClipDelta::getTimeRange() const
+{
+    if (ranges.empty())
+        return {};
+
+    AnimationTimeRange ret = ranges.front().range;
+    for (auto& r : ranges) {
+        ret.start = std::min(ret.start, r.range.start);
+        ret.end = std::max(ret.end, r.range.end);
+    }
+    return ret;
+}
+
 } // namespace ms
@@ -14,6 +14,55 @@ struct TVP
     T value;
 };
 
+// well-known curves (mskTransformTranslation etc.) are interned to these keys.
+// Animation keeps an index by key so that they can be found without string comparison.
+enum class AnimationCurveKey : int
+{
+    Unknown = -1,
+    TransformTranslation,
+    TransformRotation,
+    TransformScale,
+    TransformVisible,
+    CameraFieldOfView,
+    CameraNearPlane,
+    CameraFarPlane,
+    CameraFocalLength,
+    CameraSensorSize,
+    CameraLensShift,
+    LightColor,
+    LightIntensity,
+    LightRange,
+    LightSpotAngle,
+    Count,
+};
+// return AnimationCurveKey::Unknown if name is not a well-known curve (user / blendshape curves)
+AnimationCurveKey GetAnimationCurveKey(const char *name);
+const char* GetAnimationCurveName(AnimationCurveKey key);
+
+struct AnimationTimeRange
+{
+    float start = 0.0f;
+    float end = 0.0f;
+};
+
+// position on a curve. the value is interpolated between keys [index] and [index + 1] by t.
+struct AnimationKeyPosition
+{
+    int index = -1; // -1 if the curve has no keys
+    float t = 0.0f;
+
+    // times: n floats with stride bytes
+    static AnimationKeyPosition find(const void *times, size_t stride, size_t n, float time);
+};
+
+struct AnimationOptimizeSettings
+{
+    bool collapse_constant_curves = true; // reduce constant curves to first and last keys
+    bool erase_static_curves = true; // erase constant curves that are identical to the rest pose
+    bool share_identical_curves = true; // identical curves share data and it is sent only once
+    float eps = muEpsilon;
+};
+
 // this class holds untyped raw animation samples.
 // TAnimationCurve<> handle typed data operations.
 class AnimationCurve
@@ -37,6 +86,7 @@ public:
         uint32_t affect_handedness : 1; // for TRS values
         uint32_t ignore_negate : 1; // for scale values
         uint32_t force_constant : 1; // force constant interpolation. e.g. bool curves
+        uint32_t shared_times : 1; // times are equal to the host Animation's. only values are serialized
     };
 
     // serializable
@@ -44,8 +94,12 @@ public:
     SharedVector<char> data;
     DataType data_type = DataType::Unknown;
     DataFlags data_flags = {};
+    // if valid, data is shared with the data_ref-th curve of the AnimationClip (counted across all animations)
+    // and not serialized. AnimationClip::deserialize() restores it.
+    int data_ref = InvalidID;
 
     // non-serializable
+    AnimationCurveKey key = AnimationCurveKey::Unknown;
     std::vector<RawVector<char>> idata; // used in msUnitySpecific.cpp
 
 protected:
@@ -57,11 +111,16 @@ public:
 
     void serialize(std::ostream& os) const;
     void deserialize(std::istream& is);
+    // times: shared time base of the host Animation
+    void serialize(std::ostream& os, const SharedVector<float>& times) const;
+    void deserialize(std::istream& is, const SharedVector<float>& times);
     void clear();
     uint64_t hash() const;
     uint64_t checksum() const;
+    std::shared_ptr<AnimationCurve> clone() const; // data is copied
 
     size_t size() const;
+    size_t keySize() const; // sizeof(TVP<T>)
     bool empty() const;
 
     template<class T> TVP<T>& at(size_t i);
@@ -77,6 +136,19 @@ public:
     }
 
     void reserve(size_t size);
+
+    // v must be the value type of data_type
+    bool nearEqualAll(const void *v, float eps = muEpsilon) const;
+    // reduce to first and last keys if all keys have the same value. return true if collapsed
+    bool collapse(float eps = muEpsilon);
+    bool timesEqual(const float *times, size_t n) const;
+    // replace keys in range with keys of src. src must have the same data_type
+    void replaceKeys(const AnimationTimeRange& range, const AnimationCurve& src);
+
+    AnimationKeyPosition findKey(float time) const;
+    // dst must be the value type of data_type
+    void evaluate(const AnimationKeyPosition& pos, void *dst) const;
+    void evaluate(float time, void *dst) const;
 };
 msSerializable(AnimationCurve);
 msDeclPtr(AnimationCurve);
@@ -95,11 +167,15 @@ class Animation
 {
 public:
     using DataType = AnimationCurve::DataType;
+    using Key = AnimationCurveKey;
 
     // serializable
     EntityType entity_type = EntityType::Unknown;
     std::string path;
     std::vector<AnimationCurvePtr> curves; // sorted vector
+    // shared time base. curves with data_flags.shared_times have exactly these times.
+    // serialize() builds it from the curves. deserialize() keeps it for evaluate().
+    SharedVector<float> times;
 
 protected:
     Animation();
@@ -112,6 +188,7 @@ public:
     void clear();
     uint64_t hash() const;
     uint64_t checksum() const;
+    std::shared_ptr<Animation> clone() const;
     bool empty() const;
     void reserve(size_t n);
 
@@ -120,17 +197,50 @@ public:
     AnimationCurvePtr findCurve(const std::string& name) const;
     AnimationCurvePtr findCurve(const char *name, DataType type) const;
     AnimationCurvePtr findCurve(const std::string& name, DataType type) const;
+    // O(1). no string comparison
+    AnimationCurvePtr findCurve(Key key) const;
+    AnimationCurvePtr findCurve(Key key, DataType type) const;
     // erase old one if already exists
     AnimationCurvePtr addCurve(const char *name, DataType type);
     AnimationCurvePtr addCurve(const std::string& name, DataType type);
+    AnimationCurvePtr addCurve(Key key, DataType type);
     // find or create curve
     AnimationCurvePtr getCurve(const char *name, DataType type);
     AnimationCurvePtr getCurve(const std::string& name, DataType type);
+    AnimationCurvePtr getCurve(Key key, DataType type);
 
     bool eraseCurve(const AnimationCurve *curve);
     void clearEmptyCurves();
+    // rest: the entity at the same path. curves identical to its TRS & visibility are erased
+    void optimize(const AnimationOptimizeSettings& settings, const Transform *rest = nullptr);
 
     static void validate(std::shared_ptr<Animation>& anim);
+
+    // evaluate all curves at time. the key is searched once in times for all curves with data_flags.shared_times.
+    // body: [](const AnimationCurve& curve, const void *value) -> void. value is of curve.data_type
+    template<class Body>
+    void evaluate(float time, const Body& body) const
+    {
+        auto shared = AnimationKeyPosition::find(times.cdata(), sizeof(float), times.size(), time);
+        float4 value; // large enough for any data type
+        for (auto& curve : curves) {
+            if (curve->empty())
+                continue;
+            if (curve->data_flags.shared_times && curve->size() == times.size())
+                curve->evaluate(shared, &value);
+            else
+                curve->evaluate(time, &value);
+            body(*curve, &value);
+        }
+    }
+
+protected:
+    AnimationCurvePtr addCurveImpl(const char *name, Key key, DataType type, bool clear_existing);
+    void updateKeyIndex();
+    void buildSharedTimes(SharedVector<float>& dst) const;
+
+    // non-serializable
+    AnimationCurvePtr m_key_curves[(int)Key::Count];
 };
 msSerializable(Animation);
 msDeclPtr(Animation);
@@ -204,6 +314,7 @@ class TransformAnimation
 {
 public:
     using DataType = AnimationCurve::DataType;
+    using Key = AnimationCurveKey;
 
     static std::shared_ptr<TransformAnimation> create(AnimationPtr host = nullptr);
 
@@ -324,14 +435,64 @@ public:
     void clear() override;
     uint64_t hash() const override;
     uint64_t checksum() const override;
+    std::shared_ptr<AnimationClip> clone() const;
 
     bool empty() const;
     void addAnimation(AnimationPtr v);
     void addAnimation(TransformAnimationPtr v);
 
     void clearEmptyAnimations();
+
+    // must be called right before serialization. curves may be erased and TransformAnimation etc. become invalid.
+    // rests: entities that have the rest poses. matched by path.
+    void optimize(const AnimationOptimizeSettings& settings, const std::vector<TransformPtr>& rests = {});
+
+protected:
+    void shareIdenticalCurves();
+    void resolveDataRefs();
 };
 msSerializable(AnimationClip);
 msDeclPtr(AnimationClip);
 
+
+// time range of a curve to be replaced. the curve is identified by the path of its Animation and its name.
+struct AnimationCurveRange
+{
+    std::string path;
+    std::string curve;
+    AnimationTimeRange range;
+
+    void serialize(std::ostream& os) const;
+    void deserialize(std::istream& is);
+};
+msSerializable(AnimationCurveRange);
+
+// partial update of an AnimationClip.
+// keys of the target curve in its range are replaced by the keys of the curve with the same path and name in clip.
+class AnimationClipDelta
+{
+public:
+    // serializable
+    AnimationClipPtr clip; // has the same id (or name if id is invalid) as the target clip
+    std::vector<AnimationCurveRange> ranges; // curves of clip without a range replace the span of their own keys
+
+    // non-serializable
+    // the updated curves of the target clip. set by the receiver after apply()
+    AnimationClipPtr merged;
+
+public:
+    AnimationClipDelta();
+    void serialize(std::ostream& os) const;
+    void deserialize(std::istream& is);
+
+    bool isTarget(const AnimationClip& v) const;
+    const AnimationCurveRange* findRange(const std::string& path, const std::string& curve) const;
+    // animations and curves that don't exist in dst are added.
+    // if updated is not null, copies of the updated curves of dst are added to it.
+    void apply(AnimationClip& dst, AnimationClip *updated = nullptr) const;
+    // union of ranges
+    AnimationTimeRange getTimeRange() const;
+};
+msSerializable(AnimationClipDelta);
+
 } // namespace ms
@@ -13,6 +13,19 @@ static_assert(sizeof(LightDataFlags) == sizeof(uint32_t), "");
 
 #define CopyMember(V) V = base.V;
 
+CubicLerpParams CubicLerpParams::create(float t0, float t1, float t2, float t3, float time)
+{
+    CubicLerpParams ret;
+    ret.dt = t2 - t1;
+    ret.t = ret.dt > 0.0f ? (time - t1) / ret.dt : 0.0f;
+    if (t2 - t0 > 0.0f)
+        ret.s1 = ret.dt / (t2 - t0);
+    if (t3 - t1 > 0.0f)
+        ret.s2 = ret.dt / (t3 - t1);
+    return ret;
+}
+
+
 // Entity
 #pragma region Entity
 std::shared_ptr<Entity> Entity::create(std::istream& is)
@@ -119,6 +132,11 @@ bool Entity::lerp(const Entity& s1, const Entity& s2, float /*t*/)
     return true;
 }
 
+bool Entity::cubicLerp(const Entity& /*e0*/, const Entity& e1, const Entity& e2, const Entity& /*e3*/, const CubicLerpParams& p)
+{
+    return lerp(e1, e2, p.t);
+}
+
 void Entity::updateBounds()
 {
 }
@@ -362,6 +380,21 @@ bool Transform::lerp(const Entity& e1_, const Entity& e2_, float t)
     return true;
 }
 
+bool Transform::cubicLerp(const Entity& e0_, const Entity& e1_, const Entity& e2_, const Entity& e3_, const CubicLerpParams& p)
+{
+    // lerp() of the actual type interpolates everything linearly. derived classes refine their data after this.
+    if (!lerp(e1_, e2_, p.t))
+        return false;
+    auto& e0 = static_cast<const Transform&>(e0_);
+    auto& e1 = static_cast<const Transform&>(e1_);
+    auto& e2 = static_cast<const Transform&>(e2_);
+    auto& e3 = static_cast<const Transform&>(e3_);
+
+    position = mu::catmull_rom(e0.position, e1.position, e2.position, e3.position, p.t, p.s1, p.s2);
+    scale = mu::catmull_rom(e0.scale, e1.scale, e2.scale, e3.scale, p.t, p.s1, p.s2);
+    return true;
+}
+
 void Transform::clear()
 {
     super::clear();
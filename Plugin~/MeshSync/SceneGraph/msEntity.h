@@ -31,6 +31,18 @@ template<> struct GetEntityType<Points>     { static const EntityType type = Ent
 class EntityConverter;
 msDeclPtr(EntityConverter);
 
+// cubic interpolation between 2 frames (see Entity::cubicLerp())
+struct CubicLerpParams
+{
+    float t = 0.0f;     // 0.0 - 1.0 between the 2 frames
+    float dt = 0.0f;    // time between the 2 frames. velocities are per second.
+    float s1 = 0.5f;    // tangent scales for catmull_rom(). 0.5 if the frames are evenly spaced.
+    float s2 = 0.5f;
+
+    // times of 4 frames. the 2 frames to interpolate are t1 and t2.
+    static CubicLerpParams create(float t0, float t1, float t2, float t3, float time);
+};
+
 class Entity
 {
 public:
@@ -67,6 +79,9 @@ public:
     virtual bool merge(const Entity& base);
     virtual bool diff(const Entity& e1, const Entity& e2);
     virtual bool lerp(const Entity& e1, const Entity& e2, float t);
+    // e0 and e3 are the neighbours of e1 and e2. pass e1 and e2 themselves if there are no neighbours.
+    // falls back to lerp() by default.
+    virtual bool cubicLerp(const Entity& e0, const Entity& e1, const Entity& e2, const Entity& e3, const CubicLerpParams& p);
     virtual void updateBounds();
     virtual bool genVelocity(const Entity& prev); // todo
 
@@ -155,6 +170,7 @@ public:
     bool merge(const Entity& base) override;
     bool diff(const Entity& e1, const Entity& e2) override;
     bool lerp(const Entity& src1, const Entity& src2, float t) override;
+    bool cubicLerp(const Entity& e0, const Entity& e1, const Entity& e2, const Entity& e3, const CubicLerpParams& p) override;
 
     void clear() override;
     uint64_t checksumTrans() const override;
@@ -288,7 +288,7 @@ void FlipYZ_ZUpCorrector::convert(Animation &anim)
             break;
         case Animation::DataType::Quaternion:
             c.each<quatf>([&](auto& v) { v.value = flip_z(swap_yz(v.value)); });
-            if ((anim.entity_type == EntityType::Camera || anim.entity_type == EntityType::Light) && c.name == mskTransformRotation) {
+            if ((anim.entity_type == EntityType::Camera || anim.entity_type == EntityType::Light) && c.key == AnimationCurveKey::TransformRotation) {
                 const quatf cr = rotate_x(-90.0f * DegToRad);
                 c.each<quatf>([&](auto& v) {
                     v.value *= cr;
@@ -373,4 +373,27 @@ void RotateX_ZUpCorrector::convertAnimationCurve(AnimationCurve &c)
     }
 }
 
+
+std::vector<EntityConverterPtr> CreateEntityConverters(const SceneSettings& settings, const SceneImportSettings& cv)
+{
+    bool flip_x = settings.handedness == Handedness::Right || settings.handedness == Handedness::RightZUp;
+    bool swap_yz = settings.handedness == Handedness::LeftZUp || settings.handedness == Handedness::RightZUp;
+
+    std::vector<EntityConverterPtr> ret;
+    if (settings.scale_factor != 1.0f) {
+        float scale = 1.0f / settings.scale_factor;
+        ret.push_back(ScaleConverter::create(scale));
+    }
+    if (flip_x) {
+        ret.push_back(FlipX_HandednessCorrector::create());
+    }
+    if (swap_yz) {
+        if (cv.zup_correction_mode == ZUpCorrectionMode::FlipYZ)
+            ret.push_back(FlipYZ_ZUpCorrector::create());
+        else if (cv.zup_correction_mode == ZUpCorrectionMode::RotateX)
+            ret.push_back(RotateX_ZUpCorrector::create());
+    }
+    return ret;
+}
+
 } // namespace ms
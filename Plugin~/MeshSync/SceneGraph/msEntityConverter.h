@@ -10,6 +10,8 @@ class Mesh;
 class Points;
 class Animation;
 class AnimationCurve;
+struct SceneSettings;
+struct SceneImportSettings;
 
 class EntityConverter
 {
@@ -104,4 +106,8 @@ public:
 };
 msDeclPtr(RotateX_ZUpCorrector);
 
+
+// converters from the space of settings (scale_factor & handedness) to Unity's
+std::vector<EntityConverterPtr> CreateEntityConverters(const SceneSettings& settings, const SceneImportSettings& cv);
+
 } // namespace ms
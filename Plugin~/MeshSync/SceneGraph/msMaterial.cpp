@@ -45,6 +45,14 @@ MaterialProperty& MaterialProperty::operator=(MaterialProperty&& v)
     data = std::move(v.data);
     return *this;
 }
+MaterialProperty MaterialProperty::clone() const
+{
+    MaterialProperty ret;
+    ret.name = name;
+    ret.type = type;
+    ret.data.assign(data.cdata(), data.cdata() + data.size());
+    return ret;
+}
 
 template<class T>
 static inline void set_impl(SharedVector<char>& dst, const T& v)
@@ -197,6 +205,10 @@ MaterialKeyword& MaterialKeyword::operator=(MaterialKeyword&& v)
     value = std::move(v.value);
     return *this;
 }
+MaterialKeyword MaterialKeyword::clone() const
+{
+    return MaterialKeyword(name.c_str(), value);
+}
 
 
 
@@ -224,6 +236,7 @@ void Material::deserialize(std::istream& is)
 {
     super::deserialize(is);
     EachMember(msRead);
+    buildIndices();
 }
 
 void Material::clear()
@@ -233,6 +246,7 @@ void Material::clear()
     shader.clear();
     properties.clear();
     keywords.clear();
+    clearIndices();
 }
 
 uint64_t Material::hash() const
@@ -264,6 +278,23 @@ bool Material::operator!=(const Material& v) const
     return !(*this == v);
 }
 
+std::shared_ptr<Material> Material::clone() const
+{
+    auto ret = create();
+    ret->id = id;
+    ret->name = name;
+    ret->index = index;
+    ret->shader = shader;
+    ret->properties.reserve(properties.size());
+    for (auto& prop : properties)
+        ret->properties.push_back(prop.clone());
+    ret->keywords.reserve(keywords.size());
+    for (auto& kw : keywords)
+        ret->keywords.push_back(kw.clone());
+    ret->buildIndices();
+    return ret;
+}
+
 int Material::getPropertyCount() const
 {
     return (int)properties.size();
@@ -274,8 +305,7 @@ MaterialProperty* Material::getProperty(int i)
 }
 MaterialProperty* Material::findProperty(const char *n)
 {
-    auto it = std::find_if(properties.begin(), properties.end(), [n](const MaterialProperty& v) { return v.name == n; });
-    return it != properties.end() ? &(*it) : nullptr;
+    return findImpl(properties, m_property_index, n);
 }
 const MaterialProperty* Material::getProperty(int i) const
 {
@@ -283,22 +313,17 @@ const MaterialProperty* Material::getProperty(int i) const
 }
 const MaterialProperty* Material::findProperty(const char *n) const
 {
-    return const_cast<Material*>(this)->findProperty(n);
+    return findConstImpl(properties, m_property_index, n);
 }
 
 void Material::addProperty(MaterialProperty&& v)
 {
-    if (auto *p = findProperty(v.name.c_str()))
-        *p = std::move(v);
-    else
-        properties.emplace_back(std::move(v));
+    addImpl(properties, m_property_index, std::move(v));
 }
 
 void Material::eraseProperty(const char *n)
 {
-    auto it = std::find_if(properties.begin(), properties.end(), [n](const MaterialProperty& v) { return v.name == n; });
-    if (it != properties.end())
-        properties.erase(it);
+    eraseImpl(properties, m_property_index, n);
 }
 
 int Material::getKeywordCount() const
@@ -311,8 +336,7 @@ MaterialKeyword* Material::getKeyword(int i)
 }
 MaterialKeyword* Material::findKeyword(const char *n)
 {
-    auto it = std::find_if(keywords.begin(), keywords.end(), [n](const MaterialKeyword& v) { return v.name == n; });
-    return it != keywords.end() ? &(*it) : nullptr;
+    return findImpl(keywords, m_keyword_index, n);
 }
 const MaterialKeyword* Material::getKeyword(int i) const
 {
@@ -320,20 +344,107 @@ const MaterialKeyword* Material::getKeyword(int i) const
 }
 const MaterialKeyword* Material::findKeyword(const char *n) const
 {
-    return const_cast<Material*>(this)->findKeyword(n);
+    return findConstImpl(keywords, m_keyword_index, n);
 }
 void Material::addKeyword(MaterialKeyword&& v)
 {
-    if (auto *p = findKeyword(v.name.c_str()))
-        *p = std::move(v);
-    else
-        keywords.emplace_back(std::move(v));
+    addImpl(keywords, m_keyword_index, std::move(v));
 }
 void Material::eraseKeyword(const char *n)
 {
-    auto it = std::find_if(keywords.begin(), keywords.end(), [n](const MaterialKeyword& v) { return v.name == n; });
-    if (it != keywords.end())
-        keywords.erase(it);
+    eraseImpl(keywords, m_keyword_index, n);
+}
+
+void Material::clearIndices()
+{
+    m_property_index = {};
+    m_keyword_index = {};
+}
+
+void Material::buildIndices()
+{
+    buildIndex(properties, m_property_index);
+    buildIndex(keywords, m_keyword_index);
+}
+
+void Material::merge(const Material& v)
+{
+    for (auto& prop : v.properties)
+        addProperty(prop.clone());
+    for (auto& kw : v.keywords)
+        addKeyword(kw.clone());
+}
+
+template<class T>
+void Material::buildIndex(const std::vector<T>& cont, NameIndex& index)
+{
+    index.table.clear();
+    index.table.reserve(cont.size());
+    // emplace() keeps the first one on duplicated names. same as linear search
+    for (size_t i = 0; i < cont.size(); ++i)
+        index.table.emplace(cont[i].name, (int)i);
+    index.data = cont.data();
+    index.size = cont.size();
+}
+
+template<class T>
+T* Material::findImpl(std::vector<T>& cont, NameIndex& index, const char *n)
+{
+    if (index.data != cont.data() || index.size != cont.size())
+        buildIndex(cont, index);
+
+    auto it = index.table.find(n);
+    if (it == index.table.end())
+        return nullptr;
+    auto& r = cont[it->second];
+    if (r.name != n) {
+        // renamed in place. rebuild and retry
+        index.data = nullptr;
+        return findImpl(cont, index, n);
+    }
+    return &r;
+}
+
+template<class T>
+const T* Material::findConstImpl(const std::vector<T>& cont, const NameIndex& index, const char *n)
+{
+    if (index.data == cont.data() && index.size == cont.size()) {
+        auto it = index.table.find(n);
+        if (it == index.table.end())
+            return nullptr;
+        auto& r = cont[it->second];
+        if (r.name == n)
+            return &r;
+        // renamed in place. fall through to linear search
+    }
+    for (auto& r : cont) {
+        if (r.name == n)
+            return &r;
+    }
+    return nullptr;
+}
+
+template<class T>
+void Material::addImpl(std::vector<T>& cont, NameIndex& index, T&& v)
+{
+    if (auto *p = findImpl(cont, index, v.name.c_str())) {
+        *p = std::move(v);
+        return;
+    }
+    // findImpl() has made the index up to date. keep it valid instead of rebuilding on next lookup
+    cont.emplace_back(std::move(v));
+    index.table.emplace(cont.back().name, (int)cont.size() - 1);
+    index.data = cont.data();
+    index.size = cont.size();
+}
+
+template<class T>
+void Material::eraseImpl(std::vector<T>& cont, NameIndex& index, const char *n)
+{
+    if (auto *p = findImpl(cont, index, n)) {
+        cont.erase(cont.begin() + (p - cont.data()));
+        index.data = nullptr;
+    }
 }
 
 } // namespace ms
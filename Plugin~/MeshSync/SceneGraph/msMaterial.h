@@ -1,5 +1,6 @@
 #pragma once
 
+#include <unordered_map>
 #include "msTexture.h"
 
 namespace ms {
@@ -43,6 +44,7 @@ public:
     MaterialProperty();
     MaterialProperty(MaterialProperty&& v) noexcept; // noexcept to enforce std::vector to use move constructor
     MaterialProperty& operator=(MaterialProperty&& v);
+    MaterialProperty clone() const; // deep copy. copy constructor is intentionally not provided
 
     // T accepts int, float, float{2,3,4, 2x2, 3x3, 4x4} and TexturePtr/TextureRecord
     // note: float{2,3} are converted to float4 and float{2x2,3x3} are converted to float4x4 internally
@@ -80,6 +82,7 @@ public:
     MaterialKeyword(const char *n, bool v);
     MaterialKeyword(MaterialKeyword&& v) noexcept; // noexcept to enforce std::vector to use move constructor
     MaterialKeyword& operator=(MaterialKeyword&& v);
+    MaterialKeyword clone() const;
 };
 msSerializable(MaterialKeyword);
 
@@ -110,6 +113,7 @@ public:
     uint64_t checksum() const override;
     bool operator==(const Material& v) const;
     bool operator!=(const Material& v) const;
+    std::shared_ptr<Material> clone() const; // deep copy
 
     int getPropertyCount() const;
     MaterialProperty* getProperty(int i);
@@ -126,6 +130,32 @@ public:
     const MaterialKeyword* findKeyword(const char *name) const;
     void addKeyword(MaterialKeyword&& v);
     void eraseKeyword(const char *name);
+
+    // find*(), add*() and erase*() look up names via hash tables. these are rebuilt lazily by the non-const
+    // functions when properties or keywords are resized or reallocated. call clearIndices() after renaming elements in place.
+    // const find*() never modify the tables (they fall back to linear search if the tables are out of date),
+    // so they are safe to call from multiple threads. deserialize() and clone() build the tables.
+    void clearIndices();
+    void buildIndices();
+
+    // properties and keywords of v overwrite the ones with the same name. others are kept.
+    void merge(const Material& v);
+
+private:
+    struct NameIndex
+    {
+        const void *data = nullptr;
+        size_t size = 0;
+        std::unordered_map<std::string, int> table;
+    };
+    template<class T> static void buildIndex(const std::vector<T>& cont, NameIndex& index);
+    template<class T> static T* findImpl(std::vector<T>& cont, NameIndex& index, const char *name);
+    template<class T> static const T* findConstImpl(const std::vector<T>& cont, const NameIndex& index, const char *name);
+    template<class T> void addImpl(std::vector<T>& cont, NameIndex& index, T&& v);
+    template<class T> void eraseImpl(std::vector<T>& cont, NameIndex& index, const char *name);
+
+    NameIndex m_property_index;
+    NameIndex m_keyword_index;
 };
 msSerializable(Material);
 msDeclPtr(Material);
@@ -239,20 +239,126 @@ void BoneData::clear()
 #define EachTopologyAttribute(F)\
     F(counts) F(indices) F(material_ids)
 
+#define EachReducibleAttribute(F)\
+    F(points) F(normals) F(tangents) F(uv0) F(uv1)
+
 #define EachVertexAttribute(F)\
-    F(points) F(normals) F(tangents) F(uv0) F(uv1) F(colors) F(velocities)
+    EachReducibleAttribute(F) F(colors) F(velocities)
 
 #define EachGeometryAttribute(F)\
     EachVertexAttribute(F) EachTopologyAttribute(F)
 
+#define EachNonReducibleMember(F)\
+    F(colors) F(velocities) EachTopologyAttribute(F) F(root_bone) F(bones) F(blendshapes) F(submeshes) F(bounds)
+
 #define EachMember(F)\
-    F(refine_settings) EachGeometryAttribute(F) F(root_bone) F(bones) F(blendshapes) F(submeshes) F(bounds)
+    F(refine_settings) EachReducibleAttribute(F) EachNonReducibleMember(F)
 
 Mesh::Mesh() { clear(); }
 Mesh::~Mesh() {}
 EntityType Mesh::getType() const { return Type::Mesh; }
 bool Mesh::isGeometry() const { return true; }
 
+// reduced precision encodings of vertex attributes. see MeshPrecision
+template<class Packed, class T>
+static void WritePacked(std::ostream& os, const SharedVector<T>& src)
+{
+    SharedVector<Packed> packed;
+    packed.resize_discard(src.size());
+    enumerate(packed, src, [](Packed& d, const T& s) { d = to<Packed>(s); });
+    write(os, packed);
+}
+
+template<class Packed, class T>
+static void ReadPacked(std::istream& is, SharedVector<T>& dst)
+{
+    SharedVector<Packed> packed;
+    read(is, packed);
+    dst.resize_discard(packed.size());
+    enumerate(dst, packed, [](T& d, const Packed& s) { d = to<T>(s); });
+}
+
+template<class Packed, class T>
+static void WriteBounded(std::ostream& os, const SharedVector<T>& src)
+{
+    T bmin = T::zero(), bmax = T::zero();
+    if (!src.empty())
+        MinMax(src.cdata(), src.size(), bmin, bmax);
+
+    // flat components (e.g. z of a plane) are encoded as 0
+    auto size = bmax - bmin;
+    T rsize;
+    for (int i = 0; i < T::vector_length; ++i)
+        rsize[i] = size[i] > 0.0f ? 1.0f / size[i] : 0.0f;
+
+    SharedVector<Packed> packed;
+    packed.resize_discard(src.size());
+    enumerate(packed, src, [bmin, rsize](Packed& d, const T& s) { d = to<Packed>((s - bmin) * rsize); });
+    write(os, bmin);
+    write(os, bmax);
+    write(os, packed);
+}
+
+template<class Packed, class T>
+static void ReadBounded(std::istream& is, SharedVector<T>& dst)
+{
+    T bmin, bmax;
+    SharedVector<Packed> packed;
+    read(is, bmin);
+    read(is, bmax);
+    read(is, packed);
+
+    auto size = bmax - bmin;
+    dst.resize_discard(packed.size());
+    enumerate(dst, packed, [bmin, size](T& d, const Packed& s) { d = to<T>(s) * size + bmin; });
+}
+
+// points and normals
+static void WriteReduced(std::ostream& os, const SharedVector<float3>& v, MeshPrecision precision, bool direction)
+{
+    if (!direction)
+        WriteBounded<unorm16x3>(os, v);
+    else if (precision == MeshPrecision::Bounded)
+        WritePacked<half3>(os, v);
+    else
+        WritePacked<snormx3_32>(os, v);
+}
+static void ReadReduced(std::istream& is, SharedVector<float3>& v, MeshPrecision precision, bool direction)
+{
+    if (!direction)
+        ReadBounded<unorm16x3>(is, v);
+    else if (precision == MeshPrecision::Bounded)
+        ReadPacked<half3>(is, v);
+    else
+        ReadPacked<snormx3_32>(is, v);
+}
+
+// tangents
+static void WriteReduced(std::ostream& os, const SharedVector<float4>& v, MeshPrecision precision)
+{
+    if (precision == MeshPrecision::Bounded)
+        WritePacked<half4>(os, v);
+    else
+        WritePacked<snormx3_32>(os, v);
+}
+static void ReadReduced(std::istream& is, SharedVector<float4>& v, MeshPrecision precision)
+{
+    if (precision == MeshPrecision::Bounded)
+        ReadPacked<half4>(is, v);
+    else
+        ReadPacked<snormx3_32>(is, v);
+}
+
+// uv
+static void WriteReduced(std::ostream& os, const SharedVector<float2>& v, MeshPrecision /*precision*/)
+{
+    WriteBounded<unorm16x2>(os, v);
+}
+static void ReadReduced(std::istream& is, SharedVector<float2>& v, MeshPrecision /*precision*/)
+{
+    ReadBounded<unorm16x2>(is, v);
+}
+
 void Mesh::serialize(std::ostream& os) const
 {
     super::serialize(os);
@@ -261,7 +367,19 @@ void Mesh::serialize(std::ostream& os) const
         return;
 
 #define Body(V) if(md_flags.has_##V) write(os, V);
-    EachMember(Body);
+    auto precision = (MeshPrecision)md_flags.precision;
+    if (precision == MeshPrecision::Full) {
+        EachMember(Body);
+    }
+    else {
+        Body(refine_settings);
+        if (md_flags.has_points) WriteReduced(os, points, precision, false);
+        if (md_flags.has_normals) WriteReduced(os, normals, precision, true);
+        if (md_flags.has_tangents) WriteReduced(os, tangents, precision);
+        if (md_flags.has_uv0) WriteReduced(os, uv0, precision);
+        if (md_flags.has_uv1) WriteReduced(os, uv1, precision);
+        EachNonReducibleMember(Body);
+    }
 #undef Body
 }
 
@@ -273,7 +391,19 @@ void Mesh::deserialize(std::istream& is)
         return;
 
 #define Body(V) if(md_flags.has_##V) read(is, V);
-    EachMember(Body);
+    auto precision = (MeshPrecision)md_flags.precision;
+    if (precision == MeshPrecision::Full) {
+        EachMember(Body);
+    }
+    else {
+        Body(refine_settings);
+        if (md_flags.has_points) ReadReduced(is, points, precision, false);
+        if (md_flags.has_normals) ReadReduced(is, normals, precision, true);
+        if (md_flags.has_tangents) ReadReduced(is, tangents, precision);
+        if (md_flags.has_uv0) ReadReduced(is, uv0, precision);
+        if (md_flags.has_uv1) ReadReduced(is, uv1, precision);
+        EachNonReducibleMember(Body);
+    }
 #undef Body
 
     bones.erase(
@@ -431,6 +561,30 @@ bool Mesh::lerp(const Entity& e1_, const Entity& e2_, float t)
     return true;
 }
 
+bool Mesh::cubicLerp(const Entity& e0_, const Entity& e1_, const Entity& e2_, const Entity& e3_, const CubicLerpParams& p)
+{
+    if (!super::cubicLerp(e0_, e1_, e2_, e3_, p))
+        return false;
+    auto& e0 = static_cast<const Mesh&>(e0_);
+    auto& e1 = static_cast<const Mesh&>(e1_);
+    auto& e2 = static_cast<const Mesh&>(e2_);
+    auto& e3 = static_cast<const Mesh&>(e3_);
+
+    // other attributes are left linearly interpolated
+    size_t n = points.size();
+    if (e1.velocities.size() == n && e2.velocities.size() == n) {
+        Hermite(points.data(), e1.points.cdata(), e2.points.cdata(), e1.velocities.cdata(), e2.velocities.cdata(), n, p.t, p.dt);
+    }
+    else {
+        // neighbours with different topology are not usable
+        auto& p0 = e0.points.size() == n ? e0.points : e1.points;
+        auto& p3 = e3.points.size() == n ? e3.points : e2.points;
+        CatmullRom(points.data(), p0.cdata(), e1.points.cdata(), e2.points.cdata(), p3.cdata(), n, p.t, p.s1, p.s2);
+    }
+    updateBounds();
+    return true;
+}
+
 void Mesh::updateBounds()
 {
     float3 bmin, bmax;
@@ -469,7 +623,12 @@ uint64_t Mesh::hash() const
 {
     uint64_t ret = super::hash();
 #define Body(A) ret += vhash(A);
-    EachGeometryAttribute(Body);
+    // reduced precision attributes are not restored bit-exactly
+    if ((MeshPrecision)md_flags.precision == MeshPrecision::Full) {
+        EachReducibleAttribute(Body);
+    }
+    Body(colors) Body(velocities);
+    EachTopologyAttribute(Body);
 #undef Body
 
     // bones
@@ -532,8 +691,10 @@ EntityPtr Mesh::clone(bool detach_)
 }
 
 #undef EachTopologyAttribute
+#undef EachReducibleAttribute
 #undef EachVertexAttribute
 #undef EachGeometryAttribute
+#undef EachNonReducibleMember
 #undef EachMember
 
 template<class C1, class C2, class C3>
@@ -1308,4 +1469,105 @@ BlendShapeDataPtr Mesh::addBlendShape(const std::string& _name)
 }
 #pragma endregion
 
+
+#pragma region MeshDescriptor
+size_t MeshDescriptorTable::build(const Mesh& mesh)
+{
+    const Mesh *meshes[] = { &mesh };
+    return buildImpl(meshes, 1);
+}
+
+size_t MeshDescriptorTable::build(const Scene& scene)
+{
+    std::vector<const Mesh*> meshes;
+    meshes.reserve(scene.entities.size());
+    for (auto& e : scene.entities) {
+        if (e->getType() == EntityType::Mesh)
+            meshes.push_back(static_cast<const Mesh*>(e.get()));
+    }
+    return buildImpl(meshes.data(), meshes.size());
+}
+
+void MeshDescriptorTable::clear()
+{
+    m_descriptors.clear();
+    m_bone_paths.clear();
+}
+
+size_t MeshDescriptorTable::size() const
+{
+    return m_descriptors.size();
+}
+
+const MeshDescriptor* MeshDescriptorTable::data() const
+{
+    return m_descriptors.data();
+}
+
+size_t MeshDescriptorTable::buildImpl(const Mesh * const *meshes, size_t num_meshes)
+{
+    // bone paths of all meshes are stored in one array. size it first so that pointers to it stay valid.
+    size_t num_bones = 0;
+    for (size_t mi = 0; mi < num_meshes; ++mi)
+        num_bones += meshes[mi]->bones.size();
+    m_bone_paths.resize(num_bones);
+    m_descriptors.resize(num_meshes);
+
+    size_t bone_offset = 0;
+    for (size_t mi = 0; mi < num_meshes; ++mi) {
+        auto& mesh = *meshes[mi];
+        auto& dst = m_descriptors[mi];
+        dst.mesh = &mesh;
+        dst.points = mesh.points.cdata();
+        dst.normals = mesh.normals.cdata();
+        dst.tangents = mesh.tangents.cdata();
+        dst.uv0 = mesh.uv0.cdata();
+        dst.uv1 = mesh.uv1.cdata();
+        dst.colors = mesh.colors.cdata();
+        dst.velocities = mesh.velocities.cdata();
+        dst.indices = mesh.indices.cdata();
+        dst.counts = mesh.counts.cdata();
+        dst.submeshes = mesh.submeshes.cdata();
+        dst.bone_counts = mesh.bone_counts.cdata();
+        dst.bone_weights = mesh.weights1.cdata();
+        dst.bone_weights4 = mesh.weights4.cdata();
+        dst.root_bone = mesh.root_bone.c_str();
+        dst.bone_paths = m_bone_paths.data() + bone_offset;
+        dst.bounds = mesh.bounds;
+        dst.flags = mesh.md_flags;
+        dst.num_points = (int)mesh.points.size();
+        dst.num_indices = (int)mesh.indices.size();
+        dst.num_counts = (int)mesh.counts.size();
+        dst.num_submeshes = (int)mesh.submeshes.size();
+        dst.num_bones = (int)mesh.bones.size();
+        dst.num_bone_weights = (int)mesh.bone_weight_count;
+        dst.num_blendshapes = (int)mesh.blendshapes.size();
+
+        for (auto& bone : mesh.bones)
+            m_bone_paths[bone_offset++] = bone->path.c_str();
+    }
+    return m_descriptors.size();
+}
+
+void MeshDescriptorTable::read(const MeshDescriptor& desc, const MeshBuffers& dst)
+{
+    auto& mesh = *desc.mesh;
+    if (dst.points) mesh.points.copy_to(dst.points);
+    if (dst.normals) mesh.normals.copy_to(dst.normals);
+    if (dst.tangents) mesh.tangents.copy_to(dst.tangents);
+    if (dst.uv0) mesh.uv0.copy_to(dst.uv0);
+    if (dst.uv1) mesh.uv1.copy_to(dst.uv1);
+    if (dst.colors) mesh.colors.copy_to(dst.colors);
+    if (dst.velocities) mesh.velocities.copy_to(dst.velocities);
+    if (dst.indices) mesh.indices.copy_to(dst.indices);
+    if (dst.bone_counts) mesh.bone_counts.copy_to(dst.bone_counts);
+    if (dst.bone_weights) mesh.weights1.copy_to(dst.bone_weights);
+    if (dst.bone_weights4) mesh.weights4.copy_to(dst.bone_weights4);
+    if (dst.bindposes) {
+        for (size_t bi = 0; bi < mesh.bones.size(); ++bi)
+            dst.bindposes[bi] = mesh.bones[bi]->bindpose;
+    }
+}
+#pragma endregion
+
 } // namespace ms
@@ -5,6 +5,17 @@ namespace ms {
 
 // Mesh
 
+// precision of points, normals, tangents and uv on the wire. other attributes are always sent as they are.
+// data are decoded to float on deserialization. levels are ordered from the largest and most accurate.
+// points and uv are quantized in their bounds rather than converted to half, because half has the same size
+// but loses accuracy away from the origin (about 0.06 at 100) and can't represent values beyond 65504.
+enum class MeshPrecision : uint32_t
+{
+    Full,
+    Bounded,        // points and uv: 16 bit per component in their bounds. normals and tangents: 16 bit floats
+    BoundedPacked,  // points and uv: same as Bounded. normals and tangents: 32 bit per vector
+};
+
 // must be synced with C# side
 struct MeshDataFlags
 {
@@ -28,6 +39,7 @@ struct MeshDataFlags
     uint32_t has_blendshape_weights : 1;
     uint32_t has_submeshes : 1;
     uint32_t has_bounds: 1;
+    uint32_t precision : 2;         // 20. MeshPrecision
 
     MeshDataFlags();
 };
@@ -226,6 +238,7 @@ public:
     bool merge(const Entity& base) override;
     bool diff(const Entity& e1, const Entity& e2) override;
     bool lerp(const Entity& e1, const Entity& e2, float t) override;
+    bool cubicLerp(const Entity& e0, const Entity& e1, const Entity& e2, const Entity& e3, const CubicLerpParams& p) override;
     void updateBounds() override;
 
     void clear() override;
@@ -250,4 +263,80 @@ public:
 msSerializable(Mesh);
 msDeclPtr(Mesh);
 
+
+// must be synced with C# side
+// flat view of a Mesh for the plugin API. lets the managed side get everything it needs to build a mesh in one call.
+// pointers refer to the Mesh's own buffers (null if empty) and bone_paths refers to MeshDescriptorTable's storage.
+// these are valid while both the Mesh and the table are alive and unmodified.
+// blendshapes are not flattened. use the per-blendshape API for them.
+struct MeshDescriptor
+{
+    const Mesh *mesh;
+    const float3 *points;
+    const float3 *normals;
+    const float4 *tangents;
+    const float2 *uv0;
+    const float2 *uv1;
+    const float4 *colors;
+    const float3 *velocities;
+    const int *indices;
+    const int *counts;
+    const SubmeshData *submeshes;   // num_submeshes
+    const uint8_t *bone_counts;     // per-vertex
+    const Weights1 *bone_weights;   // num_bone_weights
+    const Weights4 *bone_weights4;  // per-vertex
+    const char *root_bone;
+    const char * const *bone_paths; // num_bones
+    Bounds bounds;
+    MeshDataFlags flags;
+    int num_points;
+    int num_indices;
+    int num_counts;
+    int num_submeshes;
+    int num_bones;
+    int num_bone_weights;
+    int num_blendshapes;
+};
+
+// must be synced with C# side
+// destination of MeshDescriptorTable::read(). null buffers are skipped.
+// sizes are given by MeshDescriptor (per-vertex: num_points, indices: num_indices, bindposes: num_bones).
+struct MeshBuffers
+{
+    float3 *points;
+    float3 *normals;
+    float4 *tangents;
+    float2 *uv0;
+    float2 *uv1;
+    float4 *colors;
+    float3 *velocities;
+    int *indices;
+    uint8_t *bone_counts;
+    Weights1 *bone_weights;
+    Weights4 *bone_weights4;
+    float4x4 *bindposes;
+};
+
+class Scene;
+
+class MeshDescriptorTable
+{
+public:
+    // returns the number of descriptors. Scene version has one descriptor per Mesh in the order of scene.entities.
+    size_t build(const Mesh& mesh);
+    size_t build(const Scene& scene);
+    void clear();
+
+    size_t size() const;
+    const MeshDescriptor* data() const;
+
+    static void read(const MeshDescriptor& desc, const MeshBuffers& dst);
+
+private:
+    size_t buildImpl(const Mesh * const *meshes, size_t num_meshes);
+
+    std::vector<MeshDescriptor> m_descriptors;
+    std::vector<const char*> m_bone_paths;
+};
+
 } // namespace ms
@@ -151,6 +151,52 @@ bool Points::diff(const Entity&e1_, const Entity& e2_)
     return true;
 }
 
+static inline void LerpArray(float3 *dst, const float3 *src1, const float3 *src2, size_t num, float t) { Lerp(dst, src1, src2, num, t); }
+static inline void LerpArray(float4 *dst, const float4 *src1, const float4 *src2, size_t num, float t) { Lerp(dst, src1, src2, num, t); }
+static inline void LerpArray(quatf *dst, const quatf *src1, const quatf *src2, size_t num, float t) { Slerp(dst, src1, src2, num, t); }
+
+// match: index in a2 for each element of a1 (-1 if it has died). null if a1 and a2 are the same particles.
+// born: indices of a2 that have no match in a1. they are appended to the result.
+template<class T>
+static void LerpMatched(SharedVector<T>& dst, const SharedVector<T>& a1, const SharedVector<T>& a2,
+    size_t n1, size_t n2, const int *match, const RawVector<int>& born, float t)
+{
+    if (a1.size() != n1 || a2.size() != n2 || a1.empty()) {
+        // the attribute doesn't exist on one side
+        dst.clear();
+        return;
+    }
+
+    const int block_size = 4096;
+    dst.resize_discard(n1 + born.size());
+    T *d = dst.data();
+    const T *s1 = a1.cdata();
+    const T *s2 = a2.cdata();
+    parallel_for_blocked(0, (int)n1, block_size, [&](int begin, int end) {
+        size_t n = end - begin;
+        if (!match) {
+            LerpArray(d + begin, s1 + begin, s2 + begin, n, t);
+            return;
+        }
+        // gather the matched elements so that the lerp runs on contiguous data. dying particles are held.
+        RawVector<T> tmp;
+        tmp.resize_discard(n);
+        for (size_t i = 0; i < n; ++i) {
+            int mi = match[begin + i];
+            tmp[i] = mi >= 0 ? s2[mi] : s1[begin + i];
+        }
+        LerpArray(d + begin, s1 + begin, tmp.cdata(), n, t);
+    });
+    // newly born particles are held
+    for (size_t i = 0; i < born.size(); ++i)
+        d[n1 + i] = s2[born[i]];
+}
+
+static bool IsStrictlyAscending(const SharedVector<int>& ids)
+{
+    return std::adjacent_find(ids.begin(), ids.end(), [](int a, int b) { return a >= b; }) == ids.end();
+}
+
 bool Points::lerp(const Entity& e1_, const Entity& e2_, float t)
 {
     if (!super::lerp(e1_, e2_, t))
@@ -158,20 +204,102 @@ bool Points::lerp(const Entity& e1_, const Entity& e2_, float t)
     auto& e1 = static_cast<const Points&>(e1_);
     auto& e2 = static_cast<const Points&>(e2_);
 
-    if (e1.points.size() != e2.points.size() || e1.ids != e2.ids)
+    size_t n1 = e1.points.size();
+    size_t n2 = e2.points.size();
+    RawVector<int> match;
+    RawVector<int> born;
+
+    bool by_id = !e1.ids.empty() && !e2.ids.empty() && e1.ids != e2.ids;
+    if (by_id) {
+        if (e1.ids.size() != n1 || e2.ids.size() != n2)
+            return false;
+
+        // join by particle id
+        match.resize_discard(n1);
+        RawVector<bool> matched;
+        matched.resize_zeroclear(n2);
+        if (IsStrictlyAscending(e1.ids) && IsStrictlyAscending(e2.ids)) {
+            // merge join. particle systems usually give ids in order of birth.
+            size_t j = 0;
+            for (size_t i = 0; i < n1; ++i) {
+                int id = e1.ids[i];
+                while (j < n2 && e2.ids[j] < id)
+                    ++j;
+                if (j < n2 && e2.ids[j] == id) {
+                    match[i] = (int)j;
+                    matched[j] = true;
+                }
+                else
+                    match[i] = -1;
+            }
+        }
+        else {
+            // hash join
+            FlatHashMap<int, int> table;
+            table.reserve(n2);
+            for (size_t j = 0; j < n2; ++j)
+                table[e2.ids[j]] = (int)j;
+            for (size_t i = 0; i < n1; ++i) {
+                auto *j = table.find(e1.ids[i]);
+                match[i] = j ? *j : -1;
+                if (j)
+                    matched[*j] = true;
+            }
+        }
+        for (size_t j = 0; j < n2; ++j) {
+            if (!matched[j])
+                born.push_back((int)j);
+        }
+    }
+    else if (n1 != n2) {
         return false;
-#define DoLerp(N) N.resize_discard(e1.N.size()); Lerp(N.data(), e1.N.cdata(), e2.N.cdata(), N.size(), t)
-    DoLerp(points);
-    DoLerp(scales);
-    DoLerp(colors);
-    DoLerp(velocities);
-#undef DoLerp
-
-    rotations.resize_discard(e1.rotations.size());
-    enumerate(rotations, e1.rotations, e2.rotations, [t](quatf& v, const quatf& t1, const quatf& t2) {
-        v = mu::slerp(t1, t2, t);
-    });
+    }
 
+    const int *m = by_id ? match.cdata() : nullptr;
+    LerpMatched(points, e1.points, e2.points, n1, n2, m, born, t);
+    LerpMatched(rotations, e1.rotations, e2.rotations, n1, n2, m, born, t);
+    LerpMatched(scales, e1.scales, e2.scales, n1, n2, m, born, t);
+    LerpMatched(colors, e1.colors, e2.colors, n1, n2, m, born, t);
+    LerpMatched(velocities, e1.velocities, e2.velocities, n1, n2, m, born, t);
+    if (by_id) {
+        ids.resize_discard(n1 + born.size());
+        e1.ids.copy_to(ids.data());
+        for (size_t i = 0; i < born.size(); ++i)
+            ids[n1 + i] = e2.ids[born[i]];
+    }
+    else {
+        ids = e1.ids;
+    }
+
+    updateBounds();
+    return true;
+}
+
+bool Points::cubicLerp(const Entity& e0_, const Entity& e1_, const Entity& e2_, const Entity& e3_, const CubicLerpParams& p)
+{
+    if (!super::cubicLerp(e0_, e1_, e2_, e3_, p))
+        return false;
+    auto& e0 = static_cast<const Points&>(e0_);
+    auto& e1 = static_cast<const Points&>(e1_);
+    auto& e2 = static_cast<const Points&>(e2_);
+    auto& e3 = static_cast<const Points&>(e3_);
+
+    // only when the particles are the same. otherwise points are left linearly interpolated by id (see lerp()).
+    size_t n = e1.points.size();
+    auto same_particles = [n, &e1](const Points& e) {
+        return e.points.size() == n && e.ids == e1.ids;
+    };
+    if (!same_particles(e2) || points.size() != n)
+        return true;
+
+    if (e1.velocities.size() == n && e2.velocities.size() == n) {
+        Hermite(points.data(), e1.points.cdata(), e2.points.cdata(), e1.velocities.cdata(), e2.velocities.cdata(), n, p.t, p.dt);
+    }
+    else {
+        auto& p0 = same_particles(e0) ? e0.points : e1.points;
+        auto& p3 = same_particles(e3) ? e3.points : e2.points;
+        CatmullRom(points.data(), p0.cdata(), e1.points.cdata(), e2.points.cdata(), p3.cdata(), n, p.t, p.s1, p.s2);
+    }
     updateBounds();
     return true;
 }
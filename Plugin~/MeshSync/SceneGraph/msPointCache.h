@@ -55,6 +55,7 @@ public:
     bool merge(const Entity& base) override;
     bool diff(const Entity& e1, const Entity& e2) override;
     bool lerp(const Entity& e1, const Entity& e2, float t) override;
+    bool cubicLerp(const Entity& e0, const Entity& e1, const Entity& e2, const Entity& e3, const CubicLerpParams& p) override;
     void updateBounds() override;
 
     void clear() override;
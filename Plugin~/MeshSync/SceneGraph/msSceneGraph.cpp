@@ -144,30 +144,113 @@ void Scene::diff(const Scene& s1, const Scene& s2)
     }
 }
 
+// indices of entities in order of id. scene caches sort entities by id, so usually this is just a sequence.
+static void SortByID(const std::vector<TransformPtr>& entities, RawVector<int>& dst)
+{
+    dst.resize_discard(entities.size());
+    for (size_t i = 0; i < entities.size(); ++i)
+        dst[i] = (int)i;
+    auto less = [&entities](int a, int b) { return entities[a]->id < entities[b]->id; };
+    if (!std::is_sorted(dst.begin(), dst.end(), less))
+        std::stable_sort(dst.begin(), dst.end(), less);
+}
+
+static const Transform* FindByID(const std::vector<TransformPtr>& entities, const RawVector<int>& order, int id)
+{
+    auto it = std::lower_bound(order.begin(), order.end(), id, [&entities](int i, int id) { return entities[i]->id < id; });
+    return it != order.end() && entities[*it]->id == id ? entities[*it].get() : nullptr;
+}
+
+// pairs entities of s1 and s2 by id with a merge join. entities that exist only in one of the scenes are passed through.
+// body: [](const TransformPtr& e1, const TransformPtr& e2) -> TransformPtr. called for pairs that can be interpolated.
+template<class Body>
+static void LerpEntities(std::vector<TransformPtr>& dst, const Scene& s1, const Scene& s2, const Body& body)
+{
+    struct Pair { int i1, i2; }; // -1 means the entity exists only in the other scene
+    RawVector<int> order1, order2;
+    SortByID(s1.entities, order1);
+    SortByID(s2.entities, order2);
+
+    RawVector<Pair> pairs;
+    pairs.reserve_discard(std::max(order1.size(), order2.size()));
+    size_t i1 = 0, i2 = 0;
+    while (i1 < order1.size() || i2 < order2.size()) {
+        if (i2 == order2.size()) {
+            pairs.push_back({ order1[i1++], -1 });
+            continue;
+        }
+        if (i1 == order1.size()) {
+            pairs.push_back({ -1, order2[i2++] });
+            continue;
+        }
+        int id1 = s1.entities[order1[i1]]->id;
+        int id2 = s2.entities[order2[i2]]->id;
+        if (id1 < id2)
+            pairs.push_back({ order1[i1++], -1 });
+        else if (id2 < id1)
+            pairs.push_back({ -1, order2[i2++] });
+        else
+            pairs.push_back({ order1[i1++], order2[i2++] });
+    }
+
+    dst.resize(pairs.size());
+    parallel_for(0, (int)pairs.size(), 10, [&dst, &s1, &s2, &pairs, &body](int i) {
+        auto& pair = pairs[i];
+        if (pair.i2 < 0) {
+            dst[i] = s1.entities[pair.i1];
+            return;
+        }
+        if (pair.i1 < 0) {
+            dst[i] = s2.entities[pair.i2];
+            return;
+        }
+
+        auto& e1 = s1.entities[pair.i1];
+        auto& e2 = s2.entities[pair.i2];
+        if (e1->getType() != e2->getType() ||
+            (e1->isGeometry() && !e1->cache_flags.constant_topology && e1->getType() != EntityType::Points)) {
+            // topology is not constant. no way to lerp. (Points are matched by particle id)
+            dst[i] = e1;
+        }
+        else {
+            dst[i] = body(e1, e2);
+        }
+    });
+}
+
 void Scene::lerp(const Scene& s1, const Scene& s2, float t)
 {
     settings = s1.settings;
     profile_data = s1.profile_data;
 
-    size_t entity_count = s1.entities.size();
-    if (entity_count == s2.entities.size()) {
-        entities.resize(entity_count);
-        parallel_for(0, (int)entity_count, 10, [this, &s1, &s2, t](int i) {
-            auto& e1 = s1.entities[i];
-            auto& e2 = s2.entities[i];
-            if (e1->id == e2->id) {
-                if (e1->isGeometry() && !e1->cache_flags.constant_topology) {
-                    // topology is not constant. no way to lerp.
-                    entities[i] = e1;
-                }
-                else {
-                    auto e3 = e1->clone();
-                    e3->lerp(*e1, *e2, t);
-                    entities[i] = std::static_pointer_cast<Transform>(e3);
-                }
-            }
-        });
-    }
+    LerpEntities(entities, s1, s2, [t](const TransformPtr& e1, const TransformPtr& e2) {
+        auto e3 = std::static_pointer_cast<Transform>(e1->clone());
+        e3->lerp(*e1, *e2, t);
+        return e3;
+    });
+}
+
+void Scene::cubicLerp(const Scene* s0, const Scene& s1, const Scene& s2, const Scene* s3, const CubicLerpParams& p)
+{
+    settings = s1.settings;
+    profile_data = s1.profile_data;
+
+    RawVector<int> order0, order3;
+    if (s0)
+        SortByID(s0->entities, order0);
+    if (s3)
+        SortByID(s3->entities, order3);
+
+    LerpEntities(entities, s1, s2, [&](const TransformPtr& e1, const TransformPtr& e2) {
+        // entities missing in the neighbouring scenes are substituted by e1 and e2
+        auto neighbour = [](const Scene* s, const RawVector<int>& order, const Transform& e) -> const Transform& {
+            auto *ret = s ? FindByID(s->entities, order, e.id) : nullptr;
+            return ret && ret->getType() == e.getType() ? *ret : e;
+        };
+        auto e3 = std::static_pointer_cast<Transform>(e1->clone());
+        e3->cubicLerp(neighbour(s0, order0, *e1), *e1, *e2, neighbour(s3, order3, *e2), p);
+        return e3;
+    });
 }
 
 void Scene::clear()
@@ -201,23 +284,7 @@ void Scene::sanitizeHierarchyPath(std::string& /*path*/)
 void Scene::import(const SceneImportSettings& cv)
 {
     // receive and convert assets
-    bool flip_x = settings.handedness == Handedness::Right || settings.handedness == Handedness::RightZUp;
-    bool swap_yz = settings.handedness == Handedness::LeftZUp || settings.handedness == Handedness::RightZUp;
-
-    std::vector<EntityConverterPtr> converters;
-    if (settings.scale_factor != 1.0f) {
-        float scale = 1.0f / settings.scale_factor;
-        converters.push_back(ScaleConverter::create(scale));
-    }
-    if (flip_x) {
-        converters.push_back(FlipX_HandednessCorrector::create());
-    }
-    if (swap_yz) {
-        if (cv.zup_correction_mode == ZUpCorrectionMode::FlipYZ)
-            converters.push_back(FlipYZ_ZUpCorrector::create());
-        else if (cv.zup_correction_mode == ZUpCorrectionMode::RotateX)
-            converters.push_back(RotateX_ZUpCorrector::create());
-    }
+    auto converters = CreateEntityConverters(settings, cv);
 
     auto convert = [&converters](auto& obj) {
         for (auto& cv : converters)
@@ -403,4 +470,109 @@ template std::vector<std::shared_ptr<Points>> Scene::getEntities<Points>() const
 
 #undef EachMember
 
+
+#pragma region EntityTable
+size_t EntityTable::build(const Scene& scene, Filter filter)
+{
+    clear();
+
+    int num_entities = (int)scene.entities.size();
+    m_rows.reserve(num_entities);
+    m_entity_indices.reserve(num_entities);
+    for (int ei = 0; ei < num_entities; ++ei) {
+        auto *e = scene.entities[ei].get();
+        if (filter == Filter::Changed && e->isUnchanged())
+            continue;
+        m_rows.push_back(e);
+        m_entity_indices.push_back(ei);
+    }
+
+    int num_rows = (int)m_rows.size();
+    m_path_offsets.resize(num_rows + 1);
+    m_path_offsets[0] = 0;
+    for (int ri = 0; ri < num_rows; ++ri)
+        m_path_offsets[ri + 1] = m_path_offsets[ri] + (int)m_rows[ri]->path.size() + 1;
+
+    // resolve parents by path. keys point to the entities' paths to avoid copying strings
+    struct PathHash { size_t operator()(const std::string *v) const { return std::hash<std::string>()(*v); } };
+    struct PathEq { bool operator()(const std::string *a, const std::string *b) const { return *a == *b; } };
+    mu::FlatHashMap<const std::string*, int, PathHash, PathEq> rows_by_path;
+    rows_by_path.reserve(num_rows);
+    for (int ri = 0; ri < num_rows; ++ri)
+        rows_by_path[&m_rows[ri]->path] = ri;
+
+    m_parents.resize(num_rows);
+    parallel_for_blocked(0, num_rows, 256, [&](int begin, int end) {
+        std::string parent_path;
+        for (int ri = begin; ri < end; ++ri) {
+            auto& path = m_rows[ri]->path;
+            auto pos = path.find_last_of('/');
+            if (pos == std::string::npos || pos == 0) {
+                m_parents[ri] = -1;
+                continue;
+            }
+            parent_path.assign(path, 0, pos);
+            auto *parent = rows_by_path.find(&parent_path);
+            m_parents[ri] = parent ? *parent : -1;
+        }
+    });
+    return m_rows.size();
+}
+
+void EntityTable::clear()
+{
+    m_rows.clear();
+    m_entity_indices.clear();
+    m_parents.clear();
+    m_path_offsets.clear();
+}
+
+size_t EntityTable::size() const
+{
+    return m_rows.size();
+}
+
+size_t EntityTable::getPathsSize() const
+{
+    return m_path_offsets.empty() ? 0 : m_path_offsets.back();
+}
+
+void EntityTable::fill(const EntityArrays& dst) const
+{
+    int num_rows = (int)m_rows.size();
+    if (dst.entity_indices)
+        std::copy(m_entity_indices.begin(), m_entity_indices.end(), dst.entity_indices);
+    if (dst.parents)
+        std::copy(m_parents.begin(), m_parents.end(), dst.parents);
+    if (dst.path_offsets)
+        std::copy(m_path_offsets.begin(), m_path_offsets.end(), dst.path_offsets);
+
+    parallel_for_blocked(0, num_rows, 256, [&](int begin, int end) {
+        for (int ri = begin; ri < end; ++ri) {
+            auto& e = *m_rows[ri];
+            if (dst.types)
+                dst.types[ri] = (int)e.getType();
+            if (dst.host_ids)
+                dst.host_ids[ri] = e.host_id;
+            if (dst.indices)
+                dst.indices[ri] = e.index;
+            if (dst.data_flags)
+                dst.data_flags[ri] = (uint32_t&)e.td_flags;
+            if (dst.positions)
+                dst.positions[ri] = e.position;
+            if (dst.rotations)
+                dst.rotations[ri] = e.rotation;
+            if (dst.scales)
+                dst.scales[ri] = e.scale;
+            if (dst.visibilities)
+                dst.visibilities[ri] = (uint32_t&)e.visibility;
+            if (dst.layers)
+                dst.layers[ri] = e.layer;
+            if (dst.paths)
+                memcpy(dst.paths + m_path_offsets[ri], e.path.c_str(), e.path.size() + 1);
+        }
+    });
+}
+#pragma endregion
+
 } // namespace ms
@@ -102,6 +102,8 @@ public:
     void merge(Scene& base);
     void diff(const Scene& src1, const Scene& src2);
     void lerp(const Scene& src1, const Scene& src2, float t);
+    // src0 and src3 are the neighbouring scenes of src1 and src2. can be null at the ends of a sequence.
+    void cubicLerp(const Scene* src0, const Scene& src1, const Scene& src2, const Scene* src3, const CubicLerpParams& p);
     void clear();
     uint64_t hash() const;
 
@@ -137,4 +139,53 @@ public:
 msSerializable(Scene);
 msDeclPtr(Scene);
 
+
+// must be synced with C# side
+// caller-provided SoA destination of EntityTable::fill(). null arrays are skipped.
+// per-row arrays need EntityTable::size() elements, path_offsets needs size() + 1 and paths needs getPathsSize().
+struct EntityArrays
+{
+    int *entity_indices;    // index in Scene::entities
+    int *types;             // EntityType
+    int *host_ids;
+    int *parents;           // row of the parent entity. -1 if the parent is not in the table
+    int *indices;           // Transform::index
+    uint32_t *data_flags;   // TransformDataFlags
+    float3 *positions;
+    quatf *rotations;
+    float3 *scales;
+    uint32_t *visibilities; // VisibilityFlags
+    int *layers;
+    int *path_offsets;      // path of row i is paths[path_offsets[i]] ~ paths[path_offsets[i + 1] - 1] (null-terminated)
+    char *paths;
+};
+
+// flattens entities of a Scene into rows for the plugin API.
+// lets the managed side get all transform data in a few calls instead of one call per field per entity.
+class EntityTable
+{
+public:
+    enum class Filter
+    {
+        All,
+        Changed, // skip entities that are marked as unchanged (see Transform::isUnchanged())
+    };
+
+    // returns the number of rows. rows are in the order of scene.entities.
+    // the scene must be kept alive and unmodified until fill() is done.
+    size_t build(const Scene& scene, Filter filter = Filter::All);
+    void clear();
+
+    size_t size() const;
+    size_t getPathsSize() const;
+    // rows are filled in parallel
+    void fill(const EntityArrays& dst) const;
+
+private:
+    std::vector<const Transform*> m_rows;
+    std::vector<int> m_entity_indices;
+    std::vector<int> m_parents;
+    std::vector<int> m_path_offsets;
+};
+
 } // namespace ms
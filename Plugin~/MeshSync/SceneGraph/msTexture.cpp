@@ -26,9 +26,59 @@ int GetPixelSize(TextureFormat format)
     return 0;
 }
 
+bool IsBlockCompressed(TextureFormat format)
+{
+    return ((int)format & (int)TextureFormat::TypeMask) == (int)TextureFormat::Type_BC;
+}
 
+static bool ToBCFormat(TextureFormat format, BCFormat& dst)
+{
+    switch (format) {
+    case TextureFormat::BC1: dst = BCFormat::BC1; return true;
+    case TextureFormat::BC3: dst = BCFormat::BC3; return true;
+    case TextureFormat::BC4: dst = BCFormat::BC4; return true;
+    case TextureFormat::BC5: dst = BCFormat::BC5; return true;
+    case TextureFormat::BC7: dst = BCFormat::BC7; return true;
+    default: return false;
+    }
+}
 
-#define EachMember(F)  F(type) F(format) F(width) F(height) F(data)
+size_t GetTextureDataSize(TextureFormat format, int width, int height, int mip_count)
+{
+    BCFormat bc;
+    bool block_compressed = ToBCFormat(format, bc);
+    size_t ret = 0;
+    for (int level = 0; level < mip_count; ++level) {
+        int w = GetMipSize(width, level);
+        int h = GetMipSize(height, level);
+        ret += block_compressed ? GetBCDataSize(bc, w, h) : (size_t)w * h * GetPixelSize(format);
+    }
+    return ret;
+}
+static PixelType ToPixelType(TextureFormat format)
+{
+    switch ((int)format & (int)TextureFormat::TypeMask) {
+    case (int)TextureFormat::Type_u8: return PixelType::U8;
+    case (int)TextureFormat::Type_i16: return PixelType::I16;
+    case (int)TextureFormat::Type_i32: return PixelType::I32;
+    case (int)TextureFormat::Type_f16: return PixelType::F16;
+    case (int)TextureFormat::Type_f32: return PixelType::F32;
+    default: return PixelType::Unknown;
+    }
+}
+
+bool ConvertPixels(void *dst, TextureFormat dst_format, const void *src, TextureFormat src_format,
+    int width, int height, const PixelConvertOptions& opt)
+{
+    return mu::ConvertPixels(
+        dst, ToPixelType(dst_format), (int)dst_format & (int)TextureFormat::ChannelMask,
+        src, ToPixelType(src_format), (int)src_format & (int)TextureFormat::ChannelMask,
+        width, height, opt);
+}
+
+
+
+#define EachMember(F)  F(type) F(format) F(width) F(height) F(mip_count) F(data)
 
 std::shared_ptr<Texture> Texture::create(std::istream& is)
 {
@@ -61,6 +111,7 @@ void Texture::clear()
     type = TextureType::Default;
     format = TextureFormat::Unknown;
     width = height = 0;
+    mip_count = 1;
     vclear(data);
 }
 
@@ -78,13 +129,14 @@ uint64_t Texture::checksum() const
     ret += csum((int)format);
     ret += csum(width);
     ret += csum(height);
+    ret += csum(mip_count);
     ret += csum(data);
     return ret;
 }
 
 void Texture::setData(const void *src)
 {
-    size_t data_size = width * height * GetPixelSize(format);
+    size_t data_size = GetTextureDataSize(format, width, height, mip_count);
     data.assign((const char*)src, (const char*)src + data_size);
 }
 
@@ -95,6 +147,166 @@ void Texture::getData(void *dst) const
     data.copy_to((char*)dst);
 }
 
+bool Texture::compress(TextureFormat dst_format, BCQuality quality)
+{
+    BCFormat bc;
+    if (!ToBCFormat(dst_format, bc) || ((int)format & (int)TextureFormat::TypeMask) != (int)TextureFormat::Type_u8)
+        return false;
+
+    int channels = (int)format & (int)TextureFormat::ChannelMask;
+    if (width <= 0 || height <= 0 || data.size() < GetTextureDataSize(format, width, height, mip_count))
+        return false;
+
+    RawVector<char> encoded;
+    encoded.resize_discard(GetTextureDataSize(dst_format, width, height, mip_count));
+
+    RawVector<unorm8x4> rgba;
+    size_t dst_offset = 0;
+    for (int level = 0; level < mip_count; ++level) {
+        int w = getMipWidth(level);
+        int h = getMipHeight(level);
+        size_t num_pixels = (size_t)w * h;
+
+        // the encoder takes RGBA8
+        const void *src = data.cdata() + getMipOffset(level);
+        if (channels != 4) {
+            rgba.resize_discard(num_pixels);
+            ConvertPixels(rgba.data(), TextureFormat::RGBAu8, src, format, w, h);
+            src = rgba.cdata();
+        }
+        EncodeBC(bc, quality, encoded.data() + dst_offset, src, w, h);
+        dst_offset += GetBCDataSize(bc, w, h);
+    }
+    data = std::move(encoded);
+    format = dst_format;
+    return true;
+}
+
+bool Texture::convert(TextureFormat dst_format, const PixelConvertOptions& opt)
+{
+    if (width <= 0 || height <= 0 || data.size() < GetTextureDataSize(format, width, height, mip_count))
+        return false;
+
+    BCFormat bc;
+    if (ToBCFormat(format, bc)) {
+        if (format == dst_format)
+            return true;
+
+        RawVector<char> decoded;
+        decoded.resize_discard(GetTextureDataSize(TextureFormat::RGBAu8, width, height, mip_count));
+        size_t src_offset = 0, dst_offset = 0;
+        for (int level = 0; level < mip_count; ++level) {
+            int w = getMipWidth(level);
+            int h = getMipHeight(level);
+            if (!DecodeBC(bc, decoded.data() + dst_offset, data.cdata() + src_offset, w, h))
+                return false;
+            src_offset += GetBCDataSize(bc, w, h);
+            dst_offset += GetTextureDataSize(TextureFormat::RGBAu8, w, h);
+        }
+        data = std::move(decoded);
+        format = TextureFormat::RGBAu8;
+    }
+    if (IsBlockCompressed(dst_format))
+        return convert(TextureFormat::RGBAu8, opt) && compress(dst_format);
+
+    if (ToPixelType(format) == PixelType::Unknown || ToPixelType(dst_format) == PixelType::Unknown)
+        return false;
+
+    RawVector<char> converted;
+    converted.resize_discard(GetTextureDataSize(dst_format, width, height, mip_count));
+    if (!convertTo(converted.data(), dst_format, opt))
+        return false;
+    data = std::move(converted);
+    format = dst_format;
+    return true;
+}
+
+bool Texture::convertTo(void *dst, TextureFormat dst_format, const PixelConvertOptions& opt) const
+{
+    if (!dst || data.size() < GetTextureDataSize(format, width, height, mip_count))
+        return false;
+
+    for (int level = 0; level < mip_count; ++level) {
+        char *d = (char*)dst + GetTextureDataSize(dst_format, width, height, level);
+        if (!ConvertPixels(d, dst_format, data.cdata() + getMipOffset(level), format, getMipWidth(level), getMipHeight(level), opt))
+            return false;
+    }
+    return true;
+}
+
+int Texture::getMipWidth(int level) const
+{
+    return GetMipSize(width, level);
+}
+
+int Texture::getMipHeight(int level) const
+{
+    return GetMipSize(height, level);
+}
+
+size_t Texture::getMipOffset(int level) const
+{
+    return GetTextureDataSize(format, width, height, level);
+}
+
+bool Texture::generateMips(MipFilter filter)
+{
+    int type = (int)format & (int)TextureFormat::TypeMask;
+    int channels = (int)format & (int)TextureFormat::ChannelMask;
+    if (type != (int)TextureFormat::Type_u8 && type != (int)TextureFormat::Type_f16 && type != (int)TextureFormat::Type_f32)
+        return false;
+
+    size_t base_size = GetTextureDataSize(format, width, height);
+    if (base_size == 0 || data.size() < base_size)
+        return false;
+
+    int count = GetMipCount(width, height);
+    RawVector<char> tmp;
+    tmp.resize_discard(GetTextureDataSize(format, width, height, count));
+    std::memcpy(tmp.data(), data.cdata(), base_size);
+
+    size_t src_offset = 0;
+    for (int level = 0; level < count - 1; ++level) {
+        int w = GetMipSize(width, level);
+        int h = GetMipSize(height, level);
+        size_t dst_offset = src_offset + GetTextureDataSize(format, w, h);
+        char *src = tmp.data() + src_offset;
+        char *dst = tmp.data() + dst_offset;
+        switch (type) {
+        case (int)TextureFormat::Type_u8:
+            GenerateMipLevel((uint8_t*)dst, (const uint8_t*)src, w, h, channels, filter);
+            break;
+        case (int)TextureFormat::Type_f16:
+            GenerateMipLevel((half*)dst, (const half*)src, w, h, channels, filter);
+            break;
+        case (int)TextureFormat::Type_f32:
+            GenerateMipLevel((float*)dst, (const float*)src, w, h, channels, filter);
+            break;
+        }
+        src_offset = dst_offset;
+    }
+    data = std::move(tmp);
+    mip_count = count;
+    return true;
+}
+
+std::shared_ptr<Texture> Texture::cloneMips(int first_level) const
+{
+    first_level = std::min(std::max(first_level, 0), mip_count - 1);
+
+    auto ret = create();
+    ret->id = id;
+    ret->name = name;
+    ret->type = type;
+    ret->format = format;
+    ret->width = getMipWidth(first_level);
+    ret->height = getMipHeight(first_level);
+    ret->mip_count = mip_count - first_level;
+    size_t offset = getMipOffset(first_level);
+    ret->data.assign(data.cdata() + offset, data.cdata() + data.size());
+    return ret;
+}
+
 #ifndef msRuntime
 bool Texture::readFromFile(const char *path)
 {
@@ -118,4 +330,82 @@ bool Texture::writeToFile(const char *path) const
 
 #undef EachMember
 
+
+#define EachMember(F)  F(x) F(y) F(width) F(height) F(data)
+
+void TextureTile::serialize(std::ostream& os) const
+{
+    EachMember(msWrite);
+}
+
+void TextureTile::deserialize(std::istream& is)
+{
+    EachMember(msRead);
+}
+
+#undef EachMember
+
+
+#define EachMember(F)  F(texture_id) F(format) F(width) F(height) F(tiles)
+
+void TextureTiles::serialize(std::ostream& os) const
+{
+    EachMember(msWrite);
+}
+
+void TextureTiles::deserialize(std::istream& is)
+{
+    EachMember(msRead);
+}
+
+#undef EachMember
+
+bool TextureTiles::isTarget(const Texture& v) const
+{
+    return v.id == texture_id && v.format == format && v.width == width && v.height == height &&
+        v.mip_count == 1 && GetPixelSize(format) > 0 &&
+        v.data.size() == GetTextureDataSize(format, width, height);
+}
+
+bool TextureTiles::addTile(const Texture& src, int x, int y, int w, int h)
+{
+    if (!isTarget(src) || x < 0 || y < 0 || w <= 0 || h <= 0 || x + w > width || y + h > height)
+        return false;
+
+    size_t psize = GetPixelSize(format);
+    size_t src_pitch = psize * width;
+    size_t dst_pitch = psize * w;
+
+    tiles.push_back({});
+    auto& tile = tiles.back();
+    tile.x = x;
+    tile.y = y;
+    tile.width = w;
+    tile.height = h;
+    tile.data.resize_discard(dst_pitch * h);
+    char *dst_data = tile.data.data();
+    for (int i = 0; i < h; ++i)
+        memcpy(dst_data + dst_pitch * i, src.data.cdata() + src_pitch * (y + i) + psize * x, dst_pitch);
+    return true;
+}
+
+bool TextureTiles::apply(Texture& dst) const
+{
+    if (!isTarget(dst))
+        return false;
+
+    size_t psize = GetPixelSize(format);
+    size_t dst_pitch = psize * width;
+    char *dst_data = dst.data.data();
+    for (auto& tile : tiles) {
+        size_t src_pitch = psize * tile.width;
+        if (tile.x < 0 || tile.y < 0 || tile.x + tile.width > width || tile.y + tile.height > height ||
+            tile.data.size() != src_pitch * tile.height)
+            continue;
+        for (int i = 0; i < tile.height; ++i)
+            memcpy(dst_data + dst_pitch * (tile.y + i) + psize * tile.x, tile.data.cdata() + src_pitch * i, src_pitch);
+    }
+    return true;
+}
+
 } // namespace ms
@@ -14,6 +14,7 @@ enum class TextureFormat
     Type_u8  = 0x3 << 4,
     Type_i16 = 0x4 << 4,
     Type_i32 = 0x5 << 4,
+    Type_BC  = 0x6 << 4, // block compressed. lower bits are BC number, not channels
 
     Rf16      = Type_f16 | 1,
     RGf16     = Type_f16 | 2,
@@ -35,6 +36,11 @@ enum class TextureFormat
     RGi32     = Type_i32 | 2,
     RGBi32    = Type_i32 | 3,
     RGBAi32   = Type_i32 | 4,
+    BC1       = Type_BC  | 1,
+    BC3       = Type_BC  | 3,
+    BC4       = Type_BC  | 4,
+    BC5       = Type_BC  | 5,
+    BC7       = Type_BC  | 7,
 
     RawFile = 0x10 << 4,
 };
@@ -60,8 +66,14 @@ template<> struct GetTextureFormat<float3>  { static const TextureFormat result
 template<> struct GetTextureFormat<float4>  { static const TextureFormat result = ms::TextureFormat::RGBAf32; };
 
 
-// in byte
+// in byte. 0 if format is block compressed
 int GetPixelSize(TextureFormat format);
+bool IsBlockCompressed(TextureFormat format);
+// in byte. includes all mip levels
+size_t GetTextureDataSize(TextureFormat format, int width, int height, int mip_count = 1);
+// uncompressed formats only. see mu::ConvertPixels()
+bool ConvertPixels(void *dst, TextureFormat dst_format, const void *src, TextureFormat src_format,
+    int width, int height, const PixelConvertOptions& opt = PixelConvertOptions());
 
 class Texture : public Asset
 {
@@ -73,6 +85,7 @@ public:
     TextureFormat format = TextureFormat::Unknown;
     int width = 0;
     int height = 0;
+    int mip_count = 1; // data contains mip levels from the largest, packed. (same layout as Unity's Texture2D.LoadRawTextureData())
     SharedVector<char> data;
 
 protected:
@@ -91,6 +104,24 @@ public:
 
     void setData(const void *src);
     void getData(void *dst) const;
+    // converts u8 formats into a block compressed format. all mip levels are converted.
+    // returns false if format can't be converted
+    bool compress(TextureFormat dst_format, BCQuality quality = BCQuality::Normal);
+    // converts all mip levels into dst_format. block compressed textures are decoded first and
+    // block compressed dst_format is done by compress(). returns false if format can't be converted
+    bool convert(TextureFormat dst_format, const PixelConvertOptions& opt = PixelConvertOptions());
+    // same as convert() but writes to dst that has GetTextureDataSize(dst_format, width, height, mip_count) bytes.
+    // uncompressed formats only
+    bool convertTo(void *dst, TextureFormat dst_format, const PixelConvertOptions& opt = PixelConvertOptions()) const;
+
+    int getMipWidth(int level) const;
+    int getMipHeight(int level) const;
+    size_t getMipOffset(int level) const;
+    // generates the full mip chain from the first level. u8, f16 and f32 formats only
+    bool generateMips(MipFilter filter = MipFilter::Box);
+    // texture that consists of mip levels from first_level. id and name are kept.
+    // useful to send coarse levels first
+    std::shared_ptr<Texture> cloneMips(int first_level) const;
 #ifndef msRuntime
     bool readFromFile(const char *path);
     bool writeToFile(const char *path) const;
@@ -99,4 +130,46 @@ public:
 msSerializable(Texture);
 msDeclPtr(Texture);
 
+
+// rectangle of the first mip level. data is rows of the rectangle, tightly packed
+struct TextureTile
+{
+    int x = 0;
+    int y = 0;
+    int width = 0;
+    int height = 0;
+    SharedVector<char> data;
+
+    void serialize(std::ostream& os) const;
+    void deserialize(std::istream& is);
+};
+msSerializable(TextureTile);
+
+// changed regions of a texture sent before. uncompressed formats without mips only
+class TextureTiles
+{
+public:
+    // serializable
+    int texture_id = InvalidID;
+    TextureFormat format = TextureFormat::Unknown;
+    int width = 0;  // size of the whole texture
+    int height = 0;
+    std::vector<TextureTile> tiles;
+
+    // non-serializable
+    TexturePtr merged; // the target texture. set by the receiver after apply()
+    TexturePtr source; // the whole texture the tiles are taken from. set by TextureManager::getDirtyTiles()
+
+public:
+    void serialize(std::ostream& os) const;
+    void deserialize(std::istream& is);
+
+    bool isTarget(const Texture& v) const;
+    // copies the rectangle from src. returns false if src is not a valid target
+    bool addTile(const Texture& src, int x, int y, int w, int h);
+    // returns false if dst is not the target or its layout differs
+    bool apply(Texture& dst) const;
+};
+msSerializable(TextureTiles);
+
 } // namespace ms
@@ -25,6 +25,9 @@ void AsyncSceneExporter::clear()
     transforms.clear();
     geometries.clear();
     animations.clear();
+    animation_deltas.clear();
+    texture_tiles.clear();
+    material_deltas.clear();
 
     deleted_entities.clear();
     deleted_materials.clear();
@@ -58,6 +61,57 @@ void AsyncSceneExporter::add(ScenePtr scene)
     }
 }
 
+void AsyncSceneExporter::optimizeAnimations()
+{
+    if (!optimize_animations || animations.empty())
+        return;
+
+    std::vector<TransformPtr> rests;
+    rests.reserve(transforms.size() + geometries.size());
+    rests.insert(rests.end(), transforms.begin(), transforms.end());
+    rests.insert(rests.end(), geometries.begin(), geometries.end());
+    for (auto& clip : animations)
+        clip->optimize(animation_optimize_settings, rests);
+}
+
+void AsyncSceneExporter::prepareTextures()
+{
+    bool compress = IsBlockCompressed(texture_compression);
+    if (!generate_texture_mips && !compress)
+        return;
+
+    // tiles can't be applied to textures with mips or block compressed ones (see TextureTiles::isTarget()).
+    // send the whole textures instead.
+    if (!texture_tiles.empty()) {
+        for (auto& tt : texture_tiles) {
+            if (tt.source)
+                textures.push_back(tt.source);
+            else
+                msLogWarning("AsyncSceneExporter: tiles of texture %d are dropped. TextureTiles::source is not set\n", tt.texture_id);
+        }
+        texture_tiles.clear();
+    }
+
+    for (auto& tex : textures) {
+        int type = (int)tex->format & (int)TextureFormat::TypeMask;
+        // partial chains are regenerated too. receivers such as Unity accept only the full chain
+        bool gen_mips = generate_texture_mips && tex->mip_count != GetMipCount(tex->width, tex->height) &&
+            (type == (int)TextureFormat::Type_u8 || type == (int)TextureFormat::Type_f16 || type == (int)TextureFormat::Type_f32);
+        bool to_bc = compress && type == (int)TextureFormat::Type_u8;
+        if (!gen_mips && !to_bc)
+            continue;
+
+        // textures may be retained by TextureManager. process a copy.
+        auto dst = Texture::create();
+        *dst = *tex;
+        if (gen_mips)
+            dst->generateMips(texture_mip_filter);
+        if (to_bc)
+            dst->compress(texture_compression, texture_compression_quality);
+        tex = dst;
+    }
+}
+
 
 #ifdef msEnableNetwork
 AsyncSceneSender::AsyncSceneSender(int sid)
@@ -92,25 +146,144 @@ bool AsyncSceneSender::isServerAvaileble()
     return ret;
 }
 
+double AsyncSceneSender::getThroughput() const
+{
+    return m_throughput;
+}
+
+MeshPrecision AsyncSceneSender::getLastPrecision() const
+{
+    return m_last_precision;
+}
+
 bool AsyncSceneSender::isExporting()
 {
-    if (m_future.valid() && m_future.wait_for(std::chrono::milliseconds(0)) == std::future_status::timeout)
-        return true;
-    return false;
+    // false while waiting for refine_delay_ms. kick() cancels the refinement
+    return m_sending;
 }
 
 void AsyncSceneSender::wait()
 {
     if (m_future.valid()) {
+        {
+            std::unique_lock<std::mutex> lock(m_refine_mutex);
+            m_cancel_refine = true;
+        }
+        m_refine_cond.notify_all();
         m_future.wait();
         m_future = {};
+        m_cancel_refine = false;
     }
 }
 
 void AsyncSceneSender::kick()
 {
+    auto begin = mu::Now();
     wait();
-    m_future = std::async(std::launch::async, [this]() { send(); });
+    m_queue_wait = mu::Now() - begin;
+
+    m_sending = true;
+    m_future = std::async(std::launch::async, [this]() {
+        send();
+        m_sending = false;
+        refine();
+    });
+}
+
+void AsyncSceneSender::setupMessage(Message& mes)
+{
+    mes.session_id = session_id;
+    mes.message_id = message_count++;
+    mes.timestamp_send = mu::Now();
+}
+
+// rough size of a mesh on the wire
+static uint64_t EstimateSize(const Mesh& mesh, MeshPrecision precision)
+{
+    // points, normals, tangents, uv
+    static const int element_sizes[][4] = {
+        { 12, 12, 16, 8 }, // Full
+        { 6, 6, 8, 4 },    // Bounded
+        { 6, 4, 4, 4 },    // BoundedPacked
+    };
+    auto& s = element_sizes[(int)precision];
+    uint64_t ret =
+        mesh.points.size() * s[0] + mesh.normals.size() * s[1] + mesh.tangents.size() * s[2] +
+        (mesh.uv0.size() + mesh.uv1.size()) * s[3];
+    ret += mesh.colors.size_in_byte() + mesh.velocities.size_in_byte() +
+        mesh.counts.size_in_byte() + mesh.indices.size_in_byte() + mesh.material_ids.size_in_byte();
+    return ret;
+}
+
+MeshPrecision AsyncSceneSender::selectPrecision()
+{
+    if (!adaptive_precision || m_throughput <= 0.0)
+        return MeshPrecision::Full;
+
+    uint64_t sizes[3] = {};
+    for (auto& geom : geometries) {
+        if (geom->getType() != EntityType::Mesh)
+            continue;
+        auto& mesh = static_cast<Mesh&>(*geom);
+        for (int i = 0; i < 3; ++i)
+            sizes[i] += EstimateSize(mesh, (MeshPrecision)i);
+    }
+
+    // if the previous send was still running when this update was kicked, it has already waited that long
+    double budget = double(latency_target_ms) / 1000.0 - double(m_queue_wait) / 1e9;
+    // levels are ordered from the largest and most accurate. the first one that fits is the best one
+    for (int i = 0; i < 2; ++i) {
+        if (double(sizes[i]) / m_throughput <= budget)
+            return (MeshPrecision)i;
+    }
+    return MeshPrecision::BoundedPacked;
+}
+
+void AsyncSceneSender::updateThroughput(uint64_t bytes, nanosec elapsed)
+{
+    // small sends are dominated by round trips and would underestimate the link
+    const uint64_t min_bytes = 64 * 1024;
+    if (bytes < min_bytes || elapsed <= 0)
+        return;
+
+    double sample = double(bytes) / (double(elapsed) / 1e9);
+    m_throughput = m_throughput == 0.0 ? sample : m_throughput * 0.7 + sample * 0.3;
+}
+
+void AsyncSceneSender::refine()
+{
+    if (m_refinements.empty())
+        return;
+    {
+        std::unique_lock<std::mutex> lock(m_refine_mutex);
+        if (m_refine_cond.wait_for(lock, std::chrono::milliseconds(refine_delay_ms), [this]() { return m_cancel_refine.load(); }))
+            return;
+    }
+
+    m_sending = true;
+    ms::Client client(client_settings);
+    client.setClockOffset(m_clock_offset);
+
+    ms::FenceMessage fence;
+    setupMessage(fence);
+    fence.type = ms::FenceMessage::FenceType::SceneBegin;
+    if (client.send(fence)) {
+        // meshes are sent one by one so that a new update can interrupt
+        while (!m_refinements.empty() && !m_cancel_refine) {
+            auto it = m_refinements.begin();
+            ms::SetMessage mes;
+            setupMessage(mes);
+            mes.scene->settings = scene_settings;
+            mes.scene->entities = { it->second };
+            if (!client.send(mes))
+                break;
+            m_refinements.erase(it);
+        }
+        setupMessage(fence);
+        fence.type = ms::FenceMessage::FenceType::SceneEnd;
+        client.send(fence);
+    }
+    m_sending = false;
 }
 
 void AsyncSceneSender::send()
@@ -119,7 +292,7 @@ void AsyncSceneSender::send()
         on_prepare();
 
     if (assets.empty() && textures.empty() && materials.empty() &&
-        transforms.empty() && geometries.empty() && animations.empty() &&
+        transforms.empty() && geometries.empty() && animations.empty() && animation_deltas.empty() && texture_tiles.empty() && material_deltas.empty() &&
         deleted_entities.empty() && deleted_materials.empty())
         return;
 
@@ -127,6 +300,8 @@ void AsyncSceneSender::send()
     SetupDataFlags(geometries);
     AssignIDs(transforms, id_table);
     AssignIDs(geometries, id_table);
+    optimizeAnimations();
+    prepareTextures();
     // sort by order. not id.
     std::sort(transforms.begin(), transforms.end(), [](auto& a, auto& b) { return a->order < b->order; });
     std::sort(geometries.begin(), geometries.end(), [](auto& a, auto& b) { return a->order < b->order; });
@@ -135,12 +310,15 @@ void AsyncSceneSender::send()
 
     bool succeeded = true;
     ms::Client client(client_settings);
-
-    auto setup_message = [this](ms::Message& mes) {
-        mes.session_id = session_id;
-        mes.message_id = message_count++;
-        mes.timestamp_send = mu::Now();
-    };
+    // keep the server's clock offset fresh so that it can measure latencies. see LatencyStats
+    client.setClockOffset(m_clock_offset);
+    if (!m_clock_offset.valid() || mu::Now() - m_clock_offset.timestamp > clock_sync_interval) {
+        client.isServerAvailable();
+        m_clock_offset = client.getClockOffset();
+    }
+    std::vector<TexturePtr> deferred_textures;
+    auto send_begin = mu::Now();
+    auto setup_message = [this](ms::Message& mes) { setupMessage(mes); };
 
     // notify scene begin
     {
@@ -158,43 +336,92 @@ void AsyncSceneSender::send()
         setup_message(mes);
         mes.scene->settings = scene_settings;
         mes.scene->assets = assets;
+        mes.flags.retain_assets = use_deltas;
         succeeded = succeeded && client.send(mes);
         if (!succeeded)
             goto cleanup;
     }
 
-    // textures
+    // textures. large textures with mips are sent as coarse levels here so that materials become usable soon.
+    // the full chains are sent after the rest of the scene.
     if (!textures.empty()) {
         for (auto& tex : textures) {
+            auto t = tex;
+            if (texture_preview_size > 0 && tex->mip_count > 1 && std::max(tex->width, tex->height) > texture_preview_size) {
+                int level = 0;
+                while (level < tex->mip_count - 1 && std::max(tex->getMipWidth(level), tex->getMipHeight(level)) > texture_preview_size)
+                    ++level;
+                t = tex->cloneMips(level);
+                deferred_textures.push_back(tex);
+            }
+
             ms::SetMessage mes;
             setup_message(mes);
             mes.scene->settings = scene_settings;
-            mes.scene->assets = { tex };
+            mes.scene->assets = { t };
+            mes.flags.retain_assets = use_deltas;
             succeeded = succeeded && client.send(mes);
             if (!succeeded)
                 goto cleanup;
         };
     }
 
+    // changed tiles of textures sent before
+    if (!texture_tiles.empty()) {
+        ms::TextureTilesMessage mes;
+        setup_message(mes);
+        mes.textures = texture_tiles;
+        succeeded = succeeded && client.send(mes);
+        if (!succeeded)
+            goto cleanup;
+    }
+
     // materials and non-geometry objects
     if (!materials.empty() || !transforms.empty()) {
         ms::SetMessage mes;
         setup_message(mes);
         mes.scene->settings = scene_settings;
         append(mes.scene->assets, materials);
+        mes.flags.retain_assets = use_deltas;
         mes.scene->entities = transforms;
         succeeded = succeeded && client.send(mes);
         if (!succeeded)
             goto cleanup;
     }
 
+    // changed properties of materials sent before
+    if (!material_deltas.empty()) {
+        ms::MaterialDeltaMessage mes;
+        setup_message(mes);
+        mes.materials = material_deltas;
+        succeeded = succeeded && client.send(mes);
+        if (!succeeded)
+            goto cleanup;
+    }
+
     // geometries
     if (!geometries.empty()) {
+        auto precision = selectPrecision();
+        m_last_precision = precision;
         for (auto& geom : geometries) {
+            auto entity = geom;
+            if (adaptive_precision) {
+                if (precision != MeshPrecision::Full && geom->getType() == EntityType::Mesh) {
+                    // send a shallow copy. geom is kept at full precision for refine()
+                    auto mesh = std::static_pointer_cast<Mesh>(geom->clone());
+                    mesh->md_flags.precision = (uint32_t)precision;
+                    entity = mesh;
+                    m_refinements[geom->path] = geom;
+                }
+                else {
+                    m_refinements.erase(geom->path);
+                }
+            }
+
             ms::SetMessage mes;
             setup_message(mes);
             mes.scene->settings = scene_settings;
-            mes.scene->entities = { geom };
+            mes.scene->entities = { entity };
             succeeded = succeeded && client.send(mes);
             if (!succeeded)
                 goto cleanup;
@@ -207,12 +434,38 @@ void AsyncSceneSender::send()
         setup_message(mes);
         mes.scene->settings = scene_settings;
         append(mes.scene->assets, animations);
+        mes.flags.retain_assets = use_deltas;
+        succeeded = succeeded && client.send(mes);
+        if (!succeeded)
+            goto cleanup;
+    }
+
+    // animation deltas
+    if (!animation_deltas.empty()) {
+        ms::AnimationDeltaMessage mes;
+        setup_message(mes);
+        mes.scene_settings = scene_settings;
+        mes.deltas = animation_deltas;
+        succeeded = succeeded && client.send(mes);
+        if (!succeeded)
+            goto cleanup;
+    }
+
+    // full mip chains of the textures sent as coarse levels
+    for (auto& tex : deferred_textures) {
+        ms::SetMessage mes;
+        setup_message(mes);
+        mes.scene->settings = scene_settings;
+        mes.scene->assets = { tex };
+        mes.flags.retain_assets = use_deltas;
         succeeded = succeeded && client.send(mes);
         if (!succeeded)
             goto cleanup;
     }
 
     // deleted
+    for (auto& id : deleted_entities)
+        m_refinements.erase(id.name);
     if (!deleted_entities.empty() || !deleted_materials.empty()) {
         ms::DeleteMessage mes;
         setup_message(mes);
@@ -232,7 +485,9 @@ void AsyncSceneSender::send()
     }
 
 cleanup:
+    lost_textures = client.getLostTextures();
     if (succeeded) {
+        updateThroughput(client.getBytesSent(), mu::Now() - send_begin);
         if (on_success)
             on_success();
     }
@@ -311,6 +566,8 @@ void AsyncSceneCacheWriter::write()
     SetupDataFlags(geometries);
     AssignIDs(transforms, id_table);
     AssignIDs(geometries, id_table);
+    optimizeAnimations();
+    prepareTextures();
 
     auto append = [](auto& dst, auto& src) { dst.insert(dst.end(), src.begin(), src.end()); };
 
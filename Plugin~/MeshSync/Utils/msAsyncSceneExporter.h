@@ -1,7 +1,9 @@
 #pragma once
 
+#include <condition_variable>
 #include "../msClient.h"
 #include "../SceneCache/msSceneCache.h"
+#include "../SceneGraph/msTexture.h"
 #include "msIDGenerator.h"
 
 #ifndef msRuntime
@@ -17,10 +19,21 @@ public:
     std::vector<TransformPtr> transforms;
     std::vector<TransformPtr> geometries;
     std::vector<AnimationClipPtr> animations;
+    std::vector<AnimationClipDelta> animation_deltas; // network only
+    std::vector<TextureTiles> texture_tiles; // network only. sent as whole textures if generate_texture_mips or texture_compression is set
+    std::vector<MaterialPtr> material_deltas; // network only. see MaterialManager::getMaterialDeltas()
 
     std::vector<Identifier> deleted_entities;
     std::vector<Identifier> deleted_materials;
 
+    bool optimize_animations = true;
+    AnimationOptimizeSettings animation_optimize_settings;
+    bool generate_texture_mips = false;
+    MipFilter texture_mip_filter = MipFilter::Box;
+    // uncompressed u8 textures are converted to this format if it is block compressed (e.g. TextureFormat::BC7)
+    TextureFormat texture_compression = TextureFormat::Unknown;
+    BCQuality texture_compression_quality = BCQuality::Normal;
+
     std::function<void()> on_prepare, on_success, on_error, on_complete;
     PathToID id_table;
 
@@ -33,6 +46,10 @@ public:
     virtual void kick() = 0;
 
     void add(ScenePtr scene);
+
+protected:
+    void optimizeAnimations();
+    void prepareTextures();
 };
 
 
@@ -42,6 +59,24 @@ class AsyncSceneSender : public AsyncSceneExporter
 public:
     int session_id = InvalidID;
     int message_count = 0;
+    // textures with mips larger than this are sent twice: the coarse levels before materials,
+    // and the full chain after the rest of the scene. 0 disables.
+    int texture_preview_size = 128;
+    // the offset to the server's clock is re-estimated at this interval
+    nanosec clock_sync_interval = 10LL * 1000000000LL;
+    // must be true if animation_deltas, texture_tiles or material_deltas are used.
+    // the server keeps the assets sent by Set as the bases of the deltas only if this is set (see SetFlags::retain_assets).
+    bool use_deltas = false;
+    // textures the server could not apply texture_tiles to (evicted, or the layout didn't match). set by send() and
+    // valid in on_success / on_error / on_complete. they must be sent entirely on the next update (see TextureManager::makeDirty()).
+    std::vector<int> lost_textures;
+
+    // adaptive precision: meshes are sent with reduced precision (see MeshPrecision) when sending them at
+    // full precision would take longer than latency_target_ms at the throughput measured on previous sends.
+    // the reduced meshes are sent again at full precision when no update has been kicked for refine_delay_ms.
+    bool adaptive_precision = false;
+    int latency_target_ms = 100;
+    int refine_delay_ms = 500;
 
     ClientSettings client_settings;
 
@@ -51,6 +86,9 @@ public:
 
     const std::string& getErrorMessage() const;
     bool isServerAvaileble();
+    // bytes per second. 0 if not measured yet
+    double getThroughput() const;
+    MeshPrecision getLastPrecision() const;
 
     bool isExporting() override;
     void wait() override;
@@ -58,9 +96,25 @@ public:
 
 private:
     void send();
+    void setupMessage(Message& mes);
+    MeshPrecision selectPrecision();
+    void updateThroughput(uint64_t bytes, nanosec elapsed);
+    // waits for refine_delay_ms and sends the reduced meshes at full precision
+    void refine();
 
     std::future<void> m_future;
+    std::atomic_bool m_sending{ false };
     std::string m_error_message;
+    ClockOffset m_clock_offset; // only touched by send()
+
+    // adaptive precision
+    nanosec m_queue_wait = 0; // time kick() waited for the previous send
+    double m_throughput = 0.0;
+    MeshPrecision m_last_precision = MeshPrecision::Full;
+    std::map<std::string, TransformPtr> m_refinements; // meshes sent with reduced precision
+    std::mutex m_refine_mutex;
+    std::condition_variable m_refine_cond;
+    std::atomic_bool m_cancel_refine{ false };
 };
 #endif // msEnableNetwork
 
@@ -0,0 +1,228 @@
+#include "pch.h"
+#include "msCulling.h"
+
+namespace ms {
+
+static const float kMinW = 1e-6f;
+
+static Bounds GetLocalBounds(const Mesh& mesh)
+{
+    if (mesh.bounds != Bounds{})
+        return mesh.bounds;
+
+    float3 bmin, bmax;
+    bmin = bmax = float3::zero();
+    MinMax(mesh.points.cdata(), mesh.points.size(), bmin, bmax);
+    return { (bmax + bmin) * 0.5f, abs(bmax - bmin) * 0.5f };
+}
+
+static void GetClipCorners(const Mesh& mesh, const float4x4& view_proj, float4 (&dst)[8])
+{
+    auto bounds = GetLocalBounds(mesh);
+    auto mvp = mesh.refine_settings.local2world * view_proj;
+    for (int i = 0; i < 8; ++i) {
+        float3 dir{ i & 1 ? 1.0f : -1.0f, i & 2 ? 1.0f : -1.0f, i & 4 ? 1.0f : -1.0f };
+        dst[i] = mul4(mvp, bounds.center + bounds.extents * dir);
+    }
+}
+
+static bool IsOutsideFrustum(const float4 (&corners)[8])
+{
+    uint32_t all = ~0u;
+    for (auto& c : corners) {
+        uint32_t code = 0;
+        if (c.x < -c.w) code |= 1;
+        if (c.x >  c.w) code |= 2;
+        if (c.y < -c.w) code |= 4;
+        if (c.y >  c.w) code |= 8;
+        if (c.z < -c.w) code |= 16;
+        if (c.z >  c.w) code |= 32;
+        all &= code;
+    }
+    return all != 0;
+}
+
+
+// coarse depth buffer. stores the nearest NDC depth (z/w) for each texel.
+class DepthBuffer
+{
+public:
+    void resize(int size)
+    {
+        m_size = size;
+        m_depth.assign(size * size, std::numeric_limits<float>::max());
+    }
+
+    void merge(const DepthBuffer& v)
+    {
+        size_t n = m_depth.size();
+        for (size_t i = 0; i < n; ++i)
+            m_depth[i] = std::min(m_depth[i], v.m_depth[i]);
+    }
+
+    // clip: points in clip space. polygons are triangulated as fans. empty counts means triangles.
+    void rasterize(const float4 *clip, const int *indices, size_t num_indices, const int *counts, size_t num_counts)
+    {
+        if (num_counts == 0) {
+            for (size_t ii = 0; ii + 2 < num_indices; ii += 3)
+                rasterizeTriangle(clip[indices[ii]], clip[indices[ii + 1]], clip[indices[ii + 2]]);
+            return;
+        }
+
+        size_t offset = 0;
+        for (size_t fi = 0; fi < num_counts; ++fi) {
+            int count = counts[fi];
+            if (offset + count > num_indices)
+                break;
+            for (int ci = 2; ci < count; ++ci)
+                rasterizeTriangle(clip[indices[offset]], clip[indices[offset + ci - 1]], clip[indices[offset + ci]]);
+            offset += count;
+        }
+    }
+
+    bool isOccluded(const float4 (&corners)[8]) const
+    {
+        float2 smin{ std::numeric_limits<float>::max(), std::numeric_limits<float>::max() };
+        float2 smax = -smin;
+        float nearest = std::numeric_limits<float>::max();
+        for (auto& c : corners) {
+            // bounds cross the camera plane. can't be projected
+            if (c.w <= kMinW)
+                return false;
+            auto s = toScreen(c);
+            smin = min(smin, s);
+            smax = max(smax, s);
+            nearest = std::min(nearest, c.z / c.w);
+        }
+
+        // every texel the rect touches
+        int x0 = std::max((int)std::floor(smin.x), 0);
+        int y0 = std::max((int)std::floor(smin.y), 0);
+        int x1 = std::min((int)std::ceil(smax.x), m_size);
+        int y1 = std::min((int)std::ceil(smax.y), m_size);
+        if (x0 >= x1 || y0 >= y1)
+            return false;
+
+        for (int y = y0; y < y1; ++y) {
+            const float *row = &m_depth[y * m_size];
+            for (int x = x0; x < x1; ++x) {
+                if (row[x] >= nearest)
+                    return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    float2 toScreen(const float4& c) const
+    {
+        float s = 0.5f * (float)m_size / c.w;
+        return { c.x * s + 0.5f * m_size, c.y * s + 0.5f * m_size };
+    }
+
+    void rasterizeTriangle(const float4& c0, const float4& c1, const float4& c2)
+    {
+        // triangles crossing the camera plane are skipped. dropping occluders only makes the test more conservative.
+        if (c0.w <= kMinW || c1.w <= kMinW || c2.w <= kMinW)
+            return;
+
+        auto p0 = toScreen(c0), p1 = toScreen(c1), p2 = toScreen(c2);
+        float z0 = c0.z / c0.w, z1 = c1.z / c1.w, z2 = c2.z / c2.w;
+        float area = (p1.x - p0.x) * (p2.y - p0.y) - (p1.y - p0.y) * (p2.x - p0.x);
+        if (area == 0.0f)
+            return;
+        // two sided. meshes can be open
+        float rcp_area = 1.0f / area;
+
+        // texels whose centers are in the bounding rect
+        auto bmin = min(min(p0, p1), p2);
+        auto bmax = max(max(p0, p1), p2);
+        int x0 = std::max((int)std::ceil(bmin.x - 0.5f), 0);
+        int y0 = std::max((int)std::ceil(bmin.y - 0.5f), 0);
+        int x1 = std::min((int)std::floor(bmax.x - 0.5f), m_size - 1);
+        int y1 = std::min((int)std::floor(bmax.y - 0.5f), m_size - 1);
+
+        for (int y = y0; y <= y1; ++y) {
+            float py = (float)y + 0.5f;
+            float *row = &m_depth[y * m_size];
+            for (int x = x0; x <= x1; ++x) {
+                float px = (float)x + 0.5f;
+                float w0 = ((p2.x - p1.x) * (py - p1.y) - (p2.y - p1.y) * (px - p1.x)) * rcp_area;
+                float w1 = ((p0.x - p2.x) * (py - p2.y) - (p0.y - p2.y) * (px - p2.x)) * rcp_area;
+                float w2 = 1.0f - w0 - w1;
+                if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+                    continue;
+                // z/w is linear in screen space
+                float z = w0 * z0 + w1 * z1 + w2 * z2;
+                row[x] = std::min(row[x], z);
+            }
+        }
+    }
+
+    int m_size = 0;
+    std::vector<float> m_depth;
+};
+
+
+size_t CullMeshes(const CullingSettings& settings, const Mesh * const *meshes, size_t num_meshes, bool *visible)
+{
+    int n = (int)num_meshes;
+    std::vector<float4> corners(n * 8);
+
+    // frustum culling
+    parallel_for(0, n, 16, [&](int mi) {
+        auto& c = (float4(&)[8])corners[mi * 8];
+        GetClipCorners(*meshes[mi], settings.view_proj, c);
+        visible[mi] = !IsOutsideFrustum(c);
+    });
+
+    if (settings.occlusion && settings.occlusion_buffer_size > 0) {
+        std::vector<int> candidates;
+        for (int mi = 0; mi < n; ++mi) {
+            if (visible[mi])
+                candidates.push_back(mi);
+        }
+
+        // rasterize candidates into per-block buffers, then merge them
+        int num_candidates = (int)candidates.size();
+        int num_blocks = std::min(num_candidates, std::max((int)std::thread::hardware_concurrency(), 1));
+        std::vector<DepthBuffer> buffers(num_blocks);
+        parallel_for(0, num_blocks, [&](int bi) {
+            auto& buffer = buffers[bi];
+            buffer.resize(settings.occlusion_buffer_size);
+
+            RawVector<float4> clip;
+            int begin = num_candidates * bi / num_blocks;
+            int end = num_candidates * (bi + 1) / num_blocks;
+            for (int ci = begin; ci < end; ++ci) {
+                auto& mesh = *meshes[candidates[ci]];
+                auto mvp = mesh.refine_settings.local2world * settings.view_proj;
+                size_t num_points = mesh.points.size();
+                clip.resize_discard(num_points);
+                for (size_t pi = 0; pi < num_points; ++pi)
+                    clip[pi] = mul4(mvp, mesh.points[pi]);
+                buffer.rasterize(clip.cdata(), mesh.indices.cdata(), mesh.indices.size(), mesh.counts.cdata(), mesh.counts.size());
+            }
+        });
+        for (int bi = 1; bi < num_blocks; ++bi)
+            buffers[0].merge(buffers[bi]);
+
+        if (num_blocks > 0) {
+            auto& depth = buffers[0];
+            parallel_for(0, num_candidates, 16, [&](int ci) {
+                int mi = candidates[ci];
+                if (depth.isOccluded((const float4(&)[8])corners[mi * 8]))
+                    visible[mi] = false;
+            });
+        }
+    }
+
+    size_t ret = 0;
+    for (int mi = 0; mi < n; ++mi) {
+        if (visible[mi])
+            ++ret;
+    }
+    return ret;
+}
+
+} // namespace ms
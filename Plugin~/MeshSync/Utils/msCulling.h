@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../SceneGraph/msSceneGraph.h"
+
+namespace ms {
+
+struct CullingSettings
+{
+    // world to clip matrix of the camera. clip space is OpenGL style (-w <= x, y, z <= w).
+    float4x4 view_proj = float4x4::identity();
+    // cull meshes that are hidden behind other meshes. done after frustum culling.
+    bool occlusion = false;
+    // width and height of the coarse depth buffer used by occlusion culling
+    int occlusion_buffer_size = 64;
+};
+
+// CPU culling of meshes against a camera. meshes are tested in parallel.
+// world matrix of a mesh is refine_settings.local2world and its bounds are in local space.
+// if a mesh has no bounds, bounds are computed from its points.
+//
+// frustum culling: a mesh is culled if all 8 corners of its bounds are outside of the same frustum plane.
+// occlusion culling: triangles of the meshes that passed frustum culling are rasterized into a coarse depth buffer,
+// and a mesh is culled if its bounds are behind every texel they cover. depth is sampled at texel centers,
+// so a mesh that is visible only through gaps narrower than a texel can be culled.
+//
+// visible[i] is set for meshes[i]. returns the number of visible meshes.
+size_t CullMeshes(const CullingSettings& settings, const Mesh * const *meshes, size_t num_meshes, bool *visible);
+
+} // namespace ms
@@ -4,6 +4,11 @@
 #ifndef msRuntime
 namespace ms {
 
+// geometries smaller than this are batched until the batch reaches kBatchVertices.
+// larger ones get their own task, and SumInt32() splits huge arrays across cores.
+static const uint64_t kSmallGeometryVertices = 4 * 1024;
+static const uint64_t kBatchVertices = 64 * 1024;
+
 EntityManager::EntityManager()
 {
 }
@@ -22,17 +27,21 @@ void EntityManager::clear()
 {
     waitTasks();
     m_records.clear();
+    m_host_ids.clear();
     m_deleted.clear();
+    m_deleted_paths.clear();
 }
 void EntityManager::clearEntityRecords()
 {
     waitTasks();
     m_records.clear();
+    m_host_ids.clear();
 }
 void EntityManager::clearDeleteRecords()
 {
     waitTasks();
     m_deleted.clear();
+    m_deleted_paths.clear();
 }
 
 
@@ -40,9 +49,8 @@ bool EntityManager::erase(const std::string& path)
 {
     auto it = m_records.find(path);
     if (it != m_records.end()) {
-        it->second.waitTask();
-        m_records.erase(it);
-        m_deleted.push_back({ path, InvalidID });
+        eraseRecord(it);
+        addDeleteRecord({ path, InvalidID });
         return true;
     }
     return false;
@@ -52,11 +60,10 @@ bool EntityManager::erase(int id)
 {
     if (id == InvalidID)
         return false;
-    auto it = std::find_if(m_records.begin(), m_records.end(), [id](const kvp& v) { return v.second.entity->host_id == id; });
-    if (it != m_records.end()) {
-        it->second.waitTask();
-        m_records.erase(it);
-        m_deleted.push_back({ std::string(), id });
+    auto hit = m_host_ids.find(id);
+    if (hit != m_host_ids.end()) {
+        eraseRecord(m_records.find(hit->second->first));
+        addDeleteRecord({ std::string(), id });
         return true;
     }
     return false;
@@ -64,15 +71,10 @@ bool EntityManager::erase(int id)
 
 bool EntityManager::erase(const Identifier& identifier)
 {
-    auto it = m_records.find(identifier.name);
-    if (it == m_records.end() && identifier.id != InvalidID) {
-        int id = identifier.id;
-        it = std::find_if(m_records.begin(), m_records.end(), [id](const kvp& v) { return v.second.entity->host_id == id; });
-    }
+    auto it = findRecord(identifier);
     if (it != m_records.end()) {
-        it->second.waitTask();
-        m_records.erase(it);
-        m_deleted.push_back(identifier);
+        eraseRecord(it);
+        addDeleteRecord(identifier);
         return true;
     }
     return false;
@@ -87,13 +89,23 @@ bool EntityManager::erase(TransformPtr v)
 
 bool EntityManager::eraseThreadSafe(TransformPtr v)
 {
+    if (!v)
+        return false;
+
+    auto identifier = v->getIdentifier();
     std::unique_lock<std::mutex> lock(m_mutex);
-    return erase(v);
+    auto it = findRecord(identifier);
+    if (it != m_records.end()) {
+        eraseRecordLocked(it);
+        addDeleteRecord(identifier);
+        return true;
+    }
+    return false;
 }
 
 inline void EntityManager::addTransform(TransformPtr obj)
 {
-    auto& rec = lockAndGet(obj->path);
+    auto& rec = lockAndGet(obj);
     rec.updated = true;
     rec.waitTask();
 
@@ -123,41 +135,36 @@ inline void EntityManager::addTransform(TransformPtr obj)
 
 inline void EntityManager::addGeometry(TransformPtr obj)
 {
-    auto& rec = lockAndGet(obj->path);
+    auto& rec = lockAndGet(obj);
     rec.updated = true;
+    if (rec.pending) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        flushPending();
+    }
     rec.waitTask();
 
-    if (!rec.entity) {
-        rec.entity = obj;
+    bool first = !rec.entity;
+    if (first) {
         rec.order = ++m_order;
         rec.dirty_geom = true;
+    }
+    rec.entity = obj;
+    obj->order = rec.order;
 
-        rec.task = std::async(std::launch::async, [this, obj, &rec]() {
-            rec.checksum_trans = obj->checksumTrans();
-            rec.checksum_geom = obj->checksumGeom();
-        });
+    if (obj->vertexCount() < kSmallGeometryVertices) {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        rec.pending = true;
+        m_pending.push_back({ &rec, obj, first });
+        m_pending_vertices += std::max<uint64_t>(obj->vertexCount(), 1);
+        if (m_pending_vertices >= kBatchVertices)
+            flushPending();
     }
     else {
-        rec.entity = obj;
-
-        rec.task = std::async(std::launch::async, [this, obj, &rec]() {
-            auto checksum_trans = obj->checksumTrans();
-            auto checksum_geom = obj->checksumGeom();
-            if (rec.checksum_geom != checksum_geom) {
-                rec.dirty_geom = true;
-                rec.checksum_trans = checksum_trans;
-                rec.checksum_geom = checksum_geom;
-            }
-            else if (m_always_mark_dirty) {
-                rec.dirty_geom = true;
-            }
-            else if (rec.checksum_trans != checksum_trans) {
-                rec.dirty_trans = true;
-                rec.checksum_trans = checksum_trans;
-            }
-        });
+        bool always_mark_dirty = m_always_mark_dirty;
+        rec.task = m_tasks.push([obj, &rec, first, always_mark_dirty]() {
+            rec.updateGeometryChecksums(*obj, first, always_mark_dirty);
+        }).share();
     }
-    obj->order = rec.order;
 }
 
 void EntityManager::add(TransformPtr obj)
@@ -175,6 +182,12 @@ void EntityManager::touch(const std::string& path)
         it->second.updated = true;
 }
 
+// records are not ordered. sort results to keep them deterministic
+static inline void SortByOrder(std::vector<TransformPtr>& v)
+{
+    std::sort(v.begin(), v.end(), [](auto& a, auto& b) { return a->order < b->order; });
+}
+
 std::vector<TransformPtr> EntityManager::getAllEntities()
 {
     waitTasks();
@@ -182,6 +195,7 @@ std::vector<TransformPtr> EntityManager::getAllEntities()
     std::vector<TransformPtr> ret;
     for (auto& v : m_records)
         ret.push_back(v.second.entity);
+    SortByOrder(ret);
     return ret;
 }
 
@@ -203,6 +217,7 @@ std::vector<TransformPtr> EntityManager::getDirtyTransforms()
             }
         }
     }
+    SortByOrder(ret);
     return ret;
 }
 
@@ -217,11 +232,20 @@ std::vector<TransformPtr> EntityManager::getDirtyGeometries()
             ret.push_back(r.entity);
         }
     }
+    SortByOrder(ret);
     return ret;
 }
 
 std::vector<Identifier>& EntityManager::getDeleted()
 {
+    // drop entries of re-added entities and re-index the rest
+    auto is_empty = [](const Identifier& v) { return v.name.empty() && v.id == InvalidID; };
+    m_deleted.erase(std::remove_if(m_deleted.begin(), m_deleted.end(), is_empty), m_deleted.end());
+    m_deleted_paths.clear();
+    for (size_t i = 0; i < m_deleted.size(); ++i) {
+        if (!m_deleted[i].name.empty())
+            m_deleted_paths[m_deleted[i].name] = i;
+    }
     return m_deleted;
 }
 
@@ -243,6 +267,7 @@ void EntityManager::clearDirtyFlags()
         r.updated = r.dirty_geom = r.dirty_trans = false;
     }
     m_deleted.clear();
+    m_deleted_paths.clear();
 }
 
 std::vector<TransformPtr> EntityManager::getStaleEntities()
@@ -255,18 +280,16 @@ std::vector<TransformPtr> EntityManager::getStaleEntities()
         if (!r.updated)
             ret.push_back(r.entity);
     }
+    SortByOrder(ret);
     return ret;
 }
 
 void EntityManager::eraseStaleEntities()
 {
-    for (auto it = m_records.begin(); it != m_records.end(); ) {
-        if (!it->second.updated) {
-            m_deleted.push_back(it->second.entity->getIdentifier());
-            m_records.erase(it++);
-        }
-        else
-            ++it;
+    for (auto& e : getStaleEntities()) {
+        auto identifier = e->getIdentifier();
+        eraseRecord(m_records.find(e->path));
+        addDeleteRecord(identifier);
     }
 }
 
@@ -277,19 +300,100 @@ void EntityManager::setAlwaysMarkDirty(bool v)
 
 void EntityManager::waitTasks()
 {
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        flushPending();
+    }
     for (auto& p : m_records)
         p.second.waitTask();
 }
 
-EntityManager::Record& EntityManager::lockAndGet(const std::string &path)
+void EntityManager::flushPending()
+{
+    if (m_pending.empty())
+        return;
+
+    auto batch = std::make_shared<std::vector<PendingGeometry>>(std::move(m_pending));
+    m_pending.clear();
+    m_pending_vertices = 0;
+
+    bool always_mark_dirty = m_always_mark_dirty;
+    auto task = m_tasks.push([batch, always_mark_dirty]() {
+        for (auto& p : *batch)
+            p.record->updateGeometryChecksums(*p.entity, p.first, always_mark_dirty);
+    }).share();
+    for (auto& p : *batch) {
+        p.record->pending = false;
+        p.record->task = task;
+    }
+}
+
+EntityManager::Record& EntityManager::lockAndGet(TransformPtr obj)
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto& path = obj->path;
+    if (!m_deleted_paths.empty()) {
+        auto dit = m_deleted_paths.find(path);
+        if (dit != m_deleted_paths.end()) {
+            m_deleted[dit->second] = {};
+            m_deleted_paths.erase(dit);
+        }
+    }
+
+    auto& v = *m_records.emplace(path, Record()).first;
+    int prev_host_id = v.second.entity ? v.second.entity->host_id : InvalidID;
+    if (prev_host_id != obj->host_id) {
+        auto hit = m_host_ids.find(prev_host_id);
+        if (hit != m_host_ids.end() && hit->second == &v)
+            m_host_ids.erase(hit);
+    }
+    if (obj->host_id != InvalidID)
+        m_host_ids[obj->host_id] = &v;
+    return v.second;
+}
+
+EntityManager::RecordMap::iterator EntityManager::findRecord(const Identifier& identifier)
+{
+    auto it = m_records.find(identifier.name);
+    if (it == m_records.end() && identifier.id != InvalidID) {
+        auto hit = m_host_ids.find(identifier.id);
+        if (hit != m_host_ids.end())
+            it = m_records.find(hit->second->first);
+    }
+    return it;
+}
+
+void EntityManager::eraseRecord(RecordMap::iterator it)
 {
     std::unique_lock<std::mutex> lock(m_mutex);
-    if (!m_deleted.empty()) {
-        auto it = std::find_if(m_deleted.begin(), m_deleted.end(), [&path](Identifier& v) { return v.name == path; });
-        if (it != m_deleted.end())
-            m_deleted.erase(it);
+    eraseRecordLocked(it);
+}
+
+void EntityManager::eraseRecordLocked(RecordMap::iterator it)
+{
+    auto& rec = it->second;
+    if (rec.pending)
+        flushPending();
+    rec.waitTask();
+    if (rec.entity && rec.entity->host_id != InvalidID) {
+        auto hit = m_host_ids.find(rec.entity->host_id);
+        if (hit != m_host_ids.end() && hit->second == &*it)
+            m_host_ids.erase(hit);
+    }
+    m_records.erase(it);
+}
+
+void EntityManager::addDeleteRecord(const Identifier& v)
+{
+    if (!v.name.empty()) {
+        auto dit = m_deleted_paths.find(v.name);
+        if (dit != m_deleted_paths.end()) {
+            m_deleted[dit->second] = v;
+            return;
+        }
+        m_deleted_paths[v.name] = m_deleted.size();
     }
-    return m_records[path];
+    m_deleted.push_back(v);
 }
 
 void EntityManager::Record::waitTask()
@@ -300,5 +404,27 @@ void EntityManager::Record::waitTask()
     }
 }
 
+void EntityManager::Record::updateGeometryChecksums(const Transform& obj, bool first, bool always_mark_dirty)
+{
+    auto ctrans = obj.checksumTrans();
+    auto cgeom = obj.checksumGeom();
+    if (first) {
+        checksum_trans = ctrans;
+        checksum_geom = cgeom;
+    }
+    else if (checksum_geom != cgeom) {
+        dirty_geom = true;
+        checksum_trans = ctrans;
+        checksum_geom = cgeom;
+    }
+    else if (always_mark_dirty) {
+        dirty_geom = true;
+    }
+    else if (checksum_trans != ctrans) {
+        dirty_trans = true;
+        checksum_trans = ctrans;
+    }
+}
+
 } // namespace ms
 #endif // msRuntime
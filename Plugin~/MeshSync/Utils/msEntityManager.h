@@ -1,6 +1,8 @@
 #pragma once
 
+#include <unordered_map>
 #include "../SceneGraph/msSceneGraph.h"
+#include "msTaskPool.h"
 
 #ifndef msRuntime
 namespace ms {
@@ -29,6 +31,7 @@ public:
 
     void touch(const std::string& path);
 
+    // results are sorted by Transform::order (the order of the first add())
     std::vector<TransformPtr> getAllEntities();
     std::vector<TransformPtr> getDirtyTransforms();
     std::vector<TransformPtr> getDirtyGeometries();
@@ -51,22 +54,46 @@ private:
         bool dirty_trans = false;
         bool dirty_geom = false;
         bool updated = false;
-        std::future<void> task;
+        bool pending = false; // in m_pending and no task yet
+        std::shared_future<void> task; // shared by the records of a batch
 
         void waitTask();
+        void updateGeometryChecksums(const Transform& obj, bool first, bool always_mark_dirty);
     };
+    struct PendingGeometry
+    {
+        Record *record;
+        TransformPtr entity;
+        bool first;
+    };
+    using RecordMap = std::unordered_map<std::string, Record>;
+    using kvp = RecordMap::value_type;
+
     void waitTasks();
-    Record& lockAndGet(const std::string& path);
+    Record& lockAndGet(TransformPtr v);
     void addTransform(TransformPtr v);
     void addGeometry(TransformPtr v);
-
-    using kvp = std::map<std::string, Record>::value_type;
+    RecordMap::iterator findRecord(const Identifier& identifier);
+    void eraseRecord(RecordMap::iterator it);
+    // m_mutex must be locked
+    void eraseRecordLocked(RecordMap::iterator it);
+    void addDeleteRecord(const Identifier& v);
+    // pushes the batch of small geometries to the task pool. m_mutex must be locked
+    void flushPending();
 
     int m_order = 0;
     bool m_always_mark_dirty = false;
-    std::map<std::string, Record> m_records;
-    std::vector<Identifier> m_deleted;
+    // records are node based. Record& stays valid on rehash (tasks hold it)
+    RecordMap m_records;
+    std::unordered_map<int, kvp*> m_host_ids;
+    std::vector<Identifier> m_deleted; // re-added entries are left as empty Identifiers until getDeleted()
+    std::unordered_map<std::string, size_t> m_deleted_paths; // path -> index in m_deleted
     std::mutex m_mutex;
+
+    // checksums of geometries are calculated in m_tasks. small ones are batched into a task
+    TaskPool m_tasks;
+    std::vector<PendingGeometry> m_pending;
+    uint64_t m_pending_vertices = 0;
 };
 
 } // namespace ms
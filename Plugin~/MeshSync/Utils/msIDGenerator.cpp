@@ -14,10 +14,9 @@ int PathToID::operator[](const std::string& path)
 
 void PathToID::rename(const std::string& old, const std::string& path)
 {
-    auto it = m_table.find(old);
-    if (it != m_table.end()) {
-        int id = it->second;
-        m_table.erase(it);
+    if (auto *p = m_table.find(old)) {
+        int id = *p;
+        m_table.erase(old);
         m_table[path] = id;
     }
 }
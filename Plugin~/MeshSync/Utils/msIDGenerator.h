@@ -1,6 +1,5 @@
 #pragma once
 
-#include <map>
 #include <vector>
 #include "msFoundation.h"
 #include "SceneGraph/msIdentifier.h"
@@ -19,26 +18,27 @@ public:
     void clear()
     {
         m_id_seed = 0;
+        m_generation = 0;
         m_records.clear();
+        m_reserved.clear();
     }
 
+    // erase records that are not referenced by getID() since last clearDirtyFlags()
     void eraseStaleRecords()
     {
-        for (auto it = m_records.begin(); it != m_records.end(); ) {
-            if (!it->second.updated) {
-                m_reserved.push_back(it->second.id);
-                m_records.erase(it++);
+        m_records.eraseIf([this](const void*, Record& rec) {
+            if (rec.generation != m_generation) {
+                m_reserved.push_back(rec.id);
+                return true;
             }
-            else
-                ++it;
-        }
+            return false;
+        });
     }
 
+    // O(1). records are marked stale by advancing the generation, not by visiting each of them.
     void clearDirtyFlags()
     {
-        for (auto& kvp : m_records) {
-            kvp.second.updated = false;
-        }
+        ++m_generation;
     }
 
 protected:
@@ -50,7 +50,7 @@ protected:
         auto& rec = m_records[p];
         if (rec.id == InvalidID)
             rec.id = genID();
-        rec.updated = true;
+        rec.generation = m_generation;
         return rec.id;
     }
 
@@ -70,10 +70,11 @@ protected:
     struct Record
     {
         int id = InvalidID;
-        bool updated = true;
+        uint32_t generation = 0; // up to date if equals to m_generation
     };
     int m_id_seed = 0;
-    std::map<const void*, Record> m_records;
+    uint32_t m_generation = 0;
+    mu::FlatHashMap<const void*, Record> m_records;
     std::vector<int> m_reserved;
 };
 
@@ -107,7 +108,7 @@ public:
 
 protected:
     int m_seed = 0;
-    std::map<std::string, int> m_table;
+    mu::FlatHashMap<std::string, int> m_table;
 };
 
 class Scene;
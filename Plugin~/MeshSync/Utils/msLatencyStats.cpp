@@ -0,0 +1,108 @@
+#include "pch.h"
+#include "msLatencyStats.h"
+
+namespace ms {
+
+void LatencyHistogram::add(nanosec v)
+{
+    // negative durations can come from clock offset errors
+    v = std::max<nanosec>(v, 0);
+    ++m_buckets[getBucketIndex(v)];
+    if (m_count == 0) {
+        m_min = m_max = v;
+    }
+    else {
+        m_min = std::min(m_min, v);
+        m_max = std::max(m_max, v);
+    }
+    ++m_count;
+    m_sum += v;
+}
+
+void LatencyHistogram::clear()
+{
+    *this = LatencyHistogram();
+}
+
+uint64_t LatencyHistogram::getCount() const { return m_count; }
+nanosec LatencyHistogram::getMin() const { return m_min; }
+nanosec LatencyHistogram::getMax() const { return m_max; }
+nanosec LatencyHistogram::getAverage() const { return m_count ? m_sum / (nanosec)m_count : 0; }
+const uint64_t* LatencyHistogram::getBuckets() const { return m_buckets; }
+
+nanosec LatencyHistogram::getPercentile(float p) const
+{
+    if (m_count == 0)
+        return 0;
+
+    uint64_t n = std::max<uint64_t>((uint64_t)std::ceil(mu::clamp01(p) * m_count), 1);
+    uint64_t total = 0;
+    for (int i = 0; i < NumBuckets; ++i) {
+        total += m_buckets[i];
+        if (total >= n)
+            return i + 1 < NumBuckets ? std::min(getBucketLowerBound(i + 1), m_max) : m_max;
+    }
+    return m_max;
+}
+
+int LatencyHistogram::getBucketIndex(nanosec v)
+{
+    uint64_t us = (uint64_t)v / 1000;
+    if (us < 4)
+        return (int)us;
+
+    int msb = 2;
+    while ((us >> (msb + 1)) != 0)
+        ++msb;
+    int sub = (int)(us >> (msb - 2)) & 3;
+    return std::min((msb - 1) * 4 + sub, NumBuckets - 1);
+}
+
+nanosec LatencyHistogram::getBucketLowerBound(int i)
+{
+    if (i < 4)
+        return (nanosec)i * 1000;
+    int msb = i / 4 + 1;
+    int sub = i % 4;
+    return (nanosec)((uint64_t)(4 + sub) << (msb - 2)) * 1000;
+}
+
+
+void LatencyStats::add(const Message& mes, nanosec consume_begin, nanosec consume_end)
+{
+    auto& l = mes.latency;
+    std::unique_lock<std::mutex> lock(m_mutex);
+    auto record = [this](LatencyStage stage, nanosec v) { m_histograms[(int)stage].add(v); };
+
+    nanosec sent = mes.timestamp_send + l.clock_offset;
+    if (l.serialize > 0)
+        record(LatencyStage::Serialize, l.serialize);
+    if (l.timestamp_request != 0) {
+        nanosec transfer = l.transfer_wait;
+        if (l.clock_synced)
+            transfer += std::max<nanosec>(l.timestamp_request - (sent + l.serialize), 0);
+        record(LatencyStage::Transfer, transfer);
+        record(LatencyStage::Deserialize, mes.timestamp_recv - l.timestamp_request - l.transfer_wait);
+    }
+    if (l.timestamp_imported != 0)
+        record(LatencyStage::Import, l.timestamp_imported - mes.timestamp_recv);
+    record(LatencyStage::Queue, consume_begin - std::max(mes.timestamp_recv, l.timestamp_imported));
+    record(LatencyStage::Consume, consume_end - consume_begin);
+    if (l.clock_synced)
+        record(LatencyStage::Total, consume_end - sent);
+}
+
+void LatencyStats::clear()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    for (auto& h : m_histograms)
+        h.clear();
+}
+
+LatencyHistogram LatencyStats::get(LatencyStage stage) const
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    return m_histograms[(int)stage];
+}
+
+} // namespace ms
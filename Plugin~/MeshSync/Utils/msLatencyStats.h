@@ -0,0 +1,63 @@
+#pragma once
+
+#include <mutex>
+#include "../msProtocol.h"
+
+namespace ms {
+
+// must be synced with C# side
+enum class LatencyStage : int
+{
+    Serialize,  // size pass of the message on the sender
+    Transfer,   // from the sender's timestamp_send + Serialize to the request, plus waiting for the body. needs clock sync for the first part
+    Deserialize,
+    Import,     // import task on the server
+    Queue,      // waiting for processMessages()
+    Consume,    // handling in processMessages()
+    Total,      // from timestamp_send to the end of Consume. needs clock sync
+    Count,
+};
+
+// log-linear histogram of durations: 4 buckets per power of 2 microseconds. within 25% up to ~1 minute.
+class LatencyHistogram
+{
+public:
+    static const int NumBuckets = 100;
+
+    void add(nanosec v);
+    void clear();
+
+    uint64_t getCount() const;
+    nanosec getMin() const;
+    nanosec getMax() const;
+    nanosec getAverage() const;
+    // p: 0.0 - 1.0. returns the upper bound of the bucket that contains the percentile, clamped to max
+    nanosec getPercentile(float p) const;
+    const uint64_t* getBuckets() const;
+
+    static int getBucketIndex(nanosec v);
+    // lower bound of the bucket. the upper bound is the lower bound of the next one.
+    static nanosec getBucketLowerBound(int i);
+
+private:
+    uint64_t m_buckets[NumBuckets] = {};
+    uint64_t m_count = 0;
+    nanosec m_sum = 0;
+    nanosec m_min = 0;
+    nanosec m_max = 0;
+};
+
+// aggregates MessageLatency of handled messages per stage. thread safe.
+class LatencyStats
+{
+public:
+    void add(const Message& mes, nanosec consume_begin, nanosec consume_end);
+    void clear();
+    LatencyHistogram get(LatencyStage stage) const;
+
+private:
+    mutable std::mutex m_mutex;
+    LatencyHistogram m_histograms[(int)LatencyStage::Count];
+};
+
+} // namespace ms
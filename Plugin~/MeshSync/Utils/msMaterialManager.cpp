@@ -52,7 +52,10 @@ bool MaterialManager::add(MaterialPtr material)
     auto csum = material->checksum();
     if (rec.checksum != csum) {
         rec.checksum = csum;
-        rec.dirty = true;
+        if (m_use_deltas)
+            updateDelta(rec, *material);
+        else
+            rec.dirty = true;
     }
     else if (m_always_mark_dirty)
         rec.dirty = true;
@@ -87,6 +90,30 @@ std::vector<MaterialPtr> MaterialManager::getDirtyMaterials()
     return ret;
 }
 
+std::vector<MaterialPtr> MaterialManager::getMaterialDeltas()
+{
+    std::vector<MaterialPtr> ret;
+    for (auto& v : m_records) {
+        auto& rec = v.second;
+        if (rec.dirty || rec.dirty_properties.empty())
+            continue;
+
+        auto& src = *rec.material;
+        auto dst = Material::create();
+        dst->id = src.id;
+        dst->name = src.name;
+        dst->index = src.index;
+        dst->shader = src.shader;
+        for (auto& name : rec.dirty_properties) {
+            // deep copy. rec.material can be replaced while the delta is being sent
+            if (auto *prop = src.findProperty(name.c_str()))
+                dst->addProperty(prop->clone());
+        }
+        ret.push_back(dst);
+    }
+    return ret;
+}
+
 std::vector<Identifier>& MaterialManager::getDeleted()
 {
     return m_deleted;
@@ -104,6 +131,7 @@ void MaterialManager::clearDirtyFlags()
     for (auto& p : m_records) {
         auto& r = p.second;
         r.updated = r.dirty = false;
+        r.dirty_properties.clear();
     }
     m_deleted.clear();
 }
@@ -136,6 +164,57 @@ void MaterialManager::setAlwaysMarkDirty(bool v)
     m_always_mark_dirty = v;
 }
 
+void MaterialManager::setUseDeltas(bool v)
+{
+    if (m_use_deltas == v)
+        return;
+    m_use_deltas = v;
+    // the receiver may not have the current materials as the bases of deltas.
+    // forget the per-property checksums so that the next change sends the whole material.
+    for (auto& p : m_records) {
+        auto& r = p.second;
+        r.property_checksums.clear();
+        r.dirty_properties.clear();
+    }
+}
+
+void MaterialManager::updateDelta(Record& rec, const Material& mat)
+{
+    uint64_t base_checksum = csum(mat.index) + csum(mat.shader) + csum(mat.keywords);
+    bool delta = !rec.dirty && !rec.property_checksums.empty() && rec.base_checksum == base_checksum;
+    rec.base_checksum = base_checksum;
+
+    std::unordered_map<std::string, uint64_t> checksums;
+    checksums.reserve(mat.properties.size());
+    size_t matched = 0;
+    for (auto& prop : mat.properties) {
+        uint64_t c = prop.checksum() + (uint64_t)prop.type;
+        checksums[prop.name] = c;
+        if (!delta)
+            continue;
+
+        auto it = rec.property_checksums.find(prop.name);
+        if (it != rec.property_checksums.end()) {
+            ++matched;
+            if (it->second == c)
+                continue;
+        }
+        auto& dirty = rec.dirty_properties;
+        if (std::find(dirty.begin(), dirty.end(), prop.name) == dirty.end())
+            dirty.push_back(prop.name);
+    }
+
+    // removed properties can't be expressed by a delta. also, a delta that has all properties is pointless.
+    if (delta && (matched < rec.property_checksums.size() || rec.dirty_properties.size() >= mat.properties.size()))
+        delta = false;
+    rec.property_checksums = std::move(checksums);
+
+    if (!delta) {
+        rec.dirty = true;
+        rec.dirty_properties.clear();
+    }
+}
+
 MaterialManager::Record& MaterialManager::lockAndGet(int id)
 {
     std::unique_lock<std::mutex> lock(m_mutex);
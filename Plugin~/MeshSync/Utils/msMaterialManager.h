@@ -1,5 +1,6 @@
 #pragma once
 
+#include <unordered_map>
 #include "SceneGraph/msMaterial.h"
 
 #ifndef msRuntime
@@ -27,6 +28,9 @@ public:
 
     std::vector<MaterialPtr> getAllMaterials();
     std::vector<MaterialPtr> getDirtyMaterials();
+    // materials that have only some properties changed. each has the header (id, name, index, shader) and
+    // the changed properties only. see setUseDeltas()
+    std::vector<MaterialPtr> getMaterialDeltas();
     std::vector<Identifier>& getDeleted();
     void makeDirtyAll();
     void clearDirtyFlags();
@@ -35,18 +39,28 @@ public:
     void eraseStaleMaterials();
 
     void setAlwaysMarkDirty(bool v);
+    // if true, add() compares materials per property and partially changed materials are reported by
+    // getMaterialDeltas() instead of getDirtyMaterials().
+    // changes of index, shader or keywords and removed properties still mark the whole material dirty.
+    // the first change after switching this sends the whole material.
+    void setUseDeltas(bool v);
 
 private:
     struct Record
     {
         MaterialPtr material;
         uint64_t checksum = 0;
+        uint64_t base_checksum = 0; // index, shader and keywords
+        std::unordered_map<std::string, uint64_t> property_checksums;
+        std::vector<std::string> dirty_properties; // valid only if !dirty
         bool dirty = false;
         bool updated = false;
     };
     Record& lockAndGet(int id);
+    void updateDelta(Record& rec, const Material& mat);
 
     bool m_always_mark_dirty = false;
+    bool m_use_deltas = false;
     std::map<int, Record> m_records;
     std::vector<Identifier> m_deleted;
     std::mutex m_mutex;
@@ -0,0 +1,180 @@
+#include "pch.h"
+#include "msRaycast.h"
+#include "../msMisc.h"
+
+namespace ms {
+
+static uint64_t GetTopologyChecksum(const Mesh& mesh)
+{
+    uint64_t ret = Hash64(mesh.points.cdata(), mesh.points.size() * sizeof(float3));
+    ret = Hash64(mesh.indices.cdata(), mesh.indices.size() * sizeof(int), ret);
+    ret = Hash64(mesh.counts.cdata(), mesh.counts.size() * sizeof(int), ret);
+    return ret;
+}
+
+static void BuildBVH(mu::TriangleBVH& dst, const Mesh& mesh)
+{
+    // polygons are triangulated as fans. empty counts means triangles
+    RawVector<int> indices, faces;
+    size_t num_indices = mesh.indices.size();
+    if (mesh.counts.empty()) {
+        size_t num_triangles = num_indices / 3;
+        indices.assign(mesh.indices.cdata(), mesh.indices.cdata() + num_triangles * 3);
+    }
+    else {
+        size_t offset = 0;
+        int num_faces = (int)mesh.counts.size();
+        for (int fi = 0; fi < num_faces; ++fi) {
+            int count = mesh.counts[fi];
+            if (offset + count > num_indices)
+                break;
+            for (int ci = 2; ci < count; ++ci) {
+                indices.push_back(mesh.indices[offset]);
+                indices.push_back(mesh.indices[offset + ci - 1]);
+                indices.push_back(mesh.indices[offset + ci]);
+                faces.push_back(fi);
+            }
+            offset += count;
+        }
+    }
+    dst.build(mesh.points.cdata(), indices.cdata(), indices.size() / 3, faces.empty() ? nullptr : faces.cdata());
+}
+
+void RaycastScene::update(const Mesh * const *meshes, size_t num_meshes)
+{
+    ++m_generation;
+
+    std::vector<Instance*> rebuild;
+    std::vector<const Mesh*> rebuild_src;
+    for (size_t mi = 0; mi < num_meshes; ++mi) {
+        auto& mesh = *meshes[mi];
+        bool inserted;
+        auto& inst = m_instances.emplace(mesh.path, inserted);
+        inst.generation = m_generation;
+        inst.host_id = mesh.host_id;
+        inst.local2world = mesh.refine_settings.local2world;
+        inst.world2local = mu::invert(inst.local2world);
+
+        auto checksum = GetTopologyChecksum(mesh);
+        if (inserted || checksum != inst.checksum) {
+            inst.checksum = checksum;
+            if (!inst.bvh)
+                inst.bvh = std::make_shared<mu::TriangleBVH>();
+            rebuild_src.push_back(&mesh);
+        }
+    }
+    m_instances.eraseIf([this](const std::string&, Instance& inst) { return inst.generation != m_generation; });
+
+    // pointers to instances are stable from here
+    for (auto *mesh : rebuild_src)
+        rebuild.push_back(m_instances.find(mesh->path));
+    parallel_for(0, (int)rebuild.size(), [&](int i) {
+        BuildBVH(*rebuild[i]->bvh, *rebuild_src[i]);
+    });
+
+    // top-level BVH over the world bounds of the meshes
+    std::vector<const Instance*> list;
+    m_instances.each([&](const std::string&, Instance& inst) {
+        if (!inst.bvh->empty())
+            list.push_back(&inst);
+    });
+
+    int n = (int)list.size();
+    RawVector<float3> bmin(n), bmax(n);
+    for (int i = 0; i < n; ++i) {
+        auto& inst = *list[i];
+        float3 lmin = inst.bvh->getBoundsMin(), lmax = inst.bvh->getBoundsMax();
+        for (int c = 0; c < 8; ++c) {
+            float3 p = mul_p(inst.local2world, float3{ c & 1 ? lmax.x : lmin.x, c & 2 ? lmax.y : lmin.y, c & 4 ? lmax.z : lmin.z });
+            bmin[i] = c == 0 ? p : min(bmin[i], p);
+            bmax[i] = c == 0 ? p : max(bmax[i], p);
+        }
+    }
+    m_tlas.build(bmin.cdata(), bmax.cdata(), n, 1);
+
+    auto& order = m_tlas.getOrder();
+    m_list.resize(n);
+    for (int i = 0; i < n; ++i)
+        m_list[i] = list[order[i]];
+}
+
+void RaycastScene::clear()
+{
+    m_instances.clear();
+    m_list.clear();
+    m_tlas.clear();
+}
+
+size_t RaycastScene::size() const
+{
+    return m_instances.size();
+}
+
+RaycastHit RaycastScene::raycast(float3 pos, float3 dir, float max_distance) const
+{
+    RaycastHit ret{ InvalidID, -1, max_distance, float3::zero() };
+    bool hit = false;
+    m_tlas.raycast(pos, dir, max_distance, [&](int first, int count, float& max_d) {
+        for (int i = first; i < first + count; ++i) {
+            auto& inst = *m_list[i];
+            // ray parameter is preserved by affine transforms. no need to convert distances
+            float3 lpos = mul_p(inst.world2local, pos);
+            float3 ldir = mul_v(inst.world2local, dir);
+            float d;
+            int face;
+            if (inst.bvh->raycast(lpos, ldir, max_d, d, face)) {
+                max_d = d;
+                ret = { inst.host_id, face, d, pos + dir * d };
+                hit = true;
+            }
+        }
+    });
+    if (!hit)
+        ret.distance = 0.0f;
+    return ret;
+}
+
+RaycastHit RaycastScene::closestPoint(float3 pos, float max_distance) const
+{
+    RaycastHit ret{ InvalidID, -1, max_distance, float3::zero() };
+    bool hit = false;
+    m_tlas.nearest(pos, max_distance, [&](int first, int count, float& max_d) {
+        for (int i = first; i < first + count; ++i) {
+            auto& inst = *m_list[i];
+            float3 lpos = mul_p(inst.world2local, pos);
+            float3 lpoint;
+            float ld;
+            int face;
+            if (inst.bvh->closestPoint(lpos, FLT_MAX, lpoint, ld, face)) {
+                float3 point = mul_p(inst.local2world, lpoint);
+                float d = length(point - pos);
+                if (d <= max_d) {
+                    max_d = d;
+                    ret = { inst.host_id, face, d, point };
+                    hit = true;
+                }
+            }
+        }
+    });
+    if (!hit)
+        ret.distance = 0.0f;
+    return ret;
+}
+
+void RaycastScene::raycast(const float3 *pos, const float3 *dir, size_t num, float max_distance, RaycastHit *dst) const
+{
+    parallel_for_blocked(0, (int)num, 64, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i)
+            dst[i] = raycast(pos[i], dir[i], max_distance);
+    });
+}
+
+void RaycastScene::closestPoint(const float3 *pos, size_t num, float max_distance, RaycastHit *dst) const
+{
+    parallel_for_blocked(0, (int)num, 64, [&](int begin, int end) {
+        for (int i = begin; i < end; ++i)
+            dst[i] = closestPoint(pos[i], max_distance);
+    });
+}
+
+} // namespace ms
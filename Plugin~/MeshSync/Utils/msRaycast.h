@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cfloat>
+#include "../SceneGraph/msSceneGraph.h"
+
+namespace ms {
+
+// must be synced with C# side
+struct RaycastHit
+{
+    int host_id;    // host id of the mesh. InvalidID if nothing was hit
+    int face;       // face index in the mesh
+    float distance;
+    float3 point;   // world space
+};
+
+// meshes and their BVHs for raycast and closest point queries.
+// a BVH is built for each mesh in its local space and a top-level BVH is built over the meshes in world space.
+class RaycastScene
+{
+public:
+    // world matrix of a mesh is refine_settings.local2world. meshes are identified by path.
+    // BVHs are rebuilt in parallel only for meshes whose geometry has changed. meshes not in the list are removed.
+    void update(const Mesh * const *meshes, size_t num_meshes);
+    void clear();
+    size_t size() const;
+
+    // distance is in units of dir's length
+    RaycastHit raycast(float3 pos, float3 dir, float max_distance = FLT_MAX) const;
+    // closest point on the surfaces. exact for meshes without non-uniform scale
+    RaycastHit closestPoint(float3 pos, float max_distance = FLT_MAX) const;
+
+    // batch versions. queries are done in parallel
+    void raycast(const float3 *pos, const float3 *dir, size_t num, float max_distance, RaycastHit *dst) const;
+    void closestPoint(const float3 *pos, size_t num, float max_distance, RaycastHit *dst) const;
+
+private:
+    struct Instance
+    {
+        std::shared_ptr<mu::TriangleBVH> bvh;
+        uint64_t checksum = 0;
+        float4x4 local2world = float4x4::identity();
+        float4x4 world2local = float4x4::identity();
+        int host_id = InvalidID;
+        uint32_t generation = 0;
+    };
+
+    mu::FlatHashMap<std::string, Instance> m_instances;
+    std::vector<const Instance*> m_list; // in the order of the top-level BVH's primitives
+    mu::BVH m_tlas;
+    uint32_t m_generation = 0;
+};
+
+} // namespace ms
@@ -0,0 +1,432 @@
+#include "pch.h"
+#include "msSceneRecorder.h"
+#include "../SceneGraph/msMesh.h"
+#include "../SceneGraph/msAnimation.h"
+#include "../SceneGraph/msTexture.h"
+#include "../SceneGraph/msMaterial.h"
+
+#ifdef msEnableSceneCache
+namespace ms {
+
+SceneRecorderSettings::SceneRecorderSettings()
+{
+    // sessions don't come at a fixed rate
+    oscs.sample_rate = 0.0f;
+    oscs.strip_unchanged = 1;
+    oscs.apply_refinement = 0;
+}
+
+SceneRecorder::SceneRecorder()
+{
+}
+
+SceneRecorder::~SceneRecorder()
+{
+    close();
+}
+
+bool SceneRecorder::open(const char *path, const SceneRecorderSettings& settings)
+{
+    close();
+    m_osc = OpenOSceneCacheFile(path, settings.oscs);
+    if (!m_osc)
+        return false;
+
+    m_max_queue_size = std::max(settings.oscs.max_queue_size, 1);
+    m_max_records = std::max(settings.max_queue_size, 1);
+    m_stop = false;
+    m_thread = std::thread([this]() { recordLoop(); });
+    return true;
+}
+
+void SceneRecorder::close()
+{
+    if (!valid())
+        return;
+
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    m_thread.join();
+
+    // destroying OSceneCache writes the remaining scenes and meta data
+    m_osc.reset();
+    m_records.clear();
+    // a session that has not ended is not recorded
+    m_pending = Record();
+    m_entities.clear();
+    m_assets.clear();
+    m_bases.clear();
+    m_first_timestamp = 0;
+    m_time = 0.0f;
+    m_dirty = false;
+}
+
+bool SceneRecorder::valid() const
+{
+    return m_osc != nullptr;
+}
+
+void SceneRecorder::addScene(ScenePtr scene, bool retain_assets)
+{
+    if (!valid() || !scene)
+        return;
+
+    auto& rec = m_pending;
+    rec.settings = scene->settings;
+    rec.has_settings = true;
+    rec.entities.insert(rec.entities.end(), scene->entities.begin(), scene->entities.end());
+    for (auto& a : scene->assets) {
+        rec.assets.push_back(a);
+        auto type = a->getAssetType();
+        if (a->id != InvalidID && (type == AssetType::Texture || type == AssetType::Material || type == AssetType::Animation))
+            (retain_assets ? rec.bases : rec.unretained).push_back(a);
+    }
+}
+
+void SceneRecorder::addAnimationDeltas(const std::vector<AnimationClipDelta>& deltas)
+{
+    if (!valid())
+        return;
+
+    for (auto& delta : deltas) {
+        m_pending.animation_deltas.push_back(delta);
+        m_pending.animation_deltas.back().merged = nullptr;
+    }
+}
+
+void SceneRecorder::addTextureTiles(const std::vector<TextureTiles>& tiles)
+{
+    if (!valid())
+        return;
+
+    for (auto& tt : tiles) {
+        m_pending.texture_tiles.push_back(tt);
+        auto& dst = m_pending.texture_tiles.back();
+        dst.merged = nullptr;
+        dst.source = nullptr;
+        // the tile data belong to the message
+        for (auto& tile : dst.tiles)
+            tile.data.detach();
+    }
+}
+
+void SceneRecorder::addMaterialDeltas(const std::vector<MaterialPtr>& deltas)
+{
+    if (!valid())
+        return;
+
+    m_pending.material_deltas.insert(m_pending.material_deltas.end(), deltas.begin(), deltas.end());
+}
+
+void SceneRecorder::deleteEntities(const std::vector<Identifier>& entities)
+{
+    if (!valid())
+        return;
+
+    m_pending.deleted.insert(m_pending.deleted.end(), entities.begin(), entities.end());
+}
+
+void SceneRecorder::endScene(nanosec timestamp)
+{
+    if (!valid())
+        return;
+
+    m_pending.timestamp = timestamp;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        if ((int)m_records.size() >= m_max_records) {
+            // the recording thread is behind. never wait for it
+            m_records.back().coalesce(m_pending);
+            ++m_scene_count_coalesced;
+        }
+        else {
+            m_records.push_back(std::move(m_pending));
+        }
+    }
+    m_pending = Record();
+    m_cond.notify_all();
+}
+
+int SceneRecorder::getSceneCountRecorded() const
+{
+    return m_scene_count_recorded;
+}
+
+int SceneRecorder::getSceneCountCoalesced() const
+{
+    return m_scene_count_coalesced;
+}
+
+static void ClearUnchangedFlags(Transform& e)
+{
+    e.td_flags.unchanged = 0;
+    if (e.getType() == EntityType::Mesh) {
+        auto& mesh = static_cast<Mesh&>(e);
+        mesh.md_flags.unchanged = 0;
+        mesh.md_flags.topology_unchanged = 0;
+    }
+}
+
+static bool IsSameAsset(const Asset& a, const Asset& b)
+{
+    return a.getAssetType() == b.getAssetType() && a.id == b.id;
+}
+
+void SceneRecorder::Record::coalesce(Record& next)
+{
+    auto append = [](auto& dst, auto& src) { dst.insert(dst.end(), src.begin(), src.end()); };
+
+    // updates of deleted entities are dropped. every delete is kept
+    for (auto& id : next.deleted) {
+        entities.erase(std::remove_if(entities.begin(), entities.end(), [&id](TransformPtr& e) {
+            return e->path == id.name || (id.id != InvalidID && e->host_id == id.id);
+        }), entities.end());
+    }
+    append(deleted, next.deleted);
+
+    // the latest entity per path. it has only what has changed since the older one, so fill the rest from it.
+    // the merged entity shares the data of both, so they are kept in sources.
+    std::map<std::string, size_t> indices;
+    for (size_t i = 0; i < entities.size(); ++i)
+        indices[entities[i]->path] = i;
+    for (auto& e : next.entities) {
+        auto it = indices.find(e->path);
+        if (it == indices.end()) {
+            indices[e->path] = entities.size();
+            entities.push_back(e);
+            continue;
+        }
+        auto& last = entities[it->second];
+        auto merged = std::static_pointer_cast<Transform>(e->clone());
+        if (merged->merge(*last)) {
+            merged->setupDataFlags();
+            ClearUnchangedFlags(*merged);
+        }
+        sources.push_back(last);
+        sources.push_back(e);
+        last = merged;
+    }
+    append(sources, next.sources);
+
+    // deltas for assets sent again are superseded
+    auto resent = [&next](AssetType type, auto&& match) {
+        for (auto *list : { &next.bases, &next.unretained }) {
+            for (auto& a : *list) {
+                if (a->getAssetType() == type && match(*a))
+                    return true;
+            }
+        }
+        return false;
+    };
+    animation_deltas.erase(std::remove_if(animation_deltas.begin(), animation_deltas.end(), [&](AnimationClipDelta& d) {
+        return resent(AssetType::Animation, [&d](Asset& a) { return d.isTarget(static_cast<AnimationClip&>(a)); });
+    }), animation_deltas.end());
+    texture_tiles.erase(std::remove_if(texture_tiles.begin(), texture_tiles.end(), [&](TextureTiles& tt) {
+        return resent(AssetType::Texture, [&tt](Asset& a) { return a.id == tt.texture_id; });
+    }), texture_tiles.end());
+    material_deltas.erase(std::remove_if(material_deltas.begin(), material_deltas.end(), [&](MaterialPtr& m) {
+        return resent(AssetType::Material, [&m](Asset& a) { return a.id == m->id; });
+    }), material_deltas.end());
+
+    // the latest retain state per asset
+    auto remove_same = [](std::vector<AssetPtr>& dst, std::vector<AssetPtr>& src) {
+        dst.erase(std::remove_if(dst.begin(), dst.end(), [&src](AssetPtr& a) {
+            return std::any_of(src.begin(), src.end(), [&a](AssetPtr& b) { return IsSameAsset(*a, *b); });
+        }), dst.end());
+    };
+    remove_same(bases, next.unretained);
+    remove_same(unretained, next.bases);
+
+    append(assets, next.assets);
+    append(bases, next.bases);
+    append(unretained, next.unretained);
+    append(animation_deltas, next.animation_deltas);
+    append(texture_tiles, next.texture_tiles);
+    append(material_deltas, next.material_deltas);
+    if (next.has_settings) {
+        settings = next.settings;
+        has_settings = true;
+    }
+    timestamp = next.timestamp;
+}
+
+void SceneRecorder::recordLoop()
+{
+    std::vector<Record> records;
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait(lock, [this]() { return m_stop || !m_records.empty(); });
+            if (m_records.empty())
+                break;
+            std::swap(records, m_records);
+        }
+        for (auto& rec : records)
+            apply(rec);
+        records.clear();
+    }
+
+    // the last session may have been coalesced
+    if (m_dirty)
+        writeScene();
+}
+
+SceneRecorder::Base* SceneRecorder::findBase(AssetType type, int id)
+{
+    auto it = std::find_if(m_bases.begin(), m_bases.end(), [type, id](Base& b) {
+        return b.asset->getAssetType() == type && b.asset->id == id;
+    });
+    return it != m_bases.end() ? &(*it) : nullptr;
+}
+
+AssetPtr SceneRecorder::getWritableBase(Base& base)
+{
+    if (base.owned)
+        return base.asset;
+
+    // shared with the received scene or m_osc. copy on write
+    auto& src = *base.asset;
+    switch (src.getAssetType()) {
+    case AssetType::Animation:
+        base.asset = static_cast<AnimationClip&>(src).clone();
+        break;
+    case AssetType::Material:
+        base.asset = static_cast<Material&>(src).clone();
+        break;
+    case AssetType::Texture:
+    {
+        auto copy = Texture::create();
+        *copy = static_cast<Texture&>(src);
+        copy->data.detach();
+        base.asset = copy;
+        break;
+    }
+    default:
+        break;
+    }
+    base.owned = true;
+    return base.asset;
+}
+
+void SceneRecorder::addPatched(AssetPtr a)
+{
+    auto it = std::find_if(m_assets.begin(), m_assets.end(), [&a](AssetPtr& p) { return IsSameAsset(*p, *a); });
+    if (a->id != InvalidID && it != m_assets.end())
+        *it = a;
+    else
+        m_assets.push_back(a);
+}
+
+void SceneRecorder::apply(Record& rec)
+{
+    for (auto& id : rec.deleted) {
+        if (!m_entities.erase(id.name) && id.id != InvalidID)
+            m_entities.eraseIf([&id](const std::string&, TransformPtr& e) { return e->host_id == id.id; });
+    }
+
+    if (rec.has_settings)
+        m_settings = rec.settings;
+    for (auto& src : rec.entities) {
+        // received entities are shared with the handler and have only what has changed. merge into a copy.
+        // merged data are shared with the last version (not ref counted), so detach before the last version is released.
+        auto e = std::static_pointer_cast<Transform>(src->clone());
+        if (auto *last = m_entities.find(e->path)) {
+            e->merge(**last);
+            e->setupDataFlags();
+            ClearUnchangedFlags(*e);
+        }
+        e->detach();
+        m_entities[e->path] = e;
+    }
+
+    for (auto& a : rec.assets)
+        addPatched(a);
+    for (auto& a : rec.bases) {
+        if (auto *base = findBase(a->getAssetType(), a->id))
+            *base = { a, false };
+        else
+            m_bases.push_back({ a, false });
+    }
+    for (auto& a : rec.unretained) {
+        m_bases.erase(std::remove_if(m_bases.begin(), m_bases.end(), [&a](Base& b) { return IsSameAsset(*b.asset, *a); }),
+            m_bases.end());
+    }
+
+    // deltas the server could not apply are not applicable to the same bases here either
+    for (auto& delta : rec.animation_deltas) {
+        auto it = std::find_if(m_bases.begin(), m_bases.end(), [&delta](Base& b) {
+            return b.asset->getAssetType() == AssetType::Animation && delta.isTarget(static_cast<AnimationClip&>(*b.asset));
+        });
+        if (it == m_bases.end())
+            continue;
+        auto clip = std::static_pointer_cast<AnimationClip>(getWritableBase(*it));
+        delta.apply(*clip);
+        addPatched(clip);
+    }
+    for (auto& tt : rec.texture_tiles) {
+        auto *base = findBase(AssetType::Texture, tt.texture_id);
+        if (!base || !tt.isTarget(static_cast<Texture&>(*base->asset)))
+            continue;
+        auto tex = std::static_pointer_cast<Texture>(getWritableBase(*base));
+        tt.apply(*tex);
+        addPatched(tex);
+    }
+    for (auto& delta : rec.material_deltas) {
+        auto *base = findBase(AssetType::Material, delta->id);
+        if (!base)
+            continue;
+        auto mat = std::static_pointer_cast<Material>(getWritableBase(*base));
+        mat->name = delta->name;
+        mat->index = delta->index;
+        mat->shader = delta->shader;
+        mat->merge(*delta);
+        addPatched(mat);
+    }
+
+    if (m_first_timestamp == 0)
+        m_first_timestamp = rec.timestamp;
+    m_time = float(double(int64_t(rec.timestamp - m_first_timestamp)) / 1e9);
+    m_dirty = true;
+
+    // OSceneCache::addScene() waits if its queue is full. coalesce into the next scene instead
+    if (m_osc->getSceneCountInQueue() < m_max_queue_size)
+        writeScene();
+    else
+        ++m_scene_count_coalesced;
+}
+
+void SceneRecorder::writeScene()
+{
+    // OSceneCache modifies scenes and encodes them asynchronously, while entities are merged into the next sessions.
+    // pass shallow copies. they share the data of the current versions of the entities, which are kept alive as long as
+    // the scene is (not ref counted). new versions replace the entries of m_entities instead of modifying them.
+    struct SceneWithSources
+    {
+        ScenePtr scene;
+        std::vector<TransformPtr> sources;
+    };
+    auto holder = std::make_shared<SceneWithSources>();
+    auto scene = holder->scene = Scene::create();
+    scene->settings = m_settings;
+    scene->assets = std::move(m_assets);
+    scene->entities.reserve(m_entities.size());
+    holder->sources.reserve(m_entities.size());
+    m_entities.each([&scene, &holder](const std::string&, TransformPtr& e) {
+        holder->sources.push_back(e);
+        scene->entities.push_back(std::static_pointer_cast<Transform>(e->clone()));
+    });
+
+    m_osc->addScene(ScenePtr(holder, scene.get()), m_time);
+    ++m_scene_count_recorded;
+    m_assets.clear();
+    // patched assets are shared with m_osc from here on
+    for (auto& base : m_bases)
+        base.owned = false;
+    m_dirty = false;
+}
+
+} // namespace ms
+#endif // msEnableSceneCache
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <thread>
+#include <condition_variable>
+#include "../SceneCache/msSceneCache.h"
+#include "../SceneGraph/msIdentifier.h"
+#include "../SceneGraph/msAnimation.h"
+#include "../SceneGraph/msTexture.h"
+
+#ifdef msEnableSceneCache
+namespace ms {
+
+struct SceneRecorderSettings
+{
+    OSceneCacheSettings oscs;
+    // ended sessions waiting for the recording thread. beyond this, a session is coalesced into the last waiting one
+    int max_queue_size = 8;
+
+    SceneRecorderSettings();
+};
+
+// records scenes received from a live session into a scene cache.
+// received messages contain only what has changed, so the recorder keeps the whole scene and
+// each scene session (SceneBegin ~ SceneEnd fence) becomes one scene in the cache.
+//
+// add*() / endScene() are meant to be called from the thread that processes messages and never wait.
+// received data are shared, not copied: the given scenes and deltas must not be modified after the call
+// (handlers only read them. AnimationCurve::idata written by msUnitySpecific is not recorded).
+// deltas are applied to the recorder's own copies of the retained assets (copy on write), and merging and
+// writing are done on a background thread. if the thread falls max_queue_size sessions behind, or the scene cache
+// is still busy with earlier scenes, sessions are coalesced into one scene, so the queues stay bounded.
+class SceneRecorder
+{
+public:
+    SceneRecorder();
+    ~SceneRecorder();
+
+    bool open(const char *path, const SceneRecorderSettings& settings = SceneRecorderSettings());
+    // waits until queued scenes are written
+    void close();
+    bool valid() const;
+
+    // if retain_assets, its textures, materials and animation clips are the bases of the deltas (see SetFlags::retain_assets)
+    void addScene(ScenePtr scene, bool retain_assets);
+    void addAnimationDeltas(const std::vector<AnimationClipDelta>& deltas);
+    // only the changed rectangles are copied
+    void addTextureTiles(const std::vector<TextureTiles>& tiles);
+    void addMaterialDeltas(const std::vector<MaterialPtr>& deltas);
+    void deleteEntities(const std::vector<Identifier>& entities);
+    // timestamp of the session. scene time is the time elapsed since the first session.
+    void endScene(nanosec timestamp);
+
+    int getSceneCountRecorded() const;
+    int getSceneCountCoalesced() const;
+
+private:
+    // a scene session
+    struct Record
+    {
+        SceneSettings settings;
+        std::vector<TransformPtr> entities;
+        std::vector<AssetPtr> assets;
+        std::vector<AssetPtr> bases; // assets sent with retain_assets
+        std::vector<AssetPtr> unretained; // assets sent without retain_assets. their bases are released
+        std::vector<AnimationClipDelta> animation_deltas;
+        std::vector<TextureTiles> texture_tiles;
+        std::vector<MaterialPtr> material_deltas;
+        std::vector<Identifier> deleted;
+        std::vector<TransformPtr> sources; // coalesced entities share the data of these
+        nanosec timestamp = 0;
+        bool has_settings = false;
+
+        void coalesce(Record& next);
+    };
+
+    struct Base
+    {
+        AssetPtr asset;
+        bool owned = false;
+    };
+
+    void recordLoop();
+    void apply(Record& rec);
+    Base* findBase(AssetType type, int id);
+    AssetPtr getWritableBase(Base& base);
+    void addPatched(AssetPtr asset);
+    void writeScene();
+
+    OSceneCachePtr m_osc;
+    int m_max_queue_size = 0; // of m_osc
+    int m_max_records = 0;
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    bool m_stop = false;
+    std::vector<Record> m_records;
+
+    // only touched by the calling thread
+    Record m_pending;
+
+    // only touched by the recording thread
+    SceneSettings m_settings;
+    mu::FlatHashMap<std::string, TransformPtr> m_entities;
+    std::vector<AssetPtr> m_assets; // received since the last scene
+    // bases of the deltas. shared with the received scenes or m_osc until a delta is applied (copy on write)
+    std::vector<Base> m_bases;
+    nanosec m_first_timestamp = 0;
+    float m_time = 0.0f;
+    bool m_dirty = false;
+
+    std::atomic_int m_scene_count_recorded{ 0 };
+    std::atomic_int m_scene_count_coalesced{ 0 };
+};
+
+} // namespace ms
+#endif // msEnableSceneCache
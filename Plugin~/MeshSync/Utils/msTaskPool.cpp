@@ -0,0 +1,59 @@
+#include "pch.h"
+#include "msTaskPool.h"
+
+namespace ms {
+
+TaskPool::TaskPool(size_t max_threads)
+    : m_max_threads(max_threads)
+{
+    if (m_max_threads == 0)
+        m_max_threads = std::max<size_t>(std::thread::hardware_concurrency(), 1);
+}
+
+TaskPool::~TaskPool()
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_stop = true;
+    }
+    m_cond.notify_all();
+    for (auto& t : m_threads)
+        t.join();
+}
+
+size_t TaskPool::getMaxThreads() const
+{
+    return m_max_threads;
+}
+
+void TaskPool::pushImpl(std::function<void()>&& task)
+{
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_tasks.push_back(std::move(task));
+        if (m_idle < m_tasks.size() && m_threads.size() < m_max_threads)
+            m_threads.emplace_back([this]() { process(); });
+    }
+    m_cond.notify_one();
+}
+
+void TaskPool::process()
+{
+    for (;;) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            ++m_idle;
+            m_cond.wait(lock, [this]() { return m_stop || !m_tasks.empty(); });
+            --m_idle;
+            // remaining tasks are processed before stopping so that futures are never abandoned
+            if (m_tasks.empty())
+                return;
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        task();
+    }
+}
+
+} // namespace ms
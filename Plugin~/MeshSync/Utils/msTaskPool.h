@@ -0,0 +1,46 @@
+#pragma once
+
+#include <deque>
+#include <vector>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+namespace ms {
+
+// fixed number of worker threads that process queued tasks in FIFO order.
+// threads are spawned lazily, up to max_threads. (0 means std::thread::hardware_concurrency())
+// tasks must not wait for other tasks in the same pool.
+class TaskPool
+{
+public:
+    TaskPool(size_t max_threads = 0);
+    ~TaskPool();
+    size_t getMaxThreads() const;
+
+    // thread safe
+    template<class Body>
+    std::future<void> push(Body&& body)
+    {
+        auto task = std::make_shared<std::packaged_task<void()>>(std::forward<Body>(body));
+        auto ret = task->get_future();
+        pushImpl([task]() { (*task)(); });
+        return ret;
+    }
+
+private:
+    void pushImpl(std::function<void()>&& task);
+    void process();
+
+    size_t m_max_threads = 0;
+    std::vector<std::thread> m_threads;
+    std::deque<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_cond;
+    size_t m_idle = 0;
+    bool m_stop = false;
+};
+
+} // namespace ms
@@ -43,6 +43,27 @@ int TextureManager::find(const std::string& name) const
     return InvalidID;
 }
 
+// hash of each tile. tiles are in row-major order and edge tiles are clipped by the image size
+static void GetTileChecksums(std::vector<uint64_t>& dst, const void *data, int width, int height, int pixel_size, int tile_size)
+{
+    int tiles_x = ceildiv(width, tile_size);
+    int tiles_y = ceildiv(height, tile_size);
+    size_t pitch = (size_t)width * pixel_size;
+    dst.assign((size_t)tiles_x * tiles_y, 0);
+    mu::parallel_for(0, tiles_y, [&](int ty) {
+        uint64_t *hashes = &dst[(size_t)tiles_x * ty];
+        int y_end = std::min(tile_size * (ty + 1), height);
+        for (int y = tile_size * ty; y < y_end; ++y) {
+            auto *row = (const char*)data + pitch * y;
+            for (int tx = 0; tx < tiles_x; ++tx) {
+                int x = tile_size * tx;
+                int w = std::min(tile_size, width - x);
+                hashes[tx] = Hash64(row + (size_t)pixel_size * x, (size_t)pixel_size * w, hashes[tx]);
+            }
+        }
+    });
+}
+
 int TextureManager::addImage(const std::string& name, int width, int height, const void *data, size_t size, TextureFormat format)
 {
     auto& rec = lockAndGet(name);
@@ -50,10 +71,54 @@ int TextureManager::addImage(const std::string& name, int width, int height, con
         rec.texture->id :
         (data && size ? genID() : -1);
 
-    // not worth to make tasks
-    auto checksum = SumInt32(data, size);
-    if (!rec.texture || rec.checksum != checksum) {
-        rec.checksum = checksum;
+    bool updated = false;
+    int pixel_size = GetPixelSize(format);
+    if (m_tile_size > 0 && pixel_size > 0 && data && size == GetTextureDataSize(format, width, height)) {
+        std::vector<uint64_t> tile_checksums;
+        GetTileChecksums(tile_checksums, data, width, height, pixel_size, m_tile_size);
+
+        auto& prev = rec.texture;
+        bool same_layout = prev && prev->format == format && prev->width == width && prev->height == height &&
+            prev->mip_count == 1 && rec.tile_checksums.size() == tile_checksums.size();
+        if (!same_layout) {
+            updated = true;
+            rec.dirty = true;
+            rec.dirty_tiles.clear();
+        }
+        else {
+            size_t num_tiles = tile_checksums.size();
+            size_t prev_dirty = rec.dirty_tiles.size();
+            for (size_t ti = 0; ti < num_tiles; ++ti) {
+                if (tile_checksums[ti] != rec.tile_checksums[ti])
+                    rec.dirty_tiles.push_back((int)ti);
+            }
+            if (rec.dirty_tiles.size() != prev_dirty) {
+                updated = true;
+                std::sort(rec.dirty_tiles.begin(), rec.dirty_tiles.end());
+                rec.dirty_tiles.erase(std::unique(rec.dirty_tiles.begin(), rec.dirty_tiles.end()), rec.dirty_tiles.end());
+                // no point in sending tiles if all of them are changed
+                if (rec.dirty_tiles.size() == num_tiles) {
+                    rec.dirty = true;
+                    rec.dirty_tiles.clear();
+                }
+            }
+        }
+        rec.tile_checksums = std::move(tile_checksums);
+    }
+    else {
+        // not worth to make tasks
+        auto checksum = SumInt32(data, size);
+        if (!rec.texture || rec.checksum != checksum) {
+            rec.checksum = checksum;
+            updated = true;
+            rec.dirty = true;
+        }
+        rec.tile_checksums.clear();
+        rec.dirty_tiles.clear();
+    }
+
+    if (updated) {
+        // textures may be referenced by exporters in flight. always make a new one.
         rec.texture = Texture::create();
         auto& tex = rec.texture;
         tex->id = id;
@@ -62,7 +127,6 @@ int TextureManager::addImage(const std::string& name, int width, int height, con
         tex->width = width;
         tex->height = height;
         tex->data.assign((const char*)data, (const char*)data + size);
-        rec.dirty = true;
     }
     if (m_always_mark_dirty)
         rec.dirty = true;
@@ -86,19 +150,27 @@ int TextureManager::addFile(const std::string& path, TextureType type)
     }
 
     rec.waitTask();
-    rec.task = std::async(std::launch::async, [this, path, type, &rec, id]() {
-        auto mtime = FileMTime(path.c_str());
-        if (!rec.texture || rec.mtime != mtime) {
-            if (!rec.texture)
-                rec.texture = Texture::create();
-            rec.mtime = mtime;
-            auto& tex = rec.texture;
-            if (FileToByteArray(path.c_str(), rec.texture->data)) {
-                tex->id = id;
-                tex->name = mu::GetFilename(path.c_str());
-                tex->format = ms::TextureFormat::RawFile;
-                tex->type = type;
-                rec.dirty = true;
+    rec.task = m_tasks.push([this, path, type, &rec, id]() {
+        // compare size, mtime and inode first. then compare contents only if they differ,
+        // because touched-but-identical files are common (e.g. re-exported by a paint tool)
+        FileStat stat;
+        if (!GetFileStat(path.c_str(), stat))
+            return;
+        uint64_t hash = 0;
+        if ((!rec.texture || rec.file_stat != stat) && FileHash(path.c_str(), hash)) {
+            rec.file_stat = stat;
+            if (!rec.texture || rec.checksum != hash) {
+                if (!rec.texture)
+                    rec.texture = Texture::create();
+                auto& tex = rec.texture;
+                if (FileToByteArray(path.c_str(), tex->data)) {
+                    rec.checksum = hash;
+                    tex->id = id;
+                    tex->name = mu::GetFilename(path.c_str());
+                    tex->format = ms::TextureFormat::RawFile;
+                    tex->type = type;
+                    rec.dirty = true;
+                }
             }
         }
         if (m_always_mark_dirty)
@@ -150,6 +222,38 @@ std::vector<TexturePtr> TextureManager::getDirtyTextures()
     return ret;
 }
 
+std::vector<TextureTiles> TextureManager::getDirtyTiles()
+{
+    waitTasks();
+
+    std::vector<TextureTiles> ret;
+    if (m_tile_size <= 0)
+        return ret;
+
+    for (auto& kvp : m_records) {
+        auto& rec = kvp.second;
+        if (rec.dirty || rec.dirty_tiles.empty() || !rec.texture)
+            continue;
+
+        auto& tex = *rec.texture;
+        TextureTiles tt;
+        tt.texture_id = tex.id;
+        tt.format = tex.format;
+        tt.width = tex.width;
+        tt.height = tex.height;
+        tt.source = rec.texture;
+
+        int tiles_x = ceildiv(tex.width, m_tile_size);
+        for (int ti : rec.dirty_tiles) {
+            int x = m_tile_size * (ti % tiles_x);
+            int y = m_tile_size * (ti / tiles_x);
+            tt.addTile(tex, x, y, std::min(m_tile_size, tex.width - x), std::min(m_tile_size, tex.height - y));
+        }
+        ret.push_back(std::move(tt));
+    }
+    return ret;
+}
+
 void TextureManager::makeDirtyAll()
 {
     for (auto& kvp : m_records) {
@@ -157,10 +261,25 @@ void TextureManager::makeDirtyAll()
     }
 }
 
+bool TextureManager::makeDirty(int texture_id)
+{
+    waitTasks();
+
+    for (auto& kvp : m_records) {
+        auto& rec = kvp.second;
+        if (rec.texture && rec.texture->id == texture_id) {
+            rec.dirty = true;
+            return true;
+        }
+    }
+    return false;
+}
+
 void TextureManager::clearDirtyFlags()
 {
     for (auto& kvp : m_records) {
         kvp.second.dirty = false;
+        kvp.second.dirty_tiles.clear();
     }
 }
 
@@ -169,6 +288,11 @@ void TextureManager::setAlwaysMarkDirty(bool v)
     m_always_mark_dirty = v;
 }
 
+void TextureManager::setTileSize(int v)
+{
+    m_tile_size = std::max(v, 0);
+}
+
 int TextureManager::genID()
 {
     return ++m_id_seed;
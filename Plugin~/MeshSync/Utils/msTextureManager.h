@@ -1,6 +1,8 @@
 #pragma once
 
 #include "SceneGraph/msMaterial.h"
+#include "msTaskPool.h"
+#include "msMisc.h"
 
 #ifndef msRuntime
 namespace ms {
@@ -24,17 +26,27 @@ public:
 
     std::vector<TexturePtr> getAllTextures();
     std::vector<TexturePtr> getDirtyTextures();
+    // changed tiles of textures that are not entirely dirty. see setTileSize()
+    std::vector<TextureTiles> getDirtyTiles();
     void makeDirtyAll();
+    // the texture is sent entirely on the next update. see AsyncSceneSender::lost_textures
+    bool makeDirty(int texture_id);
     void clearDirtyFlags();
 
     void setAlwaysMarkDirty(bool v);
+    // if non-zero, addImage() compares images per tile_size x tile_size tiles and
+    // partially changed textures are reported by getDirtyTiles() instead of getDirtyTextures().
+    // uncompressed images only.
+    void setTileSize(int v);
 
 private:
     struct Record
     {
         TexturePtr texture;
-        uint64_t mtime = 0;
+        FileStat file_stat; // file textures only
         uint64_t checksum = 0;
+        std::vector<uint64_t> tile_checksums; // tile mode only
+        std::vector<int> dirty_tiles;
         bool dirty = false;
         std::future<void> task;
 
@@ -46,8 +58,10 @@ private:
 
     int m_id_seed = 0;
     bool m_always_mark_dirty = false;
+    int m_tile_size = 0;
     std::map<std::string, Record> m_records;
     std::mutex m_mutex;
+    TaskPool m_tasks;
 };
 
 } // namespace ms
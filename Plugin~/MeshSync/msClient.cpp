@@ -7,6 +7,24 @@ namespace ms {
 using namespace Poco;
 using namespace Poco::Net;
 
+bool ClockOffset::valid() const
+{
+    return timestamp != 0;
+}
+
+void ClockOffset::update(nanosec request_time, nanosec server_time, nanosec response_time)
+{
+    // clocks drift. prefer a recent sample over an old one with a slightly shorter round trip.
+    const nanosec max_age = 60LL * 1000000000LL;
+    nanosec new_rtt = response_time - request_time;
+    if (valid() && new_rtt > rtt && response_time - timestamp < max_age)
+        return;
+
+    offset = server_time - (request_time + new_rtt / 2);
+    rtt = new_rtt;
+    timestamp = response_time;
+}
+
 Client::Client(const ClientSettings & settings)
     : m_settings(settings)
 {
@@ -17,6 +35,41 @@ const std::string& Client::getErrorMessage() const
     return m_error_message;
 }
 
+const ClockOffset& Client::getClockOffset() const
+{
+    return m_clock_offset;
+}
+
+void Client::setClockOffset(const ClockOffset& v)
+{
+    m_clock_offset = v;
+}
+
+uint64_t Client::getBytesSent() const
+{
+    return m_bytes_sent;
+}
+
+const std::vector<int>& Client::getLostTextures() const
+{
+    return m_lost_textures;
+}
+
+void Client::setupRequest(HTTPRequest& request, const Message& mes)
+{
+    request.setContentType("application/octet-stream");
+    request.setExpectContinue(true);
+
+    // the size pass walks the whole message, so it is a good measure of the serialization cost
+    auto begin = mu::Now();
+    auto size = ssize(mes);
+    request.setContentLength(size);
+    request.set(msHeaderSerializeTime, std::to_string(mu::Now() - begin));
+    m_bytes_sent += size;
+    if (m_clock_offset.valid())
+        request.set(msHeaderClockOffset, std::to_string(m_clock_offset.offset));
+}
+
 bool Client::isServerAvailable(int timeout_ms)
 {
     try {
@@ -24,6 +77,7 @@ bool Client::isServerAvailable(int timeout_ms)
         session.setTimeout(timeout_ms * 1000);
 
         HTTPRequest request{ HTTPRequest::HTTP_GET, "/protocol_version" };
+        auto request_time = mu::Now();
         session.sendRequest(request);
 
         HTTPResponse response;
@@ -31,6 +85,8 @@ bool Client::isServerAvailable(int timeout_ms)
         std::ostringstream ostr;
         StreamCopier::copyStream(rs, ostr);
         auto content = ostr.str();
+        if (response.has(msHeaderServerTime))
+            m_clock_offset.update(request_time, std::atoll(response.get(msHeaderServerTime, "0").c_str()), mu::Now());
         if (response.getStatus() != HTTPResponse::HTTP_OK) {
             m_error_message = "Server is not working.";
         }
@@ -95,72 +151,74 @@ ScenePtr Client::send(const GetMessage& mes)
 
 bool Client::send(const SetMessage& mes)
 {
-    try {
-        HTTPClientSession session{ m_settings.server, m_settings.port };
-        session.setTimeout(m_settings.timeout_ms * 1000);
-
-        HTTPRequest request{ HTTPRequest::HTTP_POST, "set" };
-        request.setContentType("application/octet-stream");
-        request.setExpectContinue(true);
-        request.setContentLength(ssize(mes));
-        auto& os = session.sendRequest(request);
-        mes.serialize(os);
-        os.flush();
-
-        HTTPResponse response;
-        auto& rs = session.receiveResponse(response);
-        std::ostringstream ostr;
-        StreamCopier::copyStream(rs, ostr);
-        return response.getStatus() == HTTPResponse::HTTP_OK;
-    }
-    catch (...) {
-        return false;
-    }
+    return post("set", mes);
 }
 
 bool Client::send(const DeleteMessage& mes)
 {
-    try {
-        HTTPClientSession session{ m_settings.server, m_settings.port };
-        session.setTimeout(m_settings.timeout_ms * 1000);
+    return post("delete", mes);
+}
 
-        HTTPRequest request{ HTTPRequest::HTTP_POST, "delete" };
-        request.setContentType("application/octet-stream");
-        request.setExpectContinue(true);
-        request.setContentLength(ssize(mes));
-        auto& os = session.sendRequest(request);
-        mes.serialize(os);
-        os.flush();
+bool Client::send(const AnimationDeltaMessage& mes)
+{
+    return post("animation_delta", mes);
+}
 
-        HTTPResponse response;
-        auto& rs = session.receiveResponse(response);
-        std::ostringstream ostr;
-        StreamCopier::copyStream(rs, ostr);
-        return response.getStatus() == HTTPResponse::HTTP_OK;
-    }
-    catch (...) {
-        return false;
-    }
+bool Client::send(const TextureTilesMessage& mes)
+{
+    return post("texture_tiles", mes);
+}
+
+bool Client::send(const MaterialDeltaMessage& mes)
+{
+    return post("material_delta", mes);
 }
 
 bool Client::send(const FenceMessage& mes)
+{
+    return post("fence", mes);
+}
+
+bool Client::forward(const std::string& uri, const void *data, size_t size)
+{
+    return post(uri,
+        [size](HTTPRequest& request) {
+            request.setContentType("application/octet-stream");
+            request.setExpectContinue(true);
+            request.setContentLength(size);
+        },
+        [data, size](std::ostream& os) { os.write((const char*)data, size); });
+}
+
+bool Client::post(const std::string& uri, const Message& mes)
+{
+    return post(uri,
+        [this, &mes](HTTPRequest& request) { setupRequest(request, mes); },
+        [&mes](std::ostream& os) { mes.serialize(os); });
+}
+
+bool Client::post(const std::string& uri, const std::function<void(HTTPRequest&)>& setup, const std::function<void(std::ostream&)>& write)
 {
     try {
         HTTPClientSession session{ m_settings.server, m_settings.port };
         session.setTimeout(m_settings.timeout_ms * 1000);
 
-        HTTPRequest request{ HTTPRequest::HTTP_POST, "fence" };
-        request.setContentType("application/octet-stream");
-        request.setExpectContinue(true);
-        request.setContentLength(ssize(mes));
+        HTTPRequest request{ HTTPRequest::HTTP_POST, uri };
+        setup(request);
         auto& os = session.sendRequest(request);
-        mes.serialize(os);
+        write(os);
         os.flush();
 
         HTTPResponse response;
         auto& rs = session.receiveResponse(response);
         std::ostringstream ostr;
         StreamCopier::copyStream(rs, ostr);
+        if (response.has(msHeaderLostTextures)) {
+            std::istringstream ids(response.get(msHeaderLostTextures, ""));
+            std::string id;
+            while (std::getline(ids, id, ','))
+                m_lost_textures.push_back(std::atoi(id.c_str()));
+        }
         return response.getStatus() == HTTPResponse::HTTP_OK;
     }
     catch (...) {
@@ -3,8 +3,21 @@
 #include "msProtocol.h"
 
 #ifdef msEnableNetwork
+namespace Poco {
+    namespace Net {
+        class HTTPRequest;
+    }
+}
+
 namespace ms {
 
+// HTTP headers for latency telemetry. see LatencyStats
+#define msHeaderServerTime    "X-MeshSync-Server-Time"
+#define msHeaderClockOffset   "X-MeshSync-Clock-Offset"
+#define msHeaderSerializeTime "X-MeshSync-Serialize-Time"
+// comma separated ids of the textures the server could not apply TextureTiles to. see Client::getLostTextures()
+#define msHeaderLostTextures  "X-MeshSync-Lost-Textures"
+
 struct ClientSettings
 {
     std::string server = "127.0.0.1";
@@ -12,6 +25,19 @@ struct ClientSettings
     int timeout_ms = 30000;
 };
 
+// offset of the server's clock (mu::Now()) to this process's. NTP style estimate:
+// the server reports its time in the response to isServerAvailable() and it is assumed to be at the middle of the round trip.
+// the sample with the shortest round trip is kept because its error (up to rtt / 2) is the smallest.
+struct ClockOffset
+{
+    nanosec offset = 0; // local clock + offset = server's clock
+    nanosec rtt = 0;
+    nanosec timestamp = 0; // when the sample was taken. 0 if not estimated yet
+
+    bool valid() const;
+    void update(nanosec request_time, nanosec server_time, nanosec response_time);
+};
+
 class Client
 {
 public:
@@ -26,13 +52,38 @@ public:
     ScenePtr send(const GetMessage& mes);
     bool send(const SetMessage& mes);
     bool send(const DeleteMessage& mes);
+    bool send(const AnimationDeltaMessage& mes);
+    bool send(const TextureTilesMessage& mes);
+    bool send(const MaterialDeltaMessage& mes);
     bool send(const FenceMessage& mes);
     ResponseMessagePtr send(const QueryMessage& mes);
     ResponseMessagePtr send(const QueryMessage& mes, int timeout_ms);
 
+    // send a message that is already serialized. uri is the destination ("set", "delete", etc.)
+    bool forward(const std::string& uri, const void *data, size_t size);
+
+    // updated by isServerAvailable(). sent with messages so that the server can measure latencies across machines.
+    const ClockOffset& getClockOffset() const;
+    void setClockOffset(const ClockOffset& v);
+    // total size of the messages sent by send() (except Get and Query)
+    uint64_t getBytesSent() const;
+    // textures the server reported in the responses that it could not apply TextureTiles to.
+    // the reports may come with later messages (e.g. Fence) because the server processes tiles asynchronously.
+    const std::vector<int>& getLostTextures() const;
+
 private:
+    void setupRequest(Poco::Net::HTTPRequest& request, const Message& mes);
+    // POST the message to uri. returns true if the server responded OK
+    bool post(const std::string& uri, const Message& mes);
+    // setup() fills the headers and write() writes the body
+    bool post(const std::string& uri, const std::function<void(Poco::Net::HTTPRequest&)>& setup,
+        const std::function<void(std::ostream&)>& write);
+
     ClientSettings m_settings;
     std::string m_error_message;
+    ClockOffset m_clock_offset;
+    uint64_t m_bytes_sent = 0;
+    std::vector<int> m_lost_textures;
 };
 
 } // namespace ms
@@ -3,7 +3,7 @@
 #define msPluginVersion 20190902
 #define msPluginVersionStr "20190902"
 #define msVendor "Unity Technologies"
-#define msProtocolVersion 122
+#define msProtocolVersion 133
 
 //#define msEnableProfiling
 #define msEnableNetwork
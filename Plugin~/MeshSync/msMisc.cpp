@@ -1,5 +1,11 @@
 #include "pch.h"
 #include "msMisc.h"
+#ifndef _WIN32
+    #include <sys/stat.h>
+    #include <sys/mman.h>
+    #include <fcntl.h>
+    #include <unistd.h>
+#endif
 
 namespace ms {
 
@@ -11,6 +17,81 @@ bool StartWith(const std::string& a, const char *b)
     return std::strncmp(a.c_str(), b, n) == 0;
 }
 
+static const uint64_t kPrime1 = 0x9E3779B185EBCA87ull;
+static const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4Full;
+static const uint64_t kPrime3 = 0x165667B19E3779F9ull;
+static const uint64_t kPrime4 = 0x85EBCA77C2B2AE63ull;
+static const uint64_t kPrime5 = 0x27D4EB2F165667C5ull;
+
+static inline uint64_t Rotl64(uint64_t v, int r) { return (v << r) | (v >> (64 - r)); }
+static inline uint64_t Read64(const char *p) { uint64_t r; std::memcpy(&r, p, 8); return r; }
+static inline uint32_t Read32(const char *p) { uint32_t r; std::memcpy(&r, p, 4); return r; }
+
+static inline uint64_t HashRound(uint64_t acc, uint64_t input)
+{
+    acc += input * kPrime2;
+    acc = Rotl64(acc, 31);
+    return acc * kPrime1;
+}
+
+static inline uint64_t HashMerge(uint64_t acc, uint64_t v)
+{
+    acc ^= HashRound(0, v);
+    return acc * kPrime1 + kPrime4;
+}
+
+uint64_t Hash64(const void *data, size_t size, uint64_t seed)
+{
+    auto *p = (const char*)data;
+    auto *end = p + size;
+    uint64_t h;
+
+    if (size >= 32) {
+        uint64_t v1 = seed + kPrime1 + kPrime2;
+        uint64_t v2 = seed + kPrime2;
+        uint64_t v3 = seed;
+        uint64_t v4 = seed - kPrime1;
+        auto *limit = end - 32;
+        do {
+            v1 = HashRound(v1, Read64(p)); p += 8;
+            v2 = HashRound(v2, Read64(p)); p += 8;
+            v3 = HashRound(v3, Read64(p)); p += 8;
+            v4 = HashRound(v4, Read64(p)); p += 8;
+        } while (p <= limit);
+
+        h = Rotl64(v1, 1) + Rotl64(v2, 7) + Rotl64(v3, 12) + Rotl64(v4, 18);
+        h = HashMerge(h, v1);
+        h = HashMerge(h, v2);
+        h = HashMerge(h, v3);
+        h = HashMerge(h, v4);
+    }
+    else {
+        h = seed + kPrime5;
+    }
+
+    h += (uint64_t)size;
+    for (; p + 8 <= end; p += 8) {
+        h ^= HashRound(0, Read64(p));
+        h = Rotl64(h, 27) * kPrime1 + kPrime4;
+    }
+    if (p + 4 <= end) {
+        h ^= (uint64_t)Read32(p) * kPrime1;
+        h = Rotl64(h, 23) * kPrime2 + kPrime3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= (uint64_t)(uint8_t)*p * kPrime5;
+        h = Rotl64(h, 11) * kPrime1;
+    }
+
+    h ^= h >> 33;
+    h *= kPrime2;
+    h ^= h >> 29;
+    h *= kPrime3;
+    h ^= h >> 32;
+    return h;
+}
+
 #ifndef msRuntime
 bool FileToByteArray(const char *path, RawVector<char> &dst)
 {
@@ -80,6 +161,105 @@ uint64_t FileMTime(const char *path)
     }
 }
 
+bool GetFileStat(const char *path, FileStat& dst)
+{
+    if (!path || *path == '\0')
+        return false;
+
+#ifdef _WIN32
+    auto wpath = mu::ToWCS(path);
+    HANDLE h = ::CreateFileW(wpath.c_str(), 0, FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+        nullptr, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (h == INVALID_HANDLE_VALUE)
+        return false;
+
+    BY_HANDLE_FILE_INFORMATION info;
+    bool ret = ::GetFileInformationByHandle(h, &info) != FALSE;
+    ::CloseHandle(h);
+    if (!ret)
+        return false;
+
+    dst.size = ((uint64_t)info.nFileSizeHigh << 32) | info.nFileSizeLow;
+    dst.mtime = ((uint64_t)info.ftLastWriteTime.dwHighDateTime << 32) | info.ftLastWriteTime.dwLowDateTime;
+    dst.inode = ((uint64_t)info.nFileIndexHigh << 32) | info.nFileIndexLow;
+#else
+    struct stat st;
+    if (::stat(path, &st) != 0)
+        return false;
+
+    dst.size = (uint64_t)st.st_size;
+#if defined(__APPLE__)
+    dst.mtime = (uint64_t)st.st_mtimespec.tv_sec * 1000000000ull + st.st_mtimespec.tv_nsec;
+#else
+    dst.mtime = (uint64_t)st.st_mtim.tv_sec * 1000000000ull + st.st_mtim.tv_nsec;
+#endif
+    dst.inode = (uint64_t)st.st_ino;
+#endif
+    return true;
+}
+
+bool FileHash(const char *path, uint64_t& dst)
+{
+    if (!path || *path == '\0')
+        return false;
+
+#ifdef _WIN32
+    auto wpath = mu::ToWCS(path);
+    HANDLE file = ::CreateFileW(wpath.c_str(), GENERIC_READ, FILE_SHARE_READ,
+        nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    bool ret = false;
+    LARGE_INTEGER size;
+    if (::GetFileSizeEx(file, &size)) {
+        if (size.QuadPart == 0) {
+            // empty files can't be mapped
+            dst = Hash64(nullptr, 0);
+            ret = true;
+        }
+        else if (HANDLE mapping = ::CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr)) {
+            if (void *data = ::MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0)) {
+                dst = Hash64(data, (size_t)size.QuadPart);
+                ::UnmapViewOfFile(data);
+                ret = true;
+            }
+            ::CloseHandle(mapping);
+        }
+    }
+    ::CloseHandle(file);
+    return ret;
+#else
+    int fd = ::open(path, O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    bool ret = false;
+    struct stat st;
+    if (::fstat(fd, &st) == 0) {
+        size_t size = (size_t)st.st_size;
+        if (size == 0) {
+            // empty files can't be mapped
+            dst = Hash64(nullptr, 0);
+            ret = true;
+        }
+        else {
+            void *data = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED) {
+#ifdef MADV_SEQUENTIAL
+                ::madvise(data, size, MADV_SEQUENTIAL);
+#endif
+                dst = Hash64(data, size);
+                ::munmap(data, size);
+                ret = true;
+            }
+        }
+    }
+    ::close(fd);
+    return ret;
+#endif
+}
+
 void FindFilesSortedByLastModified(const std::string& path, std::multimap<uint64_t, std::string>& ret) {
 
     using namespace std;
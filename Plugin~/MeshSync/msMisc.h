@@ -5,7 +5,21 @@
 namespace ms {
 
 bool StartWith(const std::string& a, const char *b);
+// fast non-cryptographic hash (xxHash64 algorithm)
+uint64_t Hash64(const void *data, size_t size, uint64_t seed = 0);
+
 #ifndef msRuntime
+// cheap metadata to detect file changes without reading contents
+struct FileStat
+{
+    uint64_t size = 0;
+    uint64_t mtime = 0;
+    uint64_t inode = 0; // file index on Windows
+
+    bool operator==(const FileStat& v) const { return size == v.size && mtime == v.mtime && inode == v.inode; }
+    bool operator!=(const FileStat& v) const { return !(*this == v); }
+};
+
 bool FileToByteArray(const char *path, RawVector<char> &out);
 bool FileToByteArray(const char *path, SharedVector<char> &out);
 bool ByteArrayToFile(const char *path, const RawVector<char> &data);
@@ -13,6 +27,9 @@ bool ByteArrayToFile(const char *path, const SharedVector<char> &data);
 bool ByteArrayToFile(const char *path, const char *data, size_t size);
 bool FileExists(const char *path);
 uint64_t FileMTime(const char *path);
+bool GetFileStat(const char *path, FileStat& dst);
+// Hash64() of the entire file. the file is memory mapped instead of being read into a buffer
+bool FileHash(const char *path, uint64_t& dst);
 void FindFilesSortedByLastModified(const std::string& path, std::multimap<uint64_t, std::string>& ret);
 #endif // msRuntime
 
@@ -51,6 +51,7 @@ void GetMessage::serialize(std::ostream& os) const
     write(os, flags);
     write(os, scene_settings);
     write(os, refine_settings);
+    write(os, view_proj);
 }
 void GetMessage::deserialize(std::istream& is)
 {
@@ -58,6 +59,7 @@ void GetMessage::deserialize(std::istream& is)
     read(is, flags);
     read(is, scene_settings);
     read(is, refine_settings);
+    read(is, view_proj);
 }
 
 
@@ -73,11 +75,13 @@ void SetMessage::serialize(std::ostream& os) const
 {
     super::serialize(os);
     msWrite(scene);
+    msWrite(flags);
 }
 void SetMessage::deserialize(std::istream& is)
 {
     super::deserialize(is);
     msRead(scene);
+    msRead(flags);
 }
 
 
@@ -98,6 +102,53 @@ void DeleteMessage::deserialize(std::istream& is)
 }
 
 
+AnimationDeltaMessage::AnimationDeltaMessage()
+{
+}
+void AnimationDeltaMessage::serialize(std::ostream& os) const
+{
+    super::serialize(os);
+    write(os, scene_settings);
+    write(os, deltas);
+}
+void AnimationDeltaMessage::deserialize(std::istream& is)
+{
+    super::deserialize(is);
+    read(is, scene_settings);
+    read(is, deltas);
+}
+
+
+TextureTilesMessage::TextureTilesMessage()
+{
+}
+void TextureTilesMessage::serialize(std::ostream& os) const
+{
+    super::serialize(os);
+    write(os, textures);
+}
+void TextureTilesMessage::deserialize(std::istream& is)
+{
+    super::deserialize(is);
+    read(is, textures);
+}
+
+
+MaterialDeltaMessage::MaterialDeltaMessage()
+{
+}
+void MaterialDeltaMessage::serialize(std::ostream& os) const
+{
+    super::serialize(os);
+    write(os, materials);
+}
+void MaterialDeltaMessage::deserialize(std::istream& is)
+{
+    super::deserialize(is);
+    read(is, materials);
+}
+
+
 FenceMessage::~FenceMessage() {}
 void FenceMessage::serialize(std::ostream& os) const
 {
@@ -138,12 +189,14 @@ void ResponseMessage::serialize(std::ostream & os) const
 {
     super::serialize(os);
     write(os, text);
+    write(os, hits);
 }
 
 void ResponseMessage::deserialize(std::istream & is)
 {
     super::deserialize(is);
     read(is, text);
+    read(is, hits);
 }
 
 
@@ -155,12 +208,18 @@ void QueryMessage::serialize(std::ostream & os) const
 {
     super::serialize(os);
     write(os, query_type);
+    write(os, positions);
+    write(os, directions);
+    write(os, max_distance);
 }
 
 void QueryMessage::deserialize(std::istream & is)
 {
     super::deserialize(is);
     read(is, query_type);
+    read(is, positions);
+    read(is, directions);
+    read(is, max_distance);
 }
 
 
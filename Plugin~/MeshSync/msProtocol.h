@@ -2,9 +2,24 @@
 
 #include <atomic>
 #include "SceneGraph/msSceneGraph.h"
+#include "SceneGraph/msAnimation.h"
+#include "SceneGraph/msTexture.h"
+#include "SceneGraph/msMaterial.h"
+#include "Utils/msRaycast.h"
 
 namespace ms {
 
+// timings of a received message. filled by Server and aggregated by LatencyStats.
+struct MessageLatency
+{
+    bool clock_synced = false;
+    nanosec clock_offset = 0;       // sender's clock + clock_offset = receiver's clock
+    nanosec serialize = 0;          // reported by the sender
+    nanosec timestamp_request = 0;  // the request reached the server
+    nanosec transfer_wait = 0;      // time spent waiting for the body while deserializing
+    nanosec timestamp_imported = 0; // 0 if the message has no import task
+};
+
 class Message
 {
 public:
@@ -19,6 +34,9 @@ public:
         Screenshot,
         Query,
         Response,
+        AnimationDelta,
+        TextureTiles,
+        MaterialDelta,
     };
     int protocol_version = msProtocolVersion;
     int session_id = InvalidID;
@@ -27,6 +45,7 @@ public:
 
     // non-serializable fields
     nanosec timestamp_recv = 0;
+    MessageLatency latency;
 
     virtual ~Message();
     virtual void serialize(std::ostream& os) const;
@@ -50,6 +69,8 @@ struct GetFlags
     uint32_t get_bones : 1;
     uint32_t get_blendshapes : 1; // 10
     uint32_t apply_culling : 1;
+    uint32_t apply_occlusion_culling : 1; // requires apply_culling
+    uint32_t update_raycast_scene : 1; // keep served meshes for QueryType::Raycast and ClosestPoint
 
     void setAllGetFlags();
 };
@@ -61,6 +82,9 @@ public:
     GetFlags flags = {0};
     SceneSettings scene_settings;
     MeshRefineSettings refine_settings;
+    // world to clip matrix of the camera in the server's coordinate system. used if flags.apply_culling is set.
+    // see CullingSettings.
+    float4x4 view_proj = float4x4::identity();
 
     // non-serializable fields
     std::atomic_bool ready{ false };
@@ -74,11 +98,21 @@ msSerializable(GetMessage);
 msDeclPtr(GetMessage);
 
 
+struct SetFlags
+{
+    // the receiver keeps the assets of the scene as the bases of AnimationDelta, TextureTiles and MaterialDelta messages
+    uint32_t retain_assets : 1;
+};
+
 class SetMessage : public Message
 {
 using super = Message;
 public:
     ScenePtr scene;
+    SetFlags flags = {0};
+
+    // non-serializable fields
+    std::vector<AnimationClipPtr> retained_clips; // copies of the clips of scene made by Server if flags.retain_assets
 
 public:
     SetMessage();
@@ -105,6 +139,56 @@ msSerializable(DeleteMessage);
 msDeclPtr(DeleteMessage);
 
 
+// partial update of AnimationClips sent by SetMessage before
+class AnimationDeltaMessage : public Message
+{
+using super = Message;
+public:
+    SceneSettings scene_settings;
+    std::vector<AnimationClipDelta> deltas;
+
+    AnimationDeltaMessage();
+    void serialize(std::ostream& os) const override;
+    void deserialize(std::istream& is) override;
+};
+msSerializable(AnimationDeltaMessage);
+msDeclPtr(AnimationDeltaMessage);
+
+
+// partial update of Textures sent by SetMessage before
+class TextureTilesMessage : public Message
+{
+using super = Message;
+public:
+    std::vector<TextureTiles> textures;
+
+    TextureTilesMessage();
+    void serialize(std::ostream& os) const override;
+    void deserialize(std::istream& is) override;
+};
+msSerializable(TextureTilesMessage);
+msDeclPtr(TextureTilesMessage);
+
+
+// partial update of Materials sent by SetMessage before.
+// each material has the header (id, name, index, shader) and the changed properties only.
+class MaterialDeltaMessage : public Message
+{
+using super = Message;
+public:
+    std::vector<MaterialPtr> materials;
+
+    // non-serializable fields
+    std::vector<MaterialPtr> merged; // same order as materials. null if the target material is unknown
+
+    MaterialDeltaMessage();
+    void serialize(std::ostream& os) const override;
+    void deserialize(std::istream& is) override;
+};
+msSerializable(MaterialDeltaMessage);
+msDeclPtr(MaterialDeltaMessage);
+
+
 class FenceMessage : public Message
 {
 using super = Message;
@@ -171,6 +255,7 @@ class ResponseMessage : public Message
     using super = Message;
 public:
     std::vector<std::string> text;
+    SharedVector<RaycastHit> hits; // QueryType::Raycast and ClosestPoint
 
     ResponseMessage();
     void serialize(std::ostream& os) const override;
@@ -192,10 +277,17 @@ public:
         HostName,
         RootNodes,
         AllNodes,
+        Raycast,
+        ClosestPoint,
     };
 
 public:
     QueryType query_type = QueryType::Unknown;
+    // Raycast: ray origins and directions. ClosestPoint: positions only.
+    // in the server's world space. queries are against meshes served with GetFlags::update_raycast_scene.
+    SharedVector<float3> positions;
+    SharedVector<float3> directions;
+    float max_distance = FLT_MAX;
 
     // non-serializable fields
     std::atomic_bool ready{ false };
@@ -0,0 +1,508 @@
+#include "pch.h"
+#include "msRelay.h"
+
+#ifdef msEnableNetwork
+namespace ms {
+
+namespace {
+
+// read-only view of a buffer. unlike MemoryStream, deserialized SharedVectors don't share the buffer.
+class ReadOnlyStreamBuf : public std::streambuf
+{
+public:
+    ReadOnlyStreamBuf(const char *data, size_t size)
+    {
+        auto *p = const_cast<char*>(data);
+        this->setg(p, p, p + size);
+    }
+};
+
+RelayPacketPtr MakePacket(const RelayPacket& src, const Message& mes)
+{
+    auto ret = std::make_shared<RelayPacket>();
+    ret->seq = src.seq;
+    ret->frame = src.frame;
+    ret->type = src.type;
+    ret->uri = src.uri;
+
+    mu::MemoryStream os;
+    mes.serialize(os);
+    os.flush();
+    ret->data.assign(os.getBuffer().cdata(), os.getBuffer().cdata() + os.getWCount());
+    return ret;
+}
+
+// merges packets of consecutive frames into one frame that leads the receiver to the same state:
+// SceneBegin, Delete (all deletes), Set (the latest entity per path and the latest version of each asset),
+// the deltas and other messages in the received order, and SceneEnd.
+// messages are re-serialized with the session id of the first SceneBegin, as the receiver accepts only the messages
+// of the current session.
+std::vector<RelayPacketPtr> CoalesceFrames(const std::vector<RelayPacketPtr>& src)
+{
+    struct Item
+    {
+        const RelayPacket *packet;
+        MessagePtr message;
+    };
+    struct RetainedAsset
+    {
+        AssetPtr asset;
+        bool retain;
+    };
+
+    const RelayPacket *begin_packet = nullptr, *end_packet = nullptr, *set_packet = nullptr, *delete_packet = nullptr;
+    FenceMessagePtr begin, end;
+    SetMessagePtr last_set;
+    DeleteMessagePtr deletes;
+    std::vector<MessagePtr> sources; // merged entities share the data of these
+    std::vector<TransformPtr> entities;
+    std::map<std::string, size_t> entity_indices;
+    std::vector<ConstraintPtr> constraints;
+    std::vector<RetainedAsset> assets;
+    std::map<std::pair<AssetType, int>, size_t> asset_indices;
+    std::vector<Item> others; // deltas, texts, etc.
+
+    // drops the deltas received so far for an asset that is sent again or deleted
+    auto drop_deltas = [&others](AssetType type, int id, const Asset *asset) {
+        for (auto& item : others) {
+            if (type == AssetType::Animation && asset) {
+                if (auto mes = std::dynamic_pointer_cast<AnimationDeltaMessage>(item.message)) {
+                    auto& clip = static_cast<const AnimationClip&>(*asset);
+                    mes->deltas.erase(std::remove_if(mes->deltas.begin(), mes->deltas.end(),
+                        [&clip](AnimationClipDelta& d) { return d.isTarget(clip); }), mes->deltas.end());
+                }
+            }
+            else if (type == AssetType::Texture) {
+                if (auto mes = std::dynamic_pointer_cast<TextureTilesMessage>(item.message)) {
+                    mes->textures.erase(std::remove_if(mes->textures.begin(), mes->textures.end(),
+                        [id](TextureTiles& tt) { return tt.texture_id == id; }), mes->textures.end());
+                }
+            }
+            else if (type == AssetType::Material) {
+                if (auto mes = std::dynamic_pointer_cast<MaterialDeltaMessage>(item.message)) {
+                    mes->materials.erase(std::remove_if(mes->materials.begin(), mes->materials.end(),
+                        [id](MaterialPtr& m) { return m->id == id; }), mes->materials.end());
+                }
+            }
+        }
+    };
+
+    int last_session_id = InvalidID;
+    for (auto& packet : src) {
+        auto mes = packet->deserialize();
+        if (!mes)
+            continue;
+        last_session_id = mes->session_id;
+
+        if (auto fence = std::dynamic_pointer_cast<FenceMessage>(mes)) {
+            if (fence->type == FenceMessage::FenceType::SceneBegin) {
+                if (!begin) {
+                    begin = fence;
+                    begin_packet = packet.get();
+                }
+                continue;
+            }
+            else if (fence->type == FenceMessage::FenceType::SceneEnd) {
+                end = fence;
+                end_packet = packet.get();
+                continue;
+            }
+        }
+        else if (auto set = std::dynamic_pointer_cast<SetMessage>(mes)) {
+            auto& scene = *set->scene;
+            for (auto& e : scene.entities) {
+                auto it = entity_indices.find(e->path);
+                if (it == entity_indices.end()) {
+                    entity_indices[e->path] = entities.size();
+                    entities.push_back(e);
+                    continue;
+                }
+                auto& last = entities[it->second];
+                if (e->getType() == EntityType::Transform && last->getType() != EntityType::Transform) {
+                    // a geometry whose transform has changed is sent as a plain Transform. keep the geometry
+                    auto merged = std::static_pointer_cast<Transform>(last->clone());
+                    static_cast<Transform&>(*merged) = *e;
+                    last = merged;
+                }
+                else
+                    last = e;
+            }
+            constraints.insert(constraints.end(), scene.constraints.begin(), scene.constraints.end());
+            for (auto& a : scene.assets) {
+                auto key = std::make_pair(a->getAssetType(), a->id);
+                drop_deltas(key.first, a->id, a.get());
+                auto it = asset_indices.find(key);
+                if (it == asset_indices.end()) {
+                    asset_indices[key] = assets.size();
+                    assets.push_back({ a, set->flags.retain_assets != 0 });
+                }
+                else
+                    assets[it->second] = { a, set->flags.retain_assets != 0 };
+            }
+            sources.push_back(set);
+            last_set = set;
+            set_packet = packet.get();
+            continue;
+        }
+        else if (auto del = std::dynamic_pointer_cast<DeleteMessage>(mes)) {
+            // updates of deleted entities are dropped. every delete is kept
+            for (auto& id : del->entities) {
+                for (auto& e : entities) {
+                    if (e && (e->path == id.name || (id.id != InvalidID && e->host_id == id.id))) {
+                        entity_indices.erase(e->path);
+                        e = nullptr;
+                    }
+                }
+            }
+            for (auto& id : del->materials) {
+                auto it = asset_indices.find(std::make_pair(AssetType::Material, id.id));
+                if (it != asset_indices.end()) {
+                    assets[it->second].asset = nullptr;
+                    asset_indices.erase(it);
+                }
+                drop_deltas(AssetType::Material, id.id, nullptr);
+            }
+            if (!deletes)
+                deletes = del;
+            else {
+                deletes->entities.insert(deletes->entities.end(), del->entities.begin(), del->entities.end());
+                deletes->materials.insert(deletes->materials.end(), del->materials.begin(), del->materials.end());
+                deletes->message_id = del->message_id;
+                deletes->timestamp_send = del->timestamp_send;
+            }
+            delete_packet = packet.get();
+            continue;
+        }
+        others.push_back({ packet.get(), mes });
+    }
+
+    // without SceneBegin, the messages are standalone ones. use the session of the latest one
+    int session_id = begin ? begin->session_id : last_session_id;
+
+    std::vector<RelayPacketPtr> ret;
+    auto add = [&](const RelayPacket& packet, Message& mes) {
+        mes.session_id = session_id;
+        ret.push_back(MakePacket(packet, mes));
+    };
+
+    if (begin)
+        add(*begin_packet, *begin);
+    if (deletes)
+        add(*delete_packet, *deletes);
+    if (last_set) {
+        // assets sent with and without SetFlags::retain_assets can't share a Set
+        for (int retain = 0; retain < 2; ++retain) {
+            bool has_entities = (retain != 0) == (last_set->flags.retain_assets != 0);
+            auto scene = Scene::create();
+            scene->settings = last_set->scene->settings;
+            for (auto& a : assets) {
+                if (a.asset && a.retain == (retain != 0))
+                    scene->assets.push_back(a.asset);
+            }
+            if (has_entities) {
+                for (auto& e : entities) {
+                    if (e)
+                        scene->entities.push_back(e);
+                }
+                scene->constraints = constraints;
+            }
+            if (scene->assets.empty() && !has_entities)
+                continue;
+
+            SetMessage mes(scene);
+            mes.flags.retain_assets = retain;
+            mes.message_id = last_set->message_id;
+            mes.timestamp_send = last_set->timestamp_send;
+            add(*set_packet, mes);
+        }
+    }
+    for (auto& item : others) {
+        if (auto mes = std::dynamic_pointer_cast<AnimationDeltaMessage>(item.message)) {
+            if (mes->deltas.empty())
+                continue;
+        }
+        else if (auto mes = std::dynamic_pointer_cast<TextureTilesMessage>(item.message)) {
+            if (mes->textures.empty())
+                continue;
+        }
+        else if (auto mes = std::dynamic_pointer_cast<MaterialDeltaMessage>(item.message)) {
+            if (mes->materials.empty())
+                continue;
+        }
+        add(*item.packet, *item.message);
+    }
+    if (end)
+        add(*end_packet, *end);
+    return ret;
+}
+
+} // namespace
+
+MessagePtr RelayPacket::deserialize() const
+{
+    MessagePtr ret;
+    switch (type) {
+    case Message::Type::Set: ret = std::make_shared<SetMessage>(); break;
+    case Message::Type::Delete: ret = std::make_shared<DeleteMessage>(); break;
+    case Message::Type::Fence: ret = std::make_shared<FenceMessage>(); break;
+    case Message::Type::Text: ret = std::make_shared<TextMessage>(); break;
+    case Message::Type::AnimationDelta: ret = std::make_shared<AnimationDeltaMessage>(); break;
+    case Message::Type::TextureTiles: ret = std::make_shared<TextureTilesMessage>(); break;
+    case Message::Type::MaterialDelta: ret = std::make_shared<MaterialDeltaMessage>(); break;
+    default: return nullptr;
+    }
+
+    ReadOnlyStreamBuf buf(data.cdata(), data.size());
+    std::istream is(&buf);
+    ret->deserialize(is);
+    return ret;
+}
+
+
+Relay::Relay()
+{
+}
+
+Relay::~Relay()
+{
+    clear();
+}
+
+int Relay::addConsumer(const Handler& handler, const RelayConsumerSettings& settings)
+{
+    auto consumer = std::make_shared<Consumer>();
+    consumer->handler = handler;
+    consumer->settings = settings;
+    consumer->settings.max_pending = std::max(consumer->settings.max_pending, 1);
+
+    lock_t lock(m_mutex);
+    consumer->id = ++m_id_seed;
+    // only packets pushed from now on are delivered
+    consumer->cursor = m_seq_end;
+    consumer->thread = std::thread([this, consumer]() { consumerLoop(consumer.get()); });
+    m_consumers.push_back(consumer);
+    return consumer->id;
+}
+
+int Relay::addForwarder(const ClientSettings& dst, const RelayConsumerSettings& settings)
+{
+    auto client = std::make_shared<Client>(dst);
+    return addConsumer([client](const RelayPacket& packet) {
+        return client->forward(packet.uri, packet.data.cdata(), packet.data.size());
+    }, settings);
+}
+
+void Relay::removeConsumer(int id)
+{
+    ConsumerPtr consumer;
+    {
+        lock_t lock(m_mutex);
+        auto it = std::find_if(m_consumers.begin(), m_consumers.end(), [id](ConsumerPtr& c) { return c->id == id; });
+        if (it == m_consumers.end())
+            return;
+        consumer = *it;
+        consumer->stop = true;
+        m_consumers.erase(it);
+        releasePackets();
+    }
+    m_cond_push.notify_all();
+    m_cond_pop.notify_all();
+
+    // must not be called from a handler. the thread would join itself
+    consumer->thread.join();
+}
+
+void Relay::clear()
+{
+    std::vector<ConsumerPtr> consumers;
+    {
+        lock_t lock(m_mutex);
+        consumers.swap(m_consumers);
+        for (auto& c : consumers)
+            c->stop = true;
+        m_packets.clear();
+        m_seq_begin = m_seq_end;
+        m_in_frame = false;
+        ++m_frame;
+    }
+    m_cond_push.notify_all();
+    m_cond_pop.notify_all();
+
+    for (auto& c : consumers)
+        c->thread.join();
+}
+
+int Relay::getNumConsumers() const
+{
+    lock_t lock(m_mutex);
+    return (int)m_consumers.size();
+}
+
+bool Relay::getStats(int id, RelayConsumerStats& dst) const
+{
+    lock_t lock(m_mutex);
+    for (auto& c : m_consumers) {
+        if (c->id == id) {
+            dst = c->stats;
+            dst.pending = (int)(m_seq_end - c->cursor);
+            return true;
+        }
+    }
+    return false;
+}
+
+void Relay::push(RelayPacketPtr packet)
+{
+    if (!packet)
+        return;
+
+    auto fence_type = FenceMessage::FenceType::Unknown;
+    if (packet->type == Message::Type::Fence) {
+        if (auto fence = std::static_pointer_cast<FenceMessage>(packet->deserialize()))
+            fence_type = fence->type;
+    }
+
+    lock_t lock(m_mutex);
+    if (m_consumers.empty())
+        return;
+
+    // back pressure from Block consumers. each one is waited for up to its own block_timeout_ms
+    // so that the receiving threads are not held by a stuck consumer.
+    auto wait_begin = std::chrono::steady_clock::now();
+    auto consumers = m_consumers; // m_consumers can be modified while waiting
+    for (auto& c : consumers) {
+        if (c->settings.drop_policy != RelayConsumerSettings::DropPolicy::Block)
+            continue;
+        auto deadline = wait_begin + std::chrono::milliseconds(c->settings.block_timeout_ms);
+        m_cond_pop.wait_until(lock, deadline, [this, &c]() {
+            return c->stop || m_seq_end - c->cursor < (uint64_t)c->settings.max_pending;
+        });
+    }
+    if (m_consumers.empty())
+        return;
+
+    if (fence_type == FenceMessage::FenceType::SceneBegin) {
+        // the previous frame is complete even if its SceneEnd is missing
+        if (m_in_frame)
+            ++m_frame;
+        m_in_frame = true;
+    }
+    packet->seq = m_seq_end++;
+    packet->frame = m_frame;
+    if (!m_in_frame || fence_type == FenceMessage::FenceType::SceneEnd) {
+        m_in_frame = false;
+        ++m_frame;
+    }
+    m_packets.push_back(packet);
+    lock.unlock();
+    m_cond_push.notify_all();
+}
+
+bool Relay::flush(int timeout_ms)
+{
+    lock_t lock(m_mutex);
+    return m_cond_pop.wait_for(lock, std::chrono::milliseconds(timeout_ms), [this]() {
+        for (auto& c : m_consumers) {
+            if (c->busy || c->cursor != m_seq_end)
+                return false;
+        }
+        return true;
+    });
+}
+
+void Relay::consumerLoop(Consumer *consumer)
+{
+    auto& c = *consumer;
+    lock_t lock(m_mutex);
+    for (;;) {
+        m_cond_push.wait(lock, [&c, this]() { return c.stop || c.cursor < m_seq_end; });
+        if (c.stop)
+            break;
+
+        std::vector<RelayPacketPtr> frames;
+        if (takeFramesToCoalesce(c, frames)) {
+            c.busy = true;
+            releasePackets();
+            lock.unlock();
+            std::vector<RelayPacketPtr> packets;
+            try {
+                packets = CoalesceFrames(frames);
+            }
+            catch (const std::exception& e) {
+                // broken packets. hand them over as they are
+                msLogError("Relay: failed to coalesce frames (%s)\n", e.what());
+                packets = frames;
+            }
+            frames.clear();
+
+            int delivered = 0, failed = 0;
+            for (auto& p : packets) {
+                if (c.handler(*p))
+                    ++delivered;
+                else
+                    ++failed;
+            }
+            lock.lock();
+            c.busy = false;
+            c.stats.delivered += delivered;
+            c.stats.failed += failed;
+            m_cond_pop.notify_all();
+            continue;
+        }
+
+        // advance the cursor before handling so that push() doesn't wait for the packet
+        auto packet = m_packets[(size_t)(c.cursor - m_seq_begin)];
+        ++c.cursor;
+        c.last_frame = packet->frame;
+        c.busy = true;
+        releasePackets();
+        lock.unlock();
+        bool ok = c.handler(*packet);
+        lock.lock();
+        c.busy = false;
+
+        if (ok)
+            ++c.stats.delivered;
+        else
+            ++c.stats.failed;
+        m_cond_pop.notify_all();
+    }
+}
+
+bool Relay::takeFramesToCoalesce(Consumer& c, std::vector<RelayPacketPtr>& dst)
+{
+    if (m_seq_end - c.cursor <= (uint64_t)c.settings.max_pending)
+        return false;
+
+    // whole frames only. coalescing a part of a frame (e.g. without its SceneEnd fence) would break the scene session
+    auto frame_of = [this](uint64_t seq) { return m_packets[(size_t)(seq - m_seq_begin)]->frame; };
+    uint64_t first_frame = frame_of(c.cursor);
+    if (first_frame == c.last_frame)
+        return false; // the consumer is in the middle of the frame
+    uint64_t end = c.cursor;
+    while (end < m_seq_end && frame_of(end) < m_frame)
+        ++end;
+    if (end == c.cursor || frame_of(end - 1) == first_frame)
+        return false; // less than 2 complete frames. nothing to coalesce
+
+    auto begin = m_packets.begin() + (size_t)(c.cursor - m_seq_begin);
+    dst.assign(begin, begin + (size_t)(end - c.cursor));
+    c.stats.coalesced += end - c.cursor;
+    c.cursor = end;
+    c.last_frame = frame_of(end - 1);
+    return true;
+}
+
+void Relay::releasePackets()
+{
+    uint64_t seq = m_seq_end;
+    for (auto& c : m_consumers)
+        seq = std::min(seq, c->cursor);
+    while (m_seq_begin < seq) {
+        m_packets.pop_front();
+        ++m_seq_begin;
+    }
+}
+
+} // namespace ms
+#endif // msEnableNetwork
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+#include "msProtocol.h"
+#include "msClient.h"
+
+#ifdef msEnableNetwork
+namespace ms {
+
+// a received message in its serialized form. shared by all consumers of a Relay.
+struct RelayPacket
+{
+    uint64_t seq = 0;
+    // packets between a SceneBegin fence and the SceneEnd fence (both inclusive) share the same frame.
+    // packets outside of them are frames of their own. set by Relay::push().
+    uint64_t frame = 0;
+    Message::Type type = Message::Type::Unknown;
+    std::string uri; // "set", "delete", "fence", etc. same as the uri the message was sent to
+    RawVector<char> data;
+
+    // for in-process consumers that need the message. data is copied, so the result can be modified.
+    MessagePtr deserialize() const;
+};
+msDeclPtr(RelayPacket);
+
+struct RelayConsumerSettings
+{
+    enum class DropPolicy
+    {
+        // when a consumer falls more than max_pending packets behind, its pending complete frames are
+        // coalesced into one frame that leads the receiver to the same state (see Relay::consumerLoop()).
+        // nothing is skipped: deletes, deltas and tiles are kept, and only Sets overwritten by newer ones are merged.
+        DropOldest,
+        // push() waits up to block_timeout_ms for the consumer to catch up, then frames are coalesced as DropOldest.
+        // the slowest consumer throttles the sender, but can't stall the receiving server indefinitely.
+        Block,
+    };
+    int max_pending = 64;
+    DropPolicy drop_policy = DropPolicy::DropOldest;
+    int block_timeout_ms = 100;
+};
+
+struct RelayConsumerStats
+{
+    uint64_t delivered = 0;
+    uint64_t coalesced = 0; // received packets merged into coalesced frames instead of being handled one by one
+    uint64_t failed = 0; // handler returned false
+    int pending = 0;
+};
+
+// fans messages out to multiple consumers.
+// packets are kept in one log and each consumer reads it through its own cursor on its own thread,
+// so a slow consumer doesn't delay the others (unless its drop policy is Block).
+// packets that all consumers have passed are released. a consumer stuck in its handler keeps its pending packets.
+class Relay
+{
+public:
+    // returns false if the packet could not be delivered. counted as failed but the cursor advances anyway.
+    using Handler = std::function<bool(const RelayPacket& packet)>;
+
+    Relay();
+    ~Relay();
+
+    // returns consumer id
+    int addConsumer(const Handler& handler, const RelayConsumerSettings& settings = {});
+    // forwards packets to another server as they were received. no re-serialization.
+    int addForwarder(const ClientSettings& dst, const RelayConsumerSettings& settings = {});
+    void removeConsumer(int id);
+    void clear();
+
+    int getNumConsumers() const;
+    bool getStats(int id, RelayConsumerStats& dst) const;
+
+    void push(RelayPacketPtr packet);
+    // wait until all consumers have handled all packets. returns false on timeout
+    bool flush(int timeout_ms = 30000);
+
+private:
+    struct Consumer
+    {
+        int id = 0;
+        Handler handler;
+        RelayConsumerSettings settings;
+        uint64_t cursor = 0; // seq of the next packet to handle
+        uint64_t last_frame = ~0ULL; // frame of the last handled packet
+        bool busy = false;
+        bool stop = false;
+        RelayConsumerStats stats;
+        std::thread thread;
+    };
+    using ConsumerPtr = std::shared_ptr<Consumer>;
+    using lock_t = std::unique_lock<std::mutex>;
+
+    void consumerLoop(Consumer *consumer);
+    bool takeFramesToCoalesce(Consumer& consumer, std::vector<RelayPacketPtr>& dst);
+    void releasePackets();
+
+    mutable std::mutex m_mutex;
+    std::condition_variable m_cond_push, m_cond_pop;
+    std::vector<ConsumerPtr> m_consumers;
+    std::deque<RelayPacketPtr> m_packets;
+    uint64_t m_seq_begin = 0; // seq of m_packets.front()
+    uint64_t m_seq_end = 0;   // seq of the next packet
+    uint64_t m_frame = 0;     // frame of the next packet. frames before this are complete
+    bool m_in_frame = false;  // between SceneBegin and SceneEnd
+    int m_id_seed = 0;
+};
+
+} // namespace ms
+#endif // msEnableNetwork
@@ -4,6 +4,7 @@
 #include "SceneGraph/msMaterial.h"
 #include "SceneGraph/msAnimation.h"
 #include "SceneGraph/msEntityConverter.h"
+#include "Utils/msCulling.h"
 
 #ifdef msEnableNetwork
 namespace ms {
@@ -50,6 +51,15 @@ void RequestHandler::handleRequest(HTTPServerRequest& request, HTTPServerRespons
     else if (uri == "delete") {
         m_server->recvDelete(request, response);
     }
+    else if (uri == "animation_delta") {
+        m_server->recvAnimationDelta(request, response);
+    }
+    else if (uri == "texture_tiles") {
+        m_server->recvTextureTiles(request, response);
+    }
+    else if (uri == "material_delta") {
+        m_server->recvMaterialDelta(request, response);
+    }
     else if (uri == "fence") {
         m_server->recvFence(request, response);
     }
@@ -70,6 +80,8 @@ void RequestHandler::handleRequest(HTTPServerRequest& request, HTTPServerRespons
     }
     else if (StartWith(uri, "/protocol_version")) {
         static const auto res = std::to_string(msProtocolVersion);
+        // for clients to estimate the offset of their clocks. see ClockOffset
+        response.set(msHeaderServerTime, std::to_string(mu::Now()));
         m_server->serveText(response, res.c_str());
     }
     else if (StartWith(uri, "/plugin_version")) {
@@ -139,7 +151,18 @@ void Server::clear()
 {
     lock_t lock(m_message_mutex);
     m_received_messages.clear();
+    m_animation_clips.clear();
+    m_textures.clear();
+    m_materials.clear();
+    {
+        lock_t llock(m_lost_textures_mutex);
+        m_lost_textures.clear();
+    }
     m_host_scene.reset();
+    {
+        lock_t rlock(m_raycast_mutex);
+        m_raycast_scene.clear();
+    }
 }
 
 ServerSettings& Server::getSettings()
@@ -171,6 +194,7 @@ int Server::processMessages(const MessageHandler& handler)
 
         bool skip = false;
         auto& mes = holder.message;
+        auto consume_begin = mu::Now();
         if (!mes)
             goto next;
 
@@ -182,15 +206,59 @@ int Server::processMessages(const MessageHandler& handler)
         else if (auto set = std::dynamic_pointer_cast<SetMessage>(mes)) {
             if (mes->session_id == m_current_scene_session)
             {
+                retainAnimationClips(*set);
+                retainTextures(*set);
+                retainMaterials(*set);
+#ifdef msEnableSceneCache
+                m_recorder.addScene(set->scene, set->flags.retain_assets);
+#endif
                 handler(Message::Type::Set, *mes);
                 m_scene_cache.push_back(set);
             }
             else
                 skip = true;
         }
+        else if (auto delta = std::dynamic_pointer_cast<AnimationDeltaMessage>(mes)) {
+            if (mes->session_id == m_current_scene_session) {
+                applyAnimationDelta(*delta);
+#ifdef msEnableSceneCache
+                m_recorder.addAnimationDeltas(delta->deltas);
+#endif
+                handler(Message::Type::AnimationDelta, *mes);
+            }
+            else
+                skip = true;
+        }
+        else if (auto tiles = std::dynamic_pointer_cast<TextureTilesMessage>(mes)) {
+            if (mes->session_id == m_current_scene_session) {
+                applyTextureTiles(*tiles);
+#ifdef msEnableSceneCache
+                m_recorder.addTextureTiles(tiles->textures);
+#endif
+                handler(Message::Type::TextureTiles, *mes);
+            }
+            else
+                skip = true;
+        }
+        else if (auto mdelta = std::dynamic_pointer_cast<MaterialDeltaMessage>(mes)) {
+            if (mes->session_id == m_current_scene_session) {
+                applyMaterialDelta(*mdelta);
+#ifdef msEnableSceneCache
+                m_recorder.addMaterialDeltas(mdelta->materials);
+#endif
+                handler(Message::Type::MaterialDelta, *mes);
+            }
+            else
+                skip = true;
+        }
         else if (auto del = std::dynamic_pointer_cast<DeleteMessage>(mes)) {
-            if (mes->session_id == m_current_scene_session)
+            if (mes->session_id == m_current_scene_session) {
+                releaseMaterials(del->materials);
                 handler(Message::Type::Delete, *mes);
+#ifdef msEnableSceneCache
+                m_recorder.deleteEntities(del->entities);
+#endif
+            }
             else
                 skip = true;
         }
@@ -210,8 +278,12 @@ int Server::processMessages(const MessageHandler& handler)
 
             if (!skip) {
                 handler(Message::Type::Fence, *mes);
-                if (fence->type == FenceMessage::FenceType::SceneEnd)
+                if (fence->type == FenceMessage::FenceType::SceneEnd) {
+#ifdef msEnableSceneCache
+                    m_recorder.endScene(fence->timestamp_send != 0 ? fence->timestamp_send : fence->timestamp_recv);
+#endif
                     m_scene_cache.clear();
+                }
             }
         }
         else if (std::dynamic_pointer_cast<TextMessage>(mes)) {
@@ -230,6 +302,8 @@ int Server::processMessages(const MessageHandler& handler)
             ++i;
         }
         else {
+            if (mes && mes->timestamp_recv != 0)
+                m_latency_stats.add(*mes, consume_begin, mu::Now());
             m_processing_messages.erase(i++);
             ++ret;
         }
@@ -250,6 +324,22 @@ void Server::serveText(HTTPServerResponse &response, const char* text, int stat)
     os.flush();
 }
 
+void Server::serveLostTextures(HTTPServerResponse &response)
+{
+    lock_t lock(m_lost_textures_mutex);
+    if (m_lost_textures.empty())
+        return;
+
+    std::string ids;
+    for (int id : m_lost_textures) {
+        if (!ids.empty())
+            ids += ',';
+        ids += std::to_string(id);
+    }
+    response.set(msHeaderLostTextures, ids);
+    m_lost_textures.clear();
+}
+
 void Server::serveBinary(Poco::Net::HTTPServerResponse & response, const void *data, size_t size, int stat)
 {
     response.setStatus((HTTPResponse::HTTPStatus)stat);
@@ -324,6 +414,19 @@ void Server::endServeScene()
     }
 
     auto& request = *m_current_get_request;
+    if (request.flags.update_raycast_scene) {
+        // before culling and refining. the raycast scene keeps all meshes in their original space
+        std::vector<const Mesh*> meshes;
+        for (auto& e : m_host_scene->entities) {
+            if (auto *mesh = dynamic_cast<Mesh*>(e.get()))
+                meshes.push_back(mesh);
+        }
+        lock_t lock(m_raycast_mutex);
+        m_raycast_scene.update(meshes.data(), meshes.size());
+    }
+    if (request.flags.apply_culling)
+        cullServedMeshes(request);
+
     parallel_for_each(m_host_scene->entities.begin(), m_host_scene->entities.end(), [&request, this](TransformPtr& p) {
         auto pmesh = dynamic_cast<Mesh*>(p.get());
         if (!pmesh)
@@ -340,6 +443,31 @@ void Server::endServeScene()
     request.ready = true;
 }
 
+void Server::cullServedMeshes(const GetMessage& request)
+{
+    auto& entities = m_host_scene->entities;
+    std::vector<const Mesh*> meshes;
+    for (auto& e : entities) {
+        if (auto *mesh = dynamic_cast<Mesh*>(e.get()))
+            meshes.push_back(mesh);
+    }
+    if (meshes.empty())
+        return;
+
+    CullingSettings settings;
+    settings.view_proj = request.view_proj;
+    settings.occlusion = request.flags.apply_occlusion_culling;
+    std::unique_ptr<bool[]> visible(new bool[meshes.size()]);
+    if (CullMeshes(settings, meshes.data(), meshes.size(), visible.get()) == meshes.size())
+        return;
+
+    // meshes are in the order of entities
+    size_t mi = 0;
+    entities.erase(std::remove_if(entities.begin(), entities.end(), [&](TransformPtr& e) {
+        return dynamic_cast<Mesh*>(e.get()) && !visible[mi++];
+    }), entities.end());
+}
+
 void Server::setScrrenshotFilePath(const std::string& path)
 {
     if (m_current_screenshot_request) {
@@ -348,6 +476,213 @@ void Server::setScrrenshotFilePath(const std::string& path)
     }
 }
 
+void Server::retainAnimationClips(SetMessage& mes)
+{
+    auto find = [this](const AnimationClip& clip) {
+        return std::find_if(m_animation_clips.begin(), m_animation_clips.end(),
+            [&clip](auto& c) { return c->identify(clip.getIdentifier()); });
+    };
+
+    if (mes.flags.retain_assets) {
+        // copied by the import task
+        for (auto& clip : mes.retained_clips) {
+            auto it = find(*clip);
+            if (it != m_animation_clips.end())
+                *it = clip;
+            else
+                m_animation_clips.push_back(clip);
+        }
+        mes.retained_clips.clear();
+    }
+    else if (!m_animation_clips.empty()) {
+        // the sender no longer sends deltas for these clips
+        for (auto& clip : mes.scene->getAssets<AnimationClip>()) {
+            auto it = find(*clip);
+            if (it != m_animation_clips.end())
+                m_animation_clips.erase(it);
+        }
+    }
+}
+
+void Server::applyAnimationDelta(AnimationDeltaMessage& mes)
+{
+    for (auto& delta : mes.deltas) {
+        auto it = std::find_if(m_animation_clips.begin(), m_animation_clips.end(),
+            [&delta](auto& c) { return delta.isTarget(*c); });
+        AnimationClipPtr base;
+        if (it != m_animation_clips.end()) {
+            base = *it;
+        }
+        else {
+            base = AnimationClip::create();
+            base->name = delta.clip->name;
+            base->id = delta.clip->id;
+            base->frame_rate = delta.clip->frame_rate;
+            m_animation_clips.push_back(base);
+        }
+
+        // the base is only owned by the server. it is patched in place and the handler gets copies of the updated
+        // curves only, because handlers modify clips (keyframe reduction etc.).
+        auto updated = AnimationClip::create();
+        updated->name = base->name;
+        updated->id = base->id;
+        updated->frame_rate = base->frame_rate;
+        delta.apply(*base, updated.get());
+        delta.merged = updated;
+    }
+}
+
+// retained textures beyond this size are released from the least recently used one. the sender is told to resend them.
+// large enough for a few 8K textures (256 MiB each as RGBAu8) so that painting on them doesn't make them evict each other.
+static const size_t MaxRetainedTextureSize = 1024 * 1024 * 1024;
+
+void Server::loseTexture(int texture_id)
+{
+    lock_t lock(m_lost_textures_mutex);
+    if (std::find(m_lost_textures.begin(), m_lost_textures.end(), texture_id) == m_lost_textures.end())
+        m_lost_textures.push_back(texture_id);
+}
+
+void Server::retainTextures(SetMessage& mes)
+{
+    if (!mes.flags.retain_assets) {
+        // the sender no longer sends tiles for these textures
+        if (!m_textures.empty()) {
+            for (auto& tex : mes.scene->getAssets<Texture>())
+                m_textures.erase(tex->id);
+        }
+        return;
+    }
+
+    // textures are not modified by handlers. they are shared until tiles are applied.
+    for (auto& tex : mes.scene->getAssets<Texture>()) {
+        if (tex->id == InvalidID)
+            continue;
+        {
+            // resent. no need to report it anymore
+            lock_t lock(m_lost_textures_mutex);
+            m_lost_textures.erase(std::remove(m_lost_textures.begin(), m_lost_textures.end(), tex->id), m_lost_textures.end());
+        }
+        auto& rec = m_textures[tex->id];
+        rec.texture = tex;
+        rec.owned = false;
+        rec.last_used = ++m_texture_use_count;
+    }
+
+    size_t total = 0;
+    for (auto& kvp : m_textures)
+        total += kvp.second.texture->data.size();
+    while (total > MaxRetainedTextureSize && m_textures.size() > 1) {
+        auto lru = std::min_element(m_textures.begin(), m_textures.end(),
+            [](auto& a, auto& b) { return a.second.last_used < b.second.last_used; });
+        total -= lru->second.texture->data.size();
+        msLogWarning("Server::retainTextures(): texture %d is released. the sender will be asked to resend it\n", lru->first);
+        loseTexture(lru->first);
+        m_textures.erase(lru);
+    }
+}
+
+void Server::applyTextureTiles(TextureTilesMessage& mes)
+{
+    for (auto& tt : mes.textures) {
+        auto it = m_textures.find(tt.texture_id);
+        if (it == m_textures.end()) {
+            msLogError("Server::applyTextureTiles(): texture %d is not retained (not sent with SetFlags::retain_assets, or released). %d tiles are dropped\n",
+                tt.texture_id, (int)tt.tiles.size());
+            loseTexture(tt.texture_id);
+            continue;
+        }
+        if (!tt.isTarget(*it->second.texture)) {
+            auto& tex = *it->second.texture;
+            msLogError("Server::applyTextureTiles(): texture %d doesn't match the tiles (format %d %dx%d mips %d, tiles format %d %dx%d). %d tiles are dropped\n",
+                tt.texture_id, (int)tex.format, tex.width, tex.height, tex.mip_count, (int)tt.format, tt.width, tt.height, (int)tt.tiles.size());
+            loseTexture(tt.texture_id);
+            continue;
+        }
+
+        auto& rec = it->second;
+        if (!rec.owned) {
+            // the texture is shared with the SetMessage it came with (and the handler and SceneRecorder). copy on write.
+            auto& src = *rec.texture;
+            auto copy = Texture::create();
+            *copy = src;
+            copy->data.detach();
+            rec.texture = copy;
+            rec.owned = true;
+        }
+        rec.last_used = ++m_texture_use_count;
+        // patched in place from here on. the handler uses merged before the next message is processed.
+        if (tt.apply(*rec.texture))
+            tt.merged = rec.texture;
+    }
+}
+
+void Server::retainMaterials(SetMessage& mes)
+{
+    if (!mes.flags.retain_assets) {
+        // the sender no longer sends deltas for these materials
+        if (!m_materials.empty()) {
+            for (auto& mat : mes.scene->getAssets<Material>())
+                m_materials.erase(mat->id);
+        }
+        return;
+    }
+
+    // materials are not modified by handlers. they are shared until a delta is applied.
+    for (auto& mat : mes.scene->getAssets<Material>()) {
+        if (mat->id == InvalidID)
+            continue;
+        auto& rec = m_materials[mat->id];
+        rec.material = mat;
+        rec.owned = false;
+    }
+}
+
+void Server::releaseMaterials(const std::vector<Identifier>& materials)
+{
+    if (m_materials.empty())
+        return;
+
+    for (auto& identifier : materials) {
+        if (identifier.id != InvalidID) {
+            m_materials.erase(identifier.id);
+        }
+        else {
+            for (auto it = m_materials.begin(); it != m_materials.end(); ++it) {
+                if (it->second.material->name == identifier.name) {
+                    m_materials.erase(it);
+                    break;
+                }
+            }
+        }
+    }
+}
+
+void Server::applyMaterialDelta(MaterialDeltaMessage& mes)
+{
+    mes.merged.resize(mes.materials.size());
+    for (size_t i = 0; i < mes.materials.size(); ++i) {
+        auto& delta = *mes.materials[i];
+        auto it = m_materials.find(delta.id);
+        if (it == m_materials.end())
+            continue;
+
+        auto& rec = it->second;
+        if (!rec.owned) {
+            // the material is shared with the SetMessage it came with (and the handler and SceneRecorder). copy on write.
+            rec.material = rec.material->clone();
+            rec.owned = true;
+        }
+        // merged in place from here on. the handler uses merged before the next message is processed.
+        auto& base = *rec.material;
+        base.name = delta.name;
+        base.index = delta.index;
+        base.shader = delta.shader;
+        base.merge(delta);
+        mes.merged[i] = rec.material;
+    }
+}
+
 bool Server::loadMIMETypes(const std::string& path)
 {
     std::fstream fs(path, std::ios::in);
@@ -402,6 +737,43 @@ const std::string& Server::getFileRootPath() const
     return m_file_root_path;
 }
 
+Relay& Server::getRelay()
+{
+    return m_relay;
+}
+
+void Server::setRelayOnly(bool v)
+{
+    m_relay_only = v;
+}
+
+bool Server::isRelayOnly() const
+{
+    return m_relay_only;
+}
+
+LatencyStats& Server::getLatencyStats()
+{
+    return m_latency_stats;
+}
+
+#ifdef msEnableSceneCache
+bool Server::startRecording(const char *path, const SceneRecorderSettings& settings)
+{
+    return m_recorder.open(path, settings);
+}
+
+void Server::stopRecording()
+{
+    m_recorder.close();
+}
+
+bool Server::isRecording() const
+{
+    return m_recorder.valid();
+}
+#endif
+
 Scene* Server::getHostScene()
 {
     return m_host_scene.get();
@@ -451,13 +823,113 @@ void Server::queueTextMessage(const char *mes, TextMessage::Type type)
 }
 
 
+// passes the request body through and measures the time spent waiting for it.
+// messages are deserialized while the body is still arriving, so this separates transfer from deserialization.
+class WaitTimingStreamBuf : public std::streambuf
+{
+public:
+    WaitTimingStreamBuf(std::istream& src) : m_src(src) {}
+    nanosec getWaitTime() const { return m_wait_time; }
+
+protected:
+    int_type underflow() override
+    {
+        auto n = readSource(m_buf, sizeof(m_buf));
+        if (n <= 0)
+            return traits_type::eof();
+        setg(m_buf, m_buf, m_buf + n);
+        return traits_type::to_int_type(m_buf[0]);
+    }
+
+    std::streamsize xsgetn(char *dst, std::streamsize n) override
+    {
+        // large arrays are read directly without going through m_buf
+        std::streamsize ret = std::min<std::streamsize>(egptr() - gptr(), n);
+        std::memcpy(dst, gptr(), (size_t)ret);
+        gbump((int)ret);
+        if (ret < n) {
+            if (n - ret >= (std::streamsize)sizeof(m_buf))
+                ret += readSource(dst + ret, n - ret);
+            else
+                ret += std::streambuf::xsgetn(dst + ret, n - ret);
+        }
+        return ret;
+    }
+
+private:
+    std::streamsize readSource(char *dst, std::streamsize n)
+    {
+        auto begin = mu::Now();
+        m_src.read(dst, n);
+        m_wait_time += mu::Now() - begin;
+        return m_src.gcount();
+    }
+
+    std::istream& m_src;
+    nanosec m_wait_time = 0;
+    char m_buf[1024 * 64];
+};
+
+static void ReadBody(HTTPServerRequest& request, RawVector<char>& dst)
+{
+    auto& is = request.stream();
+    auto length = request.getContentLength();
+    if (length >= 0) {
+        dst.resize_discard((size_t)length);
+        is.read(dst.data(), length);
+        if (is.gcount() != length)
+            throw std::runtime_error("ReadBody(): unexpected end of stream");
+    }
+    else {
+        // chunked
+        const size_t chunk_size = 1024 * 64;
+        dst.clear();
+        while (is) {
+            size_t pos = dst.size();
+            dst.resize(pos + chunk_size);
+            is.read(dst.data() + pos, chunk_size);
+            dst.resize(pos + (size_t)is.gcount());
+        }
+    }
+}
+
 template<class MessageT>
-std::shared_ptr<MessageT> Server::deserializeMessage(HTTPServerRequest& request, HTTPServerResponse& response)
+std::shared_ptr<MessageT> Server::deserializeMessage(HTTPServerRequest& request, HTTPServerResponse& response, Message::Type relay_type)
 {
     try {
-        auto mes = std::make_shared<MessageT>();
-        mes->deserialize(request.stream());
+        MessageLatency latency;
+        latency.timestamp_request = mu::Now();
+        latency.serialize = std::atoll(request.get(msHeaderSerializeTime, "0").c_str());
+        if (request.has(msHeaderClockOffset)) {
+            latency.clock_synced = true;
+            latency.clock_offset = std::atoll(request.get(msHeaderClockOffset, "0").c_str());
+        }
+
+        std::shared_ptr<MessageT> mes;
+        if (relay_type != Message::Type::Unknown && m_relay.getNumConsumers() > 0) {
+            // keep the received bytes and hand them to the relay as they are
+            auto packet = std::make_shared<RelayPacket>();
+            packet->type = relay_type;
+            packet->uri = request.getURI();
+            ReadBody(request, packet->data);
+            latency.transfer_wait = mu::Now() - latency.timestamp_request;
+            m_relay.push(packet);
+            if (m_relay_only) {
+                // nothing to do locally. the message is not even deserialized
+                serveText(response, "ok");
+                return nullptr;
+            }
+            mes = std::static_pointer_cast<MessageT>(packet->deserialize());
+        }
+        else {
+            mes = std::make_shared<MessageT>();
+            WaitTimingStreamBuf buf(request.stream());
+            std::istream is(&buf);
+            mes->deserialize(is);
+            latency.transfer_wait = buf.getWaitTime();
+        }
         mes->timestamp_recv = mu::Now();
+        mes->latency = latency;
         return mes;
     }
     catch (const std::exception& e) {
@@ -475,12 +947,18 @@ void Server::sanitizeHierarchyPath(std::string& /*path*/)
 
 void Server::recvSet(HTTPServerRequest& request, HTTPServerResponse& response)
 {
-    auto mes = deserializeMessage<SetMessage>(request, response);
+    auto mes = deserializeMessage<SetMessage>(request, response, Message::Type::Set);
     if (!mes)
         return;
 
     auto task = std::async(std::launch::async, [this, mes]() {
         mes->scene->import(m_settings.import_settings);
+        if (mes->flags.retain_assets) {
+            // copy here because handlers modify clips (keyframe reduction etc.)
+            for (auto& clip : mes->scene->getAssets<AnimationClip>())
+                mes->retained_clips.push_back(clip->clone());
+        }
+        mes->latency.timestamp_imported = mu::Now();
     });
     queueMessage(mes, std::move(task));
     serveText(response, "ok");
@@ -488,19 +966,63 @@ void Server::recvSet(HTTPServerRequest& request, HTTPServerResponse& response)
 
 void Server::recvDelete(HTTPServerRequest& request, HTTPServerResponse& response)
 {
-    auto mes = deserializeMessage<DeleteMessage>(request, response);
+    auto mes = deserializeMessage<DeleteMessage>(request, response, Message::Type::Delete);
     if (!mes)
         return;
     queueMessage(mes);
     serveText(response, "ok");
 }
 
+void Server::recvAnimationDelta(HTTPServerRequest& request, HTTPServerResponse& response)
+{
+    auto mes = deserializeMessage<AnimationDeltaMessage>(request, response, Message::Type::AnimationDelta);
+    if (!mes)
+        return;
+
+    auto task = std::async(std::launch::async, [this, mes]() {
+        // same as Scene::import() but curves are not validated. they are fragments of clips.
+        auto converters = CreateEntityConverters(mes->scene_settings, m_settings.import_settings);
+        for (auto& delta : mes->deltas) {
+            for (auto& anim : delta.clip->animations) {
+                sanitizeHierarchyPath(anim->path);
+                for (auto& cv : converters)
+                    cv->convert(*anim);
+            }
+        }
+        mes->latency.timestamp_imported = mu::Now();
+    });
+    queueMessage(mes, std::move(task));
+    serveText(response, "ok");
+}
+
+void Server::recvTextureTiles(HTTPServerRequest& request, HTTPServerResponse& response)
+{
+    auto mes = deserializeMessage<TextureTilesMessage>(request, response, Message::Type::TextureTiles);
+    if (!mes)
+        return;
+
+    queueMessage(mes);
+    serveLostTextures(response);
+    serveText(response, "ok");
+}
+
+void Server::recvMaterialDelta(HTTPServerRequest& request, HTTPServerResponse& response)
+{
+    auto mes = deserializeMessage<MaterialDeltaMessage>(request, response, Message::Type::MaterialDelta);
+    if (!mes)
+        return;
+
+    queueMessage(mes);
+    serveText(response, "ok");
+}
+
 void Server::recvFence(HTTPServerRequest& request, HTTPServerResponse& response)
 {
-    auto mes = deserializeMessage<FenceMessage>(request, response);
+    auto mes = deserializeMessage<FenceMessage>(request, response, Message::Type::Fence);
     if (!mes)
         return;
     queueMessage(mes);
+    serveLostTextures(response);
     serveText(response, "ok");
 }
 
@@ -556,6 +1078,11 @@ void Server::recvQuery(HTTPServerRequest& request, HTTPServerResponse& response)
     else if (mes->query_type == QueryMessage::QueryType::ProtocolVersion) {
         mes->response->text.push_back(std::to_string(msProtocolVersion));
     }
+    else if (mes->query_type == QueryMessage::QueryType::Raycast ||
+             mes->query_type == QueryMessage::QueryType::ClosestPoint) {
+        // answered from the raycast scene. no need to wait for the host
+        answerRaycast(*mes);
+    }
     else {
         queueMessage(mes);
 
@@ -583,6 +1110,26 @@ void Server::recvQuery(HTTPServerRequest& request, HTTPServerResponse& response)
     }
 }
 
+void Server::answerRaycast(QueryMessage& mes)
+{
+    auto& hits = mes.response->hits;
+    size_t num = mes.positions.size();
+    hits.resize_discard(num);
+
+    lock_t lock(m_raycast_mutex);
+    if (mes.query_type == QueryMessage::QueryType::Raycast) {
+        if (mes.directions.size() != num) {
+            msLogError("Server::answerRaycast(): number of positions and directions don't match\n");
+            hits.clear();
+            return;
+        }
+        m_raycast_scene.raycast(mes.positions.cdata(), mes.directions.cdata(), num, mes.max_distance, hits.data());
+    }
+    else {
+        m_raycast_scene.closestPoint(mes.positions.cdata(), num, mes.max_distance, hits.data());
+    }
+}
+
 void Server::recvText(HTTPServerRequest& request, HTTPServerResponse& response)
 {
     bool respond_form = false;
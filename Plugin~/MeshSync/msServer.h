@@ -5,6 +5,9 @@
 #include <mutex>
 #include <future>
 #include "msProtocol.h"
+#include "msRelay.h"
+#include "Utils/msSceneRecorder.h"
+#include "Utils/msLatencyStats.h"
 
 #ifdef msEnableNetwork
 namespace Poco {
@@ -42,6 +45,7 @@ public:
     int processMessages(const MessageHandler& handler);
 
     void serveText(Poco::Net::HTTPServerResponse &response, const char* text, int stat = 200);
+    void serveLostTextures(Poco::Net::HTTPServerResponse &response);
     void serveBinary(Poco::Net::HTTPServerResponse &response, const void *data, size_t size, int stat = 200);
     void serveFiles(Poco::Net::HTTPServerResponse &response, const std::string& uri);
 
@@ -57,6 +61,24 @@ public:
 
     void notifyPoll(PollMessage::PollType t);
 
+    // received Set, Delete, Fence, AnimationDelta, TextureTiles and MaterialDelta messages are fanned out to
+    // the relay's consumers in their serialized form. messages are relayed only while the relay has consumers.
+    Relay& getRelay();
+    // if true, relayed messages are not queued for processMessages(). for servers that only fan out.
+    void setRelayOnly(bool v);
+    bool isRelayOnly() const;
+
+    // latencies of messages handled by processMessages(), per stage.
+    // stages on the sender are measured only if it is an ms::Client (it reports them in HTTP headers).
+    LatencyStats& getLatencyStats();
+
+#ifdef msEnableSceneCache
+    // record received scenes into a scene cache file. see SceneRecorder.
+    bool startRecording(const char *path, const SceneRecorderSettings& settings = SceneRecorderSettings());
+    void stopRecording();
+    bool isRecording() const;
+#endif
+
 public:
     struct MessageHolder
     {
@@ -72,6 +94,9 @@ public:
     void queueTextMessage(const char *mes, TextMessage::Type type);
     void recvSet(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response);
     void recvDelete(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response);
+    void recvAnimationDelta(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response);
+    void recvTextureTiles(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response);
+    void recvMaterialDelta(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response);
     void recvFence(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response);
     void recvGet(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response);
     void recvQuery(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response);
@@ -82,12 +107,25 @@ public:
     static void sanitizeHierarchyPath(std::string& path);
 
 private:
+    // relay_type: type of the message to relay. Unknown if the message is not relayed
     template<class MessageT>
-    std::shared_ptr<MessageT> deserializeMessage(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response);
+    std::shared_ptr<MessageT> deserializeMessage(Poco::Net::HTTPServerRequest& request, Poco::Net::HTTPServerResponse& response,
+        Message::Type relay_type = Message::Type::Unknown);
 
     MessageHolder* queueMessage(MessagePtr mes);
     MessageHolder* queueMessage(MessagePtr mes, std::future<void>&& task);
 
+    void retainAnimationClips(SetMessage& mes);
+    void applyAnimationDelta(AnimationDeltaMessage& mes);
+    void retainTextures(SetMessage& mes);
+    void loseTexture(int texture_id);
+    void applyTextureTiles(TextureTilesMessage& mes);
+    void retainMaterials(SetMessage& mes);
+    void releaseMaterials(const std::vector<Identifier>& materials);
+    void applyMaterialDelta(MaterialDeltaMessage& mes);
+    void cullServedMeshes(const GetMessage& request);
+    void answerRaycast(QueryMessage& mes);
+
     bool loadMIMETypes(const std::string& path);
     const std::string& getMIMEType(const std::string& filename);
 
@@ -102,11 +140,41 @@ private:
     std::map<std::string, std::string> m_mimetypes;
     std::mutex m_message_mutex;
     std::mutex m_poll_mutex;
+    std::mutex m_raycast_mutex;
 
     int m_current_scene_session = InvalidID;
     std::list<MessageHolder> m_received_messages, m_processing_messages;
     std::vector<SetMessagePtr> m_scene_cache;
+    std::vector<AnimationClipPtr> m_animation_clips; // base of AnimationDeltaMessage. only clips sent with SetFlags::retain_assets
+    // base of TextureTilesMessage. only textures sent with SetFlags::retain_assets.
+    // shared with the SetMessage until tiles are applied (copy on write).
+    struct RetainedTexture
+    {
+        TexturePtr texture;
+        bool owned = false;
+        uint64_t last_used = 0;
+    };
+    std::map<int, RetainedTexture> m_textures;
+    uint64_t m_texture_use_count = 0;
+    // textures tiles could not be applied to, or evicted ones. reported to the sender (msHeaderLostTextures) to make it resend them
+    std::vector<int> m_lost_textures;
+    std::mutex m_lost_textures_mutex;
+    // base of MaterialDeltaMessage. only materials sent with SetFlags::retain_assets.
+    // shared with the SetMessage until a delta is applied (copy on write).
+    struct RetainedMaterial
+    {
+        MaterialPtr material;
+        bool owned = false;
+    };
+    std::map<int, RetainedMaterial> m_materials;
     PollMessages m_polls;
+    RaycastScene m_raycast_scene;
+    Relay m_relay;
+    bool m_relay_only = false;
+    LatencyStats m_latency_stats;
+#ifdef msEnableSceneCache
+    SceneRecorder m_recorder;
+#endif
 
     ScenePtr m_host_scene;
     GetMessagePtr m_current_get_request;
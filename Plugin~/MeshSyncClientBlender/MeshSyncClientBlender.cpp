@@ -145,6 +145,15 @@ PYBIND11_MODULE(MeshSyncClientBlender, m)
             BindProperty(multithreaded,
                 [](const self_t& self) { return self->getSettings().multithreaded; },
                 [](self_t& self, int v) { self->getSettings().multithreaded = v; })
+            BindProperty(material_deltas,
+                [](const self_t& self) { return self->getSettings().material_deltas; },
+                [](self_t& self, bool v) { self->getSettings().material_deltas = v; })
+            BindProperty(adaptive_precision,
+                [](const self_t& self) { return self->getSettings().adaptive_precision; },
+                [](self_t& self, bool v) { self->getSettings().adaptive_precision = v; })
+            BindProperty(latency_target_ms,
+                [](const self_t& self) { return self->getSettings().latency_target_ms; },
+                [](self_t& self, int v) { self->getSettings().latency_target_ms = v; })
 
             BindMethod(flushPendingList, [](self_t& self) { self->flushPendingList(); })
             BindMethod(setup, [](self_t& self, py::object ctx) { bl::setup(ctx); })
@@ -1316,6 +1316,7 @@ bool msblenContext::sendMaterials(bool dirty_all)
 
     m_settings.validate();
     m_material_manager.setAlwaysMarkDirty(dirty_all);
+    m_material_manager.setUseDeltas(m_settings.material_deltas);
     m_texture_manager.setAlwaysMarkDirty(dirty_all);
     exportMaterials();
 
@@ -1332,6 +1333,7 @@ bool msblenContext::sendObjects(ObjectScope scope, bool dirty_all)
     m_settings.validate();
     m_entity_manager.setAlwaysMarkDirty(dirty_all);
     m_material_manager.setAlwaysMarkDirty(dirty_all);
+    m_material_manager.setUseDeltas(m_settings.material_deltas);
     m_texture_manager.setAlwaysMarkDirty(false); // false because too heavy
 
     if (m_settings.sync_meshes)
@@ -1450,6 +1452,7 @@ bool msblenContext::exportCache(const CacheSettings& cache_settings)
     }
 
     m_material_manager.setAlwaysMarkDirty(true);
+    m_material_manager.setUseDeltas(false); // scene caches have no bases to apply deltas to
     m_entity_manager.setAlwaysMarkDirty(true);
 
     int scene_index = 0;
@@ -1561,6 +1564,10 @@ void msblenContext::kickAsyncExport()
     exporter->on_prepare = [this, exporter]() {
         if (auto sender = dynamic_cast<ms::AsyncSceneSender*>(exporter)) {
             sender->client_settings = m_settings.client_settings;
+            sender->use_deltas = m_settings.material_deltas;
+            sender->adaptive_precision = m_settings.adaptive_precision;
+            sender->latency_target_ms = m_settings.latency_target_ms;
+            sender->material_deltas = m_material_manager.getMaterialDeltas();
         }
         else if (auto writer = dynamic_cast<ms::AsyncSceneCacheWriter*>(exporter)) {
             writer->time = m_anim_time;
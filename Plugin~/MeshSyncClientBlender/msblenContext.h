@@ -62,6 +62,11 @@ struct SyncSettings
     int frame_step = 1;
 
     bool multithreaded = true;
+    // send only the changed properties of materials (see MaterialManager::setUseDeltas())
+    bool material_deltas = false;
+    // send meshes with reduced precision while editing (see AsyncSceneSender::adaptive_precision)
+    bool adaptive_precision = false;
+    int latency_target_ms = 100;
 
     // cache
     bool export_cache = false;
@@ -50,6 +50,11 @@ class MESHSYNC_PT_Scene(MESHSYNC_PT, bpy.types.Panel):
         #layout.prop(scene, "meshsync_sync_textures")
         layout.prop(scene, "meshsync_sync_cameras")
         layout.prop(scene, "meshsync_sync_lights")
+        layout.prop(scene, "meshsync_material_deltas")
+        layout.prop(scene, "meshsync_adaptive_precision")
+        if scene.meshsync_adaptive_precision:
+            b = layout.box()
+            b.prop(scene, "meshsync_latency_target_ms")
         layout.separator()
         if scene.meshsync_auto_sync:
             layout.operator("meshsync.auto_sync", text="Auto Sync", icon="PAUSE")
@@ -23,6 +23,9 @@ def msb_apply_scene_settings(self = None, context = None):
     ctx.sync_textures = scene.meshsync_sync_textures
     ctx.sync_cameras = scene.meshsync_sync_cameras
     ctx.sync_lights = scene.meshsync_sync_lights
+    ctx.material_deltas = scene.meshsync_material_deltas
+    ctx.adaptive_precision = scene.meshsync_adaptive_precision
+    ctx.latency_target_ms = scene.meshsync_latency_target_ms
     return None
 
 def msb_apply_animation_settings(self = None, context = None):
@@ -81,6 +84,9 @@ def msb_initialize_properties():
     bpy.types.Scene.meshsync_sync_textures = bpy.props.BoolProperty(name = "Sync Textures", default = True, update = msb_on_scene_settings_updated)
     bpy.types.Scene.meshsync_sync_cameras = bpy.props.BoolProperty(name = "Sync Cameras", default = True, update = msb_on_scene_settings_updated)
     bpy.types.Scene.meshsync_sync_lights = bpy.props.BoolProperty(name = "Sync Lights", default = True, update = msb_on_scene_settings_updated)
+    bpy.types.Scene.meshsync_material_deltas = bpy.props.BoolProperty(name = "Send Material Deltas", default = False, update = msb_on_scene_settings_updated)
+    bpy.types.Scene.meshsync_adaptive_precision = bpy.props.BoolProperty(name = "Adaptive Precision", default = False, update = msb_on_scene_settings_updated)
+    bpy.types.Scene.meshsync_latency_target_ms = bpy.props.IntProperty(name = "Latency Target (ms)", default = 100, min = 1, update = msb_on_scene_settings_updated)
     bpy.types.Scene.meshsync_auto_sync = bpy.props.BoolProperty(name = "Auto Sync", default = False, update = msb_on_toggle_auto_sync)
     bpy.types.Scene.meshsync_frame_step = bpy.props.IntProperty(name = "Frame Step", default = 1, min = 1, update = msb_on_animation_settings_updated)
 
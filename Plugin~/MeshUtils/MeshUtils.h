@@ -4,6 +4,7 @@
 #include <memory>
 #include "muRawVector.h"
 #include "muIntrusiveArray.h"
+#include "muFlatHashMap.h"
 #include "muHalf.h"
 #include "muMath.h"
 #include "muQuat32.h"
@@ -16,6 +17,9 @@
 #include "muMisc.h"
 #include "muConcurrency.h"
 #include "muCompression.h"
+#include "muBlockCompression.h"
+#include "muBVH.h"
+#include "muTexture.h"
 #include "muStream.h"
 #include "muDebugTimer.h"
 
@@ -0,0 +1,188 @@
+#include "pch.h"
+#include "muBVH.h"
+#include "muSIMD.h"
+#include <algorithm>
+
+namespace mu {
+
+void BVH::build(const float3 *bmin, const float3 *bmax, size_t num_primitives, int leaf_size)
+{
+    clear();
+    if (num_primitives == 0)
+        return;
+    leaf_size = std::max(leaf_size, 1);
+
+    int n = (int)num_primitives;
+    RawVector<float3> centers(n);
+    m_order.resize(n);
+    for (int i = 0; i < n; ++i) {
+        centers[i] = (bmin[i] + bmax[i]) * 0.5f;
+        m_order[i] = i;
+    }
+    m_nodes.reserve(std::max(n / leaf_size, 1) * 2);
+
+    struct Task { int node, begin, end; };
+    std::vector<Task> tasks;
+    m_nodes.push_back({});
+    tasks.push_back({ 0, 0, n });
+    while (!tasks.empty()) {
+        auto task = tasks.back();
+        tasks.pop_back();
+
+        float3 nmin = bmin[m_order[task.begin]], nmax = bmax[m_order[task.begin]];
+        float3 cmin = centers[m_order[task.begin]], cmax = cmin;
+        for (int i = task.begin + 1; i < task.end; ++i) {
+            int pi = m_order[i];
+            nmin = min(nmin, bmin[pi]);
+            nmax = max(nmax, bmax[pi]);
+            cmin = min(cmin, centers[pi]);
+            cmax = max(cmax, centers[pi]);
+        }
+        // m_nodes can be reallocated below. don't keep a reference
+        m_nodes[task.node].bmin = nmin;
+        m_nodes[task.node].bmax = nmax;
+
+        int count = task.end - task.begin;
+        float3 extent = cmax - cmin;
+        if (count <= leaf_size || (extent.x == 0.0f && extent.y == 0.0f && extent.z == 0.0f)) {
+            m_nodes[task.node].first = task.begin;
+            m_nodes[task.node].count = count;
+            continue;
+        }
+
+        int axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        int mid = task.begin + count / 2;
+        std::nth_element(m_order.begin() + task.begin, m_order.begin() + mid, m_order.begin() + task.end,
+            [&](int a, int b) { return centers[a][axis] < centers[b][axis]; });
+
+        int left = (int)m_nodes.size();
+        m_nodes[task.node].first = left;
+        m_nodes[task.node].count = 0;
+        m_nodes.push_back({});
+        m_nodes.push_back({});
+        tasks.push_back({ left, task.begin, mid });
+        tasks.push_back({ left + 1, mid, task.end });
+    }
+}
+
+void BVH::clear()
+{
+    m_nodes.clear();
+    m_order.clear();
+}
+
+
+static float3 ClosestPointOnTriangle(float3 p, float3 a, float3 b, float3 c)
+{
+    // Ericson, Real-Time Collision Detection 5.1.5
+    float3 ab = b - a, ac = c - a, ap = p - a;
+    float d1 = dot(ab, ap), d2 = dot(ac, ap);
+    if (d1 <= 0.0f && d2 <= 0.0f)
+        return a;
+
+    float3 bp = p - b;
+    float d3 = dot(ab, bp), d4 = dot(ac, bp);
+    if (d3 >= 0.0f && d4 <= d3)
+        return b;
+
+    float vc = d1 * d4 - d3 * d2;
+    if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+        return a + ab * (d1 / (d1 - d3));
+
+    float3 cp = p - c;
+    float d5 = dot(ab, cp), d6 = dot(ac, cp);
+    if (d6 >= 0.0f && d5 <= d6)
+        return c;
+
+    float vb = d5 * d2 - d1 * d6;
+    if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+        return a + ac * (d2 / (d2 - d6));
+
+    float va = d3 * d6 - d5 * d4;
+    if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+        return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+
+    float denom = 1.0f / (va + vb + vc);
+    return a + ab * (vb * denom) + ac * (vc * denom);
+}
+
+void TriangleBVH::build(const float3 *vertices, const int *indices, size_t num_triangles, const int *face_indices)
+{
+    clear();
+    if (num_triangles == 0)
+        return;
+
+    RawVector<float3> bmin(num_triangles), bmax(num_triangles);
+    for (size_t ti = 0; ti < num_triangles; ++ti) {
+        auto& p0 = vertices[indices[ti * 3 + 0]];
+        auto& p1 = vertices[indices[ti * 3 + 1]];
+        auto& p2 = vertices[indices[ti * 3 + 2]];
+        bmin[ti] = min(min(p0, p1), p2);
+        bmax[ti] = max(max(p0, p1), p2);
+    }
+    m_bvh.build(bmin.cdata(), bmax.cdata(), num_triangles, 8);
+
+    // flatten triangles in leaf order so that each leaf is a contiguous range
+    auto& order = m_bvh.getOrder();
+    m_vertices.resize_discard(num_triangles * 3);
+    m_faces.resize_discard(num_triangles);
+    for (size_t i = 0; i < num_triangles; ++i) {
+        int ti = order[i];
+        for (int c = 0; c < 3; ++c)
+            m_vertices[i * 3 + c] = vertices[indices[ti * 3 + c]];
+        m_faces[i] = face_indices ? face_indices[ti] : ti;
+    }
+}
+
+void TriangleBVH::clear()
+{
+    m_bvh.clear();
+    m_vertices.clear();
+    m_faces.clear();
+}
+
+float3 TriangleBVH::getBoundsMin() const
+{
+    return empty() ? float3::zero() : m_bvh.getNodes()[0].bmin;
+}
+
+float3 TriangleBVH::getBoundsMax() const
+{
+    return empty() ? float3::zero() : m_bvh.getNodes()[0].bmax;
+}
+
+bool TriangleBVH::raycast(float3 pos, float3 dir, float max_distance, float& distance, int& face) const
+{
+    bool ret = false;
+    m_bvh.raycast(pos, dir, max_distance, [&](int first, int count, float& max_d) {
+        int ti;
+        float d;
+        if (RayTrianglesIntersectionFlattened(pos, dir, m_vertices.cdata() + first * 3, count, ti, d) > 0 && d <= max_d) {
+            max_d = distance = d;
+            face = m_faces[first + ti];
+            ret = true;
+        }
+    });
+    return ret;
+}
+
+bool TriangleBVH::closestPoint(float3 pos, float max_distance, float3& point, float& distance, int& face) const
+{
+    bool ret = false;
+    m_bvh.nearest(pos, max_distance, [&](int first, int count, float& max_d) {
+        for (int i = first; i < first + count; ++i) {
+            auto *v = &m_vertices[i * 3];
+            float3 cp = ClosestPointOnTriangle(pos, v[0], v[1], v[2]);
+            float d = length(cp - pos);
+            if (d <= max_d) {
+                max_d = distance = d;
+                point = cp;
+                face = m_faces[i];
+                ret = true;
+            }
+        }
+    });
+    return ret;
+}
+
+} // namespace mu
@@ -0,0 +1,170 @@
+#pragma once
+
+#include <vector>
+#include "muMath.h"
+#include "muRawVector.h"
+
+namespace mu {
+
+// bounding volume hierarchy over primitives given as boxes.
+// built top-down by splitting at the median of centroids along the longest axis.
+class BVH
+{
+public:
+    struct Node
+    {
+        float3 bmin;
+        int first;  // leaf: first element of getOrder(). inner: index of the left child. the right child is first + 1
+        float3 bmax;
+        int count;  // leaf: number of primitives. 0 if inner
+    };
+
+    void build(const float3 *bmin, const float3 *bmax, size_t num_primitives, int leaf_size);
+    void clear();
+    bool empty() const { return m_nodes.empty(); }
+
+    const std::vector<Node>& getNodes() const { return m_nodes; }
+    // primitive indices in leaf order
+    const std::vector<int>& getOrder() const { return m_order; }
+
+    // visits leaves the ray passes through, nearer ones first.
+    // leaf: [](int first, int count, float& max_distance) -> void. can shrink max_distance to skip farther nodes.
+    template<class Leaf> void raycast(float3 pos, float3 dir, float max_distance, const Leaf& leaf) const;
+    // visits leaves within max_distance of pos, nearer ones first. leaf is the same as raycast().
+    template<class Leaf> void nearest(float3 pos, float max_distance, const Leaf& leaf) const;
+
+private:
+    std::vector<Node> m_nodes;
+    std::vector<int> m_order;
+};
+
+// BVH over triangles. triangles are copied, so the source buffers don't need to be kept.
+// leaf tests use RayTrianglesIntersectionFlattened().
+class TriangleBVH
+{
+public:
+    // face_indices: face index of each triangle. can be null, then triangle indices are reported as faces.
+    void build(const float3 *vertices, const int *indices, size_t num_triangles, const int *face_indices = nullptr);
+    void clear();
+    bool empty() const { return m_bvh.empty(); }
+    float3 getBoundsMin() const;
+    float3 getBoundsMax() const;
+
+    // distance is in units of dir's length
+    bool raycast(float3 pos, float3 dir, float max_distance, float& distance, int& face) const;
+    bool closestPoint(float3 pos, float max_distance, float3& point, float& distance, int& face) const;
+
+private:
+    BVH m_bvh;
+    RawVector<float3> m_vertices; // 3 vertices per triangle in leaf order
+    RawVector<int> m_faces;       // in leaf order
+};
+
+
+// ------------------------------------------------------------
+// impl
+// ------------------------------------------------------------
+
+namespace detail {
+
+inline bool RayBox(float3 pos, float3 rcp_dir, float3 bmin, float3 bmax, float max_distance, float& distance)
+{
+    float3 t0 = (bmin - pos) * rcp_dir;
+    float3 t1 = (bmax - pos) * rcp_dir;
+    float3 tmin = min(t0, t1);
+    float3 tmax = max(t0, t1);
+    float tn = std::max(std::max(tmin.x, tmin.y), std::max(tmin.z, 0.0f));
+    float tf = std::min(std::min(tmax.x, tmax.y), std::min(tmax.z, max_distance));
+    distance = tn;
+    return tn <= tf;
+}
+
+inline float PointBoxDistanceSq(float3 pos, float3 bmin, float3 bmax)
+{
+    float3 d = max(max(bmin - pos, pos - bmax), float3::zero());
+    return dot(d, d);
+}
+
+} // namespace detail
+
+template<class Leaf>
+inline void BVH::raycast(float3 pos, float3 dir, float max_distance, const Leaf& leaf) const
+{
+    if (m_nodes.empty())
+        return;
+
+    float3 rcp_dir{ 1.0f / dir.x, 1.0f / dir.y, 1.0f / dir.z };
+    struct Entry { int node; float distance; };
+    Entry stack[64];
+    int sp = 0;
+
+    float d;
+    if (!detail::RayBox(pos, rcp_dir, m_nodes[0].bmin, m_nodes[0].bmax, max_distance, d))
+        return;
+    stack[sp++] = { 0, d };
+    while (sp > 0) {
+        auto e = stack[--sp];
+        if (e.distance > max_distance)
+            continue;
+        auto& node = m_nodes[e.node];
+        if (node.count > 0) {
+            leaf(node.first, node.count, max_distance);
+            continue;
+        }
+
+        float d0, d1;
+        auto& c0 = m_nodes[node.first];
+        auto& c1 = m_nodes[node.first + 1];
+        bool h0 = detail::RayBox(pos, rcp_dir, c0.bmin, c0.bmax, max_distance, d0);
+        bool h1 = detail::RayBox(pos, rcp_dir, c1.bmin, c1.bmax, max_distance, d1);
+        // push the farther one first
+        if (h0 && h1 && d0 < d1) {
+            stack[sp++] = { node.first + 1, d1 };
+            stack[sp++] = { node.first, d0 };
+        }
+        else {
+            if (h0)
+                stack[sp++] = { node.first, d0 };
+            if (h1)
+                stack[sp++] = { node.first + 1, d1 };
+        }
+    }
+}
+
+template<class Leaf>
+inline void BVH::nearest(float3 pos, float max_distance, const Leaf& leaf) const
+{
+    if (m_nodes.empty())
+        return;
+
+    struct Entry { int node; float distance_sq; };
+    Entry stack[64];
+    int sp = 0;
+
+    stack[sp++] = { 0, detail::PointBoxDistanceSq(pos, m_nodes[0].bmin, m_nodes[0].bmax) };
+    while (sp > 0) {
+        auto e = stack[--sp];
+        if (e.distance_sq > max_distance * max_distance)
+            continue;
+        auto& node = m_nodes[e.node];
+        if (node.count > 0) {
+            leaf(node.first, node.count, max_distance);
+            continue;
+        }
+
+        auto& c0 = m_nodes[node.first];
+        auto& c1 = m_nodes[node.first + 1];
+        float d0 = detail::PointBoxDistanceSq(pos, c0.bmin, c0.bmax);
+        float d1 = detail::PointBoxDistanceSq(pos, c1.bmin, c1.bmax);
+        if (d0 < d1) {
+            stack[sp++] = { node.first + 1, d1 };
+            stack[sp++] = { node.first, d0 };
+        }
+        else {
+            stack[sp++] = { node.first, d0 };
+            stack[sp++] = { node.first + 1, d1 };
+        }
+    }
+}
+
+} // namespace mu
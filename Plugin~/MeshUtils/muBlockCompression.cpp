@@ -0,0 +1,688 @@
+#include "pch.h"
+#include "muBlockCompression.h"
+#include "muMath.h"
+#include "muConcurrency.h"
+#include <climits>
+#include <cmath>
+
+namespace mu {
+
+namespace {
+
+struct Block
+{
+    uint8_t px[16][4];
+};
+
+inline float Clamp255f(float v) { return v < 0.0f ? 0.0f : (v > 255.0f ? 255.0f : v); }
+inline int Sq(int v) { return v * v; }
+
+void FetchBlock(Block& dst, const uint8_t *src, int width, int height, int bx, int by)
+{
+    for (int y = 0; y < 4; ++y) {
+        int sy = std::min(by * 4 + y, height - 1);
+        for (int x = 0; x < 4; ++x) {
+            int sx = std::min(bx * 4 + x, width - 1);
+            std::memcpy(dst.px[y * 4 + x], src + ((size_t)sy * width + sx) * 4, 4);
+        }
+    }
+}
+
+void StoreBlock(uint8_t *dst, const Block& src, int width, int height, int bx, int by)
+{
+    for (int y = 0; y < 4; ++y) {
+        int dy = by * 4 + y;
+        if (dy >= height)
+            break;
+        for (int x = 0; x < 4; ++x) {
+            int dx = bx * 4 + x;
+            if (dx >= width)
+                break;
+            std::memcpy(dst + ((size_t)dy * width + dx) * 4, src.px[y * 4 + x], 4);
+        }
+    }
+}
+
+
+// endpoints of N channels (N: 3 or 4).
+// e0 / e1 receive both ends of the line that fits the pixels.
+template<int N>
+void FitEndpoints(const uint8_t (*px)[4], const int *indices, int num, BCQuality quality, float inset, float *e0, float *e1)
+{
+    float mean[N] = {}, lo[N], hi[N];
+    for (int c = 0; c < N; ++c) {
+        lo[c] = 255.0f;
+        hi[c] = 0.0f;
+    }
+    for (int i = 0; i < num; ++i) {
+        auto *p = px[indices[i]];
+        for (int c = 0; c < N; ++c) {
+            float v = (float)p[c];
+            mean[c] += v;
+            lo[c] = std::min(lo[c], v);
+            hi[c] = std::max(hi[c], v);
+        }
+    }
+    for (int c = 0; c < N; ++c)
+        mean[c] /= (float)num;
+
+    if (quality == BCQuality::Fast) {
+        for (int c = 0; c < N; ++c) {
+            float d = (hi[c] - lo[c]) * inset;
+            e0[c] = hi[c] - d;
+            e1[c] = lo[c] + d;
+        }
+        return;
+    }
+
+    // principal axis by power iteration on the covariance matrix
+    float cov[N][N] = {};
+    for (int i = 0; i < num; ++i) {
+        auto *p = px[indices[i]];
+        float d[N];
+        for (int c = 0; c < N; ++c)
+            d[c] = (float)p[c] - mean[c];
+        for (int r = 0; r < N; ++r)
+            for (int c = 0; c < N; ++c)
+                cov[r][c] += d[r] * d[c];
+    }
+
+    float axis[N];
+    for (int c = 0; c < N; ++c)
+        axis[c] = hi[c] - lo[c];
+    for (int iter = 0; iter < 8; ++iter) {
+        float tmp[N] = {};
+        for (int r = 0; r < N; ++r)
+            for (int c = 0; c < N; ++c)
+                tmp[r] += cov[r][c] * axis[c];
+        float len = 0.0f;
+        for (int c = 0; c < N; ++c)
+            len = std::max(len, std::abs(tmp[c]));
+        if (len == 0.0f)
+            break;
+        for (int c = 0; c < N; ++c)
+            axis[c] = tmp[c] / len;
+    }
+    float len2 = 0.0f;
+    for (int c = 0; c < N; ++c)
+        len2 += axis[c] * axis[c];
+    if (len2 == 0.0f) {
+        // all pixels are identical
+        for (int c = 0; c < N; ++c)
+            e0[c] = e1[c] = mean[c];
+        return;
+    }
+    float rlen = 1.0f / std::sqrt(len2);
+    for (int c = 0; c < N; ++c)
+        axis[c] *= rlen;
+
+    float tmin = FLT_MAX, tmax = -FLT_MAX;
+    for (int i = 0; i < num; ++i) {
+        auto *p = px[indices[i]];
+        float t = 0.0f;
+        for (int c = 0; c < N; ++c)
+            t += ((float)p[c] - mean[c]) * axis[c];
+        tmin = std::min(tmin, t);
+        tmax = std::max(tmax, t);
+    }
+    float d = (tmax - tmin) * inset;
+    tmin += d;
+    tmax -= d;
+    for (int c = 0; c < N; ++c) {
+        e0[c] = Clamp255f(mean[c] + axis[c] * tmax);
+        e1[c] = Clamp255f(mean[c] + axis[c] * tmin);
+    }
+}
+
+// least squares fit of endpoints to the pixels, given palette weights of each pixel.
+// returns false if the system is degenerate (e.g. all pixels use the same index)
+template<int N>
+bool RefineEndpoints(const uint8_t (*px)[4], const int *indices, const float *weights, int num, float *e0, float *e1)
+{
+    float a = 0.0f, b = 0.0f, c = 0.0f;
+    float x0[N] = {}, x1[N] = {};
+    for (int i = 0; i < num; ++i) {
+        auto *p = px[indices[i]];
+        float w1 = weights[i], w0 = 1.0f - w1;
+        a += w0 * w0;
+        b += w0 * w1;
+        c += w1 * w1;
+        for (int ch = 0; ch < N; ++ch) {
+            x0[ch] += w0 * (float)p[ch];
+            x1[ch] += w1 * (float)p[ch];
+        }
+    }
+    float det = a * c - b * b;
+    if (std::abs(det) < 1e-6f)
+        return false;
+
+    float rdet = 1.0f / det;
+    for (int ch = 0; ch < N; ++ch) {
+        e0[ch] = Clamp255f((c * x0[ch] - b * x1[ch]) * rdet);
+        e1[ch] = Clamp255f((a * x1[ch] - b * x0[ch]) * rdet);
+    }
+    return true;
+}
+
+
+// BC1 color block
+
+inline uint16_t To565(const float *c)
+{
+    int r = (int)(c[0] * (31.0f / 255.0f) + 0.5f);
+    int g = (int)(c[1] * (63.0f / 255.0f) + 0.5f);
+    int b = (int)(c[2] * (31.0f / 255.0f) + 0.5f);
+    return (uint16_t)((r << 11) | (g << 5) | b);
+}
+
+inline void From565(uint16_t v, int *dst)
+{
+    int r = (v >> 11) & 31, g = (v >> 5) & 63, b = v & 31;
+    dst[0] = (r << 3) | (r >> 2);
+    dst[1] = (g << 2) | (g >> 4);
+    dst[2] = (b << 3) | (b >> 2);
+}
+
+void BC1Palette(uint16_t c0, uint16_t c1, bool four_colors, int (*palette)[4])
+{
+    From565(c0, palette[0]);
+    From565(c1, palette[1]);
+    palette[0][3] = palette[1][3] = 255;
+    if (four_colors) {
+        for (int c = 0; c < 3; ++c) {
+            palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+            palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+        }
+        palette[2][3] = palette[3][3] = 255;
+    }
+    else {
+        for (int c = 0; c < 3; ++c) {
+            palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+            palette[3][c] = 0;
+        }
+        palette[2][3] = 255;
+        palette[3][3] = 0;
+    }
+}
+
+// assigns the nearest palette entry to the opaque pixels. returns total error
+int BC1Indices(const Block& b, const int *opaque, int num_opaque, const int (*palette)[4], int num_colors, int *dst)
+{
+    int total = 0;
+    for (int i = 0; i < num_opaque; ++i) {
+        auto *p = b.px[opaque[i]];
+        int best = 0, best_err = INT_MAX;
+        for (int pi = 0; pi < num_colors; ++pi) {
+            int err = Sq(p[0] - palette[pi][0]) + Sq(p[1] - palette[pi][1]) + Sq(p[2] - palette[pi][2]);
+            if (err < best_err) {
+                best_err = err;
+                best = pi;
+            }
+        }
+        dst[i] = best;
+        total += best_err;
+    }
+    return total;
+}
+
+// allow_alpha: pixels with alpha < 128 become transparent (3 color mode). must be false for BC3 color blocks
+void EncodeBC1Block(const Block& b, BCQuality quality, bool allow_alpha, uint8_t *dst)
+{
+    int opaque[16], num_opaque = 0;
+    for (int i = 0; i < 16; ++i) {
+        if (!allow_alpha || b.px[i][3] >= 128)
+            opaque[num_opaque++] = i;
+    }
+    bool four_colors = num_opaque == 16;
+
+    uint16_t c0 = 0, c1 = 0;
+    uint32_t bits = 0xFFFFFFFF; // all transparent
+    if (num_opaque > 0) {
+        float e0[3], e1[3];
+        FitEndpoints<3>(b.px, opaque, num_opaque, quality, 1.0f / 32.0f, e0, e1);
+
+        int palette[4][4];
+        int idx[16], best_idx[16];
+        auto evaluate = [&](const float *f0, const float *f1, uint16_t& q0, uint16_t& q1) {
+            q0 = To565(f0);
+            q1 = To565(f1);
+            // 4 color mode requires c0 > c1 and 3 color mode requires c0 <= c1
+            if (four_colors ? q0 < q1 : q0 > q1)
+                std::swap(q0, q1);
+            BC1Palette(q0, q1, four_colors && q0 != q1, palette);
+            return BC1Indices(b, opaque, num_opaque, palette, four_colors && q0 != q1 ? 4 : 3, idx);
+        };
+
+        int best_err = evaluate(e0, e1, c0, c1);
+        std::memcpy(best_idx, idx, sizeof(idx));
+
+        if (quality == BCQuality::High && four_colors) {
+            static const float s_weights[4] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+            for (int iter = 0; iter < 2; ++iter) {
+                float w[16];
+                for (int i = 0; i < num_opaque; ++i)
+                    w[i] = s_weights[best_idx[i]];
+                if (!RefineEndpoints<3>(b.px, opaque, w, num_opaque, e0, e1))
+                    break;
+
+                uint16_t q0, q1;
+                int err = evaluate(e0, e1, q0, q1);
+                if (err >= best_err)
+                    break;
+                best_err = err;
+                c0 = q0;
+                c1 = q1;
+                std::memcpy(best_idx, idx, sizeof(idx));
+            }
+        }
+
+        bits = 0;
+        int oi = 0;
+        for (int i = 0; i < 16; ++i) {
+            uint32_t index = 3; // transparent
+            if (oi < num_opaque && opaque[oi] == i)
+                index = (uint32_t)best_idx[oi++];
+            bits |= index << (i * 2);
+        }
+    }
+
+    dst[0] = (uint8_t)(c0 & 0xFF);
+    dst[1] = (uint8_t)(c0 >> 8);
+    dst[2] = (uint8_t)(c1 & 0xFF);
+    dst[3] = (uint8_t)(c1 >> 8);
+    std::memcpy(dst + 4, &bits, 4);
+}
+
+void DecodeBC1Block(const uint8_t *src, bool allow_alpha, Block& dst)
+{
+    uint16_t c0 = (uint16_t)(src[0] | (src[1] << 8));
+    uint16_t c1 = (uint16_t)(src[2] | (src[3] << 8));
+    uint32_t bits;
+    std::memcpy(&bits, src + 4, 4);
+
+    int palette[4][4];
+    BC1Palette(c0, c1, !allow_alpha || c0 > c1, palette);
+    for (int i = 0; i < 16; ++i) {
+        auto *p = palette[(bits >> (i * 2)) & 3];
+        for (int c = 0; c < 4; ++c)
+            dst.px[i][c] = (uint8_t)p[c];
+    }
+}
+
+
+// BC4 single channel block
+
+void BC4Palette(int e0, int e1, int *palette)
+{
+    palette[0] = e0;
+    palette[1] = e1;
+    if (e0 > e1) {
+        for (int i = 2; i < 8; ++i)
+            palette[i] = ((8 - i) * e0 + (i - 1) * e1) / 7;
+    }
+    else {
+        for (int i = 2; i < 6; ++i)
+            palette[i] = ((6 - i) * e0 + (i - 1) * e1) / 5;
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+}
+
+int BC4Indices(const uint8_t *values, int e0, int e1, int *dst)
+{
+    int palette[8];
+    BC4Palette(e0, e1, palette);
+
+    int total = 0;
+    for (int i = 0; i < 16; ++i) {
+        int best = 0, best_err = INT_MAX;
+        for (int pi = 0; pi < 8; ++pi) {
+            int err = Sq(values[i] - palette[pi]);
+            if (err < best_err) {
+                best_err = err;
+                best = pi;
+            }
+        }
+        dst[i] = best;
+        total += best_err;
+    }
+    return total;
+}
+
+void EncodeBC4Block(const uint8_t *values, BCQuality quality, uint8_t *dst)
+{
+    int mn = 255, mx = 0;
+    int mn_inner = 255, mx_inner = 0; // excluding 0 and 255
+    for (int i = 0; i < 16; ++i) {
+        int v = values[i];
+        mn = std::min(mn, v);
+        mx = std::max(mx, v);
+        if (v != 0 && v != 255) {
+            mn_inner = std::min(mn_inner, v);
+            mx_inner = std::max(mx_inner, v);
+        }
+    }
+
+    int idx[16], best_idx[16];
+    int best_e0 = mx, best_e1 = mn;
+    int best_err = BC4Indices(values, best_e0, best_e1, best_idx);
+    auto try_endpoints = [&](int e0, int e1) {
+        if (best_err == 0)
+            return;
+        int err = BC4Indices(values, e0, e1, idx);
+        if (err < best_err) {
+            best_err = err;
+            best_e0 = e0;
+            best_e1 = e1;
+            std::memcpy(best_idx, idx, sizeof(idx));
+        }
+    };
+
+    if (quality != BCQuality::Fast) {
+        // 6 values mode. 0 and 255 are exact
+        if (mn_inner <= mx_inner)
+            try_endpoints(mn_inner, mx_inner);
+        else
+            try_endpoints(0, 0);
+    }
+    if (quality == BCQuality::High && mx - mn > 8) {
+        for (int d0 = 0; d0 < 4; ++d0)
+            for (int d1 = 0; d1 < 4; ++d1)
+                try_endpoints(mx - d0, mn + d1);
+    }
+
+    dst[0] = (uint8_t)best_e0;
+    dst[1] = (uint8_t)best_e1;
+    uint64_t bits = 0;
+    for (int i = 0; i < 16; ++i)
+        bits |= (uint64_t)best_idx[i] << (i * 3);
+    for (int i = 0; i < 6; ++i)
+        dst[2 + i] = (uint8_t)(bits >> (i * 8));
+}
+
+void DecodeBC4Block(const uint8_t *src, uint8_t *dst, int stride)
+{
+    int palette[8];
+    BC4Palette(src[0], src[1], palette);
+    uint64_t bits = 0;
+    for (int i = 0; i < 6; ++i)
+        bits |= (uint64_t)src[2 + i] << (i * 8);
+    for (int i = 0; i < 16; ++i)
+        dst[i * stride] = (uint8_t)palette[(bits >> (i * 3)) & 7];
+}
+
+
+// BC7 block. mode 6 only: 1 subset, RGBA 7.7.7.7 endpoints with unique p-bits, 4 bit indices
+
+const int g_bc7_weights4[16] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+struct BitWriter
+{
+    uint8_t *dst;
+    int pos = 0;
+
+    void write(uint32_t v, int bits)
+    {
+        for (int i = 0; i < bits; ++i, ++pos) {
+            if ((v >> i) & 1)
+                dst[pos >> 3] |= (uint8_t)(1 << (pos & 7));
+        }
+    }
+};
+
+struct BitReader
+{
+    const uint8_t *src;
+    int pos = 0;
+
+    uint32_t read(int bits)
+    {
+        uint32_t ret = 0;
+        for (int i = 0; i < bits; ++i, ++pos)
+            ret |= (uint32_t)((src[pos >> 3] >> (pos & 7)) & 1) << i;
+        return ret;
+    }
+};
+
+// quantizes to 7 bits + shared p-bit. q receives 7 bit values
+void BC7QuantizeEndpoint(const float *e, int *q, int& pbit)
+{
+    int best_err = INT_MAX;
+    for (int p = 0; p < 2; ++p) {
+        int tq[4], err = 0;
+        for (int c = 0; c < 4; ++c) {
+            tq[c] = std::min(std::max((int)((e[c] - (float)p) * 0.5f + 0.5f), 0), 127);
+            err += Sq(((tq[c] << 1) | p) - (int)(e[c] + 0.5f));
+        }
+        if (err < best_err) {
+            best_err = err;
+            pbit = p;
+            std::memcpy(q, tq, sizeof(tq));
+        }
+    }
+}
+
+int BC7Indices(const Block& b, const int *q0, int p0, const int *q1, int p1, int *dst)
+{
+    int palette[16][4];
+    for (int c = 0; c < 4; ++c) {
+        int a = (q0[c] << 1) | p0;
+        int z = (q1[c] << 1) | p1;
+        for (int i = 0; i < 16; ++i)
+            palette[i][c] = ((64 - g_bc7_weights4[i]) * a + g_bc7_weights4[i] * z + 32) >> 6;
+    }
+
+    int total = 0;
+    for (int i = 0; i < 16; ++i) {
+        auto *p = b.px[i];
+        int best = 0, best_err = INT_MAX;
+        for (int pi = 0; pi < 16; ++pi) {
+            int err = Sq(p[0] - palette[pi][0]) + Sq(p[1] - palette[pi][1]) + Sq(p[2] - palette[pi][2]) + Sq(p[3] - palette[pi][3]);
+            if (err < best_err) {
+                best_err = err;
+                best = pi;
+            }
+        }
+        dst[i] = best;
+        total += best_err;
+    }
+    return total;
+}
+
+void EncodeBC7Block(const Block& b, BCQuality quality, uint8_t *dst)
+{
+    static const int s_all[16] = { 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 };
+
+    float e0[4], e1[4];
+    FitEndpoints<4>(b.px, s_all, 16, quality, 1.0f / 64.0f, e0, e1);
+
+    int q0[4], q1[4], p0, p1;
+    BC7QuantizeEndpoint(e0, q0, p0);
+    BC7QuantizeEndpoint(e1, q1, p1);
+    int idx[16];
+    int best_err = BC7Indices(b, q0, p0, q1, p1, idx);
+
+    if (quality == BCQuality::High) {
+        for (int iter = 0; iter < 2 && best_err > 0; ++iter) {
+            float w[16];
+            for (int i = 0; i < 16; ++i)
+                w[i] = (float)g_bc7_weights4[idx[i]] / 64.0f;
+            if (!RefineEndpoints<4>(b.px, s_all, w, 16, e0, e1))
+                break;
+
+            int tq0[4], tq1[4], tp0, tp1, tidx[16];
+            BC7QuantizeEndpoint(e0, tq0, tp0);
+            BC7QuantizeEndpoint(e1, tq1, tp1);
+            int err = BC7Indices(b, tq0, tp0, tq1, tp1, tidx);
+            if (err >= best_err)
+                break;
+            best_err = err;
+            std::memcpy(q0, tq0, sizeof(q0));
+            std::memcpy(q1, tq1, sizeof(q1));
+            p0 = tp0;
+            p1 = tp1;
+            std::memcpy(idx, tidx, sizeof(idx));
+        }
+    }
+
+    // the MSB of the anchor index (pixel 0) is implicit 0
+    if (idx[0] >= 8) {
+        std::swap(q0, q1);
+        std::swap(p0, p1);
+        for (int i = 0; i < 16; ++i)
+            idx[i] = 15 - idx[i];
+    }
+
+    std::memset(dst, 0, 16);
+    BitWriter bw{ dst };
+    bw.write(1 << 6, 7); // mode 6
+    for (int c = 0; c < 4; ++c) {
+        bw.write(q0[c], 7);
+        bw.write(q1[c], 7);
+    }
+    bw.write(p0, 1);
+    bw.write(p1, 1);
+    bw.write(idx[0], 3);
+    for (int i = 1; i < 16; ++i)
+        bw.write(idx[i], 4);
+}
+
+bool DecodeBC7Block(const uint8_t *src, Block& dst)
+{
+    BitReader br{ src };
+    if (br.read(7) != (1 << 6))
+        return false;
+
+    int e[2][4];
+    for (int c = 0; c < 4; ++c) {
+        e[0][c] = br.read(7) << 1;
+        e[1][c] = br.read(7) << 1;
+    }
+    int p0 = br.read(1), p1 = br.read(1);
+    for (int c = 0; c < 4; ++c) {
+        e[0][c] |= p0;
+        e[1][c] |= p1;
+    }
+    for (int i = 0; i < 16; ++i) {
+        int w = g_bc7_weights4[br.read(i == 0 ? 3 : 4)];
+        for (int c = 0; c < 4; ++c)
+            dst.px[i][c] = (uint8_t)(((64 - w) * e[0][c] + w * e[1][c] + 32) >> 6);
+    }
+    return true;
+}
+
+} // namespace
+
+
+int GetBCBlockSize(BCFormat format)
+{
+    switch (format) {
+    case BCFormat::BC1:
+    case BCFormat::BC4:
+        return 8;
+    default:
+        return 16;
+    }
+}
+
+size_t GetBCDataSize(BCFormat format, int width, int height)
+{
+    size_t bw = (size_t)(width + 3) / 4;
+    size_t bh = (size_t)(height + 3) / 4;
+    return bw * bh * GetBCBlockSize(format);
+}
+
+void EncodeBC(BCFormat format, BCQuality quality, void *dst_, const void *src_, int width, int height)
+{
+    if (!dst_ || !src_ || width <= 0 || height <= 0)
+        return;
+
+    auto *dst = (uint8_t*)dst_;
+    auto *src = (const uint8_t*)src_;
+    int block_size = GetBCBlockSize(format);
+    int num_bx = (width + 3) / 4;
+    int num_by = (height + 3) / 4;
+
+    parallel_for(0, num_by, [&](int by) {
+        Block b;
+        uint8_t channel[16];
+        auto extract = [&](int c) {
+            for (int i = 0; i < 16; ++i)
+                channel[i] = b.px[i][c];
+            return channel;
+        };
+
+        uint8_t *d = dst + (size_t)by * num_bx * block_size;
+        for (int bx = 0; bx < num_bx; ++bx, d += block_size) {
+            FetchBlock(b, src, width, height, bx, by);
+            switch (format) {
+            case BCFormat::BC1:
+                EncodeBC1Block(b, quality, true, d);
+                break;
+            case BCFormat::BC3:
+                EncodeBC4Block(extract(3), quality, d);
+                EncodeBC1Block(b, quality, false, d + 8);
+                break;
+            case BCFormat::BC4:
+                EncodeBC4Block(extract(0), quality, d);
+                break;
+            case BCFormat::BC5:
+                EncodeBC4Block(extract(0), quality, d);
+                EncodeBC4Block(extract(1), quality, d + 8);
+                break;
+            case BCFormat::BC7:
+                EncodeBC7Block(b, quality, d);
+                break;
+            }
+        }
+    });
+}
+
+bool DecodeBC(BCFormat format, void *dst_, const void *src_, int width, int height)
+{
+    if (!dst_ || !src_ || width <= 0 || height <= 0)
+        return false;
+
+    auto *dst = (uint8_t*)dst_;
+    auto *src = (const uint8_t*)src_;
+    int block_size = GetBCBlockSize(format);
+    int num_bx = (width + 3) / 4;
+    int num_by = (height + 3) / 4;
+
+    std::atomic_bool ret{ true };
+    parallel_for(0, num_by, [&](int by) {
+        Block b;
+        const uint8_t *s = src + (size_t)by * num_bx * block_size;
+        for (int bx = 0; bx < num_bx; ++bx, s += block_size) {
+            switch (format) {
+            case BCFormat::BC1:
+                DecodeBC1Block(s, true, b);
+                break;
+            case BCFormat::BC3:
+                DecodeBC1Block(s + 8, false, b);
+                DecodeBC4Block(s, &b.px[0][3], 4);
+                break;
+            case BCFormat::BC4:
+            case BCFormat::BC5:
+                for (int i = 0; i < 16; ++i) {
+                    b.px[i][1] = b.px[i][2] = 0;
+                    b.px[i][3] = 255;
+                }
+                DecodeBC4Block(s, &b.px[0][0], 4);
+                if (format == BCFormat::BC5)
+                    DecodeBC4Block(s + 8, &b.px[0][1], 4);
+                break;
+            case BCFormat::BC7:
+                if (!DecodeBC7Block(s, b)) {
+                    ret = false;
+                    std::memset(&b, 0, sizeof(b));
+                }
+                break;
+            }
+            StoreBlock(dst, b, width, height, bx, by);
+        }
+    });
+    return ret;
+}
+
+} // namespace mu
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+namespace mu {
+
+// BCn texture block compression. every format encodes 4x4 pixel blocks.
+enum class BCFormat
+{
+    BC1, // RGB + 1 bit alpha. 8 bytes per block
+    BC3, // RGBA. 16 bytes per block
+    BC4, // R. 8 bytes per block
+    BC5, // RG. 16 bytes per block
+    BC7, // RGBA. 16 bytes per block
+};
+
+enum class BCQuality
+{
+    Fast,   // bounding box endpoints
+    Normal, // principal axis endpoints
+    High,   // principal axis endpoints + least squares refinement
+};
+
+int GetBCBlockSize(BCFormat format);
+size_t GetBCDataSize(BCFormat format, int width, int height);
+
+// src: RGBA8 pixels. BC4 reads R and BC5 reads RG.
+// width and height don't need to be multiple of 4. edge pixels are repeated to fill blocks.
+// block rows are encoded in parallel.
+void EncodeBC(BCFormat format, BCQuality quality, void *dst, const void *src, int width, int height);
+
+// dst: RGBA8 pixels. BC4 writes (R, 0, 0, 255) and BC5 writes (R, G, 0, 255).
+// BC7 decoding supports mode 6 only, that is the mode EncodeBC() emits. returns false if other modes are found.
+bool DecodeBC(BCFormat format, void *dst, const void *src, int width, int height);
+
+} // namespace mu
@@ -0,0 +1,182 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+#include <vector>
+
+namespace mu {
+
+// open addressing hash map with linear probing.
+// keys and values are stored in one flat array. erase() uses backward shift, so there are no tombstones.
+// K and V must be default constructible and movable. pointers to values are invalidated by insertion and erase.
+template<class K, class V, class Hash = std::hash<K>, class Eq = std::equal_to<K>>
+class FlatHashMap
+{
+public:
+    struct Slot
+    {
+        K key;
+        V value;
+    };
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    size_t capacity() const { return m_slots.size(); }
+
+    void clear()
+    {
+        m_slots.clear();
+        m_used.clear();
+        m_size = 0;
+        m_shift = 64;
+    }
+
+    void reserve(size_t n)
+    {
+        size_t cap = 16;
+        while (cap * 3 / 4 < n)
+            cap *= 2;
+        if (cap > m_slots.size())
+            rehash(cap);
+    }
+
+    V* find(const K& key)
+    {
+        if (m_size == 0)
+            return nullptr;
+        size_t mask = m_slots.size() - 1;
+        for (size_t i = bucket(key); m_used[i]; i = (i + 1) & mask) {
+            if (Eq()(m_slots[i].key, key))
+                return &m_slots[i].value;
+        }
+        return nullptr;
+    }
+    const V* find(const K& key) const
+    {
+        return const_cast<FlatHashMap*>(this)->find(key);
+    }
+
+    // inserts a default constructed value if key doesn't exist
+    V& operator[](const K& key)
+    {
+        bool inserted;
+        return emplace(key, inserted);
+    }
+
+    V& emplace(const K& key, bool& inserted)
+    {
+        if ((m_size + 1) * 4 > m_slots.size() * 3)
+            rehash(m_slots.empty() ? 16 : m_slots.size() * 2);
+
+        size_t mask = m_slots.size() - 1;
+        size_t i = bucket(key);
+        for (; m_used[i]; i = (i + 1) & mask) {
+            if (Eq()(m_slots[i].key, key)) {
+                inserted = false;
+                return m_slots[i].value;
+            }
+        }
+        m_used[i] = 1;
+        m_slots[i].key = key;
+        m_slots[i].value = V();
+        ++m_size;
+        inserted = true;
+        return m_slots[i].value;
+    }
+
+    bool erase(const K& key)
+    {
+        if (m_size == 0)
+            return false;
+        size_t mask = m_slots.size() - 1;
+        for (size_t i = bucket(key); m_used[i]; i = (i + 1) & mask) {
+            if (Eq()(m_slots[i].key, key)) {
+                eraseSlot(i);
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // body: [](const K& key, V& value) -> void
+    template<class Body>
+    void each(const Body& body)
+    {
+        for (size_t i = 0; i < m_slots.size(); ++i) {
+            if (m_used[i])
+                body(m_slots[i].key, m_slots[i].value);
+        }
+    }
+
+    // pred: [](const K& key, V& value) -> bool. erase if returns true.
+    // pred can be called more than once for the same element.
+    template<class Pred>
+    size_t eraseIf(const Pred& pred)
+    {
+        size_t ret = 0;
+        for (size_t i = 0; i < m_slots.size(); ) {
+            // backward shift may move an element into this slot. check it again before moving on.
+            if (m_used[i] && pred(m_slots[i].key, m_slots[i].value)) {
+                eraseSlot(i);
+                ++ret;
+            }
+            else
+                ++i;
+        }
+        return ret;
+    }
+
+private:
+    size_t bucket(const K& key) const
+    {
+        // fibonacci hashing. spreads pointers and other low-entropy hashes over the table
+        return size_t((uint64_t(Hash()(key)) * 0x9E3779B97F4A7C15ull) >> m_shift);
+    }
+
+    void eraseSlot(size_t i)
+    {
+        size_t mask = m_slots.size() - 1;
+        for (size_t j = (i + 1) & mask; m_used[j]; j = (j + 1) & mask) {
+            // move j to the hole if its home bucket is not in (i, j]
+            size_t home = bucket(m_slots[j].key);
+            if (((j - home) & mask) >= ((j - i) & mask)) {
+                m_slots[i] = std::move(m_slots[j]);
+                i = j;
+            }
+        }
+        m_used[i] = 0;
+        m_slots[i] = Slot();
+        --m_size;
+    }
+
+    void rehash(size_t cap)
+    {
+        std::vector<Slot> slots(cap);
+        std::vector<uint8_t> used(cap);
+        slots.swap(m_slots);
+        used.swap(m_used);
+
+        m_shift = 64;
+        for (size_t c = cap; c > 1; c >>= 1)
+            --m_shift;
+
+        size_t mask = cap - 1;
+        for (size_t si = 0; si < slots.size(); ++si) {
+            if (!used[si])
+                continue;
+            size_t i = bucket(slots[si].key);
+            while (m_used[i])
+                i = (i + 1) & mask;
+            m_used[i] = 1;
+            m_slots[i] = std::move(slots[si]);
+        }
+    }
+
+    std::vector<Slot> m_slots;
+    std::vector<uint8_t> m_used;
+    size_t m_size = 0;
+    int m_shift = 64;
+};
+
+} // namespace mu
@@ -4,6 +4,7 @@
 namespace mu {
 
 // note: this half doesn't care about Inf nor NaN. simply round down minor bits of exponent and mantissa.
+// values too small for a normalized half become 0 and values too large are clamped.
 struct half
 {
     uint16_t value;
@@ -15,10 +16,15 @@ struct half
     {
         uint32_t n = (uint32_t&)v;
         uint16_t sign_bit = (n >> 16) & 0x8000;
-        uint16_t exponent = (std::max<int>((n >> 23) - 127 + 15, 0) & 0x1f) << 10;
+        int exponent = (int)((n >> 23) & 0xff) - 127 + 15;
         uint16_t mantissa = (n >> (23 - 10)) & 0x3ff;
 
-        value = sign_bit | exponent | mantissa;
+        if (exponent <= 0)
+            value = sign_bit;
+        else if (exponent >= 0x1f)
+            value = sign_bit | (0x1e << 10) | 0x3ff;
+        else
+            value = sign_bit | uint16_t(exponent << 10) | mantissa;
     }
 
     half& operator=(float v)
@@ -30,6 +36,8 @@ struct half
     operator float() const
     {
         uint32_t sign_bit = (value & 0x8000) << 16;
+        if ((value & 0x7c00) == 0)
+            return (float&)sign_bit;
         uint32_t exponent = ((((value >> 10) & 0x1f) - 15 + 127) & 0xff) << 23;
         uint32_t mantissa = (value & 0x3ff) << (23 - 10);
 
@@ -99,6 +99,24 @@ void LerpTangents_Generic(float4 *dst, const float4 *src1, const float4 *src2, s
     }
 }
 
+void Slerp_Generic(quatf *dst, const quatf *src1, const quatf *src2, size_t num, float w)
+{
+    for (size_t i = 0; i < num; ++i)
+        dst[i] = slerp(src1[i], src2[i], w);
+}
+
+void CatmullRom_Generic(float *dst, const float *src0, const float *src1, const float *src2, const float *src3, size_t num, float t, float s1, float s2)
+{
+    for (size_t i = 0; i < num; ++i)
+        dst[i] = catmull_rom(src0[i], src1[i], src2[i], src3[i], t, s1, s2);
+}
+
+void Hermite_Generic(float *dst, const float *src1, const float *src2, const float *vel1, const float *vel2, size_t num, float t, float dt)
+{
+    for (size_t i = 0; i < num; ++i)
+        dst[i] = hermite(src1[i], src2[i], vel1[i] * dt, vel2[i] * dt, t);
+}
+
 template<class T>
 static inline void MinMax_GenericImpl(const T *src, size_t num, T& dst_min, T& dst_max)
 {
@@ -129,6 +147,18 @@ bool NearEqual_Generic(const float *src1, const float *src2, size_t num, float e
     return true;
 }
 
+bool NearEqualStrided_Generic(const float *src, size_t stride, size_t num, const float *value, size_t num_components, float eps)
+{
+    for (size_t i = 0; i < num; ++i) {
+        const float *e = src + stride * i;
+        for (size_t c = 0; c < num_components; ++c) {
+            if (!near_equal(e[c], value[c], eps))
+                return false;
+        }
+    }
+    return true;
+}
+
 void MulPoints_Generic(const float4x4& m, const float3 src[], float3 dst[], size_t num_data)
 {
     for (size_t i = 0; i < num_data; ++i) {
@@ -506,6 +506,20 @@ template<class T> inline tvec2<T> lerp(const tvec2<T>& a, const tvec2<T>& b, T t
 template<class T> inline tvec3<T> lerp(const tvec3<T>& a, const tvec3<T>& b, T t) { return a*(T(1.0) - t) + b*t; }
 template<class T> inline tvec4<T> lerp(const tvec4<T>& a, const tvec4<T>& b, T t) { return a*(T(1.0) - t) + b*t; }
 
+// cubic hermite spline between p1 and p2. m1 and m2 are the tangents at p1 and p2 scaled to the segment.
+template<class V, class T> inline V hermite(const V& p1, const V& p2, const V& m1, const V& m2, T t)
+{
+    T t2 = t * t;
+    T t3 = t2 * t;
+    return p1 * (T(2.0)*t3 - T(3.0)*t2 + T(1.0)) + m1 * (t3 - T(2.0)*t2 + t) + p2 * (T(-2.0)*t3 + T(3.0)*t2) + m2 * (t3 - t2);
+}
+// catmull-rom spline between p1 and p2. s1 and s2 scale the tangents for non-uniform intervals:
+// s1 = (t2 - t1) / (t2 - t0), s2 = (t2 - t1) / (t3 - t1). both are 0.5 if the intervals are uniform.
+template<class V, class T> inline V catmull_rom(const V& p0, const V& p1, const V& p2, const V& p3, T t, T s1, T s2)
+{
+    return hermite(p1, p2, (p2 - p0) * s1, (p3 - p1) * s2, t);
+}
+
 template<class T> inline bool near_equal(const tvec2<T>& a, const tvec2<T>& b, T e = muEpsilon)
 {
     return near_equal(a.x, b.x, e) && near_equal(a.y, b.y, e);
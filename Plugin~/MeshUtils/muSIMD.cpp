@@ -2,6 +2,7 @@
 #include "muMath.h"
 #include "muSIMD.h"
 #include "muRawVector.h"
+#include "muConcurrency.h"
 
 namespace mu {
 
@@ -88,6 +89,21 @@ void LerpTangents_ISPC(float4 *dst, const float4 *src1, const float4 *src2, size
 {
     ispc::LerpTangents((ispc::float4*)dst, (ispc::float4*)src1, (ispc::float4*)src2, (int)num, w);
 }
+
+void Slerp_ISPC(quatf *dst, const quatf *src1, const quatf *src2, size_t num, float w)
+{
+    ispc::Slerp((ispc::quatf*)dst, (ispc::quatf*)src1, (ispc::quatf*)src2, (int)num, w);
+}
+
+void CatmullRom_ISPC(float *dst, const float *src0, const float *src1, const float *src2, const float *src3, size_t num, float t, float s1, float s2)
+{
+    ispc::CatmullRom(dst, src0, src1, src2, src3, (int)num, t, s1, s2);
+}
+
+void Hermite_ISPC(float *dst, const float *src1, const float *src2, const float *vel1, const float *vel2, size_t num, float t, float dt)
+{
+    ispc::Hermite(dst, src1, src2, vel1, vel2, (int)num, t, dt);
+}
 #endif
 
 #ifdef muSIMD_NearEqual
@@ -97,6 +113,13 @@ bool NearEqual_ISPC(const float *src1, const float *src2, size_t num, float eps)
 }
 #endif
 
+#ifdef muSIMD_NearEqualStrided
+bool NearEqualStrided_ISPC(const float *src, size_t stride, size_t num, const float *value, size_t num_components, float eps)
+{
+    return ispc::NearEqualStrided(src, (int)stride, (int)num, value, (int)num_components, eps);
+}
+#endif
+
 #ifdef muSIMD_MinMax
 void MinMax_ISPC(const int *src, size_t num, int& dst_min, int& dst_max)
 {
@@ -286,7 +309,21 @@ void GenerateTangentsTriangleSoA_ISPC(float4 *dst,
 #if defined(muSIMD_SumInt32) || !defined(muEnableISPC)
 uint64_t SumInt32(const void *src, size_t num)
 {
-    return Forward(SumInt32, (uint32_t*)src, num / sizeof(uint32_t));
+    // split large buffers (e.g. huge meshes) across cores. the sum doesn't depend on the split
+    const size_t block_size = 1024 * 1024; // in uint32_t
+    auto *s = (const uint32_t*)src;
+    size_t n = num / sizeof(uint32_t);
+    if (n < block_size * 2)
+        return Forward(SumInt32, s, n);
+
+    int num_blocks = (int)((n + block_size - 1) / block_size);
+    std::atomic<uint64_t> ret{ 0 };
+    parallel_for(0, num_blocks, [&](int bi) {
+        size_t begin = block_size * bi;
+        size_t end = std::min(begin + block_size, n);
+        ret += Forward(SumInt32, s + begin, end - begin);
+    });
+    return ret;
 }
 #endif
 
@@ -373,6 +410,29 @@ void LerpTangents(float4 * dst, const float4 * src1, const float4 * src2, size_t
 {
     Forward(LerpTangents, dst, src1, src2, num, w);
 }
+
+void Slerp(quatf *dst, const quatf *src1, const quatf *src2, size_t num, float w)
+{
+    Forward(Slerp, dst, src1, src2, num, w);
+}
+
+void CatmullRom(float *dst, const float *src0, const float *src1, const float *src2, const float *src3, size_t num, float t, float s1, float s2)
+{
+    Forward(CatmullRom, dst, src0, src1, src2, src3, num, t, s1, s2);
+}
+void CatmullRom(float3 *dst, const float3 *src0, const float3 *src1, const float3 *src2, const float3 *src3, size_t num, float t, float s1, float s2)
+{
+    CatmullRom((float*)dst, (const float*)src0, (const float*)src1, (const float*)src2, (const float*)src3, num * 3, t, s1, s2);
+}
+
+void Hermite(float *dst, const float *src1, const float *src2, const float *vel1, const float *vel2, size_t num, float t, float dt)
+{
+    Forward(Hermite, dst, src1, src2, vel1, vel2, num, t, dt);
+}
+void Hermite(float3 *dst, const float3 *src1, const float3 *src2, const float3 *vel1, const float3 *vel2, size_t num, float t, float dt)
+{
+    Hermite((float*)dst, (const float*)src1, (const float*)src2, (const float*)vel1, (const float*)vel2, num * 3, t, dt);
+}
 #endif
 
 #if defined(muSIMD_MinMax) || !defined(muEnableISPC)
@@ -402,6 +462,13 @@ bool NearEqual(const float4 *src1, const float4 *src2, size_t num, float eps)
 }
 #endif
 
+#if defined(muSIMD_NearEqualStrided) || !defined(muEnableISPC)
+bool NearEqualStrided(const float *src, size_t stride, size_t num, const float *value, size_t num_components, float eps)
+{
+    return Forward(NearEqualStrided, src, stride, num, value, num_components, eps);
+}
+#endif
+
 #if defined(muSIMD_MulPoints3) || !defined(muEnableISPC)
 void MulPoints(const float4x4& m, const float3 src[], float3 dst[], size_t num_data)
 {
@@ -6,6 +6,7 @@
 
 namespace mu {
 
+// num is in byte. large buffers are summed in parallel
 uint64_t SumInt32(const void *src, size_t num);
 
 // float <-> half
@@ -41,6 +42,12 @@ void Lerp(float3 *dst, const float3 *src1, const float3 *src2, size_t num, float
 void Lerp(float4 *dst, const float4 *src1, const float4 *src2, size_t num, float w);
 void LerpNormals(float3 *dst, const float3 *src1, const float3 *src2, size_t num, float w);
 void LerpTangents(float4 *dst, const float4 *src1, const float4 *src2, size_t num, float w);
+void Slerp(quatf *dst, const quatf *src1, const quatf *src2, size_t num, float w);
+// see catmull_rom() and hermite(). Hermite() takes velocities and dt, the time between src1 and src2.
+void CatmullRom(float  *dst, const float  *src0, const float  *src1, const float  *src2, const float  *src3, size_t num, float t, float s1, float s2);
+void CatmullRom(float3 *dst, const float3 *src0, const float3 *src1, const float3 *src2, const float3 *src3, size_t num, float t, float s1, float s2);
+void Hermite(float  *dst, const float  *src1, const float  *src2, const float  *vel1, const float  *vel2, size_t num, float t, float dt);
+void Hermite(float3 *dst, const float3 *src1, const float3 *src2, const float3 *vel1, const float3 *vel2, size_t num, float t, float dt);
 void MinMax(const int *src, size_t num, int& dst_min, int& dst_max);
 void MinMax(const float *src, size_t num, float& dst_min, float& dst_max);
 void MinMax(const float2 *src, size_t num, float2& dst_min, float2& dst_max);
@@ -50,6 +57,8 @@ bool NearEqual(const float *src1, const float *src2, size_t num, float eps = muE
 bool NearEqual(const float2 *src1, const float2 *src2, size_t num, float eps = muEpsilon);
 bool NearEqual(const float3 *src1, const float3 *src2, size_t num, float eps = muEpsilon);
 bool NearEqual(const float4 *src1, const float4 *src2, size_t num, float eps = muEpsilon);
+// compare num elements of strided data (stride is in float) with value. e.g. values of TVP<float3> array
+bool NearEqualStrided(const float *src, size_t stride, size_t num, const float *value, size_t num_components, float eps = muEpsilon);
 
 void MulPoints(const float4x4& m, const float3 src[], float3 dst[], size_t num_data);
 void MulVectors(const float4x4& m, const float3 src[], float3 dst[], size_t num_data);
@@ -167,6 +176,12 @@ void LerpNormals_Generic(float3 *dst, const float3 *src1, const float3 *src2, si
 void LerpNormals_ISPC(float3 *dst, const float3 *src1, const float3 *src2, size_t num, float w);
 void LerpTangents_Generic(float4 *dst, const float4 *src1, const float4 *src2, size_t num, float w);
 void LerpTangents_ISPC(float4 *dst, const float4 *src1, const float4 *src2, size_t num, float w);
+void Slerp_Generic(quatf *dst, const quatf *src1, const quatf *src2, size_t num, float w);
+void Slerp_ISPC(quatf *dst, const quatf *src1, const quatf *src2, size_t num, float w);
+void CatmullRom_Generic(float *dst, const float *src0, const float *src1, const float *src2, const float *src3, size_t num, float t, float s1, float s2);
+void CatmullRom_ISPC(float *dst, const float *src0, const float *src1, const float *src2, const float *src3, size_t num, float t, float s1, float s2);
+void Hermite_Generic(float *dst, const float *src1, const float *src2, const float *vel1, const float *vel2, size_t num, float t, float dt);
+void Hermite_ISPC(float *dst, const float *src1, const float *src2, const float *vel1, const float *vel2, size_t num, float t, float dt);
 
 void MinMax_Generic(const int *src, size_t num, int& dst_min, int& dst_max);
 void MinMax_ISPC(const int *src, size_t num, int& dst_min, int& dst_max);
@@ -181,6 +196,8 @@ void MinMax_ISPC(const float4 *src, size_t num, float4& dst_min, float4& dst_max
 
 bool NearEqual_Generic(const float *src1, const float *src2, size_t num, float eps);
 bool NearEqual_ISPC(const float *src1, const float *src2, size_t num, float eps);
+bool NearEqualStrided_Generic(const float *src, size_t stride, size_t num, const float *value, size_t num_components, float eps);
+bool NearEqualStrided_ISPC(const float *src, size_t stride, size_t num, const float *value, size_t num_components, float eps);
 
 void MulPoints_Generic(const float4x4& m, const float3 src[], float3 dst[], size_t num_data);
 void MulPoints_ISPC(const float4x4& m, const float3 src[], float3 dst[], size_t num_data);
@@ -11,6 +11,7 @@
 #define muSIMD_Normalize
 #define muSIMD_Lerp
 #define muSIMD_NearEqual
+#define muSIMD_NearEqualStrided
 
 #define muSIMD_MinMax
 
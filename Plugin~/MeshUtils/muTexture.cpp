@@ -0,0 +1,314 @@
+#include "pch.h"
+#include "muTexture.h"
+#include "muMath.h"
+#include "muConcurrency.h"
+#include "muSIMD.h"
+#include <cmath>
+
+namespace mu {
+
+int GetMipCount(int width, int height)
+{
+    int ret = 1;
+    int size = std::max(width, height);
+    while (size > 1) {
+        size >>= 1;
+        ++ret;
+    }
+    return ret;
+}
+
+namespace {
+
+template<class T> inline float ToFloat(T v) { return (float)v; }
+template<class T> inline T FromFloat(float v) { return T(v); }
+template<> inline uint8_t FromFloat<uint8_t>(float v) { return (uint8_t)std::min(std::max(v + 0.5f, 0.0f), 255.0f); }
+
+// weights of the 4 taps at -1.5, -0.5, +0.5, +1.5 source texels from the center of the destination texel
+struct KaiserKernel
+{
+    float w[4];
+
+    KaiserKernel()
+    {
+        // Kaiser window (alpha = 4) over sinc with 2x stretch. support is 2 destination texels
+        const float alpha = 4.0f, radius = 2.0f;
+        auto bessel0 = [](float x) {
+            // zero-th order modified Bessel function of the first kind
+            float sum = 1.0f, term = 1.0f;
+            for (int k = 1; k < 16; ++k) {
+                term *= (x / (2.0f * k)) * (x / (2.0f * k));
+                sum += term;
+            }
+            return sum;
+        };
+        auto sinc = [](float x) {
+            const float pi = 3.14159265358979f;
+            return x == 0.0f ? 1.0f : std::sin(pi * x) / (pi * x);
+        };
+
+        const float offsets[4] = { -1.5f, -0.5f, 0.5f, 1.5f };
+        float total = 0.0f;
+        for (int i = 0; i < 4; ++i) {
+            float t = offsets[i] / radius;
+            float window = bessel0(alpha * std::sqrt(std::max(1.0f - t * t, 0.0f))) / bessel0(alpha);
+            w[i] = sinc(offsets[i] * 0.5f) * window;
+            total += w[i];
+        }
+        for (auto& v : w)
+            v /= total;
+    }
+};
+
+template<class T>
+void GenerateMipLevelImpl(T *dst, const T *src, int width, int height, int channels, MipFilter filter)
+{
+    if (!dst || !src || width <= 0 || height <= 0 || channels <= 0)
+        return;
+
+    int dw = GetMipSize(width, 1);
+    int dh = GetMipSize(height, 1);
+
+    if (filter == MipFilter::Box) {
+        parallel_for(0, dh, [&](int dy) {
+            int sy0 = std::min(dy * 2, height - 1);
+            int sy1 = std::min(dy * 2 + 1, height - 1);
+            const T *row0 = src + (size_t)sy0 * width * channels;
+            const T *row1 = src + (size_t)sy1 * width * channels;
+            T *d = dst + (size_t)dy * dw * channels;
+            for (int dx = 0; dx < dw; ++dx) {
+                int sx0 = std::min(dx * 2, width - 1) * channels;
+                int sx1 = std::min(dx * 2 + 1, width - 1) * channels;
+                for (int c = 0; c < channels; ++c) {
+                    float sum = ToFloat(row0[sx0 + c]) + ToFloat(row0[sx1 + c]) + ToFloat(row1[sx0 + c]) + ToFloat(row1[sx1 + c]);
+                    d[dx * channels + c] = FromFloat<T>(sum * 0.25f);
+                }
+            }
+        });
+    }
+    else {
+        static const KaiserKernel s_kernel;
+        auto *w = s_kernel.w;
+
+        // horizontal pass into float rows, then vertical pass
+        std::vector<float> tmp((size_t)dw * height * channels);
+        parallel_for(0, height, [&](int sy) {
+            const T *s = src + (size_t)sy * width * channels;
+            float *t = tmp.data() + (size_t)sy * dw * channels;
+            for (int dx = 0; dx < dw; ++dx) {
+                int sx[4];
+                for (int i = 0; i < 4; ++i)
+                    sx[i] = std::min(std::max(dx * 2 - 1 + i, 0), width - 1) * channels;
+                for (int c = 0; c < channels; ++c) {
+                    float sum = 0.0f;
+                    for (int i = 0; i < 4; ++i)
+                        sum += ToFloat(s[sx[i] + c]) * w[i];
+                    t[dx * channels + c] = sum;
+                }
+            }
+        });
+        parallel_for(0, dh, [&](int dy) {
+            const float *rows[4];
+            for (int i = 0; i < 4; ++i)
+                rows[i] = tmp.data() + (size_t)std::min(std::max(dy * 2 - 1 + i, 0), height - 1) * dw * channels;
+            T *d = dst + (size_t)dy * dw * channels;
+            int n = dw * channels;
+            for (int i = 0; i < n; ++i)
+                d[i] = FromFloat<T>(rows[0][i] * w[0] + rows[1][i] * w[1] + rows[2][i] * w[2] + rows[3][i] * w[3]);
+        });
+    }
+}
+
+} // namespace
+
+void GenerateMipLevel(uint8_t *dst, const uint8_t *src, int width, int height, int channels, MipFilter filter)
+{
+    GenerateMipLevelImpl(dst, src, width, height, channels, filter);
+}
+void GenerateMipLevel(half *dst, const half *src, int width, int height, int channels, MipFilter filter)
+{
+    GenerateMipLevelImpl(dst, src, width, height, channels, filter);
+}
+void GenerateMipLevel(float *dst, const float *src, int width, int height, int channels, MipFilter filter)
+{
+    GenerateMipLevelImpl(dst, src, width, height, channels, filter);
+}
+
+
+int GetPixelTypeSize(PixelType type)
+{
+    switch (type) {
+    case PixelType::U8: return 1;
+    case PixelType::I16: return 2;
+    case PixelType::I32: return 4;
+    case PixelType::F16: return 2;
+    case PixelType::F32: return 4;
+    default: return 0;
+    }
+}
+
+float SRGBToLinear(float v)
+{
+    return v <= 0.04045f ? v * (1.0f / 12.92f) : std::pow((v + 0.055f) * (1.0f / 1.055f), 2.4f);
+}
+
+float LinearToSRGB(float v)
+{
+    return v <= 0.0031308f ? v * 12.92f : 1.055f * std::pow(v, 1.0f / 2.4f) - 0.055f;
+}
+
+namespace {
+
+// rows per parallel task. small images are done in one task.
+const int kConvertPixelsPerTask = 64 * 1024;
+
+struct SRGBTable
+{
+    float to_linear[256];
+
+    SRGBTable()
+    {
+        for (int i = 0; i < 256; ++i)
+            to_linear[i] = SRGBToLinear((float)i / 255.0f);
+    }
+};
+
+inline uint8_t ToU8(float v) { return (uint8_t)(std::min(std::max(v, 0.0f), 1.0f) * 255.0f + 0.5f); }
+
+// src row -> width * channels floats. returns a pointer to the floats (src itself if it is F32)
+const float* DecodeRow(RawVector<float>& buf, const void *src, PixelType type, size_t num)
+{
+    if (type == PixelType::F32)
+        return (const float*)src;
+
+    buf.resize_discard(num);
+    switch (type) {
+    case PixelType::U8: U8ToF32(buf.data(), (const unorm8*)src, num); break;
+    case PixelType::I16: S16ToF32(buf.data(), (const snorm16*)src, num); break;
+    case PixelType::I32: S32ToF32(buf.data(), (const snorm32*)src, num); break;
+    case PixelType::F16: F16ToF32(buf.data(), (const half*)src, num); break;
+    default: break;
+    }
+    return buf.data();
+}
+
+void EncodeRow(void *dst, PixelType type, const float *src, size_t num)
+{
+    switch (type) {
+    case PixelType::U8:
+    {
+        // round to nearest. F32ToU8() truncates, that darkens images converted back and forth
+        auto *d = (uint8_t*)dst;
+        for (size_t i = 0; i < num; ++i)
+            d[i] = ToU8(src[i]);
+        break;
+    }
+    case PixelType::I16: F32ToS16((snorm16*)dst, src, num); break;
+    case PixelType::I32: F32ToS32((snorm32*)dst, src, num); break;
+    case PixelType::F16: F32ToF16((half*)dst, src, num); break;
+    case PixelType::F32: memcpy(dst, src, sizeof(float) * num); break;
+    default: break;
+    }
+}
+
+} // namespace
+
+bool ConvertPixels(void *dst, PixelType dst_type, int dst_channels,
+    const void *src, PixelType src_type, int src_channels,
+    int width, int height, const PixelConvertOptions& opt)
+{
+    int src_size = GetPixelTypeSize(src_type);
+    int dst_size = GetPixelTypeSize(dst_type);
+    if (!dst || !src || src_size == 0 || dst_size == 0 || width <= 0 || height <= 0 ||
+        src_channels < 1 || src_channels > 4 || dst_channels < 1 || dst_channels > 4)
+        return false;
+
+    bool identity = src_channels == dst_channels;
+    for (int c = 0; c < dst_channels; ++c)
+        identity = identity && opt.swizzle[c] == c;
+    // both directions cancel each other
+    bool to_linear = opt.srgb_to_linear && !opt.linear_to_srgb;
+    bool to_srgb = opt.linear_to_srgb && !opt.srgb_to_linear;
+
+    size_t src_pitch = (size_t)src_size * src_channels * width;
+    size_t dst_pitch = (size_t)dst_size * dst_channels * width;
+    auto src_row = [&](int y) { return (const char*)src + src_pitch * y; };
+    auto dst_row = [&](int y) { return (char*)dst + dst_pitch * (opt.flip_y ? height - 1 - y : y); };
+    int granularity = std::max(kConvertPixelsPerTask / width, 1);
+
+    if (identity && !to_linear && !to_srgb && src_type == dst_type) {
+        parallel_for_blocked(0, height, granularity, [&](int begin, int end) {
+            for (int y = begin; y < end; ++y)
+                memcpy(dst_row(y), src_row(y), src_pitch);
+        });
+    }
+    else if (identity && !to_linear && !to_srgb) {
+        // component type conversion only
+        size_t num = (size_t)width * src_channels;
+        parallel_for_blocked(0, height, granularity, [&](int begin, int end) {
+            RawVector<float> buf;
+            for (int y = begin; y < end; ++y)
+                EncodeRow(dst_row(y), dst_type, DecodeRow(buf, src_row(y), src_type, num), num);
+        });
+    }
+    else if (src_type == PixelType::U8 && dst_type == PixelType::U8 && !to_linear && !to_srgb) {
+        // channel expansion / reduction / swizzle (e.g. RGB -> RGBA, BGRA -> RGBA) without going through floats
+        int sw[4];
+        for (int c = 0; c < 4; ++c)
+            sw[c] = opt.swizzle[c] < src_channels ? opt.swizzle[c] : -1;
+        parallel_for_blocked(0, height, granularity, [&](int begin, int end) {
+            for (int y = begin; y < end; ++y) {
+                auto *s = (const uint8_t*)src_row(y);
+                auto *d = (uint8_t*)dst_row(y);
+                for (int x = 0; x < width; ++x) {
+                    for (int c = 0; c < dst_channels; ++c)
+                        d[c] = sw[c] >= 0 ? s[sw[c]] : (c == 3 ? 255 : 0);
+                    s += src_channels;
+                    d += dst_channels;
+                }
+            }
+        });
+    }
+    else {
+        // generic path: decode to floats, swizzle and convert color space, then encode
+        int sw[4];
+        for (int c = 0; c < 4; ++c)
+            sw[c] = opt.swizzle[c] < src_channels ? opt.swizzle[c] : -1;
+        // u8 sRGB colors are decoded by a table instead of pow()
+        static const SRGBTable s_srgb_table;
+        const float *srgb_table = to_linear && src_type == PixelType::U8 ? s_srgb_table.to_linear : nullptr;
+
+        size_t src_num = (size_t)width * src_channels;
+        size_t dst_num = (size_t)width * dst_channels;
+        parallel_for_blocked(0, height, granularity, [&](int begin, int end) {
+            RawVector<float> sbuf, dbuf;
+            dbuf.resize_discard(dst_num);
+            for (int y = begin; y < end; ++y) {
+                auto *raw = (const uint8_t*)src_row(y);
+                const float *s = DecodeRow(sbuf, raw, src_type, src_num);
+                float *d = dbuf.data();
+                for (int x = 0; x < width; ++x) {
+                    for (int c = 0; c < dst_channels; ++c) {
+                        float v = sw[c] >= 0 ? s[sw[c]] : (c == 3 ? 1.0f : 0.0f);
+                        if (c < 3 && sw[c] >= 0) {
+                            if (srgb_table)
+                                v = srgb_table[raw[sw[c]]];
+                            else if (to_linear)
+                                v = SRGBToLinear(v);
+                            else if (to_srgb)
+                                v = LinearToSRGB(std::max(v, 0.0f));
+                        }
+                        d[c] = v;
+                    }
+                    s += src_channels;
+                    raw += src_channels;
+                    d += dst_channels;
+                }
+                EncodeRow(dst_row(y), dst_type, dbuf.data(), dst_num);
+            }
+        });
+    }
+    return true;
+}
+
+} // namespace mu
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include "muHalf.h"
+
+namespace mu {
+
+enum class MipFilter
+{
+    Box,    // 2x2 average
+    Kaiser, // 4x4 Kaiser windowed sinc. sharper than Box
+};
+
+// number of levels of the full mip chain. (e.g. 256x64 -> 9)
+int GetMipCount(int width, int height);
+inline int GetMipSize(int size, int level) { int r = size >> level; return r > 0 ? r : 1; }
+
+// generates the next smaller mip level of src. dst must have GetMipSize(width, 1) * GetMipSize(height, 1) * channels elements.
+// rows are processed in parallel.
+void GenerateMipLevel(uint8_t *dst, const uint8_t *src, int width, int height, int channels, MipFilter filter);
+void GenerateMipLevel(half *dst, const half *src, int width, int height, int channels, MipFilter filter);
+void GenerateMipLevel(float *dst, const float *src, int width, int height, int channels, MipFilter filter);
+
+
+// component type of uncompressed pixels. I16 and I32 are signed normalized (-1.0 - 1.0)
+enum class PixelType
+{
+    Unknown,
+    U8,
+    I16,
+    I32,
+    F16,
+    F32,
+};
+int GetPixelTypeSize(PixelType type);
+
+float SRGBToLinear(float v);
+float LinearToSRGB(float v);
+
+struct PixelConvertOptions
+{
+    bool flip_y = false;
+    // applied to color channels only. alpha is kept linear
+    bool srgb_to_linear = false;
+    bool linear_to_srgb = false;
+    // source channel of each destination channel (e.g. { 2, 1, 0, 3 } for BGRA <-> RGBA).
+    // missing source channels become 0, or 1 for alpha
+    int swizzle[4] = { 0, 1, 2, 3 };
+};
+
+// converts any pair of uncompressed layouts. channels: 1 - 4. src and dst must not overlap.
+// row blocks are processed in parallel. layouts that differ only in component type use the SIMD kernels in muSIMD.h.
+bool ConvertPixels(void *dst, PixelType dst_type, int dst_channels,
+    const void *src, PixelType src_type, int src_channels,
+    int width, int height, const PixelConvertOptions& opt = PixelConvertOptions());
+
+} // namespace mu
@@ -89,8 +89,12 @@ TestCase(Test_SendMesh)
 
 TestCase(Test_SceneCacheRead)
 {
+    int cubic = 0;
+    GetArg("cubic", cubic);
+
     ms::ISceneCacheSettings iscs;
     iscs.enable_diff = false;
+    iscs.cubic_interpolation = cubic;
     auto isc = ms::OpenISceneCacheFile("wave_c2.sc", iscs);
     Expect(isc);
     if (!isc)
@@ -145,10 +149,137 @@ TestCase(Test_Animation)
         anim->scale.push_back({ 1.0f, {2.0f, 2.0f, 2.0f} });
         anim->scale.push_back({ 2.0f, {1.0f, 1.0f, 1.0f} });
         anim->scale.push_back({ 3.0f, {2.0f, 2.0f, 2.0f} });
+
+        // well-known curves must be found by key and by name, also after round trip
+        auto& host = *anim->host;
+        Expect(host.findCurve(ms::AnimationCurveKey::TransformTranslation).get() == anim->translation.curve);
+        Expect(host.findCurve(mskTransformRotation).get() == anim->rotation.curve);
+
+        MemoryStream stream;
+        host.serialize(stream);
+        stream.flush();
+        auto dst = ms::Animation::create(stream);
+        Expect(dst->findCurve(ms::AnimationCurveKey::TransformScale) == dst->findCurve(mskTransformScale));
+        Expect(dst->findCurve(ms::AnimationCurveKey::TransformScale)->size() == 4);
+
+        // translation, rotation and scale have the same times. they must be shared
+        auto rot = ms::TAnimationCurve<quatf>(dst->findCurve(ms::AnimationCurveKey::TransformRotation));
+        Expect(dst->times.size() == 4);
+        Expect(rot.curve->data_flags.shared_times);
+        Expect(rot[3].time == 3.0f && rot[3].value == anim->rotation[3].value);
+
+        // batched evaluation must match per-curve evaluation
+        int num_evaluated = 0;
+        dst->evaluate(1.5f, [&](const ms::AnimationCurve& curve, const void *value) {
+            ++num_evaluated;
+            if (curve.key == ms::AnimationCurveKey::TransformTranslation) {
+                Expect(near_equal(*(const float3*)value, float3{ 1.0f, 0.5f, 0.0f }));
+            }
+            else if (curve.key == ms::AnimationCurveKey::TransformRotation) {
+                quatf q;
+                curve.evaluate(1.5f, &q);
+                Expect(near_equal(*(const quatf*)value, q));
+                Expect(near_equal(q, ms::rotate_x(135.0f * mu::DegToRad)));
+            }
+        });
+        Expect(num_evaluated == 3);
     }
     Send(scene);
 }
 
+TestCase(Test_AnimationOptimize)
+{
+    auto rest = ms::Transform::create();
+    rest->path = "/Test/Optimize1";
+    rest->position = { 0.0f, 0.0f, 0.0f };
+    rest->rotation = quatf::identity();
+    rest->scale = { 1.0f, 1.0f, 1.0f };
+    rest->setupDataFlags();
+
+    auto clip = ms::AnimationClip::create();
+    auto anim1 = ms::TransformAnimation::create();
+    auto anim2 = ms::TransformAnimation::create();
+    clip->addAnimation(anim1);
+    clip->addAnimation(anim2);
+    anim1->path = "/Test/Optimize1";
+    anim2->path = "/Test/Optimize2";
+    for (int i = 0; i < 4; ++i) {
+        float t = (float)i;
+        anim1->translation.push_back({ t, {0.0f, 0.0f, 0.0f} }); // equal to rest pose
+        anim1->scale.push_back({ t, {2.0f, 2.0f, 2.0f} }); // constant
+        anim1->rotation.push_back({ t, ms::rotate_x(t * 90.0f * mu::DegToRad) });
+        anim2->rotation.push_back({ t, ms::rotate_x(t * 90.0f * mu::DegToRad) }); // identical to anim1
+    }
+
+    clip->optimize(ms::AnimationOptimizeSettings(), { rest });
+    auto& host1 = *clip->animations[0];
+    auto& host2 = *clip->animations[1];
+    Expect(!host1.findCurve(ms::AnimationCurveKey::TransformTranslation));
+    Expect(host1.findCurve(ms::AnimationCurveKey::TransformScale)->size() == 2);
+    Expect(host2.findCurve(ms::AnimationCurveKey::TransformRotation)->data_ref != ms::InvalidID);
+
+    MemoryStream stream;
+    clip->serialize(stream);
+    stream.flush();
+    auto dst = ms::AnimationClip::create(stream);
+    auto rot1 = dst->animations[0]->findCurve(ms::AnimationCurveKey::TransformRotation);
+    auto rot2 = dst->animations[1]->findCurve(ms::AnimationCurveKey::TransformRotation);
+    Expect(rot2->size() == 4);
+    Expect(rot2->data_ref == ms::InvalidID);
+    Expect(rot1->data == rot2->data);
+}
+
+TestCase(Test_AnimationDelta)
+{
+    auto base = ms::AnimationClip::create();
+    base->name = "Delta";
+    auto anim = ms::TransformAnimation::create();
+    anim->path = "/Test/Delta";
+    base->addAnimation(anim);
+    for (int i = 0; i < 5; ++i)
+        anim->translation.push_back({ (float)i, {(float)i, 0.0f, 0.0f} });
+
+    ms::AnimationDeltaMessage mes;
+    {
+        ms::AnimationClipDelta delta;
+        delta.clip->name = "Delta";
+        auto danim = ms::TransformAnimation::create();
+        danim->path = "/Test/Delta";
+        delta.clip->addAnimation(danim);
+        danim->translation.push_back({ 1.5f, {10.0f, 0.0f, 0.0f} });
+        danim->translation.push_back({ 2.5f, {20.0f, 0.0f, 0.0f} });
+        delta.ranges.push_back({ "/Test/Delta", mskTransformTranslation, { 1.0f, 3.0f } });
+        // ranges are matched by path and curve name. this one has no counterpart and must be ignored
+        delta.ranges.push_back({ "/Test/Delta", mskTransformScale, { 0.0f, 5.0f } });
+        mes.deltas.push_back(delta);
+    }
+
+    MemoryStream stream;
+    mes.serialize(stream);
+    stream.flush();
+    ms::AnimationDeltaMessage dst;
+    dst.deserialize(stream);
+    Expect(dst.deltas.size() == 1);
+    auto& delta = dst.deltas[0];
+    Expect(delta.isTarget(*base));
+    Expect(delta.findRange("/Test/Delta", mskTransformTranslation)->range.end == 3.0f);
+
+    auto updated = ms::AnimationClip::create();
+    delta.apply(*base, updated.get());
+    // keys 1, 2, 3 are replaced by 1.5 and 2.5. 0 and 4 are kept.
+    auto result = ms::TransformAnimation::create(base->animations[0]);
+    Expect(result->translation.size() == 4);
+    Expect(result->translation[0].time == 0.0f);
+    Expect(result->translation[1].time == 1.5f && result->translation[1].value.x == 10.0f);
+    Expect(result->translation[2].time == 2.5f && result->translation[2].value.x == 20.0f);
+    Expect(result->translation[3].time == 4.0f);
+
+    // only the updated curve is copied
+    Expect(updated->animations.size() == 1);
+    Expect(updated->animations[0]->curves.size() == 1);
+    Expect(updated->animations[0]->findCurve(mskTransformTranslation)->size() == 4);
+}
+
 TestCase(Test_MeshMerge)
 {
     auto scene = ms::Scene::create();
@@ -307,6 +438,119 @@ ms::TexturePtr CreateCheckerImageTexture(color_t black, color_t white, int width
     return tex;
 }
 
+TestCase(Test_PointsLerp)
+{
+    // particles 0 and 1 die and 10 and 11 are born between the frames
+    auto p1 = ms::Points::create();
+    auto p2 = ms::Points::create();
+    for (int i = 0; i < 10; ++i) {
+        p1->ids.push_back(i);
+        p1->points.push_back({ (float)i, 0.0f, 0.0f });
+        p1->rotations.push_back(quatf::identity());
+    }
+    for (int i = 2; i < 12; ++i) {
+        p2->ids.push_back(i);
+        p2->points.push_back({ (float)i, 1.0f, 0.0f });
+        p2->rotations.push_back(rotate(float3{ 0.0f, 1.0f, 0.0f }, 90.0f * mu::DegToRad));
+    }
+
+    auto check = [](ms::Points& p) {
+        Expect(p.ids.size() == 12 && p.points.size() == 12 && p.rotations.size() == 12);
+        for (size_t i = 0; i < p.ids.size(); ++i) {
+            int id = p.ids[i];
+            float y = id < 2 ? 0.0f : id >= 10 ? 1.0f : 0.25f; // dying and born particles are held
+            Expect(near_equal(p.points[i], float3{ (float)id, y, 0.0f }));
+        }
+        Expect(near_equal(p.rotations[5], rotate(float3{ 0.0f, 1.0f, 0.0f }, 22.5f * mu::DegToRad)));
+    };
+
+    // merge join
+    auto r1 = std::static_pointer_cast<ms::Points>(p1->clone());
+    Expect(r1->lerp(*p1, *p2, 0.25f));
+    check(*r1);
+
+    // hash join
+    std::reverse(p2->ids.begin(), p2->ids.end());
+    std::reverse(p2->points.begin(), p2->points.end());
+    auto r2 = std::static_pointer_cast<ms::Points>(p1->clone());
+    Expect(r2->lerp(*p1, *p2, 0.25f));
+    check(*r2);
+}
+
+TestCase(Test_SceneLerp)
+{
+    // entity 1 disappears and 4 appears. entities in s2 are not sorted by id.
+    auto make = [](int id, float x) {
+        auto e = ms::Transform::create();
+        e->id = id;
+        e->path = "/Test_SceneLerp/" + std::to_string(id);
+        e->position = { x, 0.0f, 0.0f };
+        e->rotation = quatf::identity();
+        e->scale = float3::one();
+        return e;
+    };
+    auto s1 = ms::Scene::create();
+    s1->entities = { make(1, 0.0f), make(2, 0.0f), make(3, 0.0f) };
+    auto s2 = ms::Scene::create();
+    s2->entities = { make(4, 1.0f), make(3, 1.0f), make(2, 1.0f) };
+
+    auto ret = ms::Scene::create();
+    ret->lerp(*s1, *s2, 0.5f);
+    auto& entities = ret->entities;
+    Expect(entities.size() == 4);
+    if (entities.size() != 4)
+        return;
+    for (int i = 0; i < 4; ++i)
+        Expect(entities[i]->id == i + 1);
+    Expect(entities[0] == s1->entities[0] && entities[3] == s2->entities[0]);
+    Expect(near_equal(entities[1]->position.x, 0.5f) && near_equal(entities[2]->position.x, 0.5f));
+}
+
+TestCase(Test_CubicLerp)
+{
+    // a transform moves along x = time^2 and a particle along y = time^3 with exact velocities.
+    // catmull-rom reproduces the quadratic and hermite reproduces the cubic at the midpoint.
+    std::vector<ms::ScenePtr> scenes;
+    for (int i = 0; i < 4; ++i) {
+        float time = (float)i;
+        auto t = ms::Transform::create();
+        t->id = 1;
+        t->position = { time * time, 0.0f, 0.0f };
+        t->rotation = quatf::identity();
+        t->scale = float3::one();
+
+        auto p = ms::Points::create();
+        p->id = 2;
+        p->position = float3::zero();
+        p->rotation = quatf::identity();
+        p->scale = float3::one();
+        p->ids = { 0 };
+        p->points = { { 0.0f, time * time * time, 0.0f } };
+        p->velocities = { { 0.0f, 3.0f * time * time, 0.0f } };
+
+        auto scene = ms::Scene::create();
+        scene->entities = { t, p };
+        scenes.push_back(scene);
+    }
+
+    auto params = ms::CubicLerpParams::create(0.0f, 1.0f, 2.0f, 3.0f, 1.5f);
+    Expect(near_equal(params.t, 0.5f) && near_equal(params.s1, 0.5f) && near_equal(params.s2, 0.5f));
+
+    auto ret = ms::Scene::create();
+    ret->cubicLerp(scenes[0].get(), *scenes[1], *scenes[2], scenes[3].get(), params);
+    Expect(ret->entities.size() == 2);
+    if (ret->entities.size() != 2)
+        return;
+    auto& points = static_cast<ms::Points&>(*ret->entities[1]);
+    Print("  position %f, point %f\n", ret->entities[0]->position.x, points.points[0].y);
+    Expect(near_equal(ret->entities[0]->position.x, 2.25f));
+    Expect(near_equal(points.points[0].y, 3.375f));
+
+    // without neighbours
+    ret->cubicLerp(nullptr, *scenes[1], *scenes[2], nullptr, params);
+    Expect(ret->entities.size() == 2 && ret->entities[0]->position.x > 1.0f && ret->entities[0]->position.x < 4.0f);
+}
+
 TestCase(Test_SendTexture)
 {
     auto gen_id = []() {
@@ -484,6 +728,1394 @@ TestCase(Test_FileAsset)
 }
 
 
+TestCase(Test_TextureMips)
+{
+    for (auto filter : { MipFilter::Box, MipFilter::Kaiser }) {
+        auto tex = ms::Texture::create();
+        tex->format = ms::TextureFormat::RGBAu8;
+        tex->width = 37;
+        tex->height = 20;
+        RawVector<unorm8x4> pixels(tex->width * tex->height);
+        for (auto& p : pixels)
+            p = unorm8x4{ 0.5f, 0.25f, 1.0f, 1.0f };
+        tex->setData(pixels.cdata());
+
+        Expect(tex->generateMips(filter));
+        Expect(tex->mip_count == 6); // 37, 18, 9, 4, 2, 1
+        Expect(tex->data.size() == ms::GetTextureDataSize(tex->format, 37, 20, 6));
+        // uniform color must stay uniform in every level
+        auto *last = (const unorm8x4*)(tex->data.cdata() + tex->getMipOffset(5));
+        Expect(last->x == pixels[0].x && last->y == pixels[0].y && last->z == pixels[0].z);
+
+        auto coarse = tex->cloneMips(2);
+        Expect(coarse->id == tex->id && coarse->width == 9 && coarse->height == 5 && coarse->mip_count == 4);
+        Expect(coarse->data.size() == ms::GetTextureDataSize(coarse->format, 9, 5, 4));
+
+        Expect(tex->compress(ms::TextureFormat::BC7));
+        Expect(tex->data.size() == ms::GetTextureDataSize(ms::TextureFormat::BC7, 37, 20, 6));
+
+        MemoryStream stream;
+        tex->serialize(stream);
+        stream.flush();
+        auto dst = ms::Texture::create(stream);
+        Expect(dst->mip_count == 6 && dst->data == tex->data);
+    }
+}
+
+TestCase(Test_TextureConvert)
+{
+    auto tex = ms::Texture::create();
+    tex->format = ms::TextureFormat::RGBf32;
+    tex->width = 16;
+    tex->height = 8;
+    RawVector<float3> pixels(tex->width * tex->height);
+    for (auto& p : pixels)
+        p = { 0.25f, 0.5f, 0.75f };
+    tex->setData(pixels.cdata());
+    Expect(tex->generateMips());
+
+    Expect(tex->convert(ms::TextureFormat::RGBAf16));
+    Expect(tex->data.size() == ms::GetTextureDataSize(ms::TextureFormat::RGBAf16, 16, 8, tex->mip_count));
+    auto *last = (const half4*)(tex->data.cdata() + tex->getMipOffset(tex->mip_count - 1));
+    Expect(near_equal((float)last->y, 0.5f) && (float)last->w == 1.0f);
+
+    // to BC7 via RGBAu8, and decoded back
+    Expect(tex->convert(ms::TextureFormat::BC7));
+    Expect(tex->format == ms::TextureFormat::BC7);
+    Expect(tex->convert(ms::TextureFormat::Ru8));
+    Expect(tex->data.size() == ms::GetTextureDataSize(ms::TextureFormat::Ru8, 16, 8, tex->mip_count));
+    Expect(std::abs((int)(uint8_t)tex->data[0] - 64) <= 2);
+
+    Expect(!tex->convert(ms::TextureFormat::RawFile));
+}
+
+TestCase(Test_TextureManager)
+{
+    Expect(ms::Hash64(nullptr, 0) == 0xEF46DB3751D8E999ull);
+
+    const char *path = "Test_TextureManager.bin";
+    RawVector<char> data(1000);
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = (char)i;
+    ms::ByteArrayToFile(path, data);
+
+    ms::TextureManager tm;
+    int id = tm.addFile(path, ms::TextureType::Default);
+    Expect(id != ms::InvalidID);
+    Expect(tm.getDirtyTextures().size() == 1);
+    tm.clearDirtyFlags();
+
+    // rewritten with the same contents. mtime may change but contents don't
+    ms::ByteArrayToFile(path, data);
+    Expect(tm.addFile(path, ms::TextureType::Default) == id);
+    Expect(tm.getDirtyTextures().empty());
+
+    data[500] = 0;
+    ms::ByteArrayToFile(path, data);
+    tm.addFile(path, ms::TextureType::Default);
+    auto dirty = tm.getDirtyTextures();
+    Expect(dirty.size() == 1 && dirty[0]->data.size() == 1000 && dirty[0]->data[500] == 0);
+    std::remove(path);
+}
+
+TestCase(Test_EntityManager)
+{
+    const int N = 1000;
+    ms::EntityManager em;
+    for (int i = 0; i < N; ++i) {
+        auto t = ms::Transform::create();
+        t->path = "/e" + std::to_string(N - i);
+        t->host_id = 100 + i;
+        em.add(t);
+    }
+    auto all = em.getAllEntities();
+    Expect(all.size() == N && all.front()->path == "/e1000" && all.back()->path == "/e1");
+    Expect(em.getDirtyTransforms().size() == N);
+    em.clearDirtyFlags();
+
+    Expect(em.erase(100 + 5));                               // by host id
+    Expect(em.erase(ms::Identifier("/e10", ms::InvalidID)));     // by path
+    Expect(em.erase(ms::Identifier("unknown", 100 + 20)));   // falls back to host id
+    Expect(!em.erase(100 + 5));
+    Expect(em.getDeleted().size() == 3);
+
+    // re-added entities are no longer deleted
+    auto t = ms::Transform::create();
+    t->path = "/e10";
+    t->host_id = 5000;
+    em.add(t);
+    Expect(em.getDeleted().size() == 2);
+    Expect(em.erase(5000) && em.getDeleted().size() == 3);
+    Expect(em.getAllEntities().size() == N - 3);
+}
+
+TestCase(Test_EntityManagerChecksums)
+{
+    // many small meshes are batched, large ones get their own task
+    const int N = 200;
+    auto make_mesh = [](int i, size_t num_points) {
+        auto mesh = ms::Mesh::create();
+        mesh->path = "/mesh" + std::to_string(i);
+        mesh->points.resize(num_points, float3{ (float)i, 0.0f, 0.0f });
+        return mesh;
+    };
+
+    ms::EntityManager em;
+    std::vector<ms::MeshPtr> meshes;
+    for (int i = 0; i < N; ++i) {
+        meshes.push_back(make_mesh(i, i == 0 ? 100000 : 100));
+        em.add(meshes.back());
+    }
+    Expect(em.getDirtyGeometries().size() == N);
+    em.clearDirtyFlags();
+
+    // same contents. nothing is dirty
+    for (int i = 0; i < N; ++i)
+        em.add(make_mesh(i, i == 0 ? 100000 : 100));
+    Expect(em.getDirtyGeometries().empty() && em.getDirtyTransforms().empty());
+
+    // geometry change and transform-only change
+    auto m0 = make_mesh(0, 100000);
+    m0->points[50000].y = 1.0f;
+    em.add(m0);
+    auto m1 = make_mesh(1, 100);
+    m1->position.x = 1.0f;
+    em.add(m1);
+    auto m2 = make_mesh(2, 100);
+    m2->points[0].z = 1.0f;
+    em.add(m2);
+    auto geoms = em.getDirtyGeometries();
+    auto trans = em.getDirtyTransforms();
+    Expect(geoms.size() == 2 && geoms[0]->path == "/mesh0" && geoms[1]->path == "/mesh2");
+    Expect(trans.size() == 1 && trans[0]->path == "/mesh1");
+    em.clearDirtyFlags();
+
+    // erasing a record that is still waiting in the batch must not deadlock
+    auto m3 = make_mesh(N, 100);
+    em.add(m3);
+    Expect(em.eraseThreadSafe(m3));
+    Expect(em.getDirtyGeometries().empty());
+    Expect(em.getDeleted().size() == 1);
+}
+
+TestCase(Test_TextureTiles)
+{
+    const int width = 100, height = 70, tile_size = 32;
+    RawVector<unorm8x4> pixels(width * height);
+    for (int i = 0; i < width * height; ++i)
+        pixels[i] = unorm8x4{ (i % width) / (float)width, (i / width) / (float)height, 0.0f, 1.0f };
+    auto format = ms::TextureFormat::RGBAu8;
+    size_t size = pixels.size() * sizeof(unorm8x4);
+
+    ms::TextureManager tm;
+    tm.setTileSize(tile_size);
+    int id = tm.addImage("Test_TextureTiles", width, height, pixels.cdata(), size, format);
+    Expect(tm.getDirtyTextures().size() == 1 && tm.getDirtyTiles().empty());
+    // TextureManager makes a new Texture for each update. this one stays as the receiver's copy
+    auto base = tm.getDirtyTextures()[0];
+    tm.clearDirtyFlags();
+
+    // brush strokes on two tiles. one of them is a clipped edge tile
+    pixels[width * 5 + 40] = unorm8x4{ 1.0f, 0.0f, 0.0f, 1.0f };
+    pixels[width * 69 + 99] = unorm8x4{ 0.0f, 1.0f, 0.0f, 1.0f };
+    Expect(tm.addImage("Test_TextureTiles", width, height, pixels.cdata(), size, format) == id);
+    Expect(tm.getDirtyTextures().empty());
+    auto tiles = tm.getDirtyTiles();
+    Expect(tiles.size() == 1 && tiles[0].texture_id == id && tiles[0].tiles.size() == 2);
+    if (tiles.size() != 1)
+        return;
+    Expect(tiles[0].tiles[1].x == 96 && tiles[0].tiles[1].width == 4 && tiles[0].tiles[1].height == 6);
+    // the whole texture to resend if the receiver can't apply the tiles
+    Expect(tiles[0].source && tiles[0].source->id == id && memcmp(tiles[0].source->data.cdata(), pixels.cdata(), size) == 0);
+
+    MemoryStream stream;
+    tiles[0].serialize(stream);
+    stream.flush();
+    ms::TextureTiles received;
+    received.deserialize(stream);
+
+    Expect(received.apply(*base));
+    Expect(memcmp(base->data.cdata(), pixels.cdata(), size) == 0);
+    tm.clearDirtyFlags();
+    Expect(tm.getDirtyTiles().empty());
+
+    // reported lost by the receiver: the next stroke is sent as the whole texture
+    Expect(tm.makeDirty(id) && !tm.makeDirty(id + 1));
+    pixels[width * 6 + 40] = unorm8x4{ 0.0f, 0.0f, 1.0f, 1.0f };
+    tm.addImage("Test_TextureTiles", width, height, pixels.cdata(), size, format);
+    Expect(tm.getDirtyTextures().size() == 1 && tm.getDirtyTiles().empty());
+    tm.clearDirtyFlags();
+
+    // layout change falls back to the whole texture
+    tm.addImage("Test_TextureTiles", width, height / 2, pixels.cdata(), size / 2, format);
+    Expect(tm.getDirtyTextures().size() == 1 && tm.getDirtyTiles().empty());
+}
+
+
+TestCase(Test_MaterialDelta)
+{
+    auto make_material = [](float smoothness, const char *shader) {
+        auto ret = ms::Material::create();
+        ret->id = 1;
+        ret->name = "Test_MaterialDelta";
+        ret->shader = shader;
+        ret->addProperty({ "_Color", float4{ 1.0f, 0.5f, 0.25f, 1.0f } });
+        ret->addProperty({ "_Glossiness", smoothness });
+        ret->addProperty({ "_Metallic", 0.0f });
+        ret->addKeyword({ "_NORMALMAP", true });
+        return ret;
+    };
+
+    // name index
+    {
+        auto mat = make_material(0.5f, "Standard");
+        Expect(mat->findProperty("_Glossiness") == &mat->properties[1]);
+        Expect(mat->findProperty("_Unknown") == nullptr);
+        mat->properties[1].name = "_Smoothness";
+        mat->clearIndices();
+        Expect(mat->findProperty("_Smoothness") == &mat->properties[1]);
+        mat->eraseProperty("_Color");
+        Expect(mat->getPropertyCount() == 2 && mat->findProperty("_Metallic") == &mat->properties[1]);
+
+        // const lookups don't rebuild the index
+        const ms::Material& cmat = *mat;
+        mat->properties.push_back({ "_BumpScale", 1.0f });
+        Expect(cmat.findProperty("_BumpScale") == &mat->properties[2]);
+        Expect(cmat.findProperty("_Metallic") == &mat->properties[1]);
+
+        auto copy = mat->clone();
+        Expect(*copy == *mat && copy->findProperty("_BumpScale") == &copy->properties[2]);
+        copy->addProperty({ "_Metallic", 1.0f });
+        Expect(mat->findProperty("_Metallic")->get<float>() == 0.0f);
+    }
+
+    ms::MaterialManager mm;
+    mm.setUseDeltas(true);
+    auto base = make_material(0.5f, "Standard");
+    mm.add(base);
+    Expect(mm.getDirtyMaterials().size() == 1 && mm.getMaterialDeltas().empty());
+    mm.clearDirtyFlags();
+
+    // one property changed
+    auto current = make_material(0.8f, "Standard");
+    mm.add(current);
+    Expect(mm.getDirtyMaterials().empty());
+    ms::MaterialDeltaMessage mes;
+    mes.materials = mm.getMaterialDeltas();
+    Expect(mes.materials.size() == 1);
+    if (mes.materials.size() != 1)
+        return;
+    Expect(mes.materials[0]->getPropertyCount() == 1 && mes.materials[0]->findProperty("_Glossiness"));
+
+    MemoryStream stream;
+    mes.serialize(stream);
+    stream.flush();
+    ms::MaterialDeltaMessage received;
+    received.deserialize(stream);
+    Expect(received.materials.size() == 1);
+    if (received.materials.size() != 1)
+        return;
+    base->merge(*received.materials[0]);
+    Expect(*base == *current);
+    mm.clearDirtyFlags();
+    Expect(mm.getMaterialDeltas().empty());
+
+    // shader change falls back to the whole material
+    mm.add(make_material(0.8f, "Unlit/Color"));
+    Expect(mm.getDirtyMaterials().size() == 1 && mm.getMaterialDeltas().empty());
+    mm.clearDirtyFlags();
+
+    // the first change after switching delta mode sends the whole material
+    mm.setUseDeltas(false);
+    mm.setUseDeltas(true);
+    mm.add(make_material(0.2f, "Unlit/Color"));
+    Expect(mm.getDirtyMaterials().size() == 1 && mm.getMaterialDeltas().empty());
+}
+
+TestCase(Test_IDGenerator)
+{
+    const int num_objects = 100000;
+    RawVector<char> objects(num_objects);
+
+    ms::IDGenerator<char*> ids;
+    Expect(ids.getID(nullptr) == 0);
+    int id0 = ids.getID(&objects[0]);
+    int id1 = ids.getID(&objects[1]);
+    Expect(id0 != id1 && ids.getID(&objects[0]) == id0);
+
+    // objects[1] is not referenced in this export. its ID is recycled
+    ids.clearDirtyFlags();
+    Expect(ids.getID(&objects[0]) == id0);
+    ids.eraseStaleRecords();
+    Expect(ids.getID(&objects[2]) == id1);
+
+    ms::PathToID paths;
+    int pid = paths["/root/child"];
+    Expect(paths["/root/child"] == pid && paths["/root"] != pid);
+    paths.rename("/root/child", "/root/renamed");
+    Expect(paths["/root/renamed"] == pid);
+
+    // a typical export cycle: query every object, then drop stale ones
+    Print("    num_objects: %d\n", num_objects);
+    ids.clear();
+    TestScope("IDGenerator cycle", [&]() {
+        ids.clearDirtyFlags();
+        for (int i = 0; i < num_objects; ++i)
+            ids.getID(&objects[i]);
+        ids.eraseStaleRecords();
+    }, 10);
+    Expect(ids.getID(&objects[num_objects - 1]) <= num_objects);
+
+    std::vector<std::string> names(num_objects);
+    for (int i = 0; i < num_objects; ++i)
+        names[i] = "/root/group" + std::to_string(i / 100) + "/object" + std::to_string(i);
+    paths.clear();
+    TestScope("PathToID lookup", [&]() {
+        for (auto& n : names)
+            paths[n];
+    }, 10);
+    Expect(paths[names[0]] == 1);
+}
+
+TestCase(Test_MeshDescriptor)
+{
+    auto scene = ms::Scene::create();
+    scene->entities.push_back(ms::Transform::create());
+
+    auto wave = ms::Mesh::create();
+    GenerateWaveMesh(wave->counts, wave->indices, wave->points, wave->uv0, 2.0f, 1.0f, 8, 0.0f);
+    wave->submeshes.push_back({ (int)wave->indices.size(), 0, ms::Topology::Quads, 1 });
+    wave->setupDataFlags();
+    scene->entities.push_back(wave);
+
+    auto skinned = ms::Mesh::create();
+    skinned->points.resize(3, float3::zero());
+    skinned->indices = { 0, 1, 2 };
+    skinned->submeshes.push_back({ 3, 0, ms::Topology::Triangles, 2 });
+    skinned->addBone("/root/bone0")->bindpose = float4x4::identity();
+    skinned->addBone("/root/bone1")->bindpose = mu::translate(float3{ 1.0f, 2.0f, 3.0f });
+    scene->entities.push_back(skinned);
+
+    ms::MeshDescriptorTable table;
+    Expect(table.build(*scene) == 2);
+    if (table.size() != 2)
+        return;
+
+    auto& d0 = table.data()[0];
+    Expect(d0.mesh == wave.get() && d0.num_points == (int)wave->points.size() && d0.points == wave->points.cdata());
+    Expect(d0.num_submeshes == 1 && d0.submeshes[0].topology == ms::Topology::Quads && d0.submeshes[0].material_id == 1);
+    Expect(d0.num_bones == 0 && d0.normals == nullptr);
+
+    auto& d1 = table.data()[1];
+    Expect(d1.mesh == skinned.get() && d1.num_bones == 2);
+    Expect(strcmp(d1.bone_paths[0], "/root/bone0") == 0 && strcmp(d1.bone_paths[1], "/root/bone1") == 0);
+
+    // all attributes in one call
+    RawVector<float3> points(d0.num_points);
+    RawVector<float2> uv(d0.num_points);
+    RawVector<int> indices(d0.num_indices);
+    ms::MeshBuffers buf{};
+    buf.points = points.data();
+    buf.uv0 = uv.data();
+    buf.indices = indices.data();
+    ms::MeshDescriptorTable::read(d0, buf);
+    Expect(points == wave->points.as_raw() && uv == wave->uv0.as_raw() && indices == wave->indices.as_raw());
+
+    RawVector<float4x4> bindposes(d1.num_bones);
+    buf = {};
+    buf.bindposes = bindposes.data();
+    ms::MeshDescriptorTable::read(d1, buf);
+    Expect(bindposes[1] == skinned->bones[1]->bindpose);
+}
+
+TestCase(Test_MeshPrecision)
+{
+    auto src = ms::Mesh::create();
+    src->path = "/Test_MeshPrecision";
+    GenerateIcoSphereMesh(src->counts, src->indices, src->points, src->uv0, 2.0f, 3);
+    for (auto& p : src->points) {
+        auto n = mu::normalize(p);
+        src->normals.push_back(n);
+        auto t = mu::normalize(mu::cross(n, float3{ 0.27f, 0.53f, 0.8f }));
+        src->tangents.push_back({ t.x, t.y, t.z, -1.0f });
+    }
+    src->setupDataFlags();
+
+    size_t last_size = 0;
+    auto round_trip = [&last_size](ms::MeshPtr src, ms::MeshPrecision precision) {
+        auto mesh = std::static_pointer_cast<ms::Mesh>(src->clone());
+        mesh->md_flags.precision = (uint32_t)precision;
+        auto scene = ms::Scene::create();
+        scene->entities.push_back(mesh);
+
+        MemoryStream stream;
+        scene->serialize(stream);
+        stream.flush();
+        last_size = (size_t)stream.getWCount();
+        Print("  precision %d: %d bytes\n", (int)precision, (int)last_size);
+
+        auto received = ms::Scene::create();
+        received->deserialize(stream); // throws if the hash doesn't match
+        // received data point into the stream's buffer
+        auto ret = std::static_pointer_cast<ms::Mesh>(received->entities[0]);
+        ret->detach();
+        return ret;
+    };
+    auto max_error = [](const auto& a, const auto& b) {
+        float ret = 0.0f;
+        for (size_t i = 0; i < a.size(); ++i)
+            ret = std::max(ret, mu::length(a[i] - b[i]));
+        return ret;
+    };
+
+    auto full = round_trip(src, ms::MeshPrecision::Full);
+    Expect(full->points == src->points && full->normals == src->normals && full->tangents == src->tangents && full->uv0 == src->uv0);
+
+    // levels get smaller and less accurate in order
+    size_t prev_size = last_size;
+    float prev_edir = 0.0f;
+    for (auto precision : { ms::MeshPrecision::Bounded, ms::MeshPrecision::BoundedPacked }) {
+        auto mesh = round_trip(src, precision);
+        Expect(last_size < prev_size);
+        prev_size = last_size;
+        Expect(mesh->points.size() == src->points.size() && mesh->indices == src->indices);
+        float ep = max_error(mesh->points, src->points);
+        float en = max_error(mesh->normals, src->normals);
+        float et = max_error(mesh->tangents, src->tangents);
+        float eu = max_error(mesh->uv0, src->uv0);
+        Print("  precision %d: error points %f normals %f tangents %f uv %f\n", (int)precision, ep, en, et, eu);
+        // half (Bounded) for normals and tangents. snormx3_32 (BoundedPacked) restores z from x and y
+        float edir = precision == ms::MeshPrecision::Bounded ? 0.002f : 0.02f;
+        Expect(ep < 0.002f && en < edir && et < edir && eu < 0.001f);
+        Expect(std::max(en, et) >= prev_edir);
+        prev_edir = std::max(en, et);
+    }
+
+    // far from the origin. points are quantized in their bounds, so the error depends only on the size of the mesh
+    auto far = std::static_pointer_cast<ms::Mesh>(src->clone(true));
+    for (auto& p : far->points)
+        p += float3{ 100.0f, -5000.0f, 100000.0f };
+    for (auto precision : { ms::MeshPrecision::Full, ms::MeshPrecision::Bounded, ms::MeshPrecision::BoundedPacked }) {
+        auto mesh = round_trip(far, precision);
+        float ep = max_error(mesh->points, far->points);
+        Print("  precision %d: error points %f (far from the origin)\n", (int)precision, ep);
+        // the mesh spans 4 units, so 16 bit per component gives ~0.0001. (half can't even represent 100000)
+        Expect(precision == ms::MeshPrecision::Full ? ep == 0.0f : ep < 0.001f);
+    }
+}
+
+TestCase(Test_EntityTable)
+{
+    auto scene = ms::Scene::create();
+    const int num = 50000;
+    {
+        auto root = ms::Transform::create();
+        root->path = "/root";
+        root->host_id = 100;
+        scene->entities.push_back(root);
+    }
+    for (int i = 1; i < num; ++i) {
+        auto e = i % 2 ? ms::Transform::create() : ms::Mesh::create();
+        char path[64];
+        sprintf(path, "/root/child%d", i);
+        e->path = path;
+        e->position = { (float)i, 0.0f, 0.0f };
+        e->scale = float3::one();
+        // every 4th entity is unchanged
+        e->td_flags.unchanged = i % 4 == 1;
+        scene->entities.push_back(e);
+    }
+
+    ms::EntityTable table;
+    size_t paths_size = 0;
+    TestScope("EntityTable::build", [&]() {
+        table.build(*scene);
+        paths_size = table.getPathsSize();
+    }, 10);
+    Expect(table.size() == num);
+
+    std::vector<int> types(num), host_ids(num), parents(num), path_offsets(num + 1);
+    std::vector<float3> positions(num);
+    std::vector<char> paths(paths_size);
+    ms::EntityArrays dst{};
+    dst.types = types.data();
+    dst.host_ids = host_ids.data();
+    dst.parents = parents.data();
+    dst.positions = positions.data();
+    dst.path_offsets = path_offsets.data();
+    dst.paths = paths.data();
+    TestScope("EntityTable::fill", [&]() {
+        table.fill(dst);
+    }, 10);
+
+    Expect(host_ids[0] == 100 && parents[0] == -1);
+    Expect(types[1] == (int)ms::EntityType::Transform && types[2] == (int)ms::EntityType::Mesh);
+    Expect(parents[1] == 0 && parents[num - 1] == 0);
+    Expect(positions[123].x == 123.0f);
+    Expect(strcmp(&paths[path_offsets[0]], "/root") == 0 && strcmp(&paths[path_offsets[7]], "/root/child7") == 0);
+
+    // changed only. the root is in the table, so parents still resolve
+    std::vector<int> entity_indices(num);
+    table.build(*scene, ms::EntityTable::Filter::Changed);
+    Expect(table.size() == num - (num + 2) / 4);
+    dst = {};
+    dst.entity_indices = entity_indices.data();
+    dst.parents = parents.data();
+    table.fill(dst);
+    Expect(entity_indices[1] == 2 && entity_indices[4] == 6 && parents[4] == 0);
+}
+
+
+TestCase(Test_Culling)
+{
+    auto make_quad = [](float3 pos, float half_size) {
+        auto ret = ms::Mesh::create();
+        ret->points = {
+            { -half_size, -half_size, 0.0f }, { half_size, -half_size, 0.0f },
+            { half_size, half_size, 0.0f }, { -half_size, half_size, 0.0f } };
+        ret->counts = { 4 };
+        ret->indices = { 0, 1, 2, 3 };
+        ret->refine_settings.local2world = mu::translate(pos);
+        return ret;
+    };
+
+    // camera at the origin looking at -Z. 60 degrees fov, OpenGL style projection.
+    float f = 1.0f / std::tan(30.0f * mu::DegToRad), zn = 0.1f, zf = 100.0f;
+    float4x4 proj = float4x4::zero();
+    proj[0][0] = f;
+    proj[1][1] = f;
+    proj[2][2] = (zf + zn) / (zn - zf);
+    proj[2][3] = -1.0f;
+    proj[3][2] = 2.0f * zf * zn / (zn - zf);
+
+    std::vector<ms::MeshPtr> meshes = {
+        make_quad({ 0.0f, 0.0f, -5.0f }, 2.0f),     // occluder
+        make_quad({ 0.0f, 0.0f, -10.0f }, 0.5f),    // behind the occluder
+        make_quad({ 100.0f, 0.0f, -10.0f }, 0.5f),  // outside of the frustum
+        make_quad({ 0.0f, 0.0f, 10.0f }, 0.5f),     // behind the camera
+        make_quad({ 5.0f, 0.0f, -10.0f }, 0.5f),    // next to the occluder
+    };
+    std::vector<const ms::Mesh*> ptrs;
+    for (auto& m : meshes)
+        ptrs.push_back(m.get());
+
+    ms::CullingSettings settings;
+    settings.view_proj = proj;
+    bool visible[5];
+    Expect(ms::CullMeshes(settings, ptrs.data(), ptrs.size(), visible) == 3);
+    Expect(visible[0] && visible[1] && !visible[2] && !visible[3] && visible[4]);
+
+    settings.occlusion = true;
+    Expect(ms::CullMeshes(settings, ptrs.data(), ptrs.size(), visible) == 2);
+    Expect(visible[0] && !visible[1] && !visible[2] && !visible[3] && visible[4]);
+}
+
+TestCase(Test_Raycast)
+{
+    // 16 spheres and a wave in a grid
+    std::vector<ms::MeshPtr> meshes;
+    for (int i = 0; i < 16; ++i) {
+        auto mesh = ms::Mesh::create();
+        mesh->path = "/sphere" + std::to_string(i);
+        mesh->host_id = i;
+        GenerateIcoSphereMesh(mesh->counts, mesh->indices, mesh->points, mesh->uv0, 0.5f, 3);
+        mesh->refine_settings.local2world = mu::translate(float3{ float(i % 4) * 2.0f, 0.0f, float(i / 4) * 2.0f });
+        meshes.push_back(mesh);
+    }
+    {
+        auto mesh = ms::Mesh::create();
+        mesh->path = "/wave";
+        mesh->host_id = 100;
+        GenerateWaveMesh(mesh->counts, mesh->indices, mesh->points, mesh->uv0, 10.0f, 0.2f, 64, 0.0f);
+        mesh->refine_settings.local2world = mu::translate(float3{ 3.0f, -1.0f, 3.0f });
+        meshes.push_back(mesh);
+    }
+    std::vector<const ms::Mesh*> ptrs;
+    for (auto& m : meshes)
+        ptrs.push_back(m.get());
+
+    ms::RaycastScene scene;
+    TestScope("RaycastScene::update (build)", [&]() {
+        scene.clear();
+        scene.update(ptrs.data(), ptrs.size());
+    });
+    TestScope("RaycastScene::update (no changes)", [&]() {
+        scene.update(ptrs.data(), ptrs.size());
+    });
+    Expect(scene.size() == meshes.size());
+
+    // rays shooting down from above the grid
+    const int num_rays = 4096;
+    RawVector<float3> pos(num_rays), dir(num_rays);
+    for (int i = 0; i < num_rays; ++i) {
+        pos[i] = { float(i % 64) * 0.12f - 0.5f, 5.0f, float(i / 64) * 0.12f - 0.5f };
+        dir[i] = normalize(float3{ 0.05f, -1.0f, 0.02f });
+    }
+    RawVector<ms::RaycastHit> hits(num_rays);
+    TestScope("RaycastScene::raycast 4096 rays", [&]() {
+        scene.raycast(pos.cdata(), dir.cdata(), num_rays, FLT_MAX, hits.data());
+    }, 10);
+
+    // compare with brute force
+    std::vector<RawVector<float3>> world_triangles;
+    for (auto& m : meshes) {
+        RawVector<float3> tris;
+        int offset = 0;
+        for (int count : m->counts) {
+            for (int ci = 2; ci < count; ++ci) {
+                tris.push_back(mul_p(m->refine_settings.local2world, m->points[m->indices[offset]]));
+                tris.push_back(mul_p(m->refine_settings.local2world, m->points[m->indices[offset + ci - 1]]));
+                tris.push_back(mul_p(m->refine_settings.local2world, m->points[m->indices[offset + ci]]));
+            }
+            offset += count;
+        }
+        world_triangles.push_back(std::move(tris));
+    }
+    int num_hits = 0, num_mismatches = 0;
+    for (int i = 0; i < num_rays; ++i) {
+        int host_id = ms::InvalidID, ti;
+        float nearest = FLT_MAX, d;
+        for (size_t mi = 0; mi < meshes.size(); ++mi) {
+            auto& tris = world_triangles[mi];
+            if (RayTrianglesIntersectionFlattened(pos[i], dir[i], tris.cdata(), (int)tris.size() / 3, ti, d) && d < nearest) {
+                nearest = d;
+                host_id = meshes[mi]->host_id;
+            }
+        }
+        if (host_id != ms::InvalidID)
+            ++num_hits;
+        if (hits[i].host_id != host_id || (host_id != ms::InvalidID && std::abs(hits[i].distance - nearest) > 1e-3f))
+            ++num_mismatches;
+    }
+    Print("    %d hits, %d mismatches\n", num_hits, num_mismatches);
+    Expect(num_hits > 0 && num_mismatches == 0);
+
+    // closest point. a point above the center of sphere 5 (at (2, 0, 2), radius 0.5)
+    auto cp = scene.closestPoint({ 2.0f, 3.0f, 2.0f });
+    Expect(cp.host_id == 5 && std::abs(cp.distance - 2.5f) < 0.01f);
+    cp = scene.closestPoint({ 2.0f, 3.0f, 2.0f }, 1.0f);
+    Expect(cp.host_id == ms::InvalidID);
+
+    // moving a mesh doesn't need to rebuild its BVH
+    meshes[5]->refine_settings.local2world = mu::translate(float3{ 2.0f, 2.0f, 2.0f });
+    scene.update(ptrs.data(), ptrs.size());
+    cp = scene.closestPoint({ 2.0f, 3.0f, 2.0f });
+    Expect(cp.host_id == 5 && std::abs(cp.distance - 0.5f) < 0.01f);
+
+    // removed meshes are dropped
+    scene.update(ptrs.data(), 4);
+    Expect(scene.size() == 4);
+}
+
+TestCase(Test_SceneRecorder)
+{
+    const char *path = "recorder.sc";
+    ms::SceneRecorder recorder;
+    Expect(recorder.open(path));
+    if (!recorder.valid())
+        return;
+
+    const mu::nanosec second = 1000000000;
+    const mu::nanosec t0 = mu::Now();
+    size_t num_points = 0;
+
+    // retained assets. bases of the deltas of session 1
+    auto mat = ms::Material::create();
+    mat->id = 1;
+    mat->name = "Test_SceneRecorder";
+    mat->addProperty({ "_Glossiness", 0.25f });
+
+    const int tex_size = 8;
+    auto tex = ms::Texture::create();
+    tex->id = 2;
+    tex->format = ms::TextureFormat::RGBAu8;
+    tex->width = tex->height = tex_size;
+    tex->data.resize_zeroclear(tex_size * tex_size * 4);
+
+    // session 0: full data
+    {
+        auto scene = ms::Scene::create();
+        auto wave = ms::Mesh::create();
+        wave->path = "/Wave";
+        wave->id = 3; // same as the host id of the cube. entities are deleted by host id
+        wave->host_id = 1;
+        GenerateWaveMesh(wave->counts, wave->indices, wave->points, wave->uv0, 2.0f, 1.0f, 32, 0.0f);
+        wave->setupDataFlags();
+        num_points = wave->points.size();
+        scene->entities.push_back(wave);
+
+        auto sphere = ms::Mesh::create();
+        sphere->path = "/Sphere";
+        sphere->host_id = 2;
+        GenerateIcoSphereMesh(sphere->counts, sphere->indices, sphere->points, sphere->uv0, 0.5f, 2);
+        sphere->setupDataFlags();
+        scene->entities.push_back(sphere);
+
+        auto cube = ms::Transform::create();
+        cube->path = "/Cube";
+        cube->host_id = 3;
+        scene->entities.push_back(cube);
+
+        scene->assets = { mat, tex };
+        recorder.addScene(scene, true);
+        recorder.endScene(t0);
+    }
+    // session 1: only the transform of the wave, a property of the material and a tile of the texture have changed
+    {
+        auto scene = ms::Scene::create();
+        auto wave = ms::Mesh::create();
+        wave->path = "/Wave";
+        wave->host_id = 1;
+        wave->position = { 1.0f, 2.0f, 3.0f };
+        wave->setupDataFlags();
+        wave->md_flags.unchanged = 1;
+        scene->entities.push_back(wave);
+        recorder.addScene(scene, true);
+
+        auto delta = ms::Material::create();
+        delta->id = 1;
+        delta->name = "Test_SceneRecorder";
+        delta->addProperty({ "_Glossiness", 0.5f });
+        recorder.addMaterialDeltas({ delta });
+
+        ms::TextureTiles tt;
+        {
+            auto painted = ms::Texture::create();
+            *painted = *tex;
+            painted->data.detach();
+            painted->data[(tex_size * 3 + 3) * 4] = (char)255;
+            tt.texture_id = tex->id;
+            tt.format = tex->format;
+            tt.width = tt.height = tex_size;
+            tt.addTile(*painted, 2, 2, 4, 4);
+        }
+        recorder.addTextureTiles({ tt });
+        recorder.endScene(t0 + second / 2);
+    }
+    // session 2: the sphere is deleted by name and the cube by id
+    {
+        recorder.deleteEntities({ ms::Identifier("/Sphere", ms::InvalidID), ms::Identifier("", 3) });
+        recorder.endScene(t0 + second);
+    }
+    recorder.close();
+    Print("    %d scenes recorded, %d coalesced\n", recorder.getSceneCountRecorded(), recorder.getSceneCountCoalesced());
+    Expect(!recorder.valid());
+    // fewer sessions than the queue sizes. none are coalesced
+    Expect(recorder.getSceneCountRecorded() == 3 && recorder.getSceneCountCoalesced() == 0);
+    // the deltas are applied to the recorder's copies
+    Expect(mat->findProperty("_Glossiness")->get<float>() == 0.25f);
+    Expect(tex->data[(tex_size * 3 + 3) * 4] == 0);
+
+    ms::ISceneCacheSettings iscs;
+    iscs.enable_diff = false;
+    auto isc = ms::OpenISceneCacheFile(path, iscs);
+    Expect(isc);
+    if (!isc)
+        return;
+
+    int num_scenes = (int)isc->getNumScenes();
+    Expect(num_scenes == 3);
+    if (num_scenes != 3)
+        return;
+    Expect(std::abs(isc->getTime(2) - 1.0f) < 0.001f);
+
+    auto mid = isc->getByIndex(1);
+    Expect(mid && mid->entities.size() == 3);
+    if (mid) {
+        auto mats = mid->getAssets<ms::Material>();
+        Expect(mats.size() == 1);
+        if (mats.size() == 1) {
+            auto *prop = mats[0]->findProperty("_Glossiness");
+            Expect(prop && prop->get<float>() == 0.5f);
+        }
+        auto texs = mid->getAssets<ms::Texture>();
+        Expect(texs.size() == 1);
+        if (texs.size() == 1)
+            Expect((uint8_t)texs[0]->data[(tex_size * 3 + 3) * 4] == 255);
+    }
+
+    auto last = isc->getByIndex(2);
+    Expect(last && last->entities.size() == 1);
+    if (last && last->entities.size() == 1) {
+        auto& wave = static_cast<ms::Mesh&>(*last->entities[0]);
+        Expect(wave.path == "/Wave");
+        Expect(wave.points.size() == num_points);
+        Expect(near_equal(wave.position, float3{ 1.0f, 2.0f, 3.0f }));
+    }
+}
+
+TestCase(Test_SceneRecorderCoalesce)
+{
+    // sessions never wait for the recording thread. if it is behind, they are coalesced into one scene
+    const char *path = "recorder_coalesce.sc";
+    ms::SceneRecorderSettings settings;
+    settings.max_queue_size = 1;
+    ms::SceneRecorder recorder;
+    Expect(recorder.open(path, settings));
+    if (!recorder.valid())
+        return;
+
+    const int num_sessions = 100;
+    const mu::nanosec t0 = mu::Now();
+    size_t num_points = 0;
+    for (int i = 0; i < num_sessions; ++i) {
+        auto scene = ms::Scene::create();
+        auto wave = ms::Mesh::create();
+        wave->path = "/Wave";
+        wave->position = { (float)i, 0.0f, 0.0f };
+        if (i == 0) {
+            GenerateWaveMesh(wave->counts, wave->indices, wave->points, wave->uv0, 2.0f, 1.0f, 32, 0.0f);
+            num_points = wave->points.size();
+        }
+        wave->setupDataFlags();
+        wave->md_flags.unchanged = i != 0;
+        scene->entities.push_back(wave);
+        recorder.addScene(scene, false);
+        recorder.endScene(t0 + 10000000LL * i);
+    }
+    recorder.close();
+    int recorded = recorder.getSceneCountRecorded();
+    int coalesced = recorder.getSceneCountCoalesced();
+    Print("    %d scenes recorded, %d coalesced\n", recorded, coalesced);
+    Expect(recorded >= 1 && recorded + coalesced >= num_sessions);
+
+    ms::ISceneCacheSettings iscs;
+    iscs.enable_diff = false;
+    auto isc = ms::OpenISceneCacheFile(path, iscs);
+    Expect(isc && (int)isc->getNumScenes() == recorded);
+    if (!isc)
+        return;
+    auto last = isc->getByIndex(isc->getNumScenes() - 1);
+    Expect(last && last->entities.size() == 1);
+    if (last && last->entities.size() == 1) {
+        auto& wave = static_cast<ms::Mesh&>(*last->entities[0]);
+        Expect(wave.points.size() == num_points);
+        Expect(near_equal(wave.position, float3{ (float)(num_sessions - 1), 0.0f, 0.0f }));
+    }
+}
+
+TestCase(Test_Relay)
+{
+    // serialize messages once, then fan them out.
+    // frames as AsyncSceneSender sends them: SceneBegin, Sets, Delete, TextureTiles and SceneEnd.
+    // every frame updates the same entities, so consumers that fall behind get coalesced frames.
+    const int num_frames = 16, num_sets = 3;
+    std::vector<ms::RelayPacketPtr> packets;
+    auto add_packet = [&](ms::Message& mes, int session_id, ms::Message::Type type, const char *uri) {
+        mes.session_id = session_id;
+        auto packet = std::make_shared<ms::RelayPacket>();
+        packet->type = type;
+        packet->uri = uri;
+        mu::MemoryStream os;
+        mes.serialize(os);
+        os.flush();
+        packet->data.assign(os.getBuffer().cdata(), os.getBuffer().cdata() + os.getWCount());
+        packets.push_back(packet);
+    };
+    int num_set_messages = 0;
+    for (int fi = 0; fi < num_frames; ++fi) {
+        int session_id = fi + 1;
+        ms::FenceMessage begin;
+        begin.type = ms::FenceMessage::FenceType::SceneBegin;
+        add_packet(begin, session_id, ms::Message::Type::Fence, "fence");
+
+        for (int si = 0; si < num_sets; ++si) {
+            auto mesh = ms::Mesh::create();
+            mesh->path = "/relay" + std::to_string(si);
+            mesh->position = { (float)fi, 0.0f, 0.0f };
+            GenerateIcoSphereMesh(mesh->counts, mesh->indices, mesh->points, mesh->uv0, 0.5f, 1);
+            mesh->setupDataFlags();
+
+            ms::SetMessage mes;
+            mes.message_id = num_set_messages++;
+            mes.scene = ms::Scene::create();
+            mes.scene->entities.push_back(mesh);
+            add_packet(mes, session_id, ms::Message::Type::Set, "set");
+        }
+        {
+            // the geometry is sent every 4 frames. only the transform in between, as EntityManager does
+            ms::TransformPtr geom;
+            if (fi % 4 == 0) {
+                auto mesh = ms::Mesh::create();
+                GenerateIcoSphereMesh(mesh->counts, mesh->indices, mesh->points, mesh->uv0, 0.5f, 1 + (fi / 4) % 2);
+                geom = mesh;
+            }
+            else
+                geom = ms::Transform::create();
+            geom->path = "/relay_geom";
+            geom->position = { (float)fi, 0.0f, 0.0f };
+            geom->setupDataFlags();
+
+            // deleted in the next frame
+            auto tmp = ms::Transform::create();
+            tmp->path = "/relay_tmp" + std::to_string(fi);
+            tmp->setupDataFlags();
+
+            ms::SetMessage mes;
+            mes.message_id = num_set_messages++;
+            mes.scene = ms::Scene::create();
+            mes.scene->entities.push_back(geom);
+            mes.scene->entities.push_back(tmp);
+            add_packet(mes, session_id, ms::Message::Type::Set, "set");
+        }
+        if (fi > 0) {
+            ms::DeleteMessage mes;
+            mes.entities.push_back({ "/relay_tmp" + std::to_string(fi - 1), ms::InvalidID });
+            add_packet(mes, session_id, ms::Message::Type::Delete, "delete");
+        }
+        {
+            ms::TextureTiles tt;
+            tt.texture_id = fi;
+            ms::TextureTilesMessage mes;
+            mes.textures.push_back(tt);
+            add_packet(mes, session_id, ms::Message::Type::TextureTiles, "texture_tiles");
+        }
+
+        ms::FenceMessage end;
+        end.type = ms::FenceMessage::FenceType::SceneEnd;
+        add_packet(end, session_id, ms::Message::Type::Fence, "fence");
+    }
+    const int num_packets = (int)packets.size();
+
+    // the state of the receiver. a plain Transform updates only the transform of an existing entity
+    struct SceneState
+    {
+        struct EntityState
+        {
+            ms::EntityType type;
+            float x;
+            size_t num_points;
+
+            bool operator==(const EntityState& v) const { return type == v.type && x == v.x && num_points == v.num_points; }
+        };
+        std::map<std::string, EntityState> entities;
+        std::map<int, int> textures; // texture id -> number of tiles received
+
+        void apply(const ms::Message& mes)
+        {
+            if (auto set = dynamic_cast<const ms::SetMessage*>(&mes)) {
+                for (auto& e : set->scene->entities) {
+                    auto it = entities.find(e->path);
+                    if (e->getType() == ms::EntityType::Transform && it != entities.end())
+                        it->second.x = e->position.x;
+                    else {
+                        size_t num_points = e->getType() == ms::EntityType::Mesh ? static_cast<ms::Mesh&>(*e).points.size() : 0;
+                        entities[e->path] = { e->getType(), e->position.x, num_points };
+                    }
+                }
+            }
+            else if (auto del = dynamic_cast<const ms::DeleteMessage*>(&mes)) {
+                for (auto& id : del->entities)
+                    entities.erase(id.name);
+            }
+            else if (auto tiles = dynamic_cast<const ms::TextureTilesMessage*>(&mes)) {
+                for (auto& tt : tiles->textures)
+                    ++textures[tt.texture_id];
+            }
+        }
+        bool operator==(const SceneState& v) const { return entities == v.entities && textures == v.textures; }
+    };
+
+    // counts messages that break the frame structure (unpaired fences, messages outside of frames or of other sessions)
+    // and applies the others to the state. only touched by the consumer's thread
+    struct FrameChecker
+    {
+        std::atomic_int errors{ 0 };
+        bool in_frame = false;
+        int session_id = ms::InvalidID;
+        SceneState state;
+
+        void check(const ms::RelayPacket& packet)
+        {
+            auto mes = packet.deserialize();
+            if (!mes) {
+                ++errors;
+                return;
+            }
+            if (packet.type == ms::Message::Type::Fence) {
+                auto& fence = static_cast<ms::FenceMessage&>(*mes);
+                bool begin = fence.type == ms::FenceMessage::FenceType::SceneBegin;
+                if (begin == in_frame || (!begin && fence.session_id != session_id))
+                    ++errors;
+                in_frame = begin;
+                session_id = fence.session_id;
+            }
+            else if (!in_frame || mes->session_id != session_id)
+                ++errors;
+            else
+                state.apply(*mes);
+        }
+    };
+
+    ms::Relay relay;
+    std::atomic_int fast_count{ 0 }, fast_sets{ 0 }, block_count{ 0 }, mismatches{ 0 };
+    FrameChecker fast_checker;
+    int fast = relay.addConsumer([&](const ms::RelayPacket& packet) {
+        if (packet.type == ms::Message::Type::Set) {
+            auto mes = std::dynamic_pointer_cast<ms::SetMessage>(packet.deserialize());
+            if (!mes || mes->message_id != fast_sets)
+                ++mismatches;
+            ++fast_sets;
+        }
+        fast_checker.check(packet);
+        ++fast_count;
+        return true;
+    });
+
+    ms::RelayConsumerSettings block_settings;
+    block_settings.max_pending = 4;
+    block_settings.drop_policy = ms::RelayConsumerSettings::DropPolicy::Block;
+    int block = relay.addConsumer([&](const ms::RelayPacket&) {
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+        ++block_count;
+        return true;
+    }, block_settings);
+
+    FrameChecker slow_checker;
+    ms::RelayConsumerSettings slow_settings;
+    slow_settings.max_pending = 4;
+    slow_settings.drop_policy = ms::RelayConsumerSettings::DropPolicy::DropOldest;
+    int slow = relay.addConsumer([&](const ms::RelayPacket& packet) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        slow_checker.check(packet);
+        return true;
+    }, slow_settings);
+
+    // Block, but too slow to keep up within block_timeout_ms. falls back to coalescing frames
+    FrameChecker stuck_checker;
+    ms::RelayConsumerSettings stuck_settings;
+    stuck_settings.max_pending = 4;
+    stuck_settings.drop_policy = ms::RelayConsumerSettings::DropPolicy::Block;
+    stuck_settings.block_timeout_ms = 1;
+    int stuck = relay.addConsumer([&](const ms::RelayPacket& packet) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        stuck_checker.check(packet);
+        return true;
+    }, stuck_settings);
+    Expect(relay.getNumConsumers() == 4);
+
+    TestScope("Relay::push", [&]() {
+        for (auto& p : packets)
+            relay.push(p);
+    }, 1);
+    Expect(relay.flush());
+
+    ms::RelayConsumerStats fstats, bstats, sstats, tstats;
+    relay.getStats(fast, fstats);
+    relay.getStats(block, bstats);
+    relay.getStats(slow, sstats);
+    relay.getStats(stuck, tstats);
+    Print("    fast: %d delivered, block: %d delivered, slow: %d delivered %d coalesced, stuck: %d delivered %d coalesced\n",
+        (int)fstats.delivered, (int)bstats.delivered, (int)sstats.delivered, (int)sstats.coalesced,
+        (int)tstats.delivered, (int)tstats.coalesced);
+    Expect(fast_count == num_packets && fast_sets == num_set_messages && mismatches == 0 && fstats.coalesced == 0);
+    Expect(block_count == num_packets && bstats.coalesced == 0);
+    Expect(sstats.coalesced > 0 && sstats.delivered < (uint64_t)num_packets);
+    Expect(tstats.coalesced > 0 && tstats.delivered < (uint64_t)num_packets);
+    Expect(fast_checker.errors == 0 && slow_checker.errors == 0 && stuck_checker.errors == 0);
+    Expect(!slow_checker.in_frame && !stuck_checker.in_frame);
+    Expect(fstats.pending == 0 && sstats.pending == 0 && tstats.pending == 0);
+
+    // coalesced frames lead to the same state: the latest entities, no deleted ones, every tile and the geometry
+    // whose transform was updated after it
+    auto& state = fast_checker.state;
+    Expect(state.entities.size() == num_sets + 2 && state.textures.size() == num_frames);
+    Expect(state.entities.count("/relay_tmp" + std::to_string(num_frames - 1)) == 1);
+    Expect(state.entities["/relay_geom"].type == ms::EntityType::Mesh && state.entities["/relay_geom"].x == (float)(num_frames - 1));
+    Expect(slow_checker.state == state && stuck_checker.state == state);
+
+    relay.removeConsumer(slow);
+    Expect(relay.getNumConsumers() == 3);
+    relay.clear();
+    Expect(relay.getNumConsumers() == 0);
+}
+
+static void PrintLatencies(const char *name, std::vector<float>& ms)
+{
+    if (ms.empty()) {
+        Print("    %-10s: -\n", name);
+        return;
+    }
+    std::sort(ms.begin(), ms.end());
+    auto percentile = [&ms](float p) { return ms[std::min((size_t)(p * ms.size()), ms.size() - 1)]; };
+    Print("    %-10s: p50 %.2fms, p90 %.2fms, p99 %.2fms, max %.2fms\n",
+        name, percentile(0.5f), percentile(0.9f), percentile(0.99f), ms.back());
+}
+
+// replays a scene cache (arg "cache") or generated wave meshes through ms::Client into an in-process server
+// at a target rate (arg "fps". 0: as fast as possible) and reports throughput and per-stage latencies.
+// if arg "server" is given, frames are sent to that server instead and only send-side stages are measured.
+// e.g. Test cache=wave_c2.sc frames=600 fps=60 Test_LoadGenerator
+TestCase(Test_LoadGenerator)
+{
+    std::string cache_path, remote;
+    int num_frames = 120, resolution = 128, port = 8090;
+    float fps = 0.0f;
+    GetArg("cache", cache_path);
+    GetArg("server", remote);
+    GetArg("frames", num_frames);
+    GetArg("resolution", resolution);
+    GetArg("port", port);
+    GetArg("fps", fps);
+
+    // prepare all frames beforehand so that decoding is not measured
+    std::vector<ms::ScenePtr> frames;
+    if (!cache_path.empty()) {
+        ms::ISceneCacheSettings iscs;
+        iscs.enable_diff = false;
+        auto isc = ms::OpenISceneCacheFile(cache_path.c_str(), iscs);
+        if (!isc) {
+            Print("    failed to open %s\n", cache_path.c_str());
+            return;
+        }
+        for (size_t i = 0; i < isc->getNumScenes(); ++i) {
+            if (auto scene = isc->getByIndex(i))
+                frames.push_back(scene);
+        }
+    }
+    else {
+        const int num_cycle = 60;
+        for (int i = 0; i < num_cycle; ++i) {
+            auto mesh = ms::Mesh::create();
+            mesh->path = "/LoadGenerator/Wave";
+            GenerateWaveMesh(mesh->counts, mesh->indices, mesh->points, mesh->uv0, 2.0f, 1.0f, resolution, 360.0f * mu::DegToRad * i / num_cycle);
+            mesh->material_ids.resize(mesh->counts.size(), 0);
+            mesh->setupDataFlags();
+
+            auto scene = ms::Scene::create();
+            scene->entities.push_back(mesh);
+            frames.push_back(scene);
+        }
+    }
+    if (frames.empty()) {
+        Print("    no frames to send\n");
+        return;
+    }
+
+    ms::ClientSettings client_settings;
+    client_settings.port = (uint16_t)port;
+    ms::ServerPtr server;
+    if (!remote.empty()) {
+        client_settings.server = remote;
+    }
+    else {
+        ms::ServerSettings server_settings;
+        server_settings.port = (uint16_t)port;
+        server = std::make_shared<ms::Server>(server_settings);
+        if (!server->start()) {
+            Print("    failed to start server on port %d\n", port);
+            return;
+        }
+    }
+
+    ms::Client client(client_settings);
+    if (!client.isServerAvailable(1000)) {
+        Print("    server not available. error log: %s\n", client.getErrorMessage().c_str());
+        return;
+    }
+
+    // indexed by frame (= session id)
+    std::vector<nanosec> begin_times(num_frames, 0);
+    std::vector<float> serialize_ms, send_ms, recv_ms(num_frames, -1.0f), import_ms(num_frames, -1.0f),
+        consume_ms(num_frames, -1.0f), total_ms(num_frames, -1.0f);
+    std::atomic_int num_sent{ 0 }, num_consumed{ 0 };
+    std::atomic_bool sending{ true };
+    uint64_t bytes_sent = 0;
+
+    // native consumer. copies the received geometry as a renderer would upload it.
+    std::thread consumer;
+    if (server) {
+        consumer = std::thread([&]() {
+            RawVector<float3> points;
+            RawVector<int> indices;
+            nanosec deadline = 0;
+            for (;;) {
+                server->processMessages([&](ms::Message::Type type, ms::Message& mes) {
+                    int frame = mes.session_id;
+                    if (frame < 0 || frame >= num_frames)
+                        return;
+
+                    if (type == ms::Message::Type::Set) {
+                        auto begin = mu::Now();
+                        recv_ms[frame] = NS2MS(mes.timestamp_recv - mes.timestamp_send);
+                        import_ms[frame] = NS2MS(begin - mes.timestamp_recv);
+                        auto& set = static_cast<ms::SetMessage&>(mes);
+                        for (auto& e : set.scene->entities) {
+                            if (e->getType() == ms::EntityType::Mesh) {
+                                auto& mesh = static_cast<ms::Mesh&>(*e);
+                                points.assign(mesh.points.cdata(), mesh.points.cdata() + mesh.points.size());
+                                indices.assign(mesh.indices.cdata(), mesh.indices.cdata() + mesh.indices.size());
+                            }
+                        }
+                        consume_ms[frame] = NS2MS(mu::Now() - begin);
+                    }
+                    else if (type == ms::Message::Type::Fence) {
+                        auto& fence = static_cast<ms::FenceMessage&>(mes);
+                        if (fence.type == ms::FenceMessage::FenceType::SceneEnd) {
+                            total_ms[frame] = NS2MS(mu::Now() - begin_times[frame]);
+                            ++num_consumed;
+                        }
+                    }
+                });
+
+                if (num_consumed == num_frames)
+                    break;
+                if (!sending) {
+                    // give up on frames that were lost
+                    if (deadline == 0)
+                        deadline = mu::Now() + 5000000000LL;
+                    else if (num_consumed == num_sent || mu::Now() > deadline)
+                        break;
+                }
+                std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+        });
+    }
+
+    auto send_begin = mu::Now();
+    nanosec interval = fps > 0.0f ? nanosec(1e9 / fps) : 0;
+    for (int frame = 0; frame < num_frames; ++frame) {
+        if (interval > 0) {
+            nanosec t = send_begin + interval * frame;
+            nanosec now = mu::Now();
+            if (t > now)
+                std::this_thread::sleep_for(std::chrono::nanoseconds(t - now));
+        }
+
+        ms::FenceMessage fence;
+        fence.session_id = frame;
+        fence.timestamp_send = begin_times[frame] = mu::Now();
+        fence.type = ms::FenceMessage::FenceType::SceneBegin;
+        if (!client.send(fence))
+            break;
+
+        ms::SetMessage mes;
+        mes.session_id = frame;
+        mes.scene = frames[frame % frames.size()];
+        {
+            mu::CounterStream cs;
+            auto begin = mu::Now();
+            mes.serialize(cs);
+            cs.flush();
+            serialize_ms.push_back(NS2MS(mu::Now() - begin));
+            bytes_sent += cs.size();
+        }
+        mes.timestamp_send = mu::Now();
+        bool ok = client.send(mes);
+        send_ms.push_back(NS2MS(mu::Now() - mes.timestamp_send));
+        if (!ok)
+            break;
+
+        fence.timestamp_send = mu::Now();
+        fence.type = ms::FenceMessage::FenceType::SceneEnd;
+        if (!client.send(fence))
+            break;
+        ++num_sent;
+    }
+    auto send_end = mu::Now();
+    sending = false;
+    if (consumer.joinable())
+        consumer.join();
+    if (server)
+        server->stop();
+
+    float elapsed = NS2MS(send_end - send_begin) / 1000.0f;
+    Print("    %d frames sent in %.2fs: %.2f fps, %.2f MB/s\n", (int)num_sent, elapsed,
+        (float)num_sent / elapsed, float(bytes_sent / (1024.0 * 1024.0)) / elapsed);
+    if (num_sent != num_frames)
+        Print("    send failed. error log: %s\n", client.getErrorMessage().c_str());
+
+    auto received = [](std::vector<float>& v) -> std::vector<float>& {
+        v.erase(std::remove(v.begin(), v.end(), -1.0f), v.end());
+        return v;
+    };
+    PrintLatencies("serialize", serialize_ms);
+    PrintLatencies("send", send_ms);
+    if (server) {
+        Print("    %d frames consumed\n", (int)num_consumed);
+        PrintLatencies("receive", received(recv_ms));
+        PrintLatencies("import", received(import_ms));
+        PrintLatencies("consume", received(consume_ms));
+        PrintLatencies("end-to-end", received(total_ms));
+        Expect(num_consumed == num_sent);
+
+        // the server's own view. includes fences
+        const char *stage_names[] = { "Serialize", "Transfer", "Deserialize", "Import", "Queue", "Consume", "Total" };
+        Print("    server latency stats:\n");
+        for (int i = 0; i < (int)ms::LatencyStage::Count; ++i) {
+            auto h = server->getLatencyStats().get((ms::LatencyStage)i);
+            Print("    %-11s: %d messages, p50 %.2fms, p99 %.2fms, max %.2fms\n", stage_names[i], (int)h.getCount(),
+                NS2MS(h.getPercentile(0.5f)), NS2MS(h.getPercentile(0.99f)), NS2MS(h.getMax()));
+        }
+    }
+}
+
+TestCase(Test_LatencyStats)
+{
+    // bucket boundaries are continuous and each value falls in its bucket
+    for (int i = 1; i < ms::LatencyHistogram::NumBuckets; ++i) {
+        auto lb = ms::LatencyHistogram::getBucketLowerBound(i);
+        Expect(lb > ms::LatencyHistogram::getBucketLowerBound(i - 1));
+        Expect(ms::LatencyHistogram::getBucketIndex(lb) == i);
+        Expect(ms::LatencyHistogram::getBucketIndex(lb - 1) == i - 1);
+    }
+
+    ms::LatencyHistogram h;
+    for (int i = 1; i <= 1000; ++i)
+        h.add(i * 10000LL); // 10us - 10ms
+    Expect(h.getCount() == 1000);
+    Expect(h.getMin() == 10000 && h.getMax() == 10000000);
+    Expect(h.getAverage() == 5005000);
+    auto p50 = h.getPercentile(0.5f), p99 = h.getPercentile(0.99f);
+    Print("    p50: %.3fms, p99: %.3fms\n", NS2MS(p50), NS2MS(p99));
+    Expect(p50 >= 5000000 && p50 <= 5000000 * 5 / 4);
+    Expect(p99 >= 9900000 && p99 <= 10000000);
+    Expect(h.getPercentile(1.0f) == h.getMax());
+
+    // stages of a message. the sender's clock is 1s behind.
+    const nanosec ms1 = 1000000;
+    ms::SetMessage mes;
+    mes.timestamp_send = 100 * ms1;
+    mes.latency.clock_synced = true;
+    mes.latency.clock_offset = 1000 * ms1;
+    mes.latency.serialize = 2 * ms1;
+    mes.latency.timestamp_request = 1105 * ms1;
+    mes.latency.transfer_wait = 4 * ms1;
+    mes.timestamp_recv = 1115 * ms1;
+    mes.latency.timestamp_imported = 1130 * ms1;
+
+    ms::LatencyStats stats;
+    stats.add(mes, 1150 * ms1, 1151 * ms1);
+    auto check = [&stats](ms::LatencyStage stage, nanosec expected) {
+        auto v = stats.get(stage);
+        return v.getCount() == 1 && v.getMin() == expected;
+    };
+    Expect(check(ms::LatencyStage::Serialize, 2 * ms1));
+    Expect(check(ms::LatencyStage::Transfer, 3 * ms1 + 4 * ms1));
+    Expect(check(ms::LatencyStage::Deserialize, 6 * ms1));
+    Expect(check(ms::LatencyStage::Import, 15 * ms1));
+    Expect(check(ms::LatencyStage::Queue, 20 * ms1));
+    Expect(check(ms::LatencyStage::Consume, 1 * ms1));
+    Expect(check(ms::LatencyStage::Total, 51 * ms1));
+
+    // unsynced clocks: only stages measured on the server
+    mes.latency.clock_synced = false;
+    stats.clear();
+    stats.add(mes, 1150 * ms1, 1151 * ms1);
+    Expect(check(ms::LatencyStage::Transfer, 4 * ms1));
+    Expect(stats.get(ms::LatencyStage::Total).getCount() == 0);
+
+    // clock offset estimate: the sample with the shortest round trip wins
+    ms::ClockOffset clock;
+    Expect(!clock.valid());
+    clock.update(1000, 5000 + 1010, 1020);
+    Expect(clock.valid() && clock.offset == 5000 && clock.rtt == 20);
+    clock.update(2000, 5000 + 2030, 2040);
+    Expect(clock.offset == 5000 && clock.rtt == 20);
+    clock.update(3000, 5000 + 3006, 3010);
+    Expect(clock.offset == 5001 && clock.rtt == 10);
+}
+
 TestCase(Test_Query)
 {
     ms::Client client(GetClientSettings());
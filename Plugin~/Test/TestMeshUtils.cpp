@@ -315,6 +315,7 @@ TestCase(TestLerp)
     RawVector<float> v1(N), v2(N), rv1(N), rv2(N);
     RawVector<float3> n1(N), n2(N), rn1(N), rn2(N);
     RawVector<float4> t1(N), t2(N), rt1(N), rt2(N);
+    RawVector<quatf> q1(N), q2(N), rq1(N), rq2(N);
     for (int i = 0; i < N; ++i) {
         v1[i] = rnd.f11();
         v2[i] = rnd.f11();
@@ -322,6 +323,8 @@ TestCase(TestLerp)
         n2[i] = rnd.v3n();
         t1[i] = rnd.v4t();
         t2[i] = rnd.v4t();
+        q1[i] = rotate(rnd.v3n(), rnd.f11() * mu::PI);
+        q2[i] = rotate(rnd.v3n(), rnd.f11() * mu::PI);
     }
     
     TestScope("Lerp_ISPC", [&]() {
@@ -347,6 +350,30 @@ TestCase(TestLerp)
         LerpTangents_Generic(rt2.data(), t1.cdata(), t2.cdata(), N, 0.5f);
     }, T);
     Expect(near_equal(rt1, rt2));
+
+    TestScope("Slerp_ISPC", [&]() {
+        Slerp_ISPC(rq1.data(), q1.cdata(), q2.cdata(), N, 0.3f);
+    }, T);
+    TestScope("Slerp_Generic", [&]() {
+        Slerp_Generic(rq2.data(), q1.cdata(), q2.cdata(), N, 0.3f);
+    }, T);
+    Expect(NearEqual((const float*)rq1.cdata(), (const float*)rq2.cdata(), N * 4));
+
+    TestScope("CatmullRom_ISPC", [&]() {
+        CatmullRom_ISPC(rv1.data(), v1.cdata(), v2.cdata(), v1.cdata(), v2.cdata(), N, 0.3f, 0.5f, 0.5f);
+    }, T);
+    TestScope("CatmullRom_Generic", [&]() {
+        CatmullRom_Generic(rv2.data(), v1.cdata(), v2.cdata(), v1.cdata(), v2.cdata(), N, 0.3f, 0.5f, 0.5f);
+    }, T);
+    Expect(near_equal(rv1, rv2));
+
+    TestScope("Hermite_ISPC", [&]() {
+        Hermite_ISPC(rv1.data(), v1.cdata(), v2.cdata(), v2.cdata(), v1.cdata(), N, 0.3f, 0.1f);
+    }, T);
+    TestScope("Hermite_Generic", [&]() {
+        Hermite_Generic(rv2.data(), v1.cdata(), v2.cdata(), v2.cdata(), v1.cdata(), N, 0.3f, 0.1f);
+    }, T);
+    Expect(near_equal(rv1, rv2));
 }
 
 TestCase(TestHandednessConversion)
@@ -791,9 +818,11 @@ TestCase(TestSum)
     for (int i = 0; i < input_size; ++i)
         input[i] = (float)i;
 
+    uint64_t expected = 0;
     TestScope("SumInt32_Generic", [&]() {
         auto sum = SumInt32_Generic((uint32_t*)input.data(), input.size());
         Print("sum: %llu\n", sum);
+        expected = sum;
     }, 1);
     TestScope("SumInt32_ISPC", [&]() {
         auto sum = SumInt32_ISPC((uint32_t*)input.data(), input.size());
@@ -802,6 +831,7 @@ TestCase(TestSum)
     TestScope("SumInt32", [&]() {
         auto sum = SumInt32(input.data(), sizeof(float) * input.size());
         Print("sum: %llu\n", sum);
+        Expect(sum == expected); // split into blocks in parallel
     }, 1);
 }
 
@@ -1112,6 +1142,106 @@ TestCase(Test_BoundedArray)
     Expect(NearEqual(data_tangents.data(), tmp_tangents.data(), N, eps));
 }
 
+TestCase(Test_BlockCompression)
+{
+    // not multiple of 4 to test edge blocks
+    const int W = 30, H = 18;
+    RawVector<uint8_t> src(W * H * 4), decoded(W * H * 4);
+    for (int y = 0; y < H; ++y) {
+        for (int x = 0; x < W; ++x) {
+            auto *p = &src[(y * W + x) * 4];
+            p[0] = (uint8_t)(x * 255 / (W - 1));
+            p[1] = (uint8_t)(y * 255 / (H - 1));
+            p[2] = (uint8_t)(255 - p[0]);
+            p[3] = x < W / 2 ? 255 : 0;
+        }
+    }
+
+    // mean absolute error of the channels the format preserves.
+    // BC1 decodes transparent pixels as black, so they are excluded.
+    auto error = [&](int channels, bool opaque_only) {
+        int total = 0, count = 0;
+        for (int i = 0; i < W * H; ++i) {
+            if (opaque_only && src[i * 4 + 3] == 0)
+                continue;
+            for (int c = 0; c < channels; ++c)
+                total += std::abs((int)src[i * 4 + c] - (int)decoded[i * 4 + c]);
+            count += channels;
+        }
+        return (float)total / count;
+    };
+
+    struct { BCFormat format; int channels; } formats[] = {
+        { BCFormat::BC1, 3 }, { BCFormat::BC3, 4 }, { BCFormat::BC4, 1 }, { BCFormat::BC5, 2 }, { BCFormat::BC7, 4 },
+    };
+    for (auto& f : formats) {
+        for (auto q : { BCQuality::Fast, BCQuality::Normal, BCQuality::High }) {
+            RawVector<char> encoded(GetBCDataSize(f.format, W, H));
+            EncodeBC(f.format, q, encoded.data(), src.cdata(), W, H);
+            Expect(DecodeBC(f.format, decoded.data(), encoded.cdata(), W, H));
+            // the blocks contain 2D gradients that can't be represented by one line of colors
+            float e = error(f.channels, f.format == BCFormat::BC1);
+            Print("    format %d quality %d: error %f\n", (int)f.format, (int)q, e);
+            Expect(e < (q == BCQuality::Fast ? 10.0f : 7.0f));
+        }
+    }
+
+    // BC1 punch-through alpha
+    RawVector<char> bc1(GetBCDataSize(BCFormat::BC1, W, H));
+    EncodeBC(BCFormat::BC1, BCQuality::Normal, bc1.data(), src.cdata(), W, H);
+    DecodeBC(BCFormat::BC1, decoded.data(), bc1.cdata(), W, H);
+    Expect(decoded[3] == 255 && decoded[(W - 1) * 4 + 3] == 0);
+}
+
+TestCase(Test_ConvertPixels)
+{
+    const int W = 7, H = 5;
+    RawVector<uint8_t> rgb(W * H * 3), rgba(W * H * 4), back(W * H * 4);
+    for (size_t i = 0; i < rgb.size(); ++i)
+        rgb[i] = (uint8_t)(i * 37);
+
+    // RGB -> RGBA: alpha is filled with 1
+    Expect(ConvertPixels(rgba.data(), PixelType::U8, 4, rgb.cdata(), PixelType::U8, 3, W, H));
+    Expect(rgba[0] == rgb[0] && rgba[2] == rgb[2] && rgba[3] == 255 && rgba[4] == rgb[3]);
+
+    // swap R and B, and flip vertically
+    {
+        PixelConvertOptions opt;
+        opt.flip_y = true;
+        std::swap(opt.swizzle[0], opt.swizzle[2]);
+        Expect(ConvertPixels(back.data(), PixelType::U8, 4, rgba.cdata(), PixelType::U8, 4, W, H, opt));
+        size_t last_row = (size_t)W * (H - 1) * 4;
+        Expect(back[last_row + 0] == rgba[2] && back[last_row + 2] == rgba[0] && back[last_row + 3] == 255);
+    }
+
+    // u8 -> f32 -> u8 and f32 -> f16 -> f32 round trips
+    {
+        RawVector<float> f32(W * H * 4), f32b(W * H * 4);
+        RawVector<half> f16(W * H * 4);
+        Expect(ConvertPixels(f32.data(), PixelType::F32, 4, rgba.cdata(), PixelType::U8, 4, W, H));
+        Expect(ConvertPixels(back.data(), PixelType::U8, 4, f32.cdata(), PixelType::F32, 4, W, H));
+        Expect(back == rgba);
+
+        Expect(ConvertPixels(f16.data(), PixelType::F16, 4, f32.cdata(), PixelType::F32, 4, W, H));
+        Expect(ConvertPixels(f32b.data(), PixelType::F32, 4, f16.cdata(), PixelType::F16, 4, W, H));
+        Expect(NearEqual(f32.cdata(), f32b.cdata(), f32.size(), 1e-3f));
+    }
+
+    // sRGB -> linear -> sRGB. alpha is untouched
+    {
+        RawVector<float> linear(W * H * 4);
+        PixelConvertOptions to_linear, to_srgb;
+        to_linear.srgb_to_linear = true;
+        to_srgb.linear_to_srgb = true;
+        Expect(ConvertPixels(linear.data(), PixelType::F32, 4, rgba.cdata(), PixelType::U8, 4, W, H, to_linear));
+        Expect(near_equal(linear[4], SRGBToLinear(rgba[4] / 255.0f)) && linear[3] == 1.0f);
+        Expect(ConvertPixels(back.data(), PixelType::U8, 4, linear.cdata(), PixelType::F32, 4, W, H, to_srgb));
+        Expect(back == rgba);
+    }
+
+    Expect(!ConvertPixels(back.data(), PixelType::Unknown, 4, rgba.cdata(), PixelType::U8, 4, W, H));
+}
+
 TestCase(Test_RemoveNamespace)
 {
     auto remove_namespace = [](std::string path) {
@@ -1146,6 +1276,66 @@ TestCase(Test_UniqueUnsorted)
 }
 
 
+TestCase(Test_FlatHashMap)
+{
+    const int num_keys = 100000;
+
+    // keys that look like DCC object pointers
+    RawVector<char> objects(num_keys * 64);
+    std::vector<const void*> keys(num_keys);
+    for (int i = 0; i < num_keys; ++i)
+        keys[i] = &objects[i * 64];
+
+    FlatHashMap<const void*, int> fmap;
+    for (int i = 0; i < num_keys; ++i)
+        fmap[keys[i]] = i;
+    Expect(fmap.size() == num_keys);
+
+    bool found_all = true;
+    for (int i = 0; i < num_keys; ++i) {
+        auto *v = fmap.find(keys[i]);
+        found_all = found_all && v && *v == i;
+    }
+    Expect(found_all);
+
+    // erase odd ones. remaining ones must survive backward shifts
+    fmap.eraseIf([](const void*, int v) { return v % 2 == 1; });
+    Expect(fmap.size() == num_keys / 2);
+    bool valid = true;
+    for (int i = 0; i < num_keys; ++i)
+        valid = valid && ((fmap.find(keys[i]) != nullptr) == (i % 2 == 0));
+    Expect(valid);
+    Expect(fmap.erase(keys[0]) && !fmap.erase(keys[0]) && fmap.size() == num_keys / 2 - 1);
+
+    FlatHashMap<std::string, int> smap;
+    smap["/root/child"] = 1;
+    Expect(smap.find("/root/child") && *smap.find("/root/child") == 1 && !smap.find("/root"));
+
+    // lookups per export: every object is queried once
+    Print("    num_keys: %d\n", num_keys);
+    std::map<const void*, int> map;
+    std::unordered_map<const void*, int> umap;
+    for (int i = 0; i < num_keys; ++i) {
+        map[keys[i]] = i;
+        umap[keys[i]] = i;
+        fmap[keys[i]] = i;
+    }
+    int64_t total = 0;
+    TestScope("std::map lookup", [&]() {
+        for (auto k : keys)
+            total += map[k];
+    }, 10);
+    TestScope("std::unordered_map lookup", [&]() {
+        for (auto k : keys)
+            total += umap[k];
+    }, 10);
+    TestScope("FlatHashMap lookup", [&]() {
+        for (auto k : keys)
+            total += fmap[k];
+    }, 10);
+    Expect(total == int64_t(num_keys - 1) * num_keys / 2 * 30);
+}
+
 TestCase(Test_Quadify)
 {
     {
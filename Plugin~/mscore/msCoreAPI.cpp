@@ -60,6 +60,7 @@ msAPI ms::TextureType   msTextureGetType(const ms::Texture *self) { return self-
 msAPI ms::TextureFormat msTextureGetFormat(const ms::Texture *self) { return self->format; }
 msAPI int               msTextureGetWidth(const ms::Texture *self) { return self->width; }
 msAPI int               msTextureGetHeight(const ms::Texture *self) { return self->height; }
+msAPI int               msTextureGetMipCount(const ms::Texture *self) { return self->mip_count; }
 msAPI void              msTextureGetData(const ms::Texture *self, void *v) { self->getData(v); }
 msAPI const void*       msTextureGetDataPtr(const ms::Texture *self) { return self->data.cdata(); }
 msAPI int               msTextureGetSizeInByte(const ms::Texture *self) { return (int)self->data.size(); }
@@ -67,10 +68,39 @@ msAPI void              msTextureSetType(ms::Texture *self, ms::TextureType v) {
 msAPI void              msTextureSetFormat(ms::Texture *self, ms::TextureFormat v) { self->format = v; }
 msAPI void              msTextureSetWidth(ms::Texture *self, int v) { self->width = v; }
 msAPI void              msTextureSetHeight(ms::Texture *self, int v) { self->height = v; }
+msAPI void              msTextureSetMipCount(ms::Texture *self, int v) { self->mip_count = v; }
 msAPI void              msTextureSetData(ms::Texture *self, const void *v) { self->setData(v); }
 #ifndef msRuntime
 msAPI bool              msTextureWriteToFile(const ms::Texture *self, const char *path) { return self->writeToFile(path); }
 #endif // msRuntime
+
+// flags: 1: flip vertically, 2: sRGB to linear, 4: linear to sRGB, 8: swap R and B
+static ms::PixelConvertOptions ToPixelConvertOptions(int flags)
+{
+    ms::PixelConvertOptions ret;
+    ret.flip_y = (flags & 1) != 0;
+    ret.srgb_to_linear = (flags & 2) != 0;
+    ret.linear_to_srgb = (flags & 4) != 0;
+    if ((flags & 8) != 0)
+        std::swap(ret.swizzle[0], ret.swizzle[2]);
+    return ret;
+}
+msAPI bool msTextureConvert(ms::Texture *self, ms::TextureFormat format, int flags)
+{
+    return self->convert(format, ToPixelConvertOptions(flags));
+}
+msAPI bool msTextureConvertTo(const ms::Texture *self, void *dst, ms::TextureFormat format, int flags)
+{
+    return self->convertTo(dst, format, ToPixelConvertOptions(flags));
+}
+msAPI int msGetTextureDataSize(ms::TextureFormat format, int width, int height, int mip_count)
+{
+    return (int)ms::GetTextureDataSize(format, width, height, mip_count);
+}
+msAPI bool msConvertPixels(void *dst, ms::TextureFormat dst_format, const void *src, ms::TextureFormat src_format, int width, int height, int flags)
+{
+    return ms::ConvertPixels(dst, dst_format, src, src_format, width, height, ToPixelConvertOptions(flags));
+}
 #pragma endregion
 
 
@@ -101,7 +131,7 @@ msAPI void msMaterialSetMatrix(ms::Material *self, const char *n, const float4x4
 msAPI void msMaterialSetFloatArray(ms::Material *self, const char *n, const float *v, int c) { self->addProperty({ n, v, (size_t)c }); }
 msAPI void msMaterialSetVectorArray(ms::Material *self, const char *n, const float4 *v, int c) { self->addProperty({ n, v, (size_t)c }); }
 msAPI void msMaterialSetMatrixArray(ms::Material *self, const char *n, const float4x4 *v, int c) { self->addProperty({ n, v, (size_t)c }); }
-msAPI void msMaterialAddKeyword(ms::Material *self, const char *name, bool v) { self->keywords.push_back({name, v}); }
+msAPI void msMaterialAddKeyword(ms::Material *self, const char *name, bool v) { self->addKeyword({name, v}); }
 #pragma endregion
 
 
@@ -124,7 +154,7 @@ msAPI int                   msAnimationGetNumCurves(const ms::Animation *self) {
 msAPI ms::AnimationCurve*   msAnimationGetCurve(const ms::Animation *self, int i) { return self->curves[i].get(); }
 msAPI ms::AnimationCurve*   msAnimationFindCurve(const ms::Animation *self, const char *name) { return self->findCurve(name).get(); }
 
-#define DefGetCurve(Name) msAPI ms::AnimationCurve* msAnimationGet##Name(const ms::Animation *self) { return self->findCurve(msk##Name).get(); }
+#define DefGetCurve(Name) msAPI ms::AnimationCurve* msAnimationGet##Name(const ms::Animation *self) { return self->findCurve(ms::AnimationCurveKey::Name).get(); }
 DefGetCurve(TransformTranslation) // -> msAnimationGetTransformTranslation
 DefGetCurve(TransformRotation)
 DefGetCurve(TransformScale)
@@ -426,6 +456,14 @@ msAPI ms::BlendShapeData* msMeshAddBlendShape(ms::Mesh *self, const char *name)
 msAPI void msMeshSetLocal2World(ms::Mesh *self, const float4x4 *v) { self->refine_settings.local2world = *v; }
 msAPI void msMeshSetWorld2Local(ms::Mesh *self, const float4x4 *v) { self->refine_settings.world2local = *v; }
 
+msAPI ms::MeshDescriptorTable* msMeshDescriptorTableCreate() { return new ms::MeshDescriptorTable(); }
+msAPI void msMeshDescriptorTableRelease(ms::MeshDescriptorTable *self) { delete self; }
+msAPI int msMeshDescriptorTableBuildMesh(ms::MeshDescriptorTable *self, const ms::Mesh *mesh) { return (int)self->build(*mesh); }
+msAPI int msMeshDescriptorTableBuildScene(ms::MeshDescriptorTable *self, const ms::Scene *scene) { return (int)self->build(*scene); }
+msAPI const ms::MeshDescriptor* msMeshDescriptorTableGetData(const ms::MeshDescriptorTable *self) { return self->data(); }
+msAPI int msMeshDescriptorTableGetStride() { return (int)sizeof(ms::MeshDescriptor); }
+msAPI void msMeshDescriptorRead(const ms::MeshDescriptor *self, const ms::MeshBuffers *dst) { ms::MeshDescriptorTable::read(*self, *dst); }
+
 msAPI int msSubmeshGetNumIndices(const ms::SubmeshData *self) { return (int)self->index_count; }
 msAPI void msSubmeshReadIndices(const ms::SubmeshData *self, const ms::Mesh *mesh, int *dst) { mesh->indices.copy_to(dst, self->index_count, self->index_offset); }
 msAPI int msSubmeshGetMaterialID(const ms::SubmeshData *self) { return self->material_id; }
@@ -518,6 +556,13 @@ msAPI ms::Transform* msSceneGetEntity(const ms::Scene *self, int i) { return sel
 msAPI ms::Constraint* msSceneGetConstraint(const ms::Scene *self, int i) { return self->constraints[i].get(); }
 msAPI bool msSceneSubmeshesHaveUniqueMaterial(const ms::Scene *self) { return self->submeshesHaveUniqueMaterial(); }
 msAPI ms::SceneProfileData msSceneGetProfileData(const ms::Scene *self) { return self->profile_data; }
+
+msAPI ms::EntityTable* msEntityTableCreate() { return new ms::EntityTable(); }
+msAPI void msEntityTableRelease(ms::EntityTable *self) { delete self; }
+msAPI int msEntityTableBuild(ms::EntityTable *self, const ms::Scene *scene, ms::EntityTable::Filter filter) { return (int)self->build(*scene, filter); }
+msAPI int msEntityTableGetSize(const ms::EntityTable *self) { return (int)self->size(); }
+msAPI int msEntityTableGetPathsSize(const ms::EntityTable *self) { return (int)self->getPathsSize(); }
+msAPI void msEntityTableFill(const ms::EntityTable *self, const ms::EntityArrays *dst) { self->fill(*dst); }
 #pragma endregion
 
 
@@ -41,6 +41,84 @@ msAPI ms::Identifier* msDeleteGetMaterial(ms::DeleteMessage *self, int i)
     return &self->materials[i];
 }
 
+msAPI int msAnimationDeltaGetNumClips(ms::AnimationDeltaMessage *self)
+{
+    return (int)self->deltas.size();
+}
+// the updated curves of the target clip with the delta merged
+msAPI ms::AnimationClip* msAnimationDeltaGetClip(ms::AnimationDeltaMessage *self, int i)
+{
+    return self->deltas[i].merged.get();
+}
+// only the curves that have new keys
+msAPI ms::AnimationClip* msAnimationDeltaGetDeltaClip(ms::AnimationDeltaMessage *self, int i)
+{
+    return self->deltas[i].clip.get();
+}
+msAPI int msAnimationDeltaGetNumRanges(ms::AnimationDeltaMessage *self, int i)
+{
+    return (int)self->deltas[i].ranges.size();
+}
+msAPI ms::AnimationTimeRange msAnimationDeltaGetRange(ms::AnimationDeltaMessage *self, int i, int ri)
+{
+    return self->deltas[i].ranges[ri].range;
+}
+msAPI const char* msAnimationDeltaGetRangePath(ms::AnimationDeltaMessage *self, int i, int ri)
+{
+    return self->deltas[i].ranges[ri].path.c_str();
+}
+msAPI const char* msAnimationDeltaGetRangeCurve(ms::AnimationDeltaMessage *self, int i, int ri)
+{
+    return self->deltas[i].ranges[ri].curve.c_str();
+}
+msAPI ms::AnimationTimeRange msAnimationDeltaGetTimeRange(ms::AnimationDeltaMessage *self, int i)
+{
+    return self->deltas[i].getTimeRange();
+}
+
+msAPI int msTextureTilesGetNumTextures(ms::TextureTilesMessage *self)
+{
+    return (int)self->textures.size();
+}
+// the whole texture with the tiles applied. null if the target texture is unknown
+msAPI ms::Texture* msTextureTilesGetTexture(ms::TextureTilesMessage *self, int i)
+{
+    return self->textures[i].merged.get();
+}
+msAPI int msTextureTilesGetNumRects(ms::TextureTilesMessage *self, int i)
+{
+    return (int)self->textures[i].tiles.size();
+}
+// dst: x, y, width, height
+msAPI void msTextureTilesGetRect(ms::TextureTilesMessage *self, int i, int ri, int *dst)
+{
+    auto& tile = self->textures[i].tiles[ri];
+    dst[0] = tile.x;
+    dst[1] = tile.y;
+    dst[2] = tile.width;
+    dst[3] = tile.height;
+}
+// pixels of the rect. rows are tightly packed
+msAPI const void* msTextureTilesGetRectData(ms::TextureTilesMessage *self, int i, int ri)
+{
+    return self->textures[i].tiles[ri].data.cdata();
+}
+
+msAPI int msMaterialDeltaGetNumMaterials(ms::MaterialDeltaMessage *self)
+{
+    return (int)self->materials.size();
+}
+// the whole material with the delta applied. null if the target material is unknown
+msAPI ms::Material* msMaterialDeltaGetMaterial(ms::MaterialDeltaMessage *self, int i)
+{
+    return self->merged[i].get();
+}
+// the changed properties only
+msAPI ms::Material* msMaterialDeltaGetDelta(ms::MaterialDeltaMessage *self, int i)
+{
+    return self->materials[i].get();
+}
+
 msAPI ms::FenceMessage::FenceType msFenceGetType(ms::FenceMessage *self)
 {
     return self->type;
@@ -209,6 +287,79 @@ msAPI void msServerNotifyPoll(ms::Server *server, ms::PollMessage::PollType t)
     server->notifyPoll(t);
 }
 
+msAPI int msServerAddRelayTarget(ms::Server *server, const char *address, uint16_t port, int max_pending, ms::RelayConsumerSettings::DropPolicy drop_policy)
+{
+    if (!server || !address) { return 0; }
+    ms::ClientSettings dst;
+    dst.server = address;
+    dst.port = port;
+    ms::RelayConsumerSettings settings;
+    settings.max_pending = max_pending;
+    settings.drop_policy = drop_policy;
+    return server->getRelay().addForwarder(dst, settings);
+}
+msAPI void msServerRemoveRelayTarget(ms::Server *server, int id)
+{
+    if (!server) { return; }
+    server->getRelay().removeConsumer(id);
+}
+msAPI void msServerSetRelayOnly(ms::Server *server, bool v)
+{
+    if (!server) { return; }
+    server->setRelayOnly(v);
+}
+
+msAPI bool msServerStartRecording(ms::Server *server, const char *path)
+{
+    if (!server || !path) { return false; }
+    return server->startRecording(path);
+}
+msAPI void msServerStopRecording(ms::Server *server)
+{
+    if (!server) { return; }
+    server->stopRecording();
+}
+
+msAPI uint64_t msServerGetLatencyCount(ms::Server *server, ms::LatencyStage stage)
+{
+    if (!server) { return 0; }
+    return server->getLatencyStats().get(stage).getCount();
+}
+msAPI float msServerGetLatencyAverage(ms::Server *server, ms::LatencyStage stage)
+{
+    if (!server) { return 0.0f; }
+    return mu::NS2MS(server->getLatencyStats().get(stage).getAverage());
+}
+msAPI float msServerGetLatencyMax(ms::Server *server, ms::LatencyStage stage)
+{
+    if (!server) { return 0.0f; }
+    return mu::NS2MS(server->getLatencyStats().get(stage).getMax());
+}
+msAPI float msServerGetLatencyPercentile(ms::Server *server, ms::LatencyStage stage, float p)
+{
+    if (!server) { return 0.0f; }
+    return mu::NS2MS(server->getLatencyStats().get(stage).getPercentile(p));
+}
+// dst: array of ms::LatencyHistogram::NumBuckets elements or null. returns the number of buckets
+msAPI int msServerGetLatencyHistogram(ms::Server *server, ms::LatencyStage stage, uint64_t *dst)
+{
+    if (!server) { return 0; }
+    if (dst) {
+        auto histogram = server->getLatencyStats().get(stage);
+        std::copy(histogram.getBuckets(), histogram.getBuckets() + ms::LatencyHistogram::NumBuckets, dst);
+    }
+    return ms::LatencyHistogram::NumBuckets;
+}
+msAPI float msLatencyGetBucketLowerBound(int i)
+{
+    return mu::NS2MS(ms::LatencyHistogram::getBucketLowerBound(i));
+}
+msAPI void msServerClearLatencyStats(ms::Server *server)
+{
+    if (!server) { return; }
+    server->getLatencyStats().clear();
+}
+
 msAPI int msGetGetBakeSkin(ms::GetMessage *self)
 {
     return self->refine_settings.flags.bake_skin;
@@ -217,6 +368,10 @@ msAPI int msGetGetBakeCloth(ms::GetMessage *self)
 {
     return self->refine_settings.flags.bake_cloth;
 }
+msAPI void msGetGetViewProj(ms::GetMessage *self, mu::float4x4 *dst)
+{
+    *dst = self->view_proj;
+}
 
 msAPI ms::Scene* msSetGetSceneData(ms::SetMessage *self)
 {
@@ -2,6 +2,7 @@
 using System.Linq;
 using System.Collections.Generic;
 using System.Reflection;
+using System.Runtime.InteropServices;
 using UnityEngine;
 using UnityEngine.SceneManagement;
 #if UNITY_2017_1_OR_NEWER
@@ -70,7 +71,7 @@ namespace UTJ.MeshSync
             public bool recved = false;
 
             // return true if modified
-            public bool BuildMaterialData(MeshData md)
+            public bool BuildMaterialData(MeshDescriptor md)
             {
                 int numSubmeshes = md.numSubmeshes;
 
@@ -663,15 +664,25 @@ namespace UTJ.MeshSync
             // handle entities
             Try(() =>
             {
-                int numObjects = scene.numEntities;
+                // transform data of all entities and descriptors of all meshes in a few calls.
+                // rows of m_entities are in the same order as entities. descriptors are in the order of meshes in entities.
+                if (m_entities == null)
+                    m_entities = new EntityTable();
+                if (m_meshDescriptors == null)
+                    m_meshDescriptors = new MeshDescriptorTable();
+                int numObjects = m_entities.Build(scene);
+                m_meshDescriptors.Build(scene);
+                int meshIndex = 0;
+
+                var types = m_entities.types;
                 for (int i = 0; i < numObjects; ++i)
                 {
                     EntityRecord dst = null;
                     var src = scene.GetEntity(i);
-                    switch (src.entityType)
+                    switch (types[i])
                     {
                         case EntityType.Transform:
-                            dst = UpdateTransform(src);
+                            dst = UpdateTransform(m_entities, i, src);
                             break;
                         case EntityType.Camera:
                             dst = UpdateCamera((CameraData)src);
@@ -680,7 +691,7 @@ namespace UTJ.MeshSync
                             dst = UpdateLight((LightData)src);
                             break;
                         case EntityType.Mesh:
-                            dst = UpdateMesh((MeshData)src);
+                            dst = UpdateMesh(m_meshDescriptors[meshIndex++]);
                             break;
                         case EntityType.Points:
                             dst = UpdatePoints((PointsData)src);
@@ -907,7 +918,7 @@ namespace UTJ.MeshSync
             }
         }
 
-        void UpdateTexture(TextureData src)
+        protected void UpdateTexture(TextureData src)
         {
             if (!m_handleAssets)
                 return;
@@ -942,10 +953,43 @@ namespace UTJ.MeshSync
             }
             else
             {
-                texture = new Texture2D(src.width, src.height, Misc.ToUnityTextureFormat(src.format), false);
+                // formats Unity doesn't have (e.g. RGBf16) are converted to the nearest one
+                var dstFormat = Misc.ToUnityCompatibleFormat(src.format);
+                var unityFormat = Misc.ToUnityTextureFormat(dstFormat);
+                // LoadRawTextureData() accepts only the full mip chain. partial chains are loaded as the first level only.
+                int mipCount = src.mipCount == TextureData.GetMipCount(src.width, src.height) ? src.mipCount : 1;
+                bool hasMips = mipCount > 1;
+
+                // a texture may be sent as coarse mip levels first and then the full chain.
+                // update the existing texture in place so that materials keep referencing it.
+                var prev = m_textureList.Find(a => a.id == src.id);
+                if (prev != null && prev.texture != null && IsRuntimeTexture(prev.texture))
+                {
+                    texture = prev.texture;
+#if UNITY_2021_2_OR_NEWER
+                    texture.Reinitialize(src.width, src.height, unityFormat, hasMips);
+#else
+                    texture.Resize(src.width, src.height, unityFormat, hasMips);
+#endif
+                }
+                else
+                {
+                    texture = new Texture2D(src.width, src.height, unityFormat, hasMips);
+                }
                 texture.name = src.name;
-                texture.LoadRawTextureData(src.dataPtr, src.sizeInByte);
-                texture.Apply();
+                if (dstFormat != src.format)
+                {
+                    int size = TextureData.GetDataSize(dstFormat, src.width, src.height, src.mipCount);
+                    var tmp = Marshal.AllocHGlobal(size);
+                    if (src.ConvertTo(tmp, dstFormat))
+                        texture.LoadRawTextureData(tmp, TextureData.GetDataSize(dstFormat, src.width, src.height, mipCount));
+                    Marshal.FreeHGlobal(tmp);
+                }
+                else if (mipCount != src.mipCount)
+                    texture.LoadRawTextureData(src.dataPtr, TextureData.GetDataSize(src.format, src.width, src.height, mipCount));
+                else
+                    texture.LoadRawTextureData(src.dataPtr, src.sizeInByte);
+                texture.Apply(false);
 #if UNITY_EDITOR
                 // encode and write data to file and import
                 // (script-generated texture works but can't set texture type such as normal map)
@@ -1005,6 +1049,15 @@ namespace UTJ.MeshSync
                     onUpdateTexture.Invoke(texture, src);
             }
         }
+        bool IsRuntimeTexture(Texture2D tex)
+        {
+#if UNITY_EDITOR
+            return !AssetDatabase.Contains(tex);
+#else
+            return true;
+#endif
+        }
+
         byte[] EncodeToPNG(Texture2D tex)
         {
 #if UNITY_2017_3_OR_NEWER
@@ -1040,6 +1093,13 @@ namespace UTJ.MeshSync
         const string _NORMALMAP = "_NORMALMAP";
 
         void UpdateMaterial(MaterialData src)
+        {
+            UpdateMaterial(src, src);
+        }
+
+        // changes: keywords and properties to apply. src itself or a delta of MaterialDeltaMessage.
+        // all of src is applied if the Unity material is (re)created.
+        protected void UpdateMaterial(MaterialData src, MaterialData changes)
         {
             var materialID = src.id;
             var materialName = src.name;
@@ -1076,6 +1136,7 @@ namespace UTJ.MeshSync
                     dst.material = candidate;
                     dst.materialIID = 0; // ignore material params
                     m_needReassignMaterials = true;
+                    changes = src;
                 }
             }
 #endif
@@ -1095,6 +1156,7 @@ namespace UTJ.MeshSync
 
                 dst.materialIID = dst.material.GetInstanceID();
                 m_needReassignMaterials = true;
+                changes = src;
             }
             dst.name = materialName;
             dst.index = src.index;
@@ -1104,20 +1166,20 @@ namespace UTJ.MeshSync
             var dstmat = dst.material;
             if (m_syncMaterials && dst.materialIID == dst.material.GetInstanceID())
             {
-                int numKeywords = src.numKeywords;
+                int numKeywords = changes.numKeywords;
                 for (int ki = 0; ki < numKeywords; ++ki)
                 {
-                    var kw = src.GetKeyword(ki);
+                    var kw = changes.GetKeyword(ki);
                     if (kw.value)
                         dstmat.EnableKeyword(kw.name);
                     else
                         dstmat.DisableKeyword(kw.name);
                 }
 
-                int numProps = src.numProperties;
+                int numProps = changes.numProperties;
                 for (int pi = 0; pi < numProps; ++pi)
                 {
-                    var prop = src.GetProperty(pi);
+                    var prop = changes.GetProperty(pi);
                     var propName = prop.name;
                     var propType = prop.type;
                     if (!dstmat.HasProperty(propName))
@@ -1204,13 +1266,14 @@ namespace UTJ.MeshSync
                 onUpdateMaterial.Invoke(dstmat, src);
         }
 
-        EntityRecord UpdateMesh(MeshData data)
+        EntityRecord UpdateMesh(MeshDescriptor desc)
         {
             if (!m_syncMeshes)
                 return null;
 
+            var data = desc.mesh;
             var dtrans = data.transform;
-            var dflags = data.dataFlags;
+            var dflags = desc.dataFlags;
             var rec = UpdateTransform(dtrans);
             if (rec == null || dflags.unchanged)
                 return null;
@@ -1230,7 +1293,7 @@ namespace UTJ.MeshSync
 
 
             // allocate material list
-            bool materialsUpdated = rec.BuildMaterialData(data);
+            bool materialsUpdated = rec.BuildMaterialData(desc);
             bool meshUpdated = false;
 
             if (dflags.hasPoints && dflags.hasIndices)
@@ -1239,7 +1302,7 @@ namespace UTJ.MeshSync
                 // assume there is always only 1 mesh split.
                 // old versions supported multiple splits because vertex index was 16 bit (pre-Unity 2017.3),
                 // but that code path was removed for simplicity and my sanity.
-                if (data.numIndices == 0)
+                if (desc.numIndices == 0)
                 {
                     if (rec.mesh != null)
                         rec.mesh.Clear();
@@ -1256,7 +1319,7 @@ namespace UTJ.MeshSync
                         rec.mesh.indexFormat = UnityEngine.Rendering.IndexFormat.UInt32;
 #endif
                     }
-                    UpdateMesh(ref rec.mesh, data);
+                    UpdateMesh(ref rec.mesh, desc);
                 }
                 meshUpdated = true;
             }
@@ -1293,8 +1356,8 @@ namespace UTJ.MeshSync
                 if (dflags.hasBones)
                 {
                     if (dflags.hasRootBone)
-                        rec.rootBonePath = data.rootBonePath;
-                    rec.bonePaths = data.bonePaths;
+                        rec.rootBonePath = desc.rootBonePath;
+                    rec.bonePaths = desc.bonePaths;
                     // bones will be resolved in AfterUpdateScene()
                 }
                 else
@@ -1306,7 +1369,7 @@ namespace UTJ.MeshSync
                 // update blendshape weights
                 if (dflags.hasBlendshapes)
                 {
-                    int numBlendShapes = Math.Min(data.numBlendShapes, rec.mesh.blendShapeCount);
+                    int numBlendShapes = Math.Min(desc.numBlendShapes, rec.mesh.blendShapeCount);
                     for (int bi = 0; bi < numBlendShapes; ++bi)
                     {
                         var bsd = data.GetBlendShapeData(bi);
@@ -1354,18 +1417,23 @@ namespace UTJ.MeshSync
             return rec;
         }
 
+        EntityTable m_entities;
+        MeshDescriptorTable m_meshDescriptors;
         PinnedList<int> m_tmpI = new PinnedList<int>();
-        PinnedList<Vector2> m_tmpV2 = new PinnedList<Vector2>();
-        PinnedList<Vector3> m_tmpV3 = new PinnedList<Vector3>();
-        PinnedList<Vector4> m_tmpV4 = new PinnedList<Vector4>();
-        PinnedList<Color> m_tmpC = new PinnedList<Color>();
+        PinnedList<Vector3> m_tmpPoints = new PinnedList<Vector3>();
+        PinnedList<Vector3> m_tmpNormals = new PinnedList<Vector3>();
+        PinnedList<Vector4> m_tmpTangents = new PinnedList<Vector4>();
+        PinnedList<Vector2> m_tmpUV0 = new PinnedList<Vector2>();
+        PinnedList<Vector2> m_tmpUV1 = new PinnedList<Vector2>();
+        PinnedList<Color> m_tmpColors = new PinnedList<Color>();
 
-        void UpdateMesh(ref Mesh mesh, MeshData data)
+        void UpdateMesh(ref Mesh mesh, MeshDescriptor desc)
         {
+            var data = desc.mesh;
             bool keepIndices = false;
             if (mesh.vertexCount != 0)
             {
-                if (data.dataFlags.topologyUnchanged)
+                if (desc.dataFlags.topologyUnchanged)
                     keepIndices = true;
                 else
                 {
@@ -1375,80 +1443,101 @@ namespace UTJ.MeshSync
                 }
             }
 
-            var numPoints = data.numPoints;
-            var dataFlags = data.dataFlags;
+            // all vertex attributes and bone data are copied by one call
+            var numPoints = desc.numPoints;
+            var dataFlags = desc.dataFlags;
+            var buffers = default(MeshBuffers);
             if (dataFlags.hasPoints)
             {
-                m_tmpV3.Resize(numPoints);
-                data.ReadPoints(m_tmpV3);
-                mesh.SetVertices(m_tmpV3.List);
+                m_tmpPoints.Resize(numPoints);
+                buffers.points = m_tmpPoints;
             }
             if (dataFlags.hasNormals)
             {
-                m_tmpV3.Resize(numPoints);
-                data.ReadNormals(m_tmpV3);
-                mesh.SetNormals(m_tmpV3.List);
+                m_tmpNormals.Resize(numPoints);
+                buffers.normals = m_tmpNormals;
             }
             if (dataFlags.hasTangents)
             {
-                m_tmpV4.Resize(numPoints);
-                data.ReadTangents(m_tmpV4);
-                mesh.SetTangents(m_tmpV4.List);
+                m_tmpTangents.Resize(numPoints);
+                buffers.tangents = m_tmpTangents;
             }
             if (dataFlags.hasUV0)
             {
-                m_tmpV2.Resize(numPoints);
-                data.ReadUV0(m_tmpV2);
-                mesh.SetUVs(0, m_tmpV2.List);
+                m_tmpUV0.Resize(numPoints);
+                buffers.uv0 = m_tmpUV0;
             }
             if (dataFlags.hasUV1)
             {
-                m_tmpV2.Resize(numPoints);
-                data.ReadUV1(m_tmpV2);
-                mesh.SetUVs(1, m_tmpV2.List);
+                m_tmpUV1.Resize(numPoints);
+                buffers.uv1 = m_tmpUV1;
             }
             if (dataFlags.hasColors)
             {
-                m_tmpC.Resize(numPoints);
-                data.ReadColors(m_tmpC);
-                mesh.SetColors(m_tmpC.List);
+                m_tmpColors.Resize(numPoints);
+                buffers.colors = m_tmpColors;
             }
+
+            PinnedArray<Matrix4x4> bindposes = null;
+#if UNITY_2019_1_OR_NEWER
+            var bonesPerVertex = default(NativeArray<byte>);
+            var weights1 = default(NativeArray<BoneWeight1>);
+#else
+            PinnedList<BoneWeight> weights4 = null;
+#endif
             if (dataFlags.hasBones)
             {
-                mesh.bindposes = data.bindposes;
+                bindposes = new PinnedArray<Matrix4x4>(desc.numBones);
+                buffers.bindposes = bindposes;
 #if UNITY_2019_1_OR_NEWER
-                {
-                    // bonesPerVertex + weights1
-                    var bonesPerVertex = new NativeArray<byte>(numPoints, Allocator.Temp);
-                    var weights1 = new NativeArray<BoneWeight1>(data.numBoneWeights, Allocator.Temp);
-                    data.ReadBoneCounts(Misc.ForceGetPointer(ref bonesPerVertex));
-                    data.ReadBoneWeightsV(Misc.ForceGetPointer(ref weights1));
-                    mesh.SetBoneWeights(bonesPerVertex, weights1);
-                    bonesPerVertex.Dispose();
-                    weights1.Dispose();
-                }
+                // bonesPerVertex + weights1
+                bonesPerVertex = new NativeArray<byte>(numPoints, Allocator.Temp);
+                weights1 = new NativeArray<BoneWeight1>(desc.numBoneWeights, Allocator.Temp);
+                buffers.boneCounts = Misc.ForceGetPointer(ref bonesPerVertex);
+                buffers.boneWeights = Misc.ForceGetPointer(ref weights1);
 #else
-                {
-                    // weights4
-                    var tmpWeights4 = new PinnedList<BoneWeight>();
-                    tmpWeights4.Resize(numPoints);
-                    data.ReadBoneWeights4(tmpWeights4);
-                    mesh.boneWeights = tmpWeights4.Array;
-                    tmpWeights4.Dispose();
-                }
+                // weights4
+                weights4 = new PinnedList<BoneWeight>(numPoints);
+                buffers.boneWeights4 = weights4;
+#endif
+            }
+            desc.Read(ref buffers);
+
+            if (dataFlags.hasPoints)
+                mesh.SetVertices(m_tmpPoints.List);
+            if (dataFlags.hasNormals)
+                mesh.SetNormals(m_tmpNormals.List);
+            if (dataFlags.hasTangents)
+                mesh.SetTangents(m_tmpTangents.List);
+            if (dataFlags.hasUV0)
+                mesh.SetUVs(0, m_tmpUV0.List);
+            if (dataFlags.hasUV1)
+                mesh.SetUVs(1, m_tmpUV1.List);
+            if (dataFlags.hasColors)
+                mesh.SetColors(m_tmpColors.List);
+            if (dataFlags.hasBones)
+            {
+                mesh.bindposes = bindposes.Array;
+                bindposes.Dispose();
+#if UNITY_2019_1_OR_NEWER
+                mesh.SetBoneWeights(bonesPerVertex, weights1);
+                bonesPerVertex.Dispose();
+                weights1.Dispose();
+#else
+                mesh.boneWeights = weights4.Array;
+                weights4.Dispose();
 #endif
             }
             if (dataFlags.hasIndices && !keepIndices)
             {
-                int subMeshCount = data.numSubmeshes;
+                int subMeshCount = desc.numSubmeshes;
                 mesh.subMeshCount = subMeshCount;
                 for (int smi = 0; smi < subMeshCount; ++smi)
                 {
-                    var submesh = data.GetSubmesh(smi);
+                    var submesh = desc.GetSubmesh(smi);
                     var topology = submesh.topology;
 
-                    m_tmpI.Resize(submesh.numIndices);
-                    submesh.ReadIndices(data, m_tmpI);
+                    desc.ReadSubmeshIndices(submesh, m_tmpI);
 
                     if (topology == SubmeshData.Topology.Triangles)
                     {
@@ -1475,7 +1564,7 @@ namespace UTJ.MeshSync
                 var tmpBSN = new PinnedList<Vector3>(numPoints);
                 var tmpBST = new PinnedList<Vector3>(numPoints);
 
-                int numBlendShapes = data.numBlendShapes;
+                int numBlendShapes = desc.numBlendShapes;
                 for (int bi = 0; bi < numBlendShapes; ++bi)
                 {
                     var bsd = data.GetBlendShapeData(bi);
@@ -1495,7 +1584,7 @@ namespace UTJ.MeshSync
                 tmpBST.Dispose();
             }
 
-            mesh.bounds = data.bounds;
+            mesh.bounds = desc.bounds;
             mesh.UploadMeshData(false);
         }
 
@@ -1545,12 +1634,35 @@ namespace UTJ.MeshSync
 
         EntityRecord UpdateTransform(TransformData data)
         {
-            var path = data.path;
-            int hostID = data.hostID;
+            var rec = FindOrCreateTransformRecord(data.path, data.hostID);
+            if (rec == null)
+                return null;
+
+            var dflags = data.dataFlags;
+            if (!dflags.unchanged)
+                ApplyTransform(rec, data, dflags, data.entityType, data.index, data.position, data.rotation, data.scale, data.visibility);
+            return rec;
+        }
+
+        // row: row of the table. data: entity of the row. used only to get the reference if it exists.
+        EntityRecord UpdateTransform(EntityTable table, int row, TransformData data)
+        {
+            var rec = FindOrCreateTransformRecord(table.GetPath(row), table.hostIDs[row]);
+            if (rec == null)
+                return null;
+
+            var dflags = table.dataFlags[row];
+            if (!dflags.unchanged)
+                ApplyTransform(rec, data, dflags, table.types[row], table.indices[row],
+                    table.positions[row], table.rotations[row], table.scales[row], table.visibilities[row]);
+            return rec;
+        }
+
+        EntityRecord FindOrCreateTransformRecord(string path, int hostID)
+        {
             if (path.Length == 0)
                 return null;
 
-            Transform trans = null;
             EntityRecord rec = null;
             if (hostID != Lib.invalidID)
             {
@@ -1578,7 +1690,7 @@ namespace UTJ.MeshSync
                 if (rec == null)
                 {
                     bool created = false;
-                    trans = FindOrCreateObjectByPath(path, true, ref created);
+                    var trans = FindOrCreateObjectByPath(path, true, ref created);
                     rec = new EntityRecord
                     {
                         go = trans.gameObject,
@@ -1589,44 +1701,43 @@ namespace UTJ.MeshSync
                 }
             }
 
-            trans = rec.trans;
-            if (trans == null)
-                trans = rec.trans = rec.go.transform;
+            if (rec.trans == null)
+                rec.trans = rec.go.transform;
+            return rec;
+        }
 
-            var dflags = data.dataFlags;
-            if (!dflags.unchanged)
-            {
-                var visibility = data.visibility;
-                rec.index = data.index;
-                rec.dataType = data.entityType;
+        void ApplyTransform(EntityRecord rec, TransformData data, TransformDataFlags dflags, EntityType entityType, int index,
+            Vector3 position, Quaternion rotation, Vector3 scale, VisibilityFlags visibility)
+        {
+            var trans = rec.trans;
+            rec.index = index;
+            rec.dataType = entityType;
 
-                // sync TRS
-                if (m_syncTransform)
-                {
-                    if (dflags.hasPosition)
-                        trans.localPosition = data.position;
-                    if (dflags.hasRotation)
-                        trans.localRotation = data.rotation;
-                    if (dflags.hasScale)
-                        trans.localScale = data.scale;
-                }
+            // sync TRS
+            if (m_syncTransform)
+            {
+                if (dflags.hasPosition)
+                    trans.localPosition = position;
+                if (dflags.hasRotation)
+                    trans.localRotation = rotation;
+                if (dflags.hasScale)
+                    trans.localScale = scale;
+            }
 
-                // visibility
-                if (m_syncVisibility && dflags.hasVisibility)
-                    trans.gameObject.SetActive(visibility.active);
+            // visibility
+            if (m_syncVisibility && dflags.hasVisibility)
+                trans.gameObject.SetActive(visibility.active);
 
-                // visibility for reference
-                rec.hasVisibility = dflags.hasVisibility;
-                if (rec.hasVisibility)
-                    rec.visibility = visibility;
+            // visibility for reference
+            rec.hasVisibility = dflags.hasVisibility;
+            if (rec.hasVisibility)
+                rec.visibility = visibility;
 
-                // reference. will be resolved in AfterUpdateScene()
-                if (dflags.hasReference)
-                    rec.reference = data.reference;
-                else
-                    rec.reference = null;
-            }
-            return rec;
+            // reference. will be resolved in AfterUpdateScene()
+            if (dflags.hasReference)
+                rec.reference = data.reference;
+            else
+                rec.reference = null;
         }
 
         EntityRecord UpdateCamera(CameraData data)
@@ -1925,7 +2036,8 @@ namespace UTJ.MeshSync
 #endif
         }
 
-        void UpdateAnimation(AnimationClipData clipData)
+        // partial: clipData has only the updated curves (see AnimationDeltaMessage). other curves of the clip are kept.
+        protected void UpdateAnimation(AnimationClipData clipData, bool partial = false)
         {
 #if UNITY_EDITOR
             if (!m_handleAssets)
@@ -2015,6 +2127,7 @@ namespace UTJ.MeshSync
 #if UNITY_2018_1_OR_NEWER
                     usePhysicalCameraParams = m_usePhysicalCameraParams,
 #endif
+                    partial = partial,
                 };
                 if (rec != null)
                 {
@@ -2419,10 +2532,22 @@ namespace UTJ.MeshSync
         void OnDestroy()
         {
             m_tmpI.Dispose();
-            m_tmpV2.Dispose();
-            m_tmpV3.Dispose();
-            m_tmpV4.Dispose();
-            m_tmpC.Dispose();
+            m_tmpPoints.Dispose();
+            m_tmpNormals.Dispose();
+            m_tmpTangents.Dispose();
+            m_tmpUV0.Dispose();
+            m_tmpUV1.Dispose();
+            m_tmpColors.Dispose();
+            if (m_entities != null)
+            {
+                m_entities.Dispose();
+                m_entities = null;
+            }
+            if (m_meshDescriptors != null)
+            {
+                m_meshDescriptors.Dispose();
+                m_meshDescriptors = null;
+            }
         }
 
         protected virtual void OnEnable()
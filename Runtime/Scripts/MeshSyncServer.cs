@@ -141,6 +141,15 @@ namespace UTJ.MeshSync
                     case MessageType.Query:
                         OnRecvQuery((QueryMessage)data);
                         break;
+                    case MessageType.AnimationDelta:
+                        OnRecvAnimationDelta((AnimationDeltaMessage)data);
+                        break;
+                    case MessageType.TextureTiles:
+                        OnRecvTextureTiles((TextureTilesMessage)data);
+                        break;
+                    case MessageType.MaterialDelta:
+                        OnRecvMaterialDelta((MaterialDeltaMessage)data);
+                        break;
                     default:
                         break;
                 }
@@ -194,6 +203,41 @@ namespace UTJ.MeshSync
             UpdateScene(mes.scene);
         }
 
+        void OnRecvAnimationDelta(AnimationDeltaMessage mes)
+        {
+            int numClips = mes.numClips;
+            for (int i = 0; i < numClips; ++i)
+                UpdateAnimation(mes.GetClip(i), true);
+        }
+
+        void OnRecvTextureTiles(TextureTilesMessage mes)
+        {
+            int numTextures = mes.numTextures;
+            for (int i = 0; i < numTextures; ++i)
+            {
+                var tex = mes.GetTexture(i);
+                if (tex)
+                    UpdateTexture(tex);
+            }
+        }
+
+        void OnRecvMaterialDelta(MaterialDeltaMessage mes)
+        {
+            int numMaterials = mes.numMaterials;
+            for (int i = 0; i < numMaterials; ++i)
+            {
+                var mat = mes.GetMaterial(i);
+                if (mat)
+                    UpdateMaterial(mat, mes.GetDelta(i));
+            }
+            if (m_needReassignMaterials)
+            {
+                m_materialList = m_materialList.OrderBy(v => v.index).ToList();
+                ReassignMaterials();
+                m_needReassignMaterials = false;
+            }
+        }
+
         void OnRecvScreenshot(IntPtr data)
         {
             ForceRepaint();
@@ -229,10 +229,35 @@ namespace UTJ.MeshSync
                 case TextureFormat.Rf32: return UnityEngine.TextureFormat.RFloat;
                 case TextureFormat.RGf32: return UnityEngine.TextureFormat.RGFloat;
                 case TextureFormat.RGBAf32: return UnityEngine.TextureFormat.RGBAFloat;
+                case TextureFormat.BC1: return UnityEngine.TextureFormat.DXT1;
+                case TextureFormat.BC3: return UnityEngine.TextureFormat.DXT5;
+                case TextureFormat.BC4: return UnityEngine.TextureFormat.BC4;
+                case TextureFormat.BC5: return UnityEngine.TextureFormat.BC5;
+                case TextureFormat.BC7: return UnityEngine.TextureFormat.BC7;
                 default: return UnityEngine.TextureFormat.Alpha8;
             }
         }
 
+        // nearest format that ToUnityTextureFormat() can map. 3 channel float and integer formats are expanded.
+        public static TextureFormat ToUnityCompatibleFormat(TextureFormat v)
+        {
+            switch (v)
+            {
+                case TextureFormat.RGBf16: return TextureFormat.RGBAf16;
+                case TextureFormat.Ri16: return TextureFormat.Rf32;
+                case TextureFormat.Ri32: return TextureFormat.Rf32;
+                case TextureFormat.RGi16: return TextureFormat.RGf32;
+                case TextureFormat.RGi32: return TextureFormat.RGf32;
+                case TextureFormat.RGBf32:
+                case TextureFormat.RGBi16:
+                case TextureFormat.RGBi32:
+                case TextureFormat.RGBAi16:
+                case TextureFormat.RGBAi32:
+                    return TextureFormat.RGBAf32;
+                default: return v;
+            }
+        }
+
         public static TextureFormat ToMSTextureFormat(UnityEngine.TextureFormat v)
         {
             switch (v)
@@ -247,6 +272,11 @@ namespace UTJ.MeshSync
                 case UnityEngine.TextureFormat.RFloat: return TextureFormat.Rf32;
                 case UnityEngine.TextureFormat.RGFloat: return TextureFormat.RGf32;
                 case UnityEngine.TextureFormat.RGBAFloat: return TextureFormat.RGBAf32;
+                case UnityEngine.TextureFormat.DXT1: return TextureFormat.BC1;
+                case UnityEngine.TextureFormat.DXT5: return TextureFormat.BC3;
+                case UnityEngine.TextureFormat.BC4: return TextureFormat.BC4;
+                case UnityEngine.TextureFormat.BC5: return TextureFormat.BC5;
+                case UnityEngine.TextureFormat.BC7: return TextureFormat.BC7;
                 default: return TextureFormat.Ru8;
             }
         }
@@ -233,6 +233,7 @@ namespace UTJ.MeshSync
         Type_u8 = 0x3 << 4,
         Type_i16 = 0x4 << 4,
         Type_i32 = 0x5 << 4,
+        Type_BC = 0x6 << 4,
 
         Rf16 = Type_f16 | 1,
         RGf16 = Type_f16 | 2,
@@ -254,10 +255,25 @@ namespace UTJ.MeshSync
         RGi32 = Type_i32 | 2,
         RGBi32 = Type_i32 | 3,
         RGBAi32 = Type_i32 | 4,
+        BC1 = Type_BC | 1,
+        BC3 = Type_BC | 3,
+        BC4 = Type_BC | 4,
+        BC5 = Type_BC | 5,
+        BC7 = Type_BC | 7,
 
         RawFile = 0x10 << 4,
     }
 
+    [Flags]
+    public enum PixelConvertFlags
+    {
+        None = 0,
+        FlipY = 1,
+        SRGBToLinear = 2,
+        LinearToSRGB = 4,
+        SwapRB = 8,
+    }
+
     [StructLayout(LayoutKind.Explicit)]
     public struct TextureData
     {
@@ -273,13 +289,20 @@ namespace UTJ.MeshSync
         [DllImport(Lib.name)] static extern void msTextureSetWidth(IntPtr self, int v);
         [DllImport(Lib.name)] static extern int msTextureGetHeight(IntPtr self);
         [DllImport(Lib.name)] static extern void msTextureSetHeight(IntPtr self, int v);
+        [DllImport(Lib.name)] static extern int msTextureGetMipCount(IntPtr self);
+        [DllImport(Lib.name)] static extern void msTextureSetMipCount(IntPtr self, int v);
         [DllImport(Lib.name)] static extern IntPtr msTextureGetDataPtr(IntPtr self);
         [DllImport(Lib.name)] static extern int msTextureGetSizeInByte(IntPtr self);
         [DllImport(Lib.name)] static extern byte msTextureWriteToFile(IntPtr self, string path);
+        [DllImport(Lib.name)] static extern byte msTextureConvert(IntPtr self, TextureFormat format, PixelConvertFlags flags);
+        [DllImport(Lib.name)] static extern byte msTextureConvertTo(IntPtr self, IntPtr dst, TextureFormat format, PixelConvertFlags flags);
+        [DllImport(Lib.name)] static extern int msGetTextureDataSize(TextureFormat format, int width, int height, int mipCount);
+        [DllImport(Lib.name)] static extern byte msConvertPixels(IntPtr dst, TextureFormat dstFormat, IntPtr src, TextureFormat srcFormat, int width, int height, PixelConvertFlags flags);
         [DllImport(Lib.name)] static extern byte msWriteToFile(string path, byte[] data, int size);
         #endregion
 
         public static TextureData Create() { return msTextureCreate(); }
+        public static implicit operator bool(TextureData v) { return v.self != IntPtr.Zero; }
 
         public int id
         {
@@ -311,6 +334,11 @@ namespace UTJ.MeshSync
             get { return msTextureGetHeight(self); }
             set { msTextureSetHeight(self, value); }
         }
+        public int mipCount
+        {
+            get { return msTextureGetMipCount(self); }
+            set { msTextureSetMipCount(self, value); }
+        }
         public int sizeInByte
         {
             get { return msTextureGetSizeInByte(self); }
@@ -320,6 +348,33 @@ namespace UTJ.MeshSync
             get { return msTextureGetDataPtr(self); }
         }
 
+        // converts all mip levels. block compressed formats are decoded / encoded as needed
+        public bool Convert(TextureFormat format, PixelConvertFlags flags = PixelConvertFlags.None)
+        {
+            return msTextureConvert(self, format, flags) != 0;
+        }
+        // dst must have GetDataSize(format, width, height, mipCount) bytes. uncompressed formats only
+        public bool ConvertTo(IntPtr dst, TextureFormat format, PixelConvertFlags flags = PixelConvertFlags.None)
+        {
+            return msTextureConvertTo(self, dst, format, flags) != 0;
+        }
+        public static int GetDataSize(TextureFormat format, int width, int height, int mipCount = 1)
+        {
+            return msGetTextureDataSize(format, width, height, mipCount);
+        }
+        // number of levels of the full mip chain. (e.g. 256x64 -> 9)
+        public static int GetMipCount(int width, int height)
+        {
+            int ret = 1;
+            for (int size = Math.Max(width, height); size > 1; size >>= 1)
+                ++ret;
+            return ret;
+        }
+        public static bool ConvertPixels(IntPtr dst, TextureFormat dstFormat, IntPtr src, TextureFormat srcFormat, int width, int height, PixelConvertFlags flags = PixelConvertFlags.None)
+        {
+            return msConvertPixels(dst, dstFormat, src, srcFormat, width, height, flags) != 0;
+        }
+
 #if UNITY_EDITOR
         public bool WriteToFile(string path)
         {
@@ -606,6 +661,8 @@ namespace UTJ.MeshSync
 #if UNITY_2018_1_OR_NEWER
         public bool usePhysicalCameraParams;
 #endif
+        // if true, only the curves in the data are updated and the others in the clip are kept
+        public bool partial;
     }
 
     public struct AnimationCurveData
@@ -745,8 +802,8 @@ namespace UTJ.MeshSync
             var ttrans = typeof(Transform);
 
             {
-                SetCurve(clip, path, ttrans, "m_LocalPosition", null, true);
                 var curves = GenCurves(msAnimationGetTransformTranslation(self));
+                SetCurve(clip, path, ttrans, "m_LocalPosition", null, !ctx.partial || curves != null);
                 if (curves != null && curves.Length == 3)
                 {
                     SetCurve(clip, path, ttrans, "m_LocalPosition.x", curves[0]);
@@ -755,9 +812,9 @@ namespace UTJ.MeshSync
                 }
             }
             {
-                SetCurve(clip, path, ttrans, "m_LocalEuler", null, true);
-                SetCurve(clip, path, ttrans, "m_LocalRotation", null, true);
                 var curves = GenCurves(msAnimationGetTransformRotation(self));
+                SetCurve(clip, path, ttrans, "m_LocalEuler", null, !ctx.partial || curves != null);
+                SetCurve(clip, path, ttrans, "m_LocalRotation", null, !ctx.partial || curves != null);
                 if (curves != null)
                 {
                     if (curves.Length == 3)
@@ -776,8 +833,8 @@ namespace UTJ.MeshSync
                 }
             }
             {
-                SetCurve(clip, path, ttrans, "m_LocalScale", null, true);
                 var curves = GenCurves(msAnimationGetTransformScale(self));
+                SetCurve(clip, path, ttrans, "m_LocalScale", null, !ctx.partial || curves != null);
                 if (curves != null && curves.Length == 3)
                 {
                     SetCurve(clip, path, ttrans, "m_LocalScale.x", curves[0]);
@@ -788,8 +845,8 @@ namespace UTJ.MeshSync
             if (ctx.enableVisibility && ctx.mainComponentType != null)
             {
                 const string Target = "m_Enabled";
-                SetCurve(clip, path, ctx.mainComponentType, Target, null, true);
                 var curves = GenCurves(msAnimationGetTransformVisible(self));
+                SetCurve(clip, path, ctx.mainComponentType, Target, null, !ctx.partial || curves != null);
                 if (curves != null && curves.Length == 1)
                     SetCurve(clip, path, ctx.mainComponentType, Target, curves[0]);
             }
@@ -810,8 +867,8 @@ namespace UTJ.MeshSync
             if (ctx.usePhysicalCameraParams)
             {
                 const string Target = "m_FocalLength";
-                SetCurve(clip, path, tcam, Target, null, true);
                 var curves = GenCurves(msAnimationGetCameraFocalLength(self));
+                SetCurve(clip, path, tcam, Target, null, !ctx.partial || curves != null);
                 if (curves != null && curves.Length == 1)
                 {
                     SetCurve(clip, path, tcam, Target, curves[0]);
@@ -821,8 +878,8 @@ namespace UTJ.MeshSync
             if (isPhysicalCameraParamsAvailable)
             {
                 {
-                    SetCurve(clip, path, tcam, "m_SensorSize", null, true);
                     var curves = GenCurves(msAnimationGetCameraSensorSize(self));
+                    SetCurve(clip, path, tcam, "m_SensorSize", null, !ctx.partial || curves != null);
                     if (curves != null && curves.Length == 2)
                     {
                         SetCurve(clip, path, tcam, "m_SensorSize.x", curves[0]);
@@ -830,8 +887,8 @@ namespace UTJ.MeshSync
                     }
                 }
                 {
-                    SetCurve(clip, path, tcam, "m_LensShift", null, true);
                     var curves = GenCurves(msAnimationGetCameraLensShift(self));
+                    SetCurve(clip, path, tcam, "m_LensShift", null, !ctx.partial || curves != null);
                     if (curves != null && curves.Length == 2)
                     {
                         SetCurve(clip, path, tcam, "m_LensShift.x", curves[0]);
@@ -843,23 +900,23 @@ namespace UTJ.MeshSync
 #endif
             {
                 const string Target = "field of view";
-                SetCurve(clip, path, tcam, Target, null, true);
                 var curves = GenCurves(msAnimationGetCameraFieldOfView(self));
+                SetCurve(clip, path, tcam, Target, null, !ctx.partial || curves != null);
                 if (curves != null && curves.Length == 1)
                     SetCurve(clip, path, tcam, Target, curves[0]);
             }
 
             {
                 const string Target = "far clip plane";
-                SetCurve(clip, path, tcam, Target, null, true);
                 var curves = GenCurves(msAnimationGetCameraFarPlane(self));
+                SetCurve(clip, path, tcam, Target, null, !ctx.partial || curves != null);
                 if (curves != null && curves.Length == 1)
                     SetCurve(clip, path, tcam, Target, curves[0]);
             }
             {
                 const string Target = "near clip plane";
-                SetCurve(clip, path, tcam, Target, null, true);
                 var curves = GenCurves(msAnimationGetCameraNearPlane(self));
+                SetCurve(clip, path, tcam, Target, null, !ctx.partial || curves != null);
                 if (curves != null && curves.Length == 1)
                     SetCurve(clip, path, tcam, Target, curves[0]);
             }
@@ -875,8 +932,8 @@ namespace UTJ.MeshSync
             var path = ctx.path;
 
             {
-                SetCurve(clip, path, tlight, "m_Color", null, true);
                 var curves = GenCurves(msAnimationGetLightColor(self));
+                SetCurve(clip, path, tlight, "m_Color", null, !ctx.partial || curves != null);
                 if (curves != null && curves.Length == 4)
                 {
                     SetCurve(clip, path, tlight, "m_Color.r", curves[0]);
@@ -887,22 +944,22 @@ namespace UTJ.MeshSync
             }
             {
                 const string Target = "m_Intensity";
-                SetCurve(clip, path, tlight, Target, null, true);
                 var curves = GenCurves(msAnimationGetLightIntensity(self));
+                SetCurve(clip, path, tlight, Target, null, !ctx.partial || curves != null);
                 if (curves != null && curves.Length == 1)
                     SetCurve(clip, path, tlight, Target, curves[0]);
             }
             {
                 const string Target = "m_Range";
-                SetCurve(clip, path, tlight, Target, null, true);
                 var curves = GenCurves(msAnimationGetLightRange(self));
+                SetCurve(clip, path, tlight, Target, null, !ctx.partial || curves != null);
                 if (curves != null && curves.Length == 1)
                     SetCurve(clip, path, tlight, Target, curves[0]);
             }
             {
                 const string Target = "m_SpotAngle";
-                SetCurve(clip, path, tlight, Target, null, true);
                 var curves = GenCurves(msAnimationGetLightSpotAngle(self));
+                SetCurve(clip, path, tlight, Target, null, !ctx.partial || curves != null);
                 if (curves != null && curves.Length == 1)
                     SetCurve(clip, path, tlight, Target, curves[0]);
             }
@@ -926,7 +983,7 @@ namespace UTJ.MeshSync
 
             {
                 // blendshape animation
-                SetCurve(clip, path, tsmr, "blendShape", null, true);
+                SetCurve(clip, path, tsmr, "blendShape", null, !ctx.partial);
 
                 s_blendshapes = new List<AnimationCurveData>();
                 msAnimationEachBlendshapeCurves(self, BlendshapeCallback);
@@ -1788,6 +1845,159 @@ namespace UTJ.MeshSync
             return msMeshAddBlendShape(self, name);
         }
     };
+
+    // must be synced with C++ side (ms::SubmeshData)
+    [StructLayout(LayoutKind.Sequential)]
+    public struct SubmeshDescriptor
+    {
+        public int numIndices;
+        public int indexOffset;
+        public SubmeshData.Topology topology;
+        public int materialID;
+    }
+
+    // must be synced with C++ side
+    // flat view of a MeshData. pointers refer to native memory that is valid until the table or the scene is released.
+    [StructLayout(LayoutKind.Sequential)]
+    public struct MeshDescriptor
+    {
+        #region internal
+        public MeshData mesh;
+        public IntPtr points;
+        public IntPtr normals;
+        public IntPtr tangents;
+        public IntPtr uv0;
+        public IntPtr uv1;
+        public IntPtr colors;
+        public IntPtr velocities;
+        public IntPtr indices;
+        public IntPtr counts;
+        public IntPtr submeshes;
+        public IntPtr boneCounts;
+        public IntPtr boneWeights;
+        public IntPtr boneWeights4;
+        public IntPtr rootBone;
+        public IntPtr bonePaths;
+        public Bounds bounds;
+        public MeshDataFlags dataFlags;
+        public int numPoints;
+        public int numIndices;
+        public int numCounts;
+        public int numSubmeshes;
+        public int numBones;
+        public int numBoneWeights;
+        public int numBlendShapes;
+
+        [DllImport(Lib.name)] static extern void msMeshDescriptorRead(ref MeshDescriptor self, ref MeshBuffers dst);
+        #endregion
+
+        static readonly int s_submeshStride = Marshal.SizeOf(typeof(SubmeshDescriptor));
+
+        public string rootBonePath { get { return Misc.S(rootBone); } }
+
+        public string[] bonePaths
+        {
+            get
+            {
+                var ret = new string[numBones];
+                for (int i = 0; i < numBones; ++i)
+                    ret[i] = Misc.S(Marshal.ReadIntPtr(bonePaths, i * IntPtr.Size));
+                return ret;
+            }
+        }
+
+        public SubmeshDescriptor GetSubmesh(int i)
+        {
+            return (SubmeshDescriptor)Marshal.PtrToStructure(new IntPtr(submeshes.ToInt64() + i * s_submeshStride), typeof(SubmeshDescriptor));
+        }
+
+        // copy indices of a submesh without calling into the plugin
+        public void ReadSubmeshIndices(SubmeshDescriptor submesh, PinnedList<int> dst)
+        {
+            dst.Resize(submesh.numIndices);
+            if (submesh.numIndices > 0)
+                Marshal.Copy(new IntPtr(indices.ToInt64() + submesh.indexOffset * sizeof(int)), dst.Array, 0, submesh.numIndices);
+        }
+
+        // copy vertex attributes, bone weights and bindposes into dst in one call
+        public void Read(ref MeshBuffers dst) { msMeshDescriptorRead(ref this, ref dst); }
+    }
+
+    // must be synced with C++ side
+    // destination of MeshDescriptor.Read(). IntPtr.Zero fields are skipped.
+    [StructLayout(LayoutKind.Sequential)]
+    public struct MeshBuffers
+    {
+        public IntPtr points;
+        public IntPtr normals;
+        public IntPtr tangents;
+        public IntPtr uv0;
+        public IntPtr uv1;
+        public IntPtr colors;
+        public IntPtr velocities;
+        public IntPtr indices;
+        public IntPtr boneCounts;
+        public IntPtr boneWeights;
+        public IntPtr boneWeights4;
+        public IntPtr bindposes;
+    }
+
+    // MeshDescriptors of all meshes in a scene, fetched with one call.
+    public class MeshDescriptorTable : IDisposable
+    {
+        #region internal
+        IntPtr self;
+        IntPtr m_data;
+        int m_count;
+        [DllImport(Lib.name)] static extern IntPtr msMeshDescriptorTableCreate();
+        [DllImport(Lib.name)] static extern void msMeshDescriptorTableRelease(IntPtr self);
+        [DllImport(Lib.name)] static extern int msMeshDescriptorTableBuildMesh(IntPtr self, IntPtr mesh);
+        [DllImport(Lib.name)] static extern int msMeshDescriptorTableBuildScene(IntPtr self, IntPtr scene);
+        [DllImport(Lib.name)] static extern IntPtr msMeshDescriptorTableGetData(IntPtr self);
+        [DllImport(Lib.name)] static extern int msMeshDescriptorTableGetStride();
+        #endregion
+
+        static readonly int s_stride = Marshal.SizeOf(typeof(MeshDescriptor));
+
+        public MeshDescriptorTable()
+        {
+            if (msMeshDescriptorTableGetStride() != s_stride)
+                Debug.LogError("MeshDescriptorTable: struct layout mismatch between C# and the plugin");
+            self = msMeshDescriptorTableCreate();
+        }
+        ~MeshDescriptorTable() { Dispose(); }
+
+        public void Dispose()
+        {
+            if (self != IntPtr.Zero)
+            {
+                msMeshDescriptorTableRelease(self);
+                self = IntPtr.Zero;
+            }
+            GC.SuppressFinalize(this);
+        }
+
+        public int count { get { return m_count; } }
+
+        // descriptors are in the order of meshes in scene entities
+        public int Build(SceneData scene)
+        {
+            m_count = msMeshDescriptorTableBuildScene(self, scene.self);
+            m_data = msMeshDescriptorTableGetData(self);
+            return m_count;
+        }
+        public int Build(MeshData mesh)
+        {
+            m_count = msMeshDescriptorTableBuildMesh(self, mesh.self);
+            m_data = msMeshDescriptorTableGetData(self);
+            return m_count;
+        }
+
+        public MeshDescriptor this[int i]
+        {
+            get { return (MeshDescriptor)Marshal.PtrToStructure(new IntPtr(m_data.ToInt64() + i * s_stride), typeof(MeshDescriptor)); }
+        }
+    }
     #endregion
 
     #region Point
@@ -2014,6 +2224,148 @@ namespace UTJ.MeshSync
         public TransformData GetEntity(int i) { return msSceneGetEntity(self, i); }
         public ConstraintData GetConstraint(int i) { return msSceneGetConstraint(self, i); }
     }
+
+    public enum EntityTableFilter
+    {
+        All,
+        Changed,
+    }
+
+    // must be synced with C++ side
+    [StructLayout(LayoutKind.Sequential)]
+    public struct EntityArrays
+    {
+        public IntPtr entityIndices;
+        public IntPtr types;
+        public IntPtr hostIDs;
+        public IntPtr parents;
+        public IntPtr indices;
+        public IntPtr dataFlags;
+        public IntPtr positions;
+        public IntPtr rotations;
+        public IntPtr scales;
+        public IntPtr visibilities;
+        public IntPtr layers;
+        public IntPtr pathOffsets;
+        public IntPtr paths;
+    }
+
+    // transform data of all entities in a scene as arrays, fetched with a few calls.
+    public class EntityTable : IDisposable
+    {
+        #region internal
+        IntPtr self;
+        int m_count;
+        PinnedList<int> m_entityIndices = new PinnedList<int>();
+        PinnedList<EntityType> m_types = new PinnedList<EntityType>();
+        PinnedList<int> m_hostIDs = new PinnedList<int>();
+        PinnedList<int> m_parents = new PinnedList<int>();
+        PinnedList<int> m_indices = new PinnedList<int>();
+        PinnedList<TransformDataFlags> m_dataFlags = new PinnedList<TransformDataFlags>();
+        PinnedList<Vector3> m_positions = new PinnedList<Vector3>();
+        PinnedList<Quaternion> m_rotations = new PinnedList<Quaternion>();
+        PinnedList<Vector3> m_scales = new PinnedList<Vector3>();
+        PinnedList<VisibilityFlags> m_visibilities = new PinnedList<VisibilityFlags>();
+        PinnedList<int> m_layers = new PinnedList<int>();
+        PinnedList<int> m_pathOffsets = new PinnedList<int>();
+        PinnedList<byte> m_paths = new PinnedList<byte>();
+
+        [DllImport(Lib.name)] static extern IntPtr msEntityTableCreate();
+        [DllImport(Lib.name)] static extern void msEntityTableRelease(IntPtr self);
+        [DllImport(Lib.name)] static extern int msEntityTableBuild(IntPtr self, IntPtr scene, EntityTableFilter filter);
+        [DllImport(Lib.name)] static extern int msEntityTableGetPathsSize(IntPtr self);
+        [DllImport(Lib.name)] static extern void msEntityTableFill(IntPtr self, ref EntityArrays dst);
+        #endregion
+
+        public EntityTable()
+        {
+            self = msEntityTableCreate();
+        }
+        ~EntityTable() { Dispose(); }
+
+        public void Dispose()
+        {
+            if (self != IntPtr.Zero)
+            {
+                msEntityTableRelease(self);
+                self = IntPtr.Zero;
+            }
+            m_entityIndices.Dispose();
+            m_types.Dispose();
+            m_hostIDs.Dispose();
+            m_parents.Dispose();
+            m_indices.Dispose();
+            m_dataFlags.Dispose();
+            m_positions.Dispose();
+            m_rotations.Dispose();
+            m_scales.Dispose();
+            m_visibilities.Dispose();
+            m_layers.Dispose();
+            m_pathOffsets.Dispose();
+            m_paths.Dispose();
+            GC.SuppressFinalize(this);
+        }
+
+        public int count { get { return m_count; } }
+        // index in scene entities. identical to row if the filter is All
+        public int[] entityIndices { get { return m_entityIndices.Array; } }
+        public EntityType[] types { get { return m_types.Array; } }
+        public int[] hostIDs { get { return m_hostIDs.Array; } }
+        // row of the parent. -1 if the parent is not in the table
+        public int[] parents { get { return m_parents.Array; } }
+        public int[] indices { get { return m_indices.Array; } }
+        public TransformDataFlags[] dataFlags { get { return m_dataFlags.Array; } }
+        public Vector3[] positions { get { return m_positions.Array; } }
+        public Quaternion[] rotations { get { return m_rotations.Array; } }
+        public Vector3[] scales { get { return m_scales.Array; } }
+        public VisibilityFlags[] visibilities { get { return m_visibilities.Array; } }
+        public int[] layers { get { return m_layers.Array; } }
+
+        public string GetPath(int row)
+        {
+            var offsets = m_pathOffsets.Array;
+            return System.Text.Encoding.UTF8.GetString(m_paths.Array, offsets[row], offsets[row + 1] - offsets[row] - 1);
+        }
+
+        public int Build(SceneData scene, EntityTableFilter filter = EntityTableFilter.All)
+        {
+            m_count = msEntityTableBuild(self, scene.self, filter);
+            m_entityIndices.ResizeDiscard(m_count);
+            m_types.ResizeDiscard(m_count);
+            m_hostIDs.ResizeDiscard(m_count);
+            m_parents.ResizeDiscard(m_count);
+            m_indices.ResizeDiscard(m_count);
+            m_dataFlags.ResizeDiscard(m_count);
+            m_positions.ResizeDiscard(m_count);
+            m_rotations.ResizeDiscard(m_count);
+            m_scales.ResizeDiscard(m_count);
+            m_visibilities.ResizeDiscard(m_count);
+            m_layers.ResizeDiscard(m_count);
+            m_pathOffsets.ResizeDiscard(m_count + 1);
+            m_paths.ResizeDiscard(msEntityTableGetPathsSize(self));
+            if (m_count == 0)
+                return 0;
+
+            var dst = new EntityArrays
+            {
+                entityIndices = m_entityIndices.Pointer,
+                types = m_types.Pointer,
+                hostIDs = m_hostIDs.Pointer,
+                parents = m_parents.Pointer,
+                indices = m_indices.Pointer,
+                dataFlags = m_dataFlags.Pointer,
+                positions = m_positions.Pointer,
+                rotations = m_rotations.Pointer,
+                scales = m_scales.Pointer,
+                visibilities = m_visibilities.Pointer,
+                layers = m_layers.Pointer,
+                pathOffsets = m_pathOffsets.Pointer,
+                paths = m_paths.Pointer,
+            };
+            msEntityTableFill(self, ref dst);
+            return m_count;
+        }
+    }
     #endregion Scene
 
 
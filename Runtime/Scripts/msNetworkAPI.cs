@@ -43,6 +43,24 @@ namespace UTJ.MeshSync
         public static ushort defaultPort { get { return 8080; } }
     }
 
+    public enum RelayDropPolicy
+    {
+        DropOldest,
+        Block,
+    }
+
+    // must be synced with ms::LatencyStage
+    public enum LatencyStage
+    {
+        Serialize,
+        Transfer,
+        Deserialize,
+        Import,
+        Queue,
+        Consume,
+        Total,
+    }
+
     public struct Server
     {
         #region internal
@@ -66,6 +84,18 @@ namespace UTJ.MeshSync
         [DllImport(Lib.name)] static extern void msServerSetFileRootPath(IntPtr self, string path);
         [DllImport(Lib.name)] static extern void msServerSetScreenshotFilePath(IntPtr self, string path);
         [DllImport(Lib.name)] static extern void msServerNotifyPoll(IntPtr self, PollMessage.PollType t);
+        [DllImport(Lib.name)] static extern int msServerAddRelayTarget(IntPtr self, string address, ushort port, int maxPending, RelayDropPolicy dropPolicy);
+        [DllImport(Lib.name)] static extern void msServerRemoveRelayTarget(IntPtr self, int id);
+        [DllImport(Lib.name)] static extern void msServerSetRelayOnly(IntPtr self, byte v);
+        [DllImport(Lib.name)] static extern byte msServerStartRecording(IntPtr self, string path);
+        [DllImport(Lib.name)] static extern void msServerStopRecording(IntPtr self);
+        [DllImport(Lib.name)] static extern ulong msServerGetLatencyCount(IntPtr self, LatencyStage stage);
+        [DllImport(Lib.name)] static extern float msServerGetLatencyAverage(IntPtr self, LatencyStage stage);
+        [DllImport(Lib.name)] static extern float msServerGetLatencyMax(IntPtr self, LatencyStage stage);
+        [DllImport(Lib.name)] static extern float msServerGetLatencyPercentile(IntPtr self, LatencyStage stage, float p);
+        [DllImport(Lib.name)] static extern int msServerGetLatencyHistogram(IntPtr self, LatencyStage stage, ulong[] dst);
+        [DllImport(Lib.name)] static extern float msLatencyGetBucketLowerBound(int i);
+        [DllImport(Lib.name)] static extern void msServerClearLatencyStats(IntPtr self);
         #endregion
 
         public delegate void MessageHandler(MessageType type, IntPtr data);
@@ -95,6 +125,34 @@ namespace UTJ.MeshSync
         public void ServeTexture(TextureData data) { msServerServeTexture(self, data); }
         public void ServeMaterial(MaterialData data) { msServerServeMaterial(self, data); }
         public void NotifyPoll(PollMessage.PollType t) { msServerNotifyPoll(self, t); }
+
+        // received messages are forwarded to the target server as they are. returns relay id
+        public int AddRelayTarget(string address, ushort port, int maxPending = 64, RelayDropPolicy dropPolicy = RelayDropPolicy.DropOldest)
+        {
+            return msServerAddRelayTarget(self, address, port, maxPending, dropPolicy);
+        }
+        public void RemoveRelayTarget(int id) { msServerRemoveRelayTarget(self, id); }
+        public bool relayOnly { set { msServerSetRelayOnly(self, (byte)(value ? 1 : 0)); } }
+
+        // received scenes are recorded into a scene cache file until StopRecording() is called
+        public bool StartRecording(string path) { return msServerStartRecording(self, path) != 0; }
+        public void StopRecording() { msServerStopRecording(self); }
+
+        // latencies of handled messages in milliseconds. Transfer and Total need the sender's clock to be synced
+        public ulong GetLatencyCount(LatencyStage stage) { return msServerGetLatencyCount(self, stage); }
+        public float GetLatencyAverage(LatencyStage stage) { return msServerGetLatencyAverage(self, stage); }
+        public float GetLatencyMax(LatencyStage stage) { return msServerGetLatencyMax(self, stage); }
+        // p: 0.0 - 1.0
+        public float GetLatencyPercentile(LatencyStage stage, float p) { return msServerGetLatencyPercentile(self, stage, p); }
+        // message counts per bucket. see LatencyBucketLowerBound()
+        public ulong[] GetLatencyHistogram(LatencyStage stage)
+        {
+            var ret = new ulong[msServerGetLatencyHistogram(self, stage, null)];
+            msServerGetLatencyHistogram(self, stage, ret);
+            return ret;
+        }
+        public static float LatencyBucketLowerBound(int i) { return msLatencyGetBucketLowerBound(i); }
+        public void ClearLatencyStats() { msServerClearLatencyStats(self); }
     }
     #endregion
 
@@ -111,6 +169,9 @@ namespace UTJ.MeshSync
         Screenshot,
         Query,
         Response,
+        AnimationDelta,
+        TextureTiles,
+        MaterialDelta,
     }
 
     public struct GetFlags
@@ -127,6 +188,9 @@ namespace UTJ.MeshSync
         public bool getMaterialIDs { get { return flags[8]; } }
         public bool getBones { get { return flags[9]; } }
         public bool getBlendShapes { get { return flags[10]; } }
+        public bool applyCulling { get { return flags[11]; } }
+        public bool applyOcclusionCulling { get { return flags[12]; } }
+        public bool updateRaycastScene { get { return flags[13]; } }
     }
 
     public struct GetMessage
@@ -136,6 +200,7 @@ namespace UTJ.MeshSync
         [DllImport(Lib.name)] static extern GetFlags msGetGetFlags(IntPtr self);
         [DllImport(Lib.name)] static extern int msGetGetBakeSkin(IntPtr self);
         [DllImport(Lib.name)] static extern int msGetGetBakeCloth(IntPtr self);
+        [DllImport(Lib.name)] static extern void msGetGetViewProj(IntPtr self, ref Matrix4x4 dst);
         #endregion
 
         public static explicit operator GetMessage(IntPtr v)
@@ -148,6 +213,16 @@ namespace UTJ.MeshSync
         public GetFlags flags { get { return msGetGetFlags(self); } }
         public bool bakeSkin { get { return msGetGetBakeSkin(self) != 0; } }
         public bool bakeCloth { get { return msGetGetBakeCloth(self) != 0; } }
+        // meshes outside of this camera are culled by the plugin if flags.applyCulling is set
+        public Matrix4x4 viewProj
+        {
+            get
+            {
+                var ret = Matrix4x4.identity;
+                msGetGetViewProj(self, ref ret);
+                return ret;
+            }
+        }
     }
 
     public struct SetMessage
@@ -170,6 +245,95 @@ namespace UTJ.MeshSync
         }
     }
 
+    public struct AnimationDeltaMessage
+    {
+        #region internal
+        public IntPtr self;
+        [DllImport(Lib.name)] static extern int msAnimationDeltaGetNumClips(IntPtr self);
+        [DllImport(Lib.name)] static extern AnimationClipData msAnimationDeltaGetClip(IntPtr self, int i);
+        [DllImport(Lib.name)] static extern AnimationClipData msAnimationDeltaGetDeltaClip(IntPtr self, int i);
+        [DllImport(Lib.name)] static extern int msAnimationDeltaGetNumRanges(IntPtr self, int i);
+        [DllImport(Lib.name)] static extern TimeRange msAnimationDeltaGetRange(IntPtr self, int i, int ri);
+        [DllImport(Lib.name)] static extern IntPtr msAnimationDeltaGetRangePath(IntPtr self, int i, int ri);
+        [DllImport(Lib.name)] static extern IntPtr msAnimationDeltaGetRangeCurve(IntPtr self, int i, int ri);
+        [DllImport(Lib.name)] static extern TimeRange msAnimationDeltaGetTimeRange(IntPtr self, int i);
+        #endregion
+
+        public static explicit operator AnimationDeltaMessage(IntPtr v)
+        {
+            AnimationDeltaMessage ret;
+            ret.self = v;
+            return ret;
+        }
+
+        public int numClips { get { return msAnimationDeltaGetNumClips(self); } }
+        // the updated curves of the clip with the delta already merged
+        public AnimationClipData GetClip(int i) { return msAnimationDeltaGetClip(self, i); }
+        // keys inside the updated ranges only
+        public AnimationClipData GetDeltaClip(int i) { return msAnimationDeltaGetDeltaClip(self, i); }
+        public int GetNumRanges(int i) { return msAnimationDeltaGetNumRanges(self, i); }
+        public TimeRange GetRange(int i, int ri) { return msAnimationDeltaGetRange(self, i, ri); }
+        // the curve GetRange() belongs to
+        public string GetRangePath(int i, int ri) { return Misc.S(msAnimationDeltaGetRangePath(self, i, ri)); }
+        public string GetRangeCurve(int i, int ri) { return Misc.S(msAnimationDeltaGetRangeCurve(self, i, ri)); }
+        public TimeRange GetTimeRange(int i) { return msAnimationDeltaGetTimeRange(self, i); }
+    }
+
+    public struct TextureTilesMessage
+    {
+        #region internal
+        public IntPtr self;
+        [DllImport(Lib.name)] static extern int msTextureTilesGetNumTextures(IntPtr self);
+        [DllImport(Lib.name)] static extern TextureData msTextureTilesGetTexture(IntPtr self, int i);
+        [DllImport(Lib.name)] static extern int msTextureTilesGetNumRects(IntPtr self, int i);
+        [DllImport(Lib.name)] static extern void msTextureTilesGetRect(IntPtr self, int i, int ri, ref RectInt dst);
+        [DllImport(Lib.name)] static extern IntPtr msTextureTilesGetRectData(IntPtr self, int i, int ri);
+        #endregion
+
+        public static explicit operator TextureTilesMessage(IntPtr v)
+        {
+            TextureTilesMessage ret;
+            ret.self = v;
+            return ret;
+        }
+
+        public int numTextures { get { return msTextureTilesGetNumTextures(self); } }
+        // texture with the tiles already applied. null if the target texture is unknown
+        public TextureData GetTexture(int i) { return msTextureTilesGetTexture(self, i); }
+        public int GetNumRects(int i) { return msTextureTilesGetNumRects(self, i); }
+        public RectInt GetRect(int i, int ri)
+        {
+            var ret = default(RectInt);
+            msTextureTilesGetRect(self, i, ri, ref ret);
+            return ret;
+        }
+        // pixels of the rect. rows are tightly packed
+        public IntPtr GetRectData(int i, int ri) { return msTextureTilesGetRectData(self, i, ri); }
+    }
+
+    public struct MaterialDeltaMessage
+    {
+        #region internal
+        public IntPtr self;
+        [DllImport(Lib.name)] static extern int msMaterialDeltaGetNumMaterials(IntPtr self);
+        [DllImport(Lib.name)] static extern MaterialData msMaterialDeltaGetMaterial(IntPtr self, int i);
+        [DllImport(Lib.name)] static extern MaterialData msMaterialDeltaGetDelta(IntPtr self, int i);
+        #endregion
+
+        public static explicit operator MaterialDeltaMessage(IntPtr v)
+        {
+            MaterialDeltaMessage ret;
+            ret.self = v;
+            return ret;
+        }
+
+        public int numMaterials { get { return msMaterialDeltaGetNumMaterials(self); } }
+        // material with the delta already applied. null if the target material is unknown
+        public MaterialData GetMaterial(int i) { return msMaterialDeltaGetMaterial(self, i); }
+        // changed properties only
+        public MaterialData GetDelta(int i) { return msMaterialDeltaGetDelta(self, i); }
+    }
+
     public struct DeleteMessage
     {
         #region internal
@@ -278,6 +442,8 @@ namespace UTJ.MeshSync
             HostName,
             RootNodes,
             AllNodes,
+            Raycast,        // answered by the plugin
+            ClosestPoint,   // answered by the plugin
         }
 
         public static explicit operator QueryMessage(IntPtr v)